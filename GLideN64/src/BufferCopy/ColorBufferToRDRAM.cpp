@@ -122,11 +122,146 @@ bool ColorBufferToRDRAM::_prepareCopy(u32& _startAddress)
 	return true;
 }
 
-u8 ColorBufferToRDRAM::_RGBAtoR8(u8 _c, u32 x, u32 y) {
-	return _c;
+namespace {
+
+// Convert pixels from video memory to N64 buffer format, see WriteToRDRAM.h
+
+struct RGBAtoR8
+{
+	bool test(u8 _c) const { return true; }
+	u8 convert(u8 _c, u32 x, u32 y) const { return _c; }
+
+	u32 convertRow(const u8 * _src, u8 * _dst, u32 x, u32 _count, u32 y) const
+	{
+		u32 i = 0;
+#ifdef __SSE_OPT
+		for (; i + 16 <= _count; i += 16) {
+			const __m128i c = _mm_loadu_si128((const __m128i*)(_src + i));
+			_mm_storeu_si128((__m128i*)(_dst + i), swizzleRDRAM8(c));
+		}
+#endif
+		return i;
+	}
+};
+
+struct RGBAtoRGBA32
+{
+	bool test(u32 _c) const { return _c != 0; }
+
+	u32 convert(u32 _c, u32 x, u32 y) const
+	{
+		const u32 r = _c & 0xFF;
+		const u32 g = (_c >> 8) & 0xFF;
+		const u32 b = (_c >> 16) & 0xFF;
+		const u32 a = _c >> 24;
+		return (r << 24) | (g << 16) | (b << 8) | a;
+	}
+
+	u32 convertRow(const u32 * _src, u32 * _dst, u32 x, u32 _count, u32 y) const
+	{
+		u32 i = 0;
+#ifdef __SSE_OPT
+		for (; i + 4 <= _count; i += 4) {
+			const __m128i c = _mm_loadu_si128((const __m128i*)(_src + i));
+			const __m128i old = _mm_loadu_si128((const __m128i*)(_dst + i));
+			const __m128i skip = _mm_cmpeq_epi32(c, _mm_setzero_si128());
+			const __m128i res = _mm_or_si128(_mm_and_si128(skip, old), _mm_andnot_si128(skip, swizzleRDRAM8(c)));
+			_mm_storeu_si128((__m128i*)(_dst + i), res);
+		}
+#endif
+		return i;
+	}
+};
+
+// Per pixel dither thresholds, [y & 63][x][r, g, b, a]. Columns 64..71 repeat 0..7,
+// so 8 consecutive pixels can be read without wrapping.
+typedef s16 DitherTable[64][72][4];
+
+template <bool dither, bool paperMarioHack>
+struct RGBAtoRGBA16
+{
+	const DitherTable & m_dither;
+
+	RGBAtoRGBA16(const DitherTable & _dither) : m_dither(_dither) {}
+
+	bool test(u32 _c) const { return true; }
+
+	u16 convert(u32 _c, u32 x, u32 y) const
+	{
+		s32 r = _c & 0xFF;
+		s32 g = (_c >> 8) & 0xFF;
+		s32 b = (_c >> 16) & 0xFF;
+		const u32 a = _c >> 24;
+
+		if (dither) {
+			const s16 * threshold = m_dither[y & 63][x & 63];
+			r = std::max(std::min(r + threshold[0], 255), 0);
+			g = std::max(std::min(g + threshold[1], 255), 0);
+			b = std::max(std::min(b + threshold[2], 255), 0);
+		}
+
+		if (paperMarioHack && b > 0x00 && b <= 0xFB)
+			// Paper Mario subscreen fix
+			b += 0x04;
+
+		return ((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | (a == 0 ? 0 : 1);
+	}
+
+#ifdef __SSE_OPT
+	__m128i convert4(__m128i _c, const s16 * _threshold) const
+	{
+		if (dither) {
+			// 16 bit lanes hold the thresholded channels, packus clamps them to [0, 255]
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(_c, zero), _mm_loadu_si128((const __m128i*)_threshold));
+			const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(_c, zero), _mm_loadu_si128((const __m128i*)(_threshold + 8)));
+			_c = _mm_packus_epi16(lo, hi);
+		}
+
+		if (paperMarioHack) {
+			const __m128i b = _mm_and_si128(_mm_srli_epi32(_c, 16), _mm_set1_epi32(0xFF));
+			const __m128i fix = _mm_and_si128(_mm_cmpgt_epi32(b, _mm_setzero_si128()), _mm_cmplt_epi32(b, _mm_set1_epi32(0xFC)));
+			_c = _mm_add_epi32(_c, _mm_and_si128(fix, _mm_set1_epi32(0x04 << 16)));
+		}
+
+		const __m128i r = _mm_slli_epi32(_mm_and_si128(_c, _mm_set1_epi32(0xF8)), 8);
+		const __m128i g = _mm_and_si128(_mm_srli_epi32(_c, 5), _mm_set1_epi32(0xF8 << 3));
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(_c, 18), _mm_set1_epi32(0xF8 >> 2));
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(_c, 24), _mm_setzero_si128());
+		const __m128i a = _mm_andnot_si128(transparent, _mm_set1_epi32(1));
+		const __m128i res = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+		// sign extend, so that the signed saturation of packs keeps all 16 bits
+		return _mm_srai_epi32(_mm_slli_epi32(res, 16), 16);
+	}
+#endif
+
+	u32 convertRow(const u32 * _src, u16 * _dst, u32 x, u32 _count, u32 y) const
+	{
+		u32 i = 0;
+#ifdef __SSE_OPT
+		const s16 * thresholds = m_dither[y & 63][0];
+		for (; i + 8 <= _count; i += 8) {
+			const s16 * threshold = thresholds + ((x + i) & 63) * 4;
+			const __m128i c0 = convert4(_mm_loadu_si128((const __m128i*)(_src + i)), threshold);
+			const __m128i c1 = convert4(_mm_loadu_si128((const __m128i*)(_src + i + 4)), threshold + 16);
+			_mm_storeu_si128((__m128i*)(_dst + i), swizzleRDRAM16(_mm_packs_epi32(c0, c1)));
+		}
+#endif
+		return i;
+	}
+};
+
+template <bool dither, bool paperMarioHack>
+void writeRGBA16ToRdram(const DitherTable & _dither, const u32 * _src, u16 * _dst,
+	u32 _width, u32 _height, u32 _numPixels, u32 _startAddress, u32 _bufferAddress)
+{
+	writeToRdram(_src, _dst, RGBAtoRGBA16<dither, paperMarioHack>(_dither), 1,
+		_width, _height, _numPixels, _startAddress, _bufferAddress, G_IM_SIZ_16b);
 }
 
-u16 ColorBufferToRDRAM::_RGBAtoRGBA16(u32 _c, u32 x, u32 y) {
+// Returns false if the current settings don't dither
+bool fillDitherTable(DitherTable & _table, u32 _blueNoiseIdx)
+{
 	// Precalculated 4x4 bayer matrix values for 5Bit
 	static const s32 thresholdMapBayer[4][4] = {
 		{ -4, 2, -3, 4 },
@@ -143,46 +278,35 @@ u16 ColorBufferToRDRAM::_RGBAtoRGBA16(u32 _c, u32 x, u32 y) {
 		{ 3, -1, -4, 1 }
 	};
 
-	union RGBA c;
-	c.raw = _c;
-
-	if (config.generalEmulation.enableDitheringPattern == 0 || config.frameBufferEmulation.nativeResFactor != 1) {
-		// Apply color dithering
-		switch (config.generalEmulation.rdramImageDitheringMode) {
-		case Config::BufferDitheringMode::bdmBayer:
-		case Config::BufferDitheringMode::bdmMagicSquare:
-		{
-			s32 threshold = config.generalEmulation.rdramImageDitheringMode == Config::BufferDitheringMode::bdmBayer ?
-				thresholdMapBayer[x & 3][y & 3] :
-				thresholdMapMagicSquare[x & 3][y & 3];
-			c.r = (u8)std::max(std::min((s32)c.r + threshold, 255), 0);
-			c.g = (u8)std::max(std::min((s32)c.g + threshold, 255), 0);
-			c.b = (u8)std::max(std::min((s32)c.b + threshold, 255), 0);
-		}
-		break;
-		case Config::BufferDitheringMode::bdmBlueNoise:
-		{
-			const BlueNoiseItem& threshold = blueNoiseTex[m_blueNoiseIdx & 7][x & 63][y & 63];
-			c.r = (u8)std::max(std::min((s32)c.r + threshold.r, 255), 0);
-			c.g = (u8)std::max(std::min((s32)c.g + threshold.g, 255), 0);
-			c.b = (u8)std::max(std::min((s32)c.b + threshold.b, 255), 0);
-		}
-		break;
-		}
-	}
+	if (config.generalEmulation.enableDitheringPattern != 0 && config.frameBufferEmulation.nativeResFactor == 1)
+		return false;
 
-	if ((config.generalEmulation.hacks & hack_paper_mario_subscreen) != 0 && c.b > 0x00 && c.b <= 0xFB)
-		// Paper Mario subscreen fix
-		c.b += 0x04;
+	const u32 mode = config.generalEmulation.rdramImageDitheringMode;
+	if (mode != Config::BufferDitheringMode::bdmBayer &&
+		mode != Config::BufferDitheringMode::bdmMagicSquare &&
+		mode != Config::BufferDitheringMode::bdmBlueNoise)
+		return false;
 
-	return ((c.r >> 3) << 11) | ((c.g >> 3) << 6) | ((c.b >> 3) << 1) | (c.a == 0 ? 0 : 1);
+	for (u32 y = 0; y < 64; ++y) {
+		for (u32 x = 0; x < 72; ++x) {
+			s16 * threshold = _table[y][x];
+			if (mode == Config::BufferDitheringMode::bdmBlueNoise) {
+				const BlueNoiseItem& item = blueNoiseTex[_blueNoiseIdx & 7][x & 63][y];
+				threshold[0] = item.r;
+				threshold[1] = item.g;
+				threshold[2] = item.b;
+			} else {
+				threshold[0] = threshold[1] = threshold[2] = mode == Config::BufferDitheringMode::bdmBayer ?
+					thresholdMapBayer[x & 3][y & 3] :
+					thresholdMapMagicSquare[x & 3][y & 3];
+			}
+			threshold[3] = 0;
+		}
+	}
+	return true;
 }
 
-u32 ColorBufferToRDRAM::_RGBAtoRGBA32(u32 _c, u32 x, u32 y) {
-	RGBA c;
-	c.raw = _c;
-	return (c.r << 24) | (c.g << 16) | (c.b << 8) | c.a;
-}
+} // namespace
 
 void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 {
@@ -209,7 +333,7 @@ void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 	if (m_pCurFrameBuffer->m_size == G_IM_SIZ_32b) {
 		u32 *ptr_src = (u32*)pPixels;
 		u32 *ptr_dst = (u32*)(RDRAM + _startAddress);
-		writeToRdram<u32, u32>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA32, valueTester<u32, 0>, 0, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
+		writeToRdram(ptr_src, ptr_dst, RGBAtoRGBA32(), 0, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
 	} else if (m_pCurFrameBuffer->m_size == G_IM_SIZ_16b) {
 		u32 *ptr_src = (u32*)pPixels;
 		u16 *ptr_dst = (u16*)(RDRAM + _startAddress);
@@ -217,12 +341,24 @@ void ColorBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress, bool _sync)
 		if (gDP.m_subscreen) {
 			copyWhiteToRDRAM(m_pCurFrameBuffer);
 			gDP.m_subscreen = false;
-		} else
-			writeToRdram<u32, u16>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoRGBA16, dummyTester<u32>, 1, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
+		} else {
+			static DitherTable ditherTable;
+			const bool dither = fillDitherTable(ditherTable, m_blueNoiseIdx);
+			const bool paperMarioHack = (config.generalEmulation.hacks & hack_paper_mario_subscreen) != 0;
+			const u32 bufferAddress = m_pCurFrameBuffer->m_startAddress;
+			if (dither && paperMarioHack)
+				writeRGBA16ToRdram<true, true>(ditherTable, ptr_src, ptr_dst, width, height, numPixels, _startAddress, bufferAddress);
+			else if (dither)
+				writeRGBA16ToRdram<true, false>(ditherTable, ptr_src, ptr_dst, width, height, numPixels, _startAddress, bufferAddress);
+			else if (paperMarioHack)
+				writeRGBA16ToRdram<false, true>(ditherTable, ptr_src, ptr_dst, width, height, numPixels, _startAddress, bufferAddress);
+			else
+				writeRGBA16ToRdram<false, false>(ditherTable, ptr_src, ptr_dst, width, height, numPixels, _startAddress, bufferAddress);
+		}
 	} else if (m_pCurFrameBuffer->m_size == G_IM_SIZ_8b) {
 		u8 *ptr_src = (u8*)pPixels;
 		u8 *ptr_dst = RDRAM + _startAddress;
-		writeToRdram<u8, u8>(ptr_src, ptr_dst, &ColorBufferToRDRAM::_RGBAtoR8, dummyTester<u8>, 3, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
+		writeToRdram(ptr_src, ptr_dst, RGBAtoR8(), 3, width, height, numPixels, _startAddress, m_pCurFrameBuffer->m_startAddress, m_pCurFrameBuffer->m_size);
 	}
 
 	m_pCurFrameBuffer->m_copiedToRdram = true;
@@ -205,20 +205,59 @@ bool DepthBufferToRDRAM::_prepareCopy(u32& _startAddress, bool _copyChunk)
 	return true;
 }
 
-u16 DepthBufferToRDRAM::_FloatToUInt16(f32 _z, u32 x, u32 y)
+namespace {
+
+// Convert pixels from video memory to N64 depth buffer format, see WriteToRDRAM.h
+struct FloatToUInt16
 {
-	static const u16 * const zLUT = depthBufferList().getZLUT();
-	u32 idx = 0x3FFFF;
-
-	if (_z < 0.0f) {
-		idx = 0;
-	} else if (_z < 1.0f) {
-		_z *= 262144.0f;
-		idx = std::min(0x3FFFFU, u32(floorf(_z + 0.5f)));
+	const u16 * const m_zLUT;
+
+	FloatToUInt16() : m_zLUT(depthBufferList().getZLUT()) {}
+
+	bool test(f32 _z) const { return true; }
+
+	u16 convert(f32 _z, u32 x, u32 y) const
+	{
+		u32 idx = 0x3FFFF;
+
+		if (_z < 0.0f) {
+			idx = 0;
+		} else if (_z < 1.0f) {
+			_z *= 262144.0f;
+			idx = std::min(0x3FFFFU, u32(floorf(_z + 0.5f)));
+		}
+
+		return m_zLUT[idx];
 	}
 
-	return zLUT[idx];
-}
+	u32 convertRow(const f32 * _src, u16 * _dst, u32 x, u32 _count, u32 y) const
+	{
+		u32 i = 0;
+#ifdef __SSE_OPT
+		const __m128i maxIdx = _mm_set1_epi32(0x3FFFF);
+		for (; i + 4 <= _count; i += 4) {
+			const __m128 z = _mm_loadu_ps(_src + i);
+			// z is in [0, 1) where the index is used, so truncation is floor
+			__m128i idx = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(262144.0f)), _mm_set1_ps(0.5f)));
+			const __m128i inRange = _mm_castps_si128(_mm_cmplt_ps(z, _mm_set1_ps(1.0f)));
+			const __m128i negative = _mm_castps_si128(_mm_cmplt_ps(z, _mm_setzero_ps()));
+			const __m128i clamp = _mm_or_si128(_mm_cmpgt_epi32(idx, maxIdx), _mm_andnot_si128(inRange, _mm_set1_epi32(-1)));
+			idx = _mm_or_si128(_mm_and_si128(clamp, maxIdx), _mm_andnot_si128(clamp, idx));
+			idx = _mm_andnot_si128(negative, idx);
+
+			alignas(16) u32 lut[4];
+			_mm_store_si128((__m128i*)lut, idx);
+			_dst[i + 0] = m_zLUT[lut[1]];
+			_dst[i + 1] = m_zLUT[lut[0]];
+			_dst[i + 2] = m_zLUT[lut[3]];
+			_dst[i + 3] = m_zLUT[lut[2]];
+		}
+#endif
+		return i;
+	}
+};
+
+} // namespace
 
 bool DepthBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress)
 {
@@ -252,10 +291,9 @@ bool DepthBufferToRDRAM::_copy(u32 _startAddress, u32 _endAddress)
 
 	std::vector<f32> srcBuf(width * height);
 	memcpy(srcBuf.data(), ptr_src, width * height * sizeof(f32));
-	writeToRdram<f32, u16>(srcBuf.data(),
+	writeToRdram(srcBuf.data(),
 						   ptr_dst,
-						   &DepthBufferToRDRAM::_FloatToUInt16,
-						   dummyTester<f32>,
+						   FloatToUInt16(),
 						   1,
 						   width,
 						   height,
@@ -29,9 +29,6 @@ private:
 	bool _prepareCopy(u32& _startAddress, bool _copyChunk);
 	bool _copy(u32 _startAddress, u32 _endAddress);
 
-	// Convert pixel from video memory to N64 depth buffer format.
-	static u16 _FloatToUInt16(f32 _z, u32 x, u32 y);
-
 	graphics::ObjectHandle m_FBO;
 	std::unique_ptr<graphics::PixelReadBuffer> m_pbuf;
 	u32 m_frameCount;
@@ -1,25 +1,61 @@
 #ifndef WriteToRDRAM_H
 #define WriteToRDRAM_H
 
-
+#include <algorithm>
 #include "../Types.h"
 
-template <typename T, T testValue>
-bool valueTester(T _c)
+#ifdef __SSE_OPT
+#include <emmintrin.h>
+
+// Swaps the 16 bit halves of every 32 bit word: the RDRAM order of 16 bit pixels (index ^ 1)
+inline __m128i swizzleRDRAM16(__m128i _v)
+{
+	return _mm_or_si128(_mm_slli_epi32(_v, 16), _mm_srli_epi32(_v, 16));
+}
+
+// Reverses the bytes of every 32 bit word: the RDRAM order of 8 bit pixels (index ^ 3)
+inline __m128i swizzleRDRAM8(__m128i _v)
 {
-	return _c != testValue;
+	_v = swizzleRDRAM16(_v);
+	return _mm_or_si128(_mm_slli_epi16(_v, 8), _mm_srli_epi16(_v, 8));
 }
+#endif // __SSE_OPT
 
-template <typename T>
-bool dummyTester(T _c)
+/*
+ * A converter for writeToRdram is a class providing
+ *   bool test(TSrc _c) const
+ *     false leaves the RDRAM pixel as it is.
+ *   TDst convert(TSrc _c, u32 x, u32 y) const
+ *     converts one pixel.
+ *   u32 convertRow(const TSrc * _src, TDst * _dst, u32 x, u32 count, u32 y) const
+ *     converts pixels [x, x + count) of row y and stores them already swizzled.
+ *     _dst starts a swizzle group. Returns the number of pixels done, a multiple
+ *     of the group size; convert() does the rest.
+ */
+
+template <typename TSrc, typename TDst, class Converter>
+void writeRowToRdram(const TSrc * _src, TDst * _dst, const Converter & _converter,
+	u32 _xor, u32 _dstIdx, u32 _x, u32 _count, u32 _y)
 {
-	return true;
+	u32 i = 0;
+	for (; i < _count && ((_dstIdx + i) & _xor) != 0; ++i) {
+		const TSrc c = _src[i];
+		if (_converter.test(c))
+			_dst[(_dstIdx + i) ^ _xor] = _converter.convert(c, _x + i, _y);
+	}
+
+	i += _converter.convertRow(_src + i, _dst + _dstIdx + i, _x + i, _count - i, _y);
+
+	for (; i < _count; ++i) {
+		const TSrc c = _src[i];
+		if (_converter.test(c))
+			_dst[(_dstIdx + i) ^ _xor] = _converter.convert(c, _x + i, _y);
+	}
 }
 
-template <typename TSrc, typename TDst>
-void writeToRdram(TSrc* _src, TDst* _dst,
-	TDst(*converter)(TSrc _c, u32 x, u32 y),
-	bool(*tester)(TSrc _c),
+template <typename TSrc, typename TDst, class Converter>
+void writeToRdram(const TSrc* _src, TDst* _dst,
+	const Converter & _converter,
 	u32 _xor,
 	u32 _width,
 	u32 _height,
@@ -37,26 +73,18 @@ void writeToRdram(TSrc* _src, TDst* _dst,
 
 	u32 numStored = 0;
 	u32 y = 0;
-	TSrc c;
 	if (chunkStart > 0) {
-		for (u32 x = chunkStart; x < _width; ++x) {
-			c = _src[x];
-			if (tester(c))
-				_dst[numStored ^ _xor] = converter(c, x, y);
-			++numStored;
-		}
+		numStored = _width - chunkStart;
+		writeRowToRdram(_src + chunkStart, _dst, _converter, _xor, 0, chunkStart, numStored, y);
 		++y;
 		_dst += numStored;
 	}
 
 	u32 dsty = 0;
-	for (; y < _height; ++y) {
-		for (u32 x = 0; x < _width && numStored < _numPixels; ++x) {
-			c = _src[x + y *_width];
-			if (tester(c))
-				_dst[(x + dsty*_width) ^ _xor] = converter(c, x, y);
-			++numStored;
-		}
+	for (; y < _height && numStored < _numPixels; ++y) {
+		const u32 count = std::min(_width, _numPixels - numStored);
+		writeRowToRdram(_src + y * _width, _dst, _converter, _xor, dsty * _width, 0, count, y);
+		numStored += count;
 		++dsty;
 	}
 }
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <functional>
 #include <cstring>
@@ -10,6 +12,9 @@
 #include "Config.h"
 #include "PluginAPI.h"
 #include "RSP.h"
+#include "GBI.h"
+#include "Log.h"
+#include "DisplayLoadProgress.h"
 #include "Graphics/Context.h"
 
 using namespace graphics;
@@ -94,6 +99,7 @@ void CombinerInfo::init()
 {
 	gfxContext.resetCombinerProgramBuilder();
 	m_pCurrent = nullptr;
+	m_compileStats = CompileStats();
 
 	m_shadersLoaded = 0;
 	if (config.generalEmulation.enableShadersStorage != 0 && !_loadShadersStorage()) {
@@ -102,6 +108,9 @@ void CombinerInfo::init()
 		m_combiners.clear();
 	}
 
+	if (config.generalEmulation.enableShadersStorage != 0 && config.generalEmulation.shaderWarmupCount != 0)
+		_warmUpShaders();
+
 	if (m_combiners.empty()) {
 		setPolygonMode(DrawingState::TexRect);
 		gDP.otherMode.cycleType = G_CYC_COPY;
@@ -132,6 +141,9 @@ void CombinerInfo::destroy()
 	for (auto cur = m_combiners.begin(); cur != m_combiners.end(); ++cur)
 		delete cur->second;
 	m_combiners.clear();
+	for (auto cur = m_warmCombiners.begin(); cur != m_warmCombiners.end(); ++cur)
+		delete cur->second;
+	m_warmCombiners.clear();
 }
 
 static
@@ -298,10 +310,25 @@ void CombinerInfo::setCombine(u64 _mux )
 	auto iter = m_combiners.find(key);
 	if (iter != m_combiners.end()) {
 		m_pCurrent = iter->second;
+	} else if ((iter = m_warmCombiners.find(key)) != m_warmCombiners.end()) {
+		m_pCurrent = iter->second;
+		m_combiners[key] = m_pCurrent;
+		m_warmCombiners.erase(iter);
+		++m_compileStats.warmHits;
 	} else {
+		const auto start = std::chrono::steady_clock::now();
 		m_pCurrent = Combiner_Compile(key);
 		m_pCurrent->update(true);
 		m_combiners[m_pCurrent->getKey()] = m_pCurrent;
+
+		const u64 us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		++m_compileStats.programs;
+		if (m_pCurrent->isReady())
+			++m_compileStats.stalls;
+		else
+			++m_compileStats.deferred;
+		m_compileStats.compileTimeUs += us;
+		m_compileStats.maxCompileTimeUs = std::max(m_compileStats.maxCompileTimeUs, us);
 	}
 	m_bChanged = true;
 }
@@ -309,6 +336,8 @@ void CombinerInfo::setCombine(u64 _mux )
 void CombinerInfo::updateParameters()
 {
 	m_pCurrent->update(false);
+	if (!m_pCurrent->isReady())
+		++m_compileStats.fallbackDraws;
 }
 
 void CombinerInfo::setDepthFogCombiner()
@@ -365,6 +394,40 @@ void CombinerInfo::_saveShadersStorage() const
 	gfxContext.saveShadersStorage(m_combiners);
 }
 
+void CombinerInfo::_warmUpShaders()
+{
+	std::vector<u64> keys;
+	if (!gfxContext.loadShadersCorpus(config.generalEmulation.shaderWarmupCount, keys))
+		return;
+
+	// Keys carry the HWL support of the title which recorded them
+	const bool hwlSupported = GBI.isHWLSupported();
+	const auto start = std::chrono::steady_clock::now();
+	const auto timeLimit = std::chrono::milliseconds(config.generalEmulation.shaderWarmupTime);
+
+	displayLoadProgress(L"WARM UP COMBINER SHADERS %.1f%%", 0.0f);
+	for (u32 i = 0; i < keys.size(); ++i) {
+		if (std::chrono::steady_clock::now() - start > timeLimit)
+			break;
+
+		const CombinerKey key(keys[i], false);
+		if (m_combiners.find(key) != m_combiners.end() || m_warmCombiners.find(key) != m_warmCombiners.end())
+			continue;
+
+		GBI.setHWLSupported(key.isHWLSupported());
+		graphics::CombinerProgram * pCombiner = Combiner_Compile(key);
+		pCombiner->update(true);
+		m_warmCombiners[pCombiner->getKey()] = pCombiner;
+		++m_compileStats.warmedUp;
+		if ((m_compileStats.warmedUp & 15) == 0)
+			displayLoadProgress(L"WARM UP COMBINER SHADERS %.1f%%", f32(i + 1) * 100.f / f32(keys.size()));
+	}
+	GBI.setHWLSupported(hwlSupported);
+	displayLoadProgress(L"");
+
+	LOG(LOG_VERBOSE, "Warmed up %u of %u common combiner shaders", m_compileStats.warmedUp, static_cast<u32>(keys.size()));
+}
+
 bool CombinerInfo::_loadShadersStorage()
 {
 	if (gfxContext.loadShadersStorage(m_combiners)) {
@@ -122,6 +122,24 @@ struct CombineCycle
 class CombinerInfo
 {
 public:
+	// Render thread time spent on new combiners since init()
+	struct CompileStats
+	{
+		u32 programs = 0;
+		// Programs which blocked rendering until compiled
+		u32 stalls = 0;
+		// Programs linked in the background
+		u32 deferred = 0;
+		// Draws done with the ubershader
+		u32 fallbackDraws = 0;
+		u64 compileTimeUs = 0;
+		u64 maxCompileTimeUs = 0;
+		// Programs compiled at startup from the corpus of all titles
+		u32 warmedUp = 0;
+		// Warmed up programs used by this title
+		u32 warmHits = 0;
+	};
+
 	void init();
 	void destroy();
 	void update();
@@ -137,6 +155,7 @@ public:
 	graphics::CombinerProgram * getCurrent() const { return m_pCurrent; }
 	bool isChanged() const {return m_bChanged;}
 	bool isShaderCacheSupported() const;
+	const CompileStats & getCompileStats() const { return m_compileStats; }
 
 	static CombinerInfo & get();
 
@@ -154,6 +173,7 @@ private:
 
 	void _saveShadersStorage() const;
 	bool _loadShadersStorage();
+	void _warmUpShaders();
 
 	bool m_bChanged;
 	bool m_rectMode;
@@ -162,6 +182,10 @@ private:
 
 	graphics::CombinerProgram * m_pCurrent;
 	graphics::Combiners m_combiners;
+	// Warmed up programs this title has not used yet. They are kept out of
+	// m_combiners, so that they are not recorded in its shader storage.
+	graphics::Combiners m_warmCombiners;
+	CompileStats m_compileStats;
 
 	std::unique_ptr<graphics::ShaderProgram> m_shadowmapProgram;
 	std::unique_ptr<graphics::ShaderProgram> m_texrectUpscaleCopyProgram;
@@ -47,6 +47,9 @@ void Config::resetToDefaults()
 	generalEmulation.enableClipping = 1;
 	generalEmulation.enableCustomSettings = 1;
 	generalEmulation.enableShadersStorage = 1;
+	generalEmulation.enableAsyncShaderCompile = 0;
+	generalEmulation.shaderWarmupCount = 0;
+	generalEmulation.shaderWarmupTime = 1000;
 	generalEmulation.enableLegacyBlending = 0;
 	generalEmulation.enableHybridFilter = 1;
 	generalEmulation.enableInaccurateTextureCoordinates = 0;
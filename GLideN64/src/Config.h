@@ -65,6 +65,9 @@ struct Config
 		u32 enableClipping;
 		u32 enableCustomSettings;
 		u32 enableShadersStorage;
+		u32 enableAsyncShaderCompile;
+		u32 shaderWarmupCount;
+		u32 shaderWarmupTime;
 		u32 enableLegacyBlending;
 		u32 enableHybridFilter;
 		u32 enableInaccurateTextureCoordinates;
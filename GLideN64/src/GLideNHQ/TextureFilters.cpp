@@ -36,7 +36,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // Basic 2x R8G8B8A8 filter with interpolation
 
-void Texture2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
+void Texture2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
 {
 	uint32 *pDst1, *pDst2;
 	uint32 *pSrc, *pSrc2;
@@ -63,7 +63,7 @@ void Texture2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch
 	uint32 xSrc;
 	uint32 ySrc;
 
-	for (ySrc = 0; ySrc < nHeight; ySrc++)
+	for (ySrc = yFirst; ySrc < (uint32)yLast; ySrc++)
 	{
 		pSrc = (uint32*)(((uint8*)srcPtr)+ySrc*srcPitch);
 		pSrc2 = (uint32*)(((uint8*)srcPtr)+(ySrc+1)*srcPitch);
@@ -262,7 +262,7 @@ void Texture2x_16(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch
  * Sharp filters
  * Hiroshi Morii <koolsmoky@users.sourceforge.net>
  */
-void SharpFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter)
+void SharpFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter, uint32 yFirst, uint32 yLast)
 {
 	// NOTE: for now we get away with copying the boundaries
 	//       filter the boundaries if we face problems
@@ -291,17 +291,20 @@ void SharpFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *de
 	break;
 	}
 
-	// setup rows
-	_src1 = src;
-	_src2 = _src1 + srcwidth;
-	_src3 = _src2 + srcwidth;
-	_dest = dest;
+	for (y = yFirst; y < yLast; y++) {
+		_src2 = src + y * srcwidth;
+		_dest = dest + y * srcwidth;
+
+		// copy the first and the last row
+		if (y == 0 || y == srcheight - 1) {
+			memcpy(_dest, _src2, (srcwidth << 2));
+			continue;
+		}
+
+		// setup rows
+		_src1 = _src2 - srcwidth;
+		_src3 = _src2 + srcwidth;
 
-	// copy the first row
-	memcpy(_dest, _src1, (srcwidth << 2));
-	_dest += srcwidth;
-	// filter 2nd row to 1 row before the last
-	for (y = 1; y < srcheight-1; y++) {
 		// copy the first pixel
 		_dest[0] = *_src2;
 		// filter 2nd pixel to 1 pixel before last
@@ -328,14 +331,7 @@ void SharpFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *de
 		}
 		// copy the ending pixel
 		_dest[srcwidth-1] = *(_src3 - 1);
-		// next row
-		_src1 += srcwidth;
-		_src2 += srcwidth;
-		_src3 += srcwidth;
-		_dest += srcwidth;
 	}
-	// copy the last row
-	memcpy(_dest, _src2, (srcwidth << 2));
 }
 
 #if !_16BPP_HACK
@@ -423,7 +419,7 @@ void SharpFilter_4444(uint16 *src, uint32 srcwidth, uint32 srcheight, uint16 *de
  * Smooth filters
  * Hiroshi Morii <koolsmoky@users.sourceforge.net>
  */
-void SmoothFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter)
+void SmoothFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter, uint32 yFirst, uint32 yLast)
 {
 	// NOTE: for now we get away with copying the boundaries
 	//       filter the boundaries if we face problems
@@ -466,16 +462,17 @@ void SmoothFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *d
 	switch (filter) {
 	case SMOOTH_FILTER_3:
 	case SMOOTH_FILTER_4:
-		// setup rows
-		_src1 = src;
-		_src2 = _src1 + srcwidth;
-		_src3 = _src2 + srcwidth;
-		_dest = dest;
-		// copy the first row
-		memcpy(_dest, _src1, (srcwidth << 2));
-		_dest += srcwidth;
-		// filter 2nd row to 1 row before the last
-		for (y = 1; y < srcheight - 1; y++){
+		for (y = yFirst; y < yLast; y++) {
+			_src2 = src + y * srcwidth;
+			_dest = dest + y * srcwidth;
+			// copy the first and the last row
+			if (y == 0 || y == srcheight - 1) {
+				memcpy(_dest, _src2, (srcwidth << 2));
+				continue;
+			}
+			// setup rows
+			_src1 = _src2 - srcwidth;
+			_src3 = _src2 + srcwidth;
 			// copy the first pixel
 			_dest[0] = _src2[0];
 			// filter 2nd pixel to 1 pixel before last
@@ -498,28 +495,22 @@ void SmoothFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *d
 			}
 			// copy the ending pixel
 			_dest[srcwidth-1] = *(_src3 - 1);
-			// next row
-			_src1 += srcwidth;
-			_src2 += srcwidth;
-			_src3 += srcwidth;
-			_dest += srcwidth;
 		}
-		// copy the last row
-		memcpy(_dest, _src2, (srcwidth << 2));
 	break;
 	case SMOOTH_FILTER_1:
 	case SMOOTH_FILTER_2:
 	default:
-		// setup rows
-		_src1 = src;
-		_src2 = _src1 + srcwidth;
-		_src3 = _src2 + srcwidth;
-		_dest = dest;
-		// copy the first row
-		memcpy(_dest, _src1, (srcwidth << 2));
-		_dest += srcwidth;
-		// filter 2nd row to 1 row before the last
-		for (y = 1; y < srcheight - 1; y++) {
+		for (y = yFirst; y < yLast; y++) {
+			_src2 = src + y * srcwidth;
+			_dest = dest + y * srcwidth;
+			// copy the first and the last row
+			if (y == 0 || y == srcheight - 1) {
+				memcpy(_dest, _src2, (srcwidth << 2));
+				continue;
+			}
+			// setup rows
+			_src1 = _src2 - srcwidth;
+			_src3 = _src2 + srcwidth;
 			// filter 1st pixel to the last
 			if (y & 1) {
 				for( x = 0; x < srcwidth; x++) {
@@ -536,14 +527,7 @@ void SmoothFilter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *d
 			} else {
 				memcpy(_dest, _src2, (srcwidth << 2));
 			}
-			// next row
-			_src1 += srcwidth;
-			_src2 += srcwidth;
-			_src3 += srcwidth;
-			_dest += srcwidth;
 		}
-		// copy the last row
-		memcpy(_dest, _src2, (srcwidth << 2));
 	break;
 	}
 }
@@ -746,58 +730,52 @@ void deposterizeV(uint32* data, uint32* out, int w, int h, int l, int u) {
 
 static
 void DePosterize(uint32* source, uint32* dest, uint32* buf, int width, int height) {
-	deposterizeH(source, buf, width, 0, height);
-	deposterizeV(buf, dest, width, height, 0, height);
-	deposterizeH(dest, buf, width, 0, height);
-	deposterizeV(buf, dest, width, height, 0, height);
+	// every pass reads the neighbouring rows of the previous one
+	TxThreadPool * pool = TxThreadPool::getInstance();
+	pool->runBands(width, height, 1, [&](uint32 l, uint32 u) { deposterizeH(source, buf, width, l, u); });
+	pool->runBands(width, height, 1, [&](uint32 l, uint32 u) { deposterizeV(buf, dest, width, height, l, u); });
+	pool->runBands(width, height, 1, [&](uint32 l, uint32 u) { deposterizeH(dest, buf, width, l, u); });
+	pool->runBands(width, height, 1, [&](uint32 l, uint32 u) { deposterizeV(buf, dest, width, height, l, u); });
 }
 
-void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter, uint32 threadId) {
-	if (filter & DEPOSTERIZE) {
-		const auto bufSize = srcwidth * srcheight;
-		uint32 * tex = TxMemBuf::getInstance()->getThreadBuf(threadId, 0, bufSize);
-		uint32 * buf = TxMemBuf::getInstance()->getThreadBuf(threadId, 1, bufSize);
-		if (tex != nullptr && buf != nullptr) {
-			DePosterize(src, tex, buf, srcwidth, srcheight);
-			src = tex;
-		}
-	}
+static
+void filter_8888_rows(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter, uint32 yFirst, uint32 yLast) {
 	switch (filter & ENHANCEMENT_MASK) {
 	case BRZ2X_ENHANCEMENT:
-		xbrz::scale(2, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
+		xbrz::scale(2, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR, xbrz::ScalerCfg(), yFirst, yLast);
 	return;
 	case BRZ3X_ENHANCEMENT:
-		xbrz::scale(3, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
+		xbrz::scale(3, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR, xbrz::ScalerCfg(), yFirst, yLast);
 	return;
 	case BRZ4X_ENHANCEMENT:
-		xbrz::scale(4, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
+		xbrz::scale(4, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR, xbrz::ScalerCfg(), yFirst, yLast);
 	return;
 	case BRZ5X_ENHANCEMENT:
-		xbrz::scale(5, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
+		xbrz::scale(5, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR, xbrz::ScalerCfg(), yFirst, yLast);
 	return;
 	case BRZ6X_ENHANCEMENT:
-		xbrz::scale(6, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR);
+		xbrz::scale(6, (const uint32_t *)const_cast<const uint32 *>(src), (uint32_t *)dest, srcwidth, srcheight, xbrz::ColorFormat::ABGR, xbrz::ScalerCfg(), yFirst, yLast);
 		return;
 	case HQ4X_ENHANCEMENT:
-		hq4x_8888((uint8*)src, (uint8*)dest, srcwidth, srcheight, srcwidth, (srcwidth << 4));
+		hq4x_8888((uint8*)src, (uint8*)dest, srcwidth, srcheight, srcwidth, (srcwidth << 4), yFirst, yLast);
 	return;
 	case HQ2X_ENHANCEMENT:
-		hq2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight);
+		hq2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight, yFirst, yLast);
 	return;
 	case HQ2XS_ENHANCEMENT:
-		hq2xS_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight);
+		hq2xS_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight, yFirst, yLast);
 	return;
 	case LQ2X_ENHANCEMENT:
-		lq2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight);
+		lq2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight, yFirst, yLast);
 	return;
 	case LQ2XS_ENHANCEMENT:
-		lq2xS_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight);
+		lq2xS_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight, yFirst, yLast);
 	return;
 	case X2SAI_ENHANCEMENT:
-		Super2xSaI_8888((uint32*)src, (uint32*)dest, srcwidth, srcheight, srcwidth);
+		Super2xSaI_8888((uint32*)src, (uint32*)dest, srcwidth, srcheight, srcwidth, yFirst, yLast);
 	return;
 	case X2_ENHANCEMENT:
-		Texture2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight);
+		Texture2x_32((uint8*)src, (srcwidth << 2), (uint8*)dest, (srcwidth << 3), srcwidth, srcheight, yFirst, yLast);
 	return;
 	}
 
@@ -806,11 +784,28 @@ void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, u
 	case SMOOTH_FILTER_2:
 	case SMOOTH_FILTER_3:
 	case SMOOTH_FILTER_4:
-		SmoothFilter_8888((uint32*)src, srcwidth, srcheight, (uint32*)dest, (filter & SMOOTH_FILTER_MASK));
+		SmoothFilter_8888((uint32*)src, srcwidth, srcheight, (uint32*)dest, (filter & SMOOTH_FILTER_MASK), yFirst, yLast);
 	return;
 	case SHARP_FILTER_1:
 	case SHARP_FILTER_2:
-		SharpFilter_8888((uint32*)src, srcwidth, srcheight, (uint32*)dest, (filter & SHARP_FILTER_MASK));
+		SharpFilter_8888((uint32*)src, srcwidth, srcheight, (uint32*)dest, (filter & SHARP_FILTER_MASK), yFirst, yLast);
 	return;
 	}
 }
+
+void filter_8888(uint32 *src, uint32 srcwidth, uint32 srcheight, uint32 *dest, uint32 filter) {
+	if (filter & DEPOSTERIZE) {
+		const auto bufSize = srcwidth * srcheight;
+		uint32 * tex = TxMemBuf::getInstance()->getThreadBuf(0, 0, bufSize);
+		uint32 * buf = TxMemBuf::getInstance()->getThreadBuf(0, 1, bufSize);
+		if (tex != nullptr && buf != nullptr) {
+			DePosterize(src, tex, buf, srcwidth, srcheight);
+			src = tex;
+		}
+	}
+
+	// all filters read across band borders, so the result does not depend on the split
+	TxThreadPool::getInstance()->runBands(srcwidth, srcheight, 1, [&](uint32 yFirst, uint32 yLast) {
+		filter_8888_rows(src, srcwidth, srcheight, dest, filter, yFirst, yLast);
+	});
+}
@@ -29,7 +29,10 @@
   uint16 x;
   uint16 y;
 
-  for (y = 0; y < height; y++) {
+  srcPtr += yFirst * pitch;
+  destPtr += yFirst * (pitch << 2);
+
+  for (y = yFirst; y < yLast; y++) {
     if ((y > 0) && (y < height - 1)) {
       row0 = width;
       row0 = -row0;
@@ -1312,62 +1312,36 @@ void hq2xS_16(u8 *srcPtr, u32 srcPitch, u8 * /* deltaPtr */,
 }
 #endif /* !_16BPP_HACK */
 
-void hq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
-{
-  uint32 *dst0 = (uint32 *)dstPtr;
-  uint32 *dst1 = dst0 + (dstPitch >> 2);
-
-  uint32 *src0 = (uint32 *)srcPtr;
-  uint32 *src1 = src0 + (srcPitch >> 2);
-  uint32 *src2 = src1 + (srcPitch >> 2);
-
-  int count;
-
-  hq2x_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
-
-  count = height;
+typedef void (*hq2x_32_row_func)(uint32* dst0, uint32* dst1, const uint32* src0, const uint32* src1, const uint32* src2, unsigned count);
 
-  count -= 2;
-  while(count>0) {
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
-	src0 = src1;
-	src1 = src2;
-	src2 += srcPitch >> 2;
-	--count;
+/* filters source rows [yFirst, yLast), the first and last row of the image
+ * go through edgeFunc */
+static void hq2x_32_rows(hq2x_32_row_func edgeFunc, hq2x_32_row_func rowFunc, uint8 *srcPtr, uint32 srcPitch,
+						 uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
+{
+  for (int y = yFirst; y < yLast; ++y) {
+	const uint32 *src1 = (const uint32 *)(srcPtr + y * srcPitch);
+	const uint32 *src0 = y > 0 ? src1 - (srcPitch >> 2) : src1;
+	const uint32 *src2 = y < height - 1 ? src1 + (srcPitch >> 2) : src1;
+
+	uint32 *dst0 = (uint32 *)(dstPtr + y * 2 * dstPitch);
+	uint32 *dst1 = dst0 + (dstPitch >> 2);
+
+	if (y == 0 || y == height - 1)
+	  edgeFunc(dst0, dst1, src0, src1, src2, width);
+	else
+	  rowFunc(dst0, dst1, src0, src1, src2, width);
   }
-  dst0 += dstPitch >> 1;
-  dst1 += dstPitch >> 1;
-  hq2x_32_def(dst0, dst1, src0, src1, src1, width);
 }
 
-void hq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
+void hq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
 {
-  uint32 *dst0 = (uint32 *)dstPtr;
-  uint32 *dst1 = dst0 + (dstPitch >> 2);
-
-  uint32 *src0 = (uint32 *)srcPtr;
-  uint32 *src1 = src0 + (srcPitch >> 2);
-  uint32 *src2 = src1 + (srcPitch >> 2);
-  hq2xS_32_def(dst0, dst1, src0, src0, src1, width);
-
-  int count = height;
+  hq2x_32_rows(hq2x_32_def, hq2x_32_def, srcPtr, srcPitch, dstPtr, dstPitch, width, height, yFirst, yLast);
+}
 
-  count -= 2;
-  while(count) {
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	hq2xS_32_def(dst0, dst1, src0, src1, src2, width);
-	src0 = src1;
-	src1 = src2;
-	src2 += srcPitch >> 2;
-	--count;
-  }
-  dst0 += dstPitch >> 1;
-  dst1 += dstPitch >> 1;
-  hq2xS_32_def(dst0, dst1, src0, src1, src1, width);
+void hq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
+{
+  hq2x_32_rows(hq2xS_32_def, hq2xS_32_def, srcPtr, srcPitch, dstPtr, dstPitch, width, height, yFirst, yLast);
 }
 
 #if !_16BPP_HACK
@@ -1434,66 +1408,14 @@ void lq2xS_16(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 }
 #endif /* !_16BPP_HACK */
 
-void lq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
+void lq2x_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
 {
-  uint32 *dst0 = (uint32 *)dstPtr;
-  uint32 *dst1 = dst0 + (dstPitch >> 2);
-
-  uint32 *src0 = (uint32 *)srcPtr;
-  uint32 *src1 = src0 + (srcPitch >> 2);
-  uint32 *src2 = src1 + (srcPitch >> 2);
-
-  int count;
-
-  lq2x_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
-
-  count = height;
-
-  count -= 2;
-  while(count>0) {
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
-	src0 = src1;
-	src1 = src2;
-	src2 += srcPitch >> 2;
-	--count;
-  }
-  dst0 += dstPitch >> 1;
-  dst1 += dstPitch >> 1;
-  lq2x_32_def(dst0, dst1, src0, src1, src1, width);
+  hq2x_32_rows(lq2x_32_def, hq2x_32_def, srcPtr, srcPitch, dstPtr, dstPitch, width, height, yFirst, yLast);
 }
 
-void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
+void lq2xS_32(uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height, int yFirst, int yLast)
 {
-  uint32 *dst0 = (uint32 *)dstPtr;
-  uint32 *dst1 = dst0 + (dstPitch >> 2);
-
-  uint32 *src0 = (uint32 *)srcPtr;
-  uint32 *src1 = src0 + (srcPitch >> 2);
-  uint32 *src2 = src1 + (srcPitch >> 2);
-
-  int count;
-
-  lq2xS_32_def(dst0, dst1, src0, src0, src1, width);
-  if( height == 1 ) return;
-
-  count = height;
-
-  count -= 2;
-  while(count>0) {
-	dst0 += dstPitch >> 1;
-	dst1 += dstPitch >> 1;
-	hq2x_32_def(dst0, dst1, src0, src1, src2, width);
-	src0 = src1;
-	src1 = src2;
-	src2 += srcPitch >> 2;
-	--count;
-  }
-  dst0 += dstPitch >> 1;
-  dst1 += dstPitch >> 1;
-  lq2xS_32_def(dst0, dst1, src0, src1, src1, width);
+  hq2x_32_rows(lq2xS_32_def, hq2x_32_def, srcPtr, srcPitch, dstPtr, dstPitch, width, height, yFirst, yLast);
 }
 
 /************************************************************************/
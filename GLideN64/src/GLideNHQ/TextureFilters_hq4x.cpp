@@ -688,7 +688,7 @@ void hq4x_565(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int
 }
 #endif /* !_16BPP_HACK */
 
-void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int SrcPPL, int BpL)
+void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int SrcPPL, int BpL, int yFirst, int yLast)
 {
 #define hq4x_Interp1 hq4x_Interp1_8888
 #define hq4x_Interp2 hq4x_Interp2_8888
@@ -724,7 +724,10 @@ void hq4x_8888(unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, in
   //   | w7 | w8 | w9 |
   //   +----+----+----+
 
-  for (j = 0; j < Yres; j++) {
+  pIn += yFirst * SrcPPL * 4;
+  pOut += yFirst * (16 * SrcPPL + 3 * BpL);
+
+  for (j = yFirst; j < yLast; j++) {
 	if (j>0)      prevline = -SrcPPL*4; else prevline = 0;
 	if (j<Yres-1) nextline =  SrcPPL*4; else nextline = 0;
 
@@ -25,8 +25,6 @@
 #pragma warning(disable: 4786)
 #endif
 
-#include <functional>
-#include <thread>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -100,9 +98,6 @@ TxFilter::TxFilter(int maxwidth,
 	_txImage      = new TxImage();
 	_txQuantize   = new TxQuantize();
 
-	/* get number of CPU cores. */
-	_numcore = TxUtil::getNumberofProcessors();
-
 	_initialized = 0;
 
 	_tex1 = nullptr;
@@ -306,46 +301,7 @@ TxFilter::filter(uint8 *src, int srcwidth, int srcheight, ColorFormat srcformat,
 
 				tmptex = (texture == _tex1) ? _tex2 : _tex1;
 
-				uint8 *_texture = texture;
-				uint8 *_tmptex  = tmptex;
-
-				unsigned int numcore = _numcore;
-				unsigned int blkrow = 0;
-				while (numcore > 1 && blkrow == 0) {
-					blkrow = (srcheight >> 2) / numcore;
-					numcore--;
-				}
-				if (blkrow > 0 && numcore > 1) {
-					//std::thread *thrd[MAX_NUMCORE];
-					unsigned int i;
-					int blkheight = blkrow << 2;
-					unsigned int srcStride = (srcwidth * blkheight) << 2;
-					unsigned int destStride = srcStride * scale * scale;
-					for (i = 0; i < numcore - 1; i++) {/*
-						thrd[i] = new std::thread(std::bind(filter_8888,
-																(uint32*)_texture,
-																srcwidth,
-																blkheight,
-																(uint32*)_tmptex,
-																filter,
-																i));*/
-						_texture += srcStride;
-						_tmptex  += destStride;
-					}/*
-					thrd[i] = new std::thread(std::bind(filter_8888,
-															(uint32*)_texture,
-															srcwidth,
-															srcheight - blkheight * i,
-															(uint32*)_tmptex,
-															filter,
-															i));*/
-					for (i = 0; i < numcore; i++) {
-						//thrd[i]->join();
-						//delete thrd[i];
-					}
-				} else {
-					filter_8888((uint32*)_texture, srcwidth, srcheight, (uint32*)_tmptex, filter, 0);
-				}
+				filter_8888((uint32*)texture, srcwidth, srcheight, (uint32*)tmptex, filter);
 
 				if (filter & ENHANCEMENT_MASK) {
 					srcwidth  *= scale;
@@ -36,8 +36,6 @@
 class TxFilter
 {
 private:
-  int _numcore;
-
   uint8 *_tex1;
   uint8 *_tex2;
   int _maxwidth;
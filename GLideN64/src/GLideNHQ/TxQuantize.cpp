@@ -27,8 +27,6 @@
 
 /* NOTE: The codes are not optimized. They can be made faster. */
 
-#include <functional>
-#include <thread>
 #include <assert.h>
 
 #include "TxQuantize.h"
@@ -77,8 +75,6 @@ static const unsigned char Five2Eight[32] =
 
 TxQuantize::TxQuantize()
 {
-	/* get number of CPU cores. */
-	_numcore = TxUtil::getNumberofProcessors();
 }
 
 
@@ -831,10 +827,20 @@ TxQuantize::P8_16BPP(uint32* src, uint32* dest, int width, int height, uint32* p
 	}
 }
 
+void
+TxQuantize::quantizeRows(quantizerFunc quantizer, uint8* src, uint8* dest, int width, int height, int srcShift, int destShift)
+{
+	/* bands of 4 rows keep the 16 bit pixel pairs together */
+	TxThreadPool::getInstance()->runBands(width, height, 4, [&](uint32 yFirst, uint32 yLast) {
+		(*this.*quantizer)((uint32*)(src + ((yFirst * width) << srcShift)),
+						   (uint32*)(dest + ((yFirst * width) << destShift)),
+						   width, yLast - yFirst);
+	});
+}
+
 boolean
 TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, ColorFormat srcformat, ColorFormat destformat, boolean fastQuantizer)
 {
-	typedef void (TxQuantize::*quantizerFunc)(uint32* src, uint32* dest, int width, int height);
 	assert(srcformat != graphics::colorFormat::RGBA);
 	assert(destformat != graphics::colorFormat::RGBA);
 	quantizerFunc quantizer;
@@ -853,41 +859,7 @@ TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, ColorFormat
 		} else
 			return 0;
 
-		unsigned int numcore = _numcore;
-		unsigned int blkrow = 0;
-		while (numcore > 1 && blkrow == 0) {
-			blkrow = (height >> 2) / numcore;
-			numcore--;
-		}
-		if (blkrow > 0 && numcore > 1) {
-		//	std::thread *thrd[MAX_NUMCORE];
-			unsigned int i;
-			int blkheight = blkrow << 2;
-			unsigned int srcStride = (width * blkheight) << (2 - bpp_shift);
-			unsigned int destStride = srcStride << bpp_shift;
-			for (i = 0; i < numcore - 1; i++) {
-				/*thrd[i] = new std::thread(std::bind(quantizer,
-														this,
-														(uint32*)src,
-														(uint32*)dest,
-														width,
-														blkheight));*/
-				src  += srcStride;
-				dest += destStride;
-			}
-			/*thrd[i] = new std::thread(std::bind(quantizer,
-													this,
-													(uint32*)src,
-													(uint32*)dest,
-													width,
-													height - blkheight * i));*/
-			for (i = 0; i < numcore; i++) {
-			//	thrd[i]->join();
-			//	delete thrd[i];
-			}
-		} else {
-			(*this.*quantizer)((uint32*)src, (uint32*)dest, width, height);
-		}
+		quantizeRows(quantizer, src, dest, width, height, 2 - bpp_shift, 2);
 
 	} else if (srcformat == graphics::internalcolorFormat::RGBA8) {
 		if (destformat == graphics::internalcolorFormat::RGB5_A1) {
@@ -902,41 +874,12 @@ TxQuantize::quantize(uint8* src, uint8* dest, int width, int height, ColorFormat
 		} else
 			return 0;
 
-		unsigned int numcore = _numcore;
-		unsigned int blkrow = 0;
-		while (numcore > 1 && blkrow == 0) {
-			blkrow = (height >> 2) / numcore;
-			numcore--;
-		}
-		if (blkrow > 0 && numcore > 1) {
-			//std::thread *thrd[MAX_NUMCORE];
-			unsigned int i;
-			int blkheight = blkrow << 2;
-			unsigned int srcStride = (width * blkheight) << 2;
-			unsigned int destStride = srcStride >> bpp_shift;
-			for (i = 0; i < numcore - 1; i++) {
-				/*thrd[i] = new std::thread(std::bind(quantizer,
-														this,
-														(uint32*)src,
-														(uint32*)dest,
-														width,
-														blkheight));*/
-				src  += srcStride;
-				dest += destStride;
-			}
-			/*thrd[i] = new std::thread(std::bind(quantizer,
-													this,
-													(uint32*)src,
-													(uint32*)dest,
-													width,
-													height - blkheight * i));*/
-			for (i = 0; i < numcore; i++) {
-			//	thrd[i]->join();
-			//	delete thrd[i];
-			}
-		} else {
+		/* error diffusion carries over to the next row, so only the fast
+		 * quantizers can be split */
+		if (fastQuantizer)
+			quantizeRows(quantizer, src, dest, width, height, 2, 2 - bpp_shift);
+		else
 			(*this.*quantizer)((uint32*)src, (uint32*)dest, width, height);
-		}
 
 	} else {
 		return 0;
@@ -21,6 +21,7 @@
  * the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <algorithm>
 #include <thread>
 #include "TxUtil.h"
 #include "TxDbg.h"
@@ -583,7 +584,8 @@ TxUtil::StrongCRC32_CI8(const uint8* src, int width, int height, int rowStride,
 
 uint32 TxUtil::getNumberofProcessors()
 {
-	uint32 numcore = 1; //std::thread::hardware_concurrency();
+	uint32 numcore = std::thread::hardware_concurrency();
+	if (numcore == 0) numcore = 1;
 	if (numcore > MAX_NUMCORE) numcore = MAX_NUMCORE;
 	DBG_INFO(80, wst("Number of processors : %d\n"), numcore);
 	return numcore;
@@ -679,6 +681,131 @@ TxMemBuf::getThreadBuf(uint32 threadIdx, uint32 num, uint32 size)
 	return buf.data();
 }
 
+/*
+ * Worker threads for texture manipulations
+ ******************************************************************************/
+
+/* bands smaller than this are not worth waking up another thread */
+#define MIN_BAND_PIXELS 4096
+
+TxThreadPool::TxThreadPool()
+	: _func(nullptr)
+	, _height(0)
+	, _bandHeight(0)
+	, _numBands(0)
+	, _nextBand(0)
+	, _busy(0)
+	, _generation(0)
+	, _quit(false)
+{
+	init(0);
+}
+
+TxThreadPool::~TxThreadPool()
+{
+	stop();
+}
+
+void
+TxThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_start.notify_all();
+	for (auto& thread : _workers)
+		thread.join();
+	_workers.clear();
+	_quit = false;
+}
+
+void
+TxThreadPool::init(uint32 numThreads)
+{
+	std::lock_guard<std::mutex> runLock(_runMutex);
+
+	if (numThreads == 0)
+		numThreads = TxUtil::getNumberofProcessors();
+	if (numThreads > MAX_NUMCORE)
+		numThreads = MAX_NUMCORE;
+
+	/* new workers only pick up runs started after the current one, which
+	 * can't move on while _runMutex is held */
+	stop();
+	for (uint32 i = 1; i < numThreads; i++)
+		_workers.emplace_back(&TxThreadPool::worker, this, _generation);
+}
+
+void
+TxThreadPool::execute()
+{
+	uint32 band;
+	while ((band = _nextBand.fetch_add(1)) < _numBands) {
+		const uint32 yFirst = band * _bandHeight;
+		const uint32 yLast = std::min(yFirst + _bandHeight, _height);
+		(*_func)(yFirst, yLast);
+	}
+}
+
+void
+TxThreadPool::worker(uint32 generation)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	for (;;) {
+		_start.wait(lock, [&] { return _quit || _generation != generation; });
+		if (_quit)
+			return;
+		generation = _generation;
+
+		lock.unlock();
+		execute();
+		lock.lock();
+
+		if (--_busy == 0)
+			_done.notify_one();
+	}
+}
+
+void
+TxThreadPool::runBands(uint32 width, uint32 height, uint32 align, const BandFunc &func)
+{
+	if (height == 0)
+		return;
+
+	std::lock_guard<std::mutex> runLock(_runMutex);
+
+	/* two bands per thread to even out the load, but not too small ones */
+	const uint32 numThreads = this->numThreads();
+	uint32 bandHeight = (height + numThreads * 2 - 1) / (numThreads * 2);
+	if (width > 0 && bandHeight * width < MIN_BAND_PIXELS)
+		bandHeight = (MIN_BAND_PIXELS + width - 1) / width;
+	bandHeight = (bandHeight + align - 1) / align * align;
+
+	if (_workers.empty() || bandHeight >= height) {
+		func(0, height);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_func = &func;
+		_height = height;
+		_bandHeight = bandHeight;
+		_numBands = (height + bandHeight - 1) / bandHeight;
+		_nextBand = 0;
+		_busy = (uint32)_workers.size();
+		_generation++;
+	}
+	_start.notify_all();
+
+	execute();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this] { return _busy == 0; });
+	_func = nullptr;
+}
+
 void setTextureFormat(ColorFormat internalFormat, GHQTexInfo * info)
 {
 	info->format = u32(internalFormat);
@@ -33,6 +33,11 @@
 #define TEXCACHE_EXT wst("htc")
 #define TEXSTREAM_EXT wst("hts")
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 class TxUtil
@@ -76,6 +81,49 @@ public:
 	uint32 *getThreadBuf(uint32 threadIdx, uint32 num, uint32 size);
 };
 
+/*
+ * Persistent worker threads shared by the texture filters and quantizers.
+ * The calling thread works on the tasks as well, so with a single core
+ * everything runs inline.
+ */
+class TxThreadPool
+{
+public:
+	typedef std::function<void(uint32 yFirst, uint32 yLast)> BandFunc;
+
+private:
+	std::vector<std::thread> _workers;
+	std::mutex _runMutex;
+	std::mutex _mutex;
+	std::condition_variable _start;
+	std::condition_variable _done;
+	const BandFunc *_func;
+	uint32 _height;
+	uint32 _bandHeight;
+	uint32 _numBands;
+	std::atomic<uint32> _nextBand;
+	uint32 _busy;
+	uint32 _generation;
+	bool _quit;
+	TxThreadPool();
+	void worker(uint32 generation);
+	void execute();
+	void stop();
+public:
+	static TxThreadPool* getInstance() {
+		static TxThreadPool txThreadPool;
+		return &txThreadPool;
+	}
+	~TxThreadPool();
+	/* number of threads including the caller, 0 picks the number of cores */
+	void init(uint32 numThreads);
+	uint32 numThreads() const { return (uint32)_workers.size() + 1; }
+	/* calls func for bands of rows covering [0, height) and waits for all of
+	 * them. Band heights are a multiple of align rows except for the last one.
+	 * Results must not depend on where the bands are split. */
+	void runBands(uint32 width, uint32 height, uint32 align, const BandFunc &func);
+};
+
 void setTextureFormat(ColorFormat internalFormat, GHQTexInfo * info);
 
 #endif /* __TXUTIL_H__ */
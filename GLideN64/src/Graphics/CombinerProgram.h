@@ -22,6 +22,9 @@ namespace graphics {
 
 		virtual bool getBinaryForm(std::vector<char> & _buffer) = 0;
 
+		// False while the program is linked in the background and draws use a fallback
+		virtual bool isReady() const = 0;
+
 		static u32 getShaderCombinerOptionsBits();
 	};
 
@@ -277,6 +277,11 @@ bool Context::loadShadersStorage(Combiners & _combiners)
 	return m_impl->loadShadersStorage(_combiners);
 }
 
+bool Context::loadShadersCorpus(u32 _count, std::vector<u64> & _keys)
+{
+	return m_impl->loadShadersCorpus(_count, _keys);
+}
+
 ShaderProgram * Context::createDepthFogShader()
 {
 	return m_impl->createDepthFogShader();
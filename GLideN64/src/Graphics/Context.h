@@ -238,6 +238,8 @@ namespace graphics {
 
 		bool loadShadersStorage(Combiners & _combiners);
 
+		bool loadShadersCorpus(u32 _count, std::vector<u64> & _keys);
+
 		ShaderProgram * createDepthFogShader();
 
 		TexrectDrawerShaderProgram * createTexrectDrawerDrawShader();
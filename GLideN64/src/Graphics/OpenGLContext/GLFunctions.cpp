@@ -217,6 +217,7 @@ PFNGLDISABLEIPROC ptrDisablei;
 PFNGLDEBUGMESSAGECALLBACKPROC ptrDebugMessageCallback;
 PFNGLDEBUGMESSAGECONTROLPROC ptrDebugMessageControl;
 PFNGLCOPYTEXIMAGE2DPROC ptrCopyTexImage2D;
+PFNGLMAXSHADERCOMPILERTHREADSARBPROC ptrMaxShaderCompilerThreadsKHR;
 PFNGLEGLIMAGETARGETTEXTURE2DOESPROC ptrEGLImageTargetTexture2DOES;
 PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC ptrEGLImageTargetRenderbufferStorageOES;
 
@@ -405,6 +406,13 @@ extern "C" void initGLFunctions()
 	GL_GET_PROC_ADR(PFNGLDEBUGMESSAGECALLBACKPROC, DebugMessageCallback);
 	GL_GET_PROC_ADR(PFNGLDEBUGMESSAGECONTROLPROC, DebugMessageControl);
 	GL_GET_PROC_ADR(PFNGLCOPYTEXIMAGE2DPROC, CopyTexImage2D);
+	GL_GET_PROC_ADR(PFNGLMAXSHADERCOMPILERTHREADSARBPROC, MaxShaderCompilerThreadsKHR);
+	if (ptrMaxShaderCompilerThreadsKHR == nullptr) {
+		// GL_ARB_parallel_shader_compile has the same entry point
+		PFNGLMAXSHADERCOMPILERTHREADSARBPROC ptrMaxShaderCompilerThreadsARB;
+		GL_GET_PROC_ADR(PFNGLMAXSHADERCOMPILERTHREADSARBPROC, MaxShaderCompilerThreadsARB);
+		ptrMaxShaderCompilerThreadsKHR = ptrMaxShaderCompilerThreadsARB;
+	}
 
 	GL_GET_PROC_ADR(PFNGLEGLIMAGETARGETTEXTURE2DOESPROC, EGLImageTargetTexture2DOES);
 	GL_GET_PROC_ADR(PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC, EGLImageTargetRenderbufferStorageOES);
@@ -205,6 +205,7 @@ extern PFNGLDISABLEIPROC ptrDisablei;
 extern PFNGLDEBUGMESSAGECALLBACKPROC ptrDebugMessageCallback;
 extern PFNGLDEBUGMESSAGECONTROLPROC ptrDebugMessageControl;
 extern PFNGLCOPYTEXIMAGE2DPROC ptrCopyTexImage2D;
+extern PFNGLMAXSHADERCOMPILERTHREADSARBPROC ptrMaxShaderCompilerThreadsKHR;
 
 typedef void (APIENTRYP PFNGLEGLIMAGETARGETTEXTURE2DOESPROC) (GLenum target, void* image);
 extern PFNGLEGLIMAGETARGETTEXTURE2DOESPROC ptrEGLImageTargetTexture2DOES;
@@ -353,6 +354,7 @@ extern "C" void initGLFunctions();
 #define glEnablei(...) opengl::FunctionWrapper::wrEnablei(__VA_ARGS__)
 #define glDisablei(...) opengl::FunctionWrapper::wrDisablei(__VA_ARGS__)
 #define glCopyTexImage2D(...) opengl::FunctionWrapper::wrCopyTexImage2D(__VA_ARGS__)
+#define glMaxShaderCompilerThreadsKHR(...) opengl::FunctionWrapper::wrMaxShaderCompilerThreadsKHR(__VA_ARGS__)
 #define glDebugMessageCallback(...) opengl::FunctionWrapper::wrDebugMessageCallback(__VA_ARGS__)
 #define glDebugMessageControl(...) opengl::FunctionWrapper::wrDebugMessageControl(__VA_ARGS__)
 #define glEGLImageTargetTexture2DOES(...) opengl::FunctionWrapper::wrEGLImageTargetTexture2DOES(__VA_ARGS__)
@@ -361,6 +363,10 @@ extern "C" void initGLFunctions();
 
 #define GL_TEXTURE_EXTERNAL_OES 0x8D65
 
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
 #include "Graphics/OpenGLContext/ThreadedOpenGl/opengl_Wrapper.h"
 
 #endif // GLFUNCTIONS_H
@@ -5,6 +5,7 @@
 #include "glsl_Utils.h"
 #include "glsl_CombinerInputs.h"
 #include "glsl_CombinerProgramImpl.h"
+#include "glsl_CombinerProgramDeferred.h"
 #include "glsl_CombinerProgramBuilderAccurate.h"
 #include "glsl_CombinerProgramUniformFactoryAccurate.h"
 #include "GraphicsDrawer.h"
@@ -243,6 +244,143 @@ bool combinedAlphaABD(const gDPCombine & _combine) {
 	return false;
 }
 
+/*---------------Ubershader-------------*/
+
+static
+const char *UberInput[] = {
+	"vec4(0.0)",
+	"readtex0",
+	"readtex1",
+	"uPrimColor",
+	"vec_color",
+	"uEnvColor",
+	"uCenterColor",
+	"uScaleColor",
+	"vec4(0.0)",
+	"vec4(readtex0.a)",
+	"vec4(readtex1.a)",
+	"vec4(uPrimColor.a)",
+	"vec4(vec_color.a)",
+	"vec4(uEnvColor.a)",
+	"vec4(lod_frac)",
+	"vec4(uPrimLod)",
+	"vec4(0.5 + 0.5*snoise())",
+	"vec4(uK4)",
+	"vec4(uK5)",
+	"vec4(1.0)",
+	"vec4(0.0)",
+	"vec4(0.5)"
+};
+
+static
+bool _isUberInputAvailable(u32 _input, const CombinerInputs & _inputs)
+{
+	switch (_input) {
+	case G_GCI_TEXEL0:
+	case G_GCI_TEXEL0_ALPHA:
+		return _inputs.usesTile(0);
+	case G_GCI_TEXEL1:
+	case G_GCI_TEXEL1_ALPHA:
+		return _inputs.usesTile(1);
+	case G_GCI_LOD_FRACTION:
+		return _inputs.usesLOD();
+	}
+	return true;
+}
+
+// Inputs which change the generated code. The rest is selected by uniforms.
+static
+CombinerInputs _getUberShaderInputs(const CombinerInputs & _inputs)
+{
+	CombinerInputs inputs;
+	if (_inputs.usesTile(0)) {
+		inputs.addInput(G_GCI_TEXEL0);
+		inputs.addInput(G_GCI_TEXEL0_ALPHA);
+	}
+	if (_inputs.usesTile(1)) {
+		inputs.addInput(G_GCI_TEXEL1);
+		inputs.addInput(G_GCI_TEXEL1_ALPHA);
+	}
+	if (_inputs.usesLOD())
+		inputs.addInput(G_GCI_LOD_FRACTION);
+	if (_inputs.usesHwLighting()) {
+		inputs.addInput(G_GCI_SHADE);
+		inputs.addInput(G_GCI_HW_LIGHT);
+	}
+	return inputs;
+}
+
+// Stage operations evaluated in order are (A - B) * C + D
+static
+void _getStageEquation(const CombinerStage & _stage, int _abcd[4])
+{
+	_abcd[0] = G_GCI_ZERO;
+	_abcd[1] = G_GCI_ZERO;
+	_abcd[2] = G_GCI_ONE;
+	_abcd[3] = G_GCI_ZERO;
+	for (u32 i = 0; i < _stage.numOps; ++i) {
+		const CombinerOp & op = _stage.op[i];
+		switch (op.op) {
+		case LOAD:
+			_abcd[0] = op.param1;
+			break;
+		case SUB:
+			_abcd[1] = op.param1;
+			break;
+		case MUL:
+			_abcd[2] = op.param1;
+			break;
+		case ADD:
+			_abcd[3] = op.param1;
+			break;
+		case INTER:
+			// mix(p2, p1, p3) == (p1 - p2) * p3 + p2
+			_abcd[0] = op.param1;
+			_abcd[1] = op.param2;
+			_abcd[2] = op.param3;
+			_abcd[3] = op.param2;
+			break;
+		}
+	}
+}
+
+// Must be called after compileCombiner(), which corrects the stage parameters
+static
+CombinerEquation _getCombinerEquation(const CombinerKey & _key, const Combiner & _color, const Combiner & _alpha)
+{
+	gDPCombine combine;
+	combine.mux = _key.getMux();
+
+	CombinerEquation eq;
+	_getStageEquation(_color.stage[0], eq.color[0]);
+	_getStageEquation(_alpha.stage[0], eq.alpha[0]);
+	if (CombinerProgramBuilder::s_cycleType == G_CYC_2CYCLE) {
+		eq.colorStages = _color.numStages;
+		eq.alphaStages = _alpha.numStages;
+	}
+	_getStageEquation(_color.stage[eq.colorStages - 1], eq.color[1]);
+	_getStageEquation(_alpha.stage[eq.alphaStages - 1], eq.alpha[1]);
+
+	if (combinedColorC(combine))
+		eq.colorSignExtend = 1;
+	else if (combinedColorABD(combine))
+		eq.colorSignExtend = 2;
+	if (combinedAlphaC(combine))
+		eq.alphaSignExtend = 1;
+	else if (combinedAlphaABD(combine))
+		eq.alphaSignExtend = 2;
+	return eq;
+}
+
+static
+void _writeUberCombinerStage(const char * _result, const char * _select, const char * _component, std::stringstream & _strShader)
+{
+	_strShader << "  " << _result << " = (cmbInput[" << _select << ".x]" << _component
+		<< " - cmbInput[" << _select << ".y]" << _component
+		<< ") * cmbInput[" << _select << ".z]" << _component
+		<< " + cmbInput[" << _select << ".w]" << _component << ";" << std::endl;
+}
+
 CombinerInputs CombinerProgramBuilder::compileCombiner(const CombinerKey & _key, Combiner & _color, Combiner & _alpha, std::string & _strShader)
 {
 	gDPCombine combine;
@@ -305,6 +443,69 @@ CombinerInputs CombinerProgramBuilder::compileCombiner(const CombinerKey & _key,
 		ssShader << "  lowp vec4 cmbRes = vec4(color1, alpha1);" << std::endl;
 	}
 
+	writeCombinerOutput(ssShader);
+
+	_strShader = ssShader.str();
+	return inputs;
+}
+
+void CombinerProgramBuilder::compileUberCombiner(const CombinerInputs & _inputs, std::string & _strShader)
+{
+	std::stringstream ssShader;
+
+	ssShader << "  lowp vec4 cmbInput[" << G_GCI_HW_LIGHT << "];" << std::endl;
+	for (u32 i = 0; i < G_GCI_HW_LIGHT; ++i)
+		ssShader << "  cmbInput[" << i << "] = " << (_isUberInputAvailable(i, _inputs) ? UberInput[i] : "vec4(0.0)") << ";" << std::endl;
+
+	_writeUberCombinerStage("alpha1", "uCmbAlpha0", ".a", ssShader);
+	if (CombinerProgramBuilder::s_cycleType == G_CYC_2CYCLE) {
+		ssShader << "  if (uCmbMode.y == 1) {" << std::endl;
+		_writeSignExtendAlphaC(ssShader);
+		ssShader << "  } else if (uCmbMode.y == 2) {" << std::endl;
+		_writeSignExtendAlphaABD(ssShader);
+		ssShader << "  }" << std::endl;
+	}
+
+	_writeAlphaTest(ssShader);
+
+	_writeUberCombinerStage("color1", "uCmbColor0", ".rgb", ssShader);
+	if (CombinerProgramBuilder::s_cycleType == G_CYC_2CYCLE) {
+		ssShader << "  if (uCmbMode.x == 1) {" << std::endl;
+		_writeSignExtendColorC(ssShader);
+		ssShader << "  } else if (uCmbMode.x == 2) {" << std::endl;
+		_writeSignExtendColorABD(ssShader);
+		ssShader << "  }" << std::endl;
+
+		ssShader << "  combined_color = vec4(color1, alpha1);" << std::endl;
+		ssShader << "  cmbInput[" << G_GCI_COMBINED << "] = combined_color;" << std::endl;
+		ssShader << "  cmbInput[" << G_GCI_COMBINED_ALPHA << "] = vec4(combined_color.a);" << std::endl;
+
+		ssShader << "  if (uCmbMode.w == 2) {" << std::endl;
+		_writeUberCombinerStage("alpha2", "uCmbAlpha1", ".a", ssShader);
+		ssShader << "  } else" << std::endl;
+		ssShader << "    alpha2 = alpha1;" << std::endl;
+
+		ssShader << "  if (uCvgXAlpha != 0 && alpha2 < 0.125) discard;" << std::endl;
+
+		ssShader << "  if (uCmbMode.z == 2) {" << std::endl;
+		_writeUberCombinerStage("color2", "uCmbColor1", ".rgb", ssShader);
+		ssShader << "  } else" << std::endl;
+		ssShader << "    color2 = color1;" << std::endl;
+
+		ssShader << "  lowp vec4 cmbRes = vec4(color2, alpha2);" << std::endl;
+	}
+	else {
+		ssShader << "  if (uCvgXAlpha != 0 && alpha1 < 0.125) discard;" << std::endl;
+		ssShader << "  lowp vec4 cmbRes = vec4(color1, alpha1);" << std::endl;
+	}
+
+	writeCombinerOutput(ssShader);
+
+	_strShader = ssShader.str();
+}
+
+void CombinerProgramBuilder::writeCombinerOutput(std::stringstream & ssShader) const
+{
 	// Simulate N64 color clamp.
 	if (needClampColor())
 		_writeClamp(ssShader);
@@ -337,9 +538,6 @@ CombinerInputs CombinerProgramBuilder::compileCombiner(const CombinerKey & _key,
 
 	// SHOW COVERAGE HACK
 	//	ssShader << "fragColor.rgb = vec3(cvg);" << std::endl;
-
-	_strShader = ssShader.str();
-	return inputs;
 }
 
 graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combiner & _color,
@@ -352,16 +550,69 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 	std::string strCombiner;
 	CombinerInputs combinerInputs(compileCombiner(_key, _color, _alpha, strCombiner));
 
-	const bool bUseLod = combinerInputs.usesLOD();
-	const bool bUseTextures = combinerInputs.usesTexture();
-	const bool bIsRect = _key.isRectKey();
-	const bool bUseHWLight = !bIsRect && // Rects not use lighting
+	const bool bUseHWLight = !_key.isRectKey() && // Rects not use lighting
 							 isHWLightingAllowed() &&
 							 combinerInputs.usesShadeColor();
 
 	if (bUseHWLight)
 		combinerInputs.addInput(G_GCI_HW_LIGHT);
 
+	std::string strFragmentShader(writeFragmentShader(strCombiner, combinerInputs, false));
+
+	if (m_asyncCompile && CombinerProgramBuilder::s_cycleType <= G_CYC_2CYCLE) {
+		std::shared_ptr<UberCombinerProgram> uberProgram(getUberCombinerProgram(combinerInputs, _key));
+		if (uberProgram) {
+			// Let the driver link in the background and draw with the ubershader meanwhile
+			const GLuint program = linkProgram(strFragmentShader, combinerInputs, _key, false);
+			return new DeferredCombinerProgram(_key, program, m_useProgram, combinerInputs, m_uniformFactory,
+				std::move(uberProgram), _getCombinerEquation(_key, _color, _alpha), std::move(strFragmentShader));
+		}
+	}
+
+	const GLuint program = linkProgram(strFragmentShader, combinerInputs, _key, true);
+
+	UniformGroups uniforms;
+	m_uniformFactory->buildUniforms(program, combinerInputs, _key, uniforms);
+
+	return new CombinerProgramImpl(_key, program, m_useProgram, combinerInputs, std::move(uniforms));
+}
+
+std::shared_ptr<UberCombinerProgram> CombinerProgramBuilder::getUberCombinerProgram(const CombinerInputs & _inputs,
+	const CombinerKey & _key)
+{
+	CombinerInputs inputs(_getUberShaderInputs(_inputs));
+	const u64 shape = ((_key.getMux() >> 56) << 32) | u32(int(inputs));
+	auto iter = m_uberPrograms.find(shape);
+	if (iter != m_uberPrograms.end())
+		return iter->second;
+
+	const CombinerKey key(_key.getMux() & 0xFF00000000000000ULL, false);
+	std::string strCombiner;
+	compileUberCombiner(inputs, strCombiner);
+	const std::string strFragmentShader(writeFragmentShader(strCombiner, inputs, true));
+	const GLuint program = linkProgram(strFragmentShader, inputs, key, false);
+
+	std::shared_ptr<UberCombinerProgram> uberProgram;
+	if (Utils::checkProgramLinkStatus(program, true)) {
+		UniformGroups uniforms;
+		m_uniformFactory->buildUniforms(program, inputs, key, uniforms);
+		uberProgram = std::make_shared<UberCombinerProgram>(key, program, m_useProgram, inputs, std::move(uniforms));
+	} else {
+		// Combiners of this shape are compiled synchronously
+		Utils::logErrorShader(GL_FRAGMENT_SHADER, strFragmentShader);
+		glDeleteProgram(program);
+	}
+	m_uberPrograms[shape] = uberProgram;
+	return uberProgram;
+}
+
+std::string CombinerProgramBuilder::writeFragmentShader(const std::string & _strCombiner, const CombinerInputs & _inputs,
+	bool _bUberShader)
+{
+	const bool bUseLod = _inputs.usesLOD();
+	const bool bUseTextures = _inputs.usesTexture();
+	const bool bUseHWLight = _inputs.usesHwLighting();
+
 	std::stringstream ssShader;
 
 	/* Write headers */
@@ -399,6 +650,11 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 		_writeFragmentHeaderDepthCompare(ssShader);
 	}
 
+	if (_bUberShader)
+		ssShader << "uniform lowp ivec4 uCmbColor0;" << std::endl << "uniform lowp ivec4 uCmbAlpha0;" << std::endl
+			<< "uniform lowp ivec4 uCmbColor1;" << std::endl << "uniform lowp ivec4 uCmbAlpha1;" << std::endl
+			<< "uniform lowp ivec4 uCmbMode;" << std::endl;
+
 	if (bUseHWLight)
 		_writeFragmentHeaderCalcLight(ssShader);
 
@@ -420,11 +676,11 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 
 	if (bUseTextures) {
 		_writeFragmentCorrectTexCoords(ssShader);
-		if (combinerInputs.usesTile(0))
+		if (_inputs.usesTile(0))
 		{
 			_writeFragmentClampWrapMirrorEngineTex0(ssShader);
 		}
-		if (combinerInputs.usesTile(1))
+		if (_inputs.usesTile(1))
 		{
 			_writeFragmentClampWrapMirrorEngineTex1(ssShader);
 		}
@@ -433,12 +689,12 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 			_writeFragmentReadTexMipmap(ssShader);
 		} else {
 			if (CombinerProgramBuilder::s_cycleType < G_CYC_COPY) {
-				if (combinerInputs.usesTile(0))
+				if (_inputs.usesTile(0))
 					_writeFragmentReadTex0(ssShader);
 				else
 					ssShader << "  lowp vec4 readtex0;" << std::endl;
 
-				if (combinerInputs.usesTile(1))
+				if (_inputs.usesTile(1))
 					_writeFragmentReadTex1(ssShader);
 			} else
 				_writeFragmentReadTexCopyMode(ssShader);
@@ -451,7 +707,7 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 		ssShader << "  input_color = shadeColor.rgb;" << std::endl;
 
 	ssShader << "  vec_color = vec4(input_color, shadeColor.a);" << std::endl;
-	ssShader << strCombiner << std::endl;
+	ssShader << _strCombiner << std::endl;
 
 	if (config.frameBufferEmulation.N64DepthCompare != Config::dcDisable)
 		_writeFragmentCallN64Depth(ssShader);
@@ -488,16 +744,21 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 
 	_writeShaderN64DepthRender(ssShader);
 
-	const std::string strFragmentShader(ssShader.str());
+	return ssShader.str();
+}
 
-	/* Create shader program */
+GLuint CombinerProgramBuilder::linkProgram(const std::string & _strFragmentShader, const CombinerInputs & _inputs,
+	const CombinerKey & _key, bool _bCheckStatus)
+{
+	const bool bUseTextures = _inputs.usesTexture();
+	const bool bIsRect = _key.isRectKey();
 
 	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	const GLchar * strShaderData = strFragmentShader.data();
+	const GLchar * strShaderData = _strFragmentShader.data();
 	glShaderSource(fragmentShader, 1, &strShaderData, nullptr);
 	glCompileShader(fragmentShader);
-	if (!Utils::checkShaderCompileStatus(fragmentShader))
-		Utils::logErrorShader(GL_FRAGMENT_SHADER, strFragmentShader);
+	if (_bCheckStatus && !Utils::checkShaderCompileStatus(fragmentShader))
+		Utils::logErrorShader(GL_FRAGMENT_SHADER, _strFragmentShader);
 
 	GLuint program = glCreateProgram();
 	Utils::locateAttributes(program, bIsRect, bUseTextures);
@@ -511,13 +772,9 @@ graphics::CombinerProgram * CombinerProgramBuilder::buildCombinerProgram(Combine
 			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	}
 	glLinkProgram(program);
-	assert(Utils::checkProgramLinkStatus(program));
+	assert(!_bCheckStatus || Utils::checkProgramLinkStatus(program));
 	glDeleteShader(fragmentShader);
-
-	UniformGroups uniforms;
-	m_uniformFactory->buildUniforms(program, combinerInputs, _key, uniforms);
-
-	return new CombinerProgramImpl(_key, program, m_useProgram, combinerInputs, std::move(uniforms));
+	return program;
 }
 
 CombinerProgramBuilder::CombinerProgramBuilder(const opengl::GLInfo & _glinfo, opengl::CachedUseProgram * _useProgram,
@@ -525,6 +782,7 @@ CombinerProgramBuilder::CombinerProgramBuilder(const opengl::GLInfo & _glinfo, o
 : m_uniformFactory(std::move(_uniformFactory))
 , m_useProgram(_useProgram)
 , m_useCoverage(_glinfo.coverage && config.generalEmulation.enableCoverage != 0)
+, m_asyncCompile(_glinfo.parallelShaderCompile && config.generalEmulation.enableAsyncShaderCompile != 0)
 {
 }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <map>
 #include <memory>
 #include <Combiner.h>
 #include <Graphics/OpenGLContext/opengl_GLInfo.h>
@@ -15,6 +16,7 @@ namespace opengl {
 
 namespace glsl {
 	class CombinerInputs;
+	class UberCombinerProgram;
 }
 
 namespace glsl {
@@ -73,6 +75,13 @@ protected:
 
 private:
 	CombinerInputs compileCombiner(const CombinerKey & _key, Combiner & _color, Combiner & _alpha, std::string & _strShader);
+	void compileUberCombiner(const CombinerInputs & _inputs, std::string & _strShader);
+	void writeCombinerOutput(std::stringstream & ssShader) const;
+	std::string writeFragmentShader(const std::string & _strCombiner, const CombinerInputs & _inputs,
+		bool _bUberShader);
+	GLuint linkProgram(const std::string & _strFragmentShader, const CombinerInputs & _inputs,
+		const CombinerKey & _key, bool _bCheckStatus);
+	std::shared_ptr<UberCombinerProgram> getUberCombinerProgram(const CombinerInputs & _inputs, const CombinerKey & _key);
 
 	virtual void _writeSignExtendAlphaC(std::stringstream& ssShader) const = 0;
 	virtual void _writeSignExtendAlphaABD(std::stringstream& ssShader) const = 0;
@@ -128,9 +137,12 @@ private:
 	virtual GLuint _getVertexShaderTexturedRect() const = 0;
 	virtual GLuint _getVertexShaderTexturedTriangle() const = 0;
 
-	std::unique_ptr<CombinerProgramUniformFactory> m_uniformFactory;
+	std::shared_ptr<CombinerProgramUniformFactory> m_uniformFactory;
 	opengl::CachedUseProgram * m_useProgram;
 	bool m_useCoverage = false;
+	bool m_asyncCompile = false;
+	// Ubershaders by cycle type, primitive type and used inputs
+	std::map<u64, std::shared_ptr<UberCombinerProgram>> m_uberPrograms;
 };
 
 }
@@ -0,0 +1,209 @@
+#include <Combiner.h>
+#include <DisplayWindow.h>
+#include <Graphics/OpenGLContext/opengl_CachedFunctions.h>
+#include "glsl_Utils.h"
+#include "glsl_CombinerProgramUniformFactoryCommon.h"
+#include "glsl_CombinerProgramDeferred.h"
+
+namespace glsl {
+
+/*---------------UCombinerEquation-------------*/
+
+class UCombinerEquation : public UniformGroup
+{
+public:
+	UCombinerEquation(GLuint _program) {
+		LocateUniform(uCmbColor0);
+		LocateUniform(uCmbAlpha0);
+		LocateUniform(uCmbColor1);
+		LocateUniform(uCmbAlpha1);
+		LocateUniform(uCmbMode);
+	}
+
+	void setEquation(const CombinerEquation * _equation)
+	{
+		m_equation = _equation;
+	}
+
+	void update(bool _force) override
+	{
+		if (m_equation == nullptr)
+			return;
+		const CombinerEquation & eq = *m_equation;
+		uCmbColor0.set(eq.color[0][0], eq.color[0][1], eq.color[0][2], eq.color[0][3], _force);
+		uCmbAlpha0.set(eq.alpha[0][0], eq.alpha[0][1], eq.alpha[0][2], eq.alpha[0][3], _force);
+		uCmbColor1.set(eq.color[1][0], eq.color[1][1], eq.color[1][2], eq.color[1][3], _force);
+		uCmbAlpha1.set(eq.alpha[1][0], eq.alpha[1][1], eq.alpha[1][2], eq.alpha[1][3], _force);
+		uCmbMode.set(eq.colorSignExtend, eq.alphaSignExtend, eq.colorStages, eq.alphaStages, _force);
+	}
+
+private:
+	const CombinerEquation * m_equation = nullptr;
+	i4Uniform uCmbColor0;
+	i4Uniform uCmbAlpha0;
+	i4Uniform uCmbColor1;
+	i4Uniform uCmbAlpha1;
+	i4Uniform uCmbMode;
+};
+
+/*---------------UberCombinerProgram-------------*/
+
+UberCombinerProgram::UberCombinerProgram(const CombinerKey & _key,
+	GLuint _program,
+	opengl::CachedUseProgram * _useProgram,
+	const CombinerInputs & _inputs,
+	UniformGroups && _uniforms)
+: m_equation(new UCombinerEquation(_program))
+{
+	_uniforms.emplace_back(m_equation);
+	m_program.reset(new CombinerProgramImpl(_key, _program, _useProgram, _inputs, std::move(_uniforms)));
+}
+
+UberCombinerProgram::~UberCombinerProgram()
+{
+}
+
+void UberCombinerProgram::activate()
+{
+	m_program->activate();
+}
+
+void UberCombinerProgram::update(const CombinerEquation & _equation, bool _force)
+{
+	m_equation->setEquation(&_equation);
+	m_program->update(_force);
+}
+
+/*---------------DeferredCombinerProgram-------------*/
+
+DeferredCombinerProgram::DeferredCombinerProgram(const CombinerKey & _key,
+	GLuint _program,
+	opengl::CachedUseProgram * _useProgram,
+	const CombinerInputs & _inputs,
+	std::shared_ptr<CombinerProgramUniformFactory> _uniformFactory,
+	std::shared_ptr<UberCombinerProgram> _fallback,
+	const CombinerEquation & _equation,
+	std::string && _strFragmentShader)
+: m_key(_key)
+, m_linkingProgram(_program)
+, m_useProgram(_useProgram)
+, m_inputs(_inputs)
+, m_uniformFactory(std::move(_uniformFactory))
+, m_fallback(std::move(_fallback))
+, m_equation(_equation)
+, m_strFragmentShader(std::move(_strFragmentShader))
+, m_lastPoll(dwnd().getBuffersSwapCount())
+, m_bLinkFailed(false)
+{
+}
+
+DeferredCombinerProgram::~DeferredCombinerProgram()
+{
+	if (!m_program && m_linkingProgram != 0) {
+		m_useProgram->useProgram(graphics::ObjectHandle::null);
+		glDeleteProgram(m_linkingProgram);
+	}
+}
+
+bool DeferredCombinerProgram::_poll()
+{
+	if (m_program)
+		return true;
+	if (m_bLinkFailed)
+		return false;
+
+	// Querying the status is a sync point with the GL thread, so only once per frame
+	const u32 frame = dwnd().getBuffersSwapCount();
+	if (frame == m_lastPoll)
+		return false;
+	m_lastPoll = frame;
+
+	GLint completed = GL_FALSE;
+	glGetProgramiv(m_linkingProgram, GL_COMPLETION_STATUS_KHR, &completed);
+	if (completed == GL_FALSE)
+		return false;
+
+	_finish();
+	return m_program != nullptr;
+}
+
+void DeferredCombinerProgram::_finish()
+{
+	if (Utils::checkProgramLinkStatus(m_linkingProgram, true)) {
+		UniformGroups uniforms;
+		m_uniformFactory->buildUniforms(m_linkingProgram, m_inputs, m_key, uniforms);
+		m_program.reset(new CombinerProgramImpl(m_key, m_linkingProgram, m_useProgram, m_inputs, std::move(uniforms)));
+		m_fallback.reset();
+	} else {
+		// Keep drawing with the ubershader
+		Utils::logErrorShader(GL_FRAGMENT_SHADER, m_strFragmentShader);
+		glDeleteProgram(m_linkingProgram);
+		m_linkingProgram = 0;
+		m_bLinkFailed = true;
+	}
+	m_uniformFactory.reset();
+	std::string().swap(m_strFragmentShader);
+}
+
+void DeferredCombinerProgram::activate()
+{
+	if (_poll())
+		m_program->activate();
+	else
+		m_fallback->activate();
+}
+
+void DeferredCombinerProgram::update(bool _force)
+{
+	if (_poll())
+		m_program->update(_force);
+	else
+		m_fallback->update(m_equation, _force);
+}
+
+const CombinerKey & DeferredCombinerProgram::getKey() const
+{
+	return m_key;
+}
+
+bool DeferredCombinerProgram::usesTexture() const
+{
+	return m_inputs.usesTexture();
+}
+
+bool DeferredCombinerProgram::usesTile(u32 _t) const
+{
+	return m_inputs.usesTile(_t);
+}
+
+bool DeferredCombinerProgram::usesShade() const
+{
+	return m_inputs.usesShade();
+}
+
+bool DeferredCombinerProgram::usesLOD() const
+{
+	return m_inputs.usesLOD();
+}
+
+bool DeferredCombinerProgram::usesHwLighting() const
+{
+	return m_inputs.usesHwLighting();
+}
+
+bool DeferredCombinerProgram::getBinaryForm(std::vector<char> & _buffer)
+{
+	// Blocks until the driver is done with the program
+	if (!m_program && !m_bLinkFailed)
+		_finish();
+	if (!m_program)
+		return false;
+	return m_program->getBinaryForm(_buffer);
+}
+
+bool DeferredCombinerProgram::isReady() const
+{
+	return m_program != nullptr;
+}
+
+}
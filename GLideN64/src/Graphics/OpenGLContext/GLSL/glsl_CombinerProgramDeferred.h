@@ -0,0 +1,91 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "glsl_CombinerProgramImpl.h"
+
+namespace glsl {
+
+	class CombinerProgramUniformFactory;
+
+	// Combine mode of a specialized program, for the ubershader.
+	// Inputs are the generalized G_GCI_ indices of A, B, C and D in (A - B) * C + D.
+	struct CombinerEquation
+	{
+		int color[2][4];
+		int alpha[2][4];
+		// Sign extension of the first cycle result: 0 - none, 1 - C, 2 - ABD
+		int colorSignExtend = 0;
+		int alphaSignExtend = 0;
+		int colorStages = 1;
+		int alphaStages = 1;
+	};
+
+	class UCombinerEquation;
+
+	// Generic program for all combine modes with the same cycle type, primitive type
+	// and used inputs. It evaluates the combiner equation with inputs selected by uniforms.
+	class UberCombinerProgram
+	{
+	public:
+		UberCombinerProgram(const CombinerKey & _key,
+			GLuint _program,
+			opengl::CachedUseProgram * _useProgram,
+			const CombinerInputs & _inputs,
+			UniformGroups && _uniforms);
+		~UberCombinerProgram();
+
+		void activate();
+		void update(const CombinerEquation & _equation, bool _force);
+
+	private:
+		std::unique_ptr<CombinerProgramImpl> m_program;
+		UCombinerEquation * m_equation;
+	};
+
+	// Combiner program which the driver links in the background.
+	// Until the link is complete, it draws with the ubershader.
+	class DeferredCombinerProgram : public graphics::CombinerProgram
+	{
+	public:
+		DeferredCombinerProgram(const CombinerKey & _key,
+			GLuint _program,
+			opengl::CachedUseProgram * _useProgram,
+			const CombinerInputs & _inputs,
+			std::shared_ptr<CombinerProgramUniformFactory> _uniformFactory,
+			std::shared_ptr<UberCombinerProgram> _fallback,
+			const CombinerEquation & _equation,
+			std::string && _strFragmentShader);
+		~DeferredCombinerProgram();
+
+		void activate() override;
+		void update(bool _force) override;
+		const CombinerKey & getKey() const override;
+
+		bool usesTexture() const override;
+		bool usesTile(u32 _t) const override;
+		bool usesShade() const override;
+		bool usesLOD() const override;
+		bool usesHwLighting() const override;
+
+		bool getBinaryForm(std::vector<char> & _buffer) override;
+
+		bool isReady() const override;
+
+	private:
+		bool _poll();
+		void _finish();
+
+		CombinerKey m_key;
+		GLuint m_linkingProgram;
+		opengl::CachedUseProgram * m_useProgram;
+		CombinerInputs m_inputs;
+		std::shared_ptr<CombinerProgramUniformFactory> m_uniformFactory;
+		std::shared_ptr<UberCombinerProgram> m_fallback;
+		CombinerEquation m_equation;
+		std::string m_strFragmentShader;
+		u32 m_lastPoll;
+		bool m_bLinkFailed;
+		std::unique_ptr<CombinerProgramImpl> m_program;
+	};
+
+}
@@ -42,6 +42,8 @@ namespace glsl {
 
 		bool getBinaryForm(std::vector<char> & _buffer) override;
 
+		bool isReady() const override { return true; }
+
 	private:
 		bool m_bNeedUpdate;
 		CombinerKey m_key;
@@ -26,7 +26,7 @@ using namespace glsl;
 #define SHADER_STORAGE_FOLDER_NAME "shaders"
 
 static
-std::string getStorageFileName(const opengl::GLInfo & _glinfo, const char * _fileExtension)
+std::string getStorageFolder()
 {
 	class SetLocale
 	{
@@ -59,16 +59,21 @@ std::string getStorageFileName(const opengl::GLInfo & _glinfo, const char * _fil
 		}
 	}
 
-	std::string strOpenGLType;
+	return path.str();
+}
 
-	if(_glinfo.isGLESX) {
-		strOpenGLType = "GLES";
-	} else {
-		strOpenGLType = "OpenGL";
-	}
+static
+const char * getOpenGLType(const opengl::GLInfo & _glinfo)
+{
+	return _glinfo.isGLESX ? "GLES" : "OpenGL";
+}
 
-	path << "/GLideN64." << std::hex << static_cast<u32>(std::hash<std::string>()(RSP.romname))
-		<< "." << strOpenGLType << "." << _fileExtension;
+static
+std::string getStorageFileName(const opengl::GLInfo & _glinfo, const char * _fileExtension)
+{
+	std::stringstream path;
+	path << getStorageFolder() << "/GLideN64." << std::hex << static_cast<u32>(std::hash<std::string>()(RSP.romname))
+		<< "." << getOpenGLType(_glinfo) << "." << _fileExtension;
 
 	return path.str();
 }
@@ -384,6 +389,34 @@ bool ShaderStorage::loadShadersStorage(graphics::Combiners & _combiners)
 }
 
 
+/*
+The corpus is built from the keys files of all titles played with this
+storage folder, plus GLideN64.<OpenGL|GLES>.corpus if present. The latter
+is written by the shadercorpus tool from any collection of keys files.
+*/
+bool ShaderStorage::loadShadersCorpus(u32 _count, std::vector<u64> & _keys) const
+{
+	const std::string folder(getStorageFolder());
+	const std::string strOpenGLType(getOpenGLType(m_glinfo));
+
+	ShaderCorpus corpus;
+	corpus.addFolder(folder, "." + strOpenGLType + ".keys");
+
+	const std::string corpusFileName(folder + "/GLideN64." + strOpenGLType + ".corpus");
+#if defined(OS_WINDOWS) && !defined(MINGW)
+	std::ifstream fin(corpusFileName);
+#else
+	std::ifstream fin(corpusFileName.c_str());
+#endif
+	if (fin && !corpus.addCorpus(fin))
+		LOG(LOG_WARNING, "Unsupported shader corpus %s", corpusFileName.c_str());
+
+	for (const ShaderCorpus::Entry & entry : corpus.getRanked(_count))
+		_keys.push_back(entry.mux);
+
+	return !_keys.empty();
+}
+
 ShaderStorage::ShaderStorage(const opengl::GLInfo & _glinfo, opengl::CachedUseProgram * _useProgram)
 : m_glinfo(_glinfo)
 , m_useProgram(_useProgram)
@@ -1,4 +1,6 @@
 #pragma once
+#include <vector>
+#include <ShaderCorpus.h>
 #include <Graphics/OpenGLContext/opengl_GLInfo.h>
 
 namespace opengl {
@@ -16,12 +18,15 @@ namespace glsl {
 
 		bool loadShadersStorage(graphics::Combiners & _combiners);
 
+		// Most common combiner keys of all titles, at most _count of them
+		bool loadShadersCorpus(u32 _count, std::vector<u64> & _keys) const;
+
 	private:
 		bool _saveCombinerKeys(const graphics::Combiners & _combiners) const;
 		bool _loadFromCombinerKeys(graphics::Combiners & _combiners);
 
 		const u32 m_formatVersion = 0x3BU;
-		const u32 m_keysFormatVersion = 0x05;
+		const u32 m_keysFormatVersion = ShaderCorpus::keysFormatVersion;
 		const opengl::GLInfo & m_glinfo;
 		opengl::CachedUseProgram * m_useProgram;
 	};
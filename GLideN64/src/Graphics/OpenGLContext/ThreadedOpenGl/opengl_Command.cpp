@@ -2,17 +2,18 @@
 #include "Graphics/OpenGLContext/GLFunctions.h"
 #include "RingBufferPool.h"
 #include <chrono>
+#include <string.h>
 
 namespace opengl {
 
 	// Max memory pool size
 	RingBufferPool OpenGlCommand::m_ringBufferPool(1024 * 1024 * 200 );
 
+	CommandRing OpenGlCommand::m_commandRing(1024 * 1024 * 4);
+
 	void OpenGlCommand::performCommandSingleThreaded()
 	{
 		commandToExecute();
-
-		setInUse(false);
 #ifdef GL_DEBUG
 		if (m_isGlCommand) {
 			auto error = ptrGetError();
@@ -33,31 +34,21 @@ namespace opengl {
 
 	void OpenGlCommand::performCommand()
 	{
-		std::unique_lock<std::mutex> lock(m_condvarMutex);
 		performCommandSingleThreaded();
-		if (m_synced) {
 #ifdef GL_DEBUG
-			if (m_logIfSynced) {
-				std::stringstream errorString;
-				errorString << " Executing synced: " << m_functionName;
-				LOG(LOG_ERROR, errorString.str().c_str());
-			}
-#endif
-			m_executed = true;
-			m_condition.notify_all();
+		if (m_synced && m_logIfSynced) {
+			std::stringstream errorString;
+			errorString << " Executing synced: " << m_functionName;
+			LOG(LOG_ERROR, errorString.str().c_str());
 		}
+#endif
 	}
 
-	void OpenGlCommand::waitOnCommand()
+	bool OpenGlCommand::isSynced() const
 	{
-		std::unique_lock<std::mutex> lock(m_condvarMutex);
-
-		if (m_synced && !m_executed) {
-			m_condition.wait(lock, [this] { return m_executed; });
-		}
-
-		m_executed = false;
+		return m_synced;
 	}
+
 #ifdef GL_DEBUG
 	std::string OpenGlCommand::getFunctionName()
 	{
@@ -66,7 +57,7 @@ namespace opengl {
 #endif
 	OpenGlCommand::OpenGlCommand(bool _synced, bool _logIfSynced, const std::string &_functionName,
 		bool _isGlCommand) :
-		m_synced(_synced), m_executed(false)
+		m_synced(_synced)
 #ifdef GL_DEBUG
 		, m_logIfSynced(_logIfSynced)
 		, m_functionName(std::move(_functionName))
@@ -75,4 +66,24 @@ namespace opengl {
 	{
 	}
 
+	void CommandPayload::set(const void* _data, size_t _size)
+	{
+		if (_size <= INLINE_SIZE) {
+			m_pooled = PoolBufferPointer();
+			if (_size != 0)
+				memcpy(m_inline, _data, _size);
+		} else {
+			m_pooled = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(_data), _size);
+		}
+	}
+
+	const char* CommandPayload::get() const
+	{
+		return m_pooled.isValid() ? OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_pooled) : m_inline;
+	}
+
+	void CommandPayload::release()
+	{
+		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_pooled);
+	}
 }
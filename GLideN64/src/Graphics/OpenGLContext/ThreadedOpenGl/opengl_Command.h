@@ -1,23 +1,22 @@
 #pragma once
 
 #include <memory>
-#include <vector>
-#include <mutex>
-#include <atomic>
+#include <new>
 #include <string>
-#include <condition_variable>
-#include "opengl_ObjectPool.h"
+#include "opengl_CommandRing.h"
 #include "RingBufferPool.h"
 
 namespace opengl {
 
-	class OpenGlCommand : public PoolObject {
+	class OpenGlCommand {
 	public:
+		virtual ~OpenGlCommand() = default;
+
 		void performCommandSingleThreaded();
 
 		void performCommand();
 
-		void waitOnCommand();
+		bool isSynced() const;
 #ifdef GL_DEBUG
 		std::string getFunctionName();
 #endif
@@ -26,22 +25,20 @@ namespace opengl {
 
 		static RingBufferPool m_ringBufferPool;
 
+		static CommandRing m_commandRing;
+
 	protected:
 		OpenGlCommand(bool _synced, bool _logIfSynced, const std::string &_functionName,
 			bool _isGlCommand = true);
 
 		virtual void commandToExecute() = 0;
 
-		template<typename CoomandType>
-		static std::shared_ptr<CoomandType> getFromPool(int _poolId) {
-			auto poolObject = OpenGlCommandPool::get().getAvailableObject(_poolId);
-			if (poolObject == nullptr) {
-				poolObject = std::shared_ptr<CoomandType>(new CoomandType);
-				OpenGlCommandPool::get().addObjectToPool(_poolId, poolObject);
-			}
-
-			poolObject->setInUse(true);
-			return std::static_pointer_cast<CoomandType>(poolObject);
+		// Constructs the command in place in the command ring. It stays invisible
+		// to the GL thread until FunctionWrapper commits it.
+		template<typename CommandType>
+		static CommandType* allocate() {
+			static_assert(alignof(CommandType) <= CommandRing::RECORD_ALIGN, "command is over-aligned");
+			return new (m_commandRing.allocate(sizeof(CommandType))) CommandType;
 		}
 
 #ifdef GL_DEBUG
@@ -51,9 +48,24 @@ namespace opengl {
 #endif
 
 	private:
-		std::atomic<bool> m_synced;
-		bool m_executed;
-		std::mutex m_condvarMutex;
-		std::condition_variable m_condition;
+		const bool m_synced;
+	};
+
+	// Array argument of a command. Small arrays are copied into the command
+	// itself, larger ones are side-allocated in the ring buffer pool.
+	class CommandPayload
+	{
+	public:
+		void set(const void* _data, size_t _size);
+
+		const char* get() const;
+
+		void release();
+
+	private:
+		static const size_t INLINE_SIZE = 64;
+
+		PoolBufferPointer m_pooled;
+		alignas(8) char m_inline[INLINE_SIZE];
 	};
 }
@@ -0,0 +1,158 @@
+#include "opengl_CommandRing.h"
+#include "opengl_Command.h"
+#include <sstream>
+#include <stdexcept>
+#include <Log.h>
+
+namespace opengl {
+
+	CommandRing::CommandRing(size_t _size) :
+		m_size(RECORD_ALIGN),
+		m_reserved(0),
+		m_unsignaled(0),
+		m_head(0),
+		m_tail(0),
+		m_consumerWaiting(false),
+		m_producerWaiting(false),
+		m_interrupted(false)
+	{
+		// Positions grow forever and are masked, so the size must be a power of two
+		while (m_size < _size)
+			m_size <<= 1;
+		m_mask = m_size - 1;
+		m_buffer.reset(new char[m_size]);
+	}
+
+	void* CommandRing::allocate(size_t _size)
+	{
+		const size_t recordSize = (HEADER_SIZE + _size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+		if (recordSize > m_size / 2) {
+			std::stringstream errorString;
+			errorString << " Attempted to queue a command of invalid size, size=" << _size;
+			LOG(LOG_ERROR, errorString.str().c_str());
+			throw std::runtime_error(errorString.str().c_str());
+		}
+
+		// A record never wraps, the rest of the ring is skipped instead
+		size_t pos = m_tail.load(std::memory_order_relaxed);
+		const size_t padding = (pos & m_mask) + recordSize > m_size ? m_size - (pos & m_mask) : 0;
+		waitForSpace(padding + recordSize);
+
+		if (padding != 0) {
+			header(pos)->size = padding;
+			header(pos)->skip = true;
+			pos += padding;
+		}
+
+		RecordHeader* record = header(pos);
+		record->size = recordSize;
+		record->skip = false;
+		m_reserved = pos + recordSize;
+		return reinterpret_cast<char*>(record) + HEADER_SIZE;
+	}
+
+	void CommandRing::commit(bool _sync)
+	{
+		m_tail.store(m_reserved);
+
+		if (_sync || ++m_unsignaled >= WAKE_BATCH)
+			wakeConsumer();
+	}
+
+	void CommandRing::discard()
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		RecordHeader* record = header(tail);
+		if (record->skip)
+			record = header(tail + record->size);
+		reinterpret_cast<OpenGlCommand*>(reinterpret_cast<char*>(record) + HEADER_SIZE)->~OpenGlCommand();
+		m_reserved = tail;
+	}
+
+	void CommandRing::flush()
+	{
+		if (m_unsignaled != 0)
+			wakeConsumer();
+	}
+
+	void CommandRing::waitUntilEmpty()
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (m_head.load() == tail)
+			return;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_producerWaiting = true;
+		m_consumerCondition.notify_one();
+		m_producerCondition.wait(lock, [this, tail] { return m_head.load() == tail; });
+		m_producerWaiting = false;
+	}
+
+	void CommandRing::waitForSpace(size_t _size)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail + _size - m_head.load(std::memory_order_acquire) <= m_size)
+			return;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_producerWaiting = true;
+		m_unsignaled = 0;
+		m_consumerCondition.notify_one();
+		m_producerCondition.wait(lock, [this, tail, _size] { return tail + _size - m_head.load() <= m_size; });
+		m_producerWaiting = false;
+	}
+
+	void CommandRing::wakeConsumer()
+	{
+		m_unsignaled = 0;
+		if (m_consumerWaiting.load()) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_consumerCondition.notify_one();
+		}
+	}
+
+	OpenGlCommand* CommandRing::front(std::chrono::milliseconds _timeout)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_consumerWaiting = true;
+			m_consumerCondition.wait_for(lock, _timeout, [this, head] { return m_interrupted || m_tail.load() != head; });
+			m_consumerWaiting = false;
+			m_interrupted = false;
+
+			if (m_tail.load(std::memory_order_acquire) == head)
+				return nullptr;
+		}
+
+		RecordHeader* record = header(head);
+		if (record->skip) {
+			// The record behind the padding was committed together with it
+			head += record->size;
+			m_head.store(head, std::memory_order_release);
+			record = header(head);
+		}
+
+		return reinterpret_cast<OpenGlCommand*>(reinterpret_cast<char*>(record) + HEADER_SIZE);
+	}
+
+	void CommandRing::pop()
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		RecordHeader* record = header(head);
+		reinterpret_cast<OpenGlCommand*>(reinterpret_cast<char*>(record) + HEADER_SIZE)->~OpenGlCommand();
+		m_head.store(head + record->size);
+
+		if (m_producerWaiting.load()) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_producerCondition.notify_one();
+		}
+	}
+
+	void CommandRing::interrupt()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_interrupted = true;
+		m_consumerCondition.notify_one();
+	}
+}
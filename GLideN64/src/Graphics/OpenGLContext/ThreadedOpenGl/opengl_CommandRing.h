@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace opengl {
+
+	class OpenGlCommand;
+
+	// Single producer, single consumer byte ring of commands. A command is
+	// constructed in place behind a small record header, so queueing it takes
+	// neither a heap allocation nor a lock. The consumer is only woken when
+	// it sleeps and a batch of records, a sync point or a full ring requires it.
+	class CommandRing
+	{
+	public:
+		static const size_t RECORD_ALIGN = 16;
+
+		explicit CommandRing(size_t _size);
+
+		// Producer: reserves room for a command of _size bytes and returns it.
+		// Blocks while the ring is full. Nothing is visible to the consumer
+		// until commit().
+		void* allocate(size_t _size);
+
+		// Producer: publishes the reserved command. _sync wakes the consumer at once.
+		void commit(bool _sync);
+
+		// Producer: destroys the reserved command without publishing it
+		void discard();
+
+		// Producer: wakes the consumer if anything is pending
+		void flush();
+
+		// Producer: blocks until the consumer has executed every committed command
+		void waitUntilEmpty();
+
+		// Consumer: returns the oldest command, or nullptr if none arrived within
+		// _timeout or interrupt() was called
+		OpenGlCommand* front(std::chrono::milliseconds _timeout);
+
+		// Consumer: destroys the command returned by front() and frees its record
+		void pop();
+
+		// Either side: makes a waiting front() return
+		void interrupt();
+
+	private:
+		struct RecordHeader
+		{
+			size_t size;
+			bool skip;
+		};
+
+		static const size_t HEADER_SIZE = (sizeof(RecordHeader) + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+		static const unsigned int WAKE_BATCH = 64;
+
+		RecordHeader* header(size_t _pos) { return reinterpret_cast<RecordHeader*>(&m_buffer[_pos & m_mask]); }
+		void waitForSpace(size_t _size);
+		void wakeConsumer();
+
+		std::unique_ptr<char[]> m_buffer;
+		size_t m_size;
+		size_t m_mask;
+
+		// Producer side
+		size_t m_reserved;
+		unsigned int m_unsignaled;
+
+		std::atomic<size_t> m_head;
+		std::atomic<size_t> m_tail;
+		std::atomic<bool> m_consumerWaiting;
+		std::atomic<bool> m_producerWaiting;
+		bool m_interrupted;
+		std::mutex m_mutex;
+		std::condition_variable m_consumerCondition;
+		std::condition_variable m_producerCondition;
+	};
+}
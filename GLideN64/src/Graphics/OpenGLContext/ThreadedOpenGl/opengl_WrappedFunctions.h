@@ -44,10 +44,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum sfactor, GLenum dfactor)
+	static OpenGlCommand* get(GLenum sfactor, GLenum dfactor)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBlendFuncCommand>(poolId);
+		auto ptr = allocate<GlBlendFuncCommand>();
 		ptr->set(sfactor, dfactor);
 		return ptr;
 	}
@@ -75,10 +74,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum sfactorcolor, GLenum dfactorcolor, GLenum sfactoralpha, GLenum dfactoralpha)
+	static OpenGlCommand* get(GLenum sfactorcolor, GLenum dfactorcolor, GLenum sfactoralpha, GLenum dfactoralpha)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBlendFuncSeparateCommand>(poolId);
+		auto ptr = allocate<GlBlendFuncSeparateCommand>();
 		ptr->set(sfactorcolor, dfactorcolor, sfactoralpha, dfactoralpha);
 		return ptr;
 	}
@@ -111,10 +109,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum pname, GLint param)
+	static OpenGlCommand* get(GLenum pname, GLint param)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlPixelStoreiCommand>(poolId);
+		auto ptr = allocate<GlPixelStoreiCommand>();
 		ptr->set(pname, param);
 		return ptr;
 	}
@@ -144,10 +141,9 @@ public:
 
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	static OpenGlCommand* get(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlClearColorCommand>(poolId);
+		auto ptr = allocate<GlClearColorCommand>();
 		ptr->set(red, green, blue, alpha);
 		return ptr;
 	}
@@ -179,10 +175,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum mode)
+	static OpenGlCommand* get(GLenum mode)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCullFaceCommand>(poolId);
+		auto ptr = allocate<GlCullFaceCommand>();
 		ptr->set(mode);
 		return ptr;
 	}
@@ -209,10 +204,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum func)
+	static OpenGlCommand* get(GLenum func)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDepthFuncCommand>(poolId);
+		auto ptr = allocate<GlDepthFuncCommand>();
 		ptr->set(func);
 		return ptr;
 	}
@@ -240,10 +234,9 @@ public:
 
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLboolean flag)
+	static OpenGlCommand* get(GLboolean flag)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDepthMaskCommand>(poolId);
+		auto ptr = allocate<GlDepthMaskCommand>();
 		ptr->set(flag);
 		return ptr;
 	}
@@ -270,10 +263,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum cap)
+	static OpenGlCommand* get(GLenum cap)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDisableCommand>(poolId);
+		auto ptr = allocate<GlDisableCommand>();
 		ptr->set(cap);
 		return ptr;
 	}
@@ -300,10 +292,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum cap)
+	static OpenGlCommand* get(GLenum cap)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlEnableCommand>(poolId);
+		auto ptr = allocate<GlEnableCommand>();
 		ptr->set(cap);
 		return ptr;
 	}
@@ -330,10 +321,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint index)
+	static OpenGlCommand* get(GLenum target, GLuint index)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDisableiCommand>(poolId);
+		auto ptr = allocate<GlDisableiCommand>();
 		ptr->set(target, index);
 		return ptr;
 	}
@@ -362,10 +352,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint index)
+	static OpenGlCommand* get(GLenum target, GLuint index)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlEnableiCommand>(poolId);
+		auto ptr = allocate<GlEnableiCommand>();
 		ptr->set(target, index);
 		return ptr;
 	}
@@ -394,10 +383,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat factor, GLfloat units)
+	static OpenGlCommand* get(GLfloat factor, GLfloat units)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlPolygonOffsetCommand>(poolId);
+		auto ptr = allocate<GlPolygonOffsetCommand>();
 		ptr->set(factor, units);
 		return ptr;
 	}
@@ -426,10 +414,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint x, GLint y, GLsizei width, GLsizei height)
+	static OpenGlCommand* get(GLint x, GLint y, GLsizei width, GLsizei height)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlScissorCommand>(poolId);
+		auto ptr = allocate<GlScissorCommand>();
 		ptr->set(x, y, width, height);
 		return ptr;
 	}
@@ -462,10 +449,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint x, GLint y, GLsizei width, GLsizei height)
+	static OpenGlCommand* get(GLint x, GLint y, GLsizei width, GLsizei height)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlViewportCommand>(poolId);
+		auto ptr = allocate<GlViewportCommand>();
 		ptr->set(x, y, width, height);
 		return ptr;
 	}
@@ -498,10 +484,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint texture)
+	static OpenGlCommand* get(GLenum target, GLuint texture)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindTextureCommand>(poolId);
+		auto ptr = allocate<GlBindTextureCommand>();
 		ptr->set(target, texture);
 		return ptr;
 	}
@@ -530,11 +515,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+	static OpenGlCommand* get(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
 		GLint border, GLenum format, GLenum type, const PoolBufferPointer& pixels)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexImage2DCommand>(poolId);
+		auto ptr = allocate<GlTexImage2DCommand>();
 		ptr->set(target, level, internalformat, width, height, border, format, type, pixels);
 		return ptr;
 	}
@@ -580,10 +564,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum pname, GLint param)
+	static OpenGlCommand* get(GLenum target, GLenum pname, GLint param)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexParameteriCommand>(poolId);
+		auto ptr = allocate<GlTexParameteriCommand>();
 		ptr->set(target, pname, param);
 		return ptr;
 	}
@@ -614,10 +597,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum pname, GLint* data)
+	static OpenGlCommand* get(GLenum pname, GLint* data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetIntegervCommand>(poolId);
+		auto ptr = allocate<GlGetIntegervCommand>();
 		ptr->set(pname, data);
 		return ptr;
 	}
@@ -646,10 +628,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum name, const GLubyte*& returnValue)
+	static OpenGlCommand* get(GLenum name, const GLubyte*& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetStringCommand>(poolId);
+		auto ptr = allocate<GlGetStringCommand>();
 		ptr->set(name, returnValue);
 		return ptr;
 	}
@@ -678,10 +659,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+	static OpenGlCommand* get(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlReadPixelsCommand>(poolId);
+		auto ptr = allocate<GlReadPixelsCommand>();
 		ptr->set(x, y, width, height, format, type, pixels);
 		return ptr;
 	}
@@ -720,10 +700,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type)
+	static OpenGlCommand* get(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlReadPixelsAsyncCommand>(poolId);
+		auto ptr = allocate<GlReadPixelsAsyncCommand>();
 		ptr->set(x, y, width, height, format, type);
 		return ptr;
 	}
@@ -771,11 +750,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+	static OpenGlCommand* get(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
 		GLenum format, GLenum type, const PoolBufferPointer& pixels)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexSubImage2DUnbufferedCommand>(poolId);
+		auto ptr = allocate<GlTexSubImage2DUnbufferedCommand>();
 		ptr->set(target, level, xoffset, yoffset, width, height, format, type, pixels);
 		return ptr;
 	}
@@ -821,10 +799,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum mode, GLint first, GLsizei count)
+	static OpenGlCommand* get(GLenum mode, GLint first, GLsizei count)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDrawArraysCommand>(poolId);
+		auto ptr = allocate<GlDrawArraysCommand>();
 		ptr->set(mode, first, count);
 		return ptr;
 	}
@@ -985,10 +962,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
+	static OpenGlCommand* get(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlVertexAttribPointerUnbufferedCommand>(poolId);
+		auto ptr = allocate<GlVertexAttribPointerUnbufferedCommand>();
 		ptr->set(index, size, type, normalized, stride, pointer);
 		return ptr;
 	}
@@ -1025,10 +1001,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum mode, GLint first, GLsizei count, const PoolBufferPointer& data)
+	static OpenGlCommand* get(GLenum mode, GLint first, GLsizei count, const PoolBufferPointer& data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDrawArraysUnbufferedCommand>(poolId);
+		auto ptr = allocate<GlDrawArraysUnbufferedCommand>();
 		ptr->set(mode, first, count, data);
 		return ptr;
 	}
@@ -1078,10 +1053,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum& returnValue)
+	static OpenGlCommand* get(GLenum& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetErrorCommand>(poolId);
+		auto ptr = allocate<GlGetErrorCommand>();
 		ptr->set(returnValue);
 		return ptr;
 	}
@@ -1108,11 +1082,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum mode, GLsizei count, GLenum type, const PoolBufferPointer& indices,
+	static OpenGlCommand* get(GLenum mode, GLsizei count, GLenum type, const PoolBufferPointer& indices,
 		const PoolBufferPointer& data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDrawElementsUnbufferedCommand>(poolId);
+		auto ptr = allocate<GlDrawElementsUnbufferedCommand>();
 		ptr->set(mode, count, type, indices, data);
 		return ptr;
 	}
@@ -1165,10 +1138,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat width)
+	static OpenGlCommand* get(GLfloat width)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlLineWidthCommand>(poolId);
+		auto ptr = allocate<GlLineWidthCommand>();
 		ptr->set(width);
 		return ptr;
 	}
@@ -1195,10 +1167,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLbitfield mask)
+	static OpenGlCommand* get(GLbitfield mask)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlClearCommand>(poolId);
+		auto ptr = allocate<GlClearCommand>();
 		ptr->set(mask);
 		return ptr;
 	}
@@ -1225,31 +1196,30 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum buffer, GLint drawbuffer, const PoolBufferPointer& value)
+	static OpenGlCommand* get(GLenum buffer, GLint drawbuffer, const GLfloat* value, int numValues)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlClearBufferfvCommand>(poolId);
-		ptr->set(buffer, drawbuffer, value);
+		auto ptr = allocate<GlClearBufferfvCommand>();
+		ptr->set(buffer, drawbuffer, value, numValues);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrClearBufferfv(m_buffer, m_drawbuffer, reinterpret_cast<const GLfloat*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_value)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_value);
+		ptrClearBufferfv(m_buffer, m_drawbuffer, reinterpret_cast<const GLfloat*>(m_value.get()));
+		m_value.release();
 	}
 
 private:
-	void set(GLenum buffer, GLint drawbuffer, const PoolBufferPointer& value)
+	void set(GLenum buffer, GLint drawbuffer, const GLfloat* value, int numValues)
 	{
 		m_buffer = buffer;
 		m_drawbuffer = drawbuffer;
-		m_value = value;
+		m_value.set(value, numValues * sizeof(GLfloat));
 	}
 
 	GLenum m_buffer;
 	GLint m_drawbuffer;
-	PoolBufferPointer m_value;
+	CommandPayload m_value;
 };
 
 class GlGetFloatvCommand : public OpenGlCommand
@@ -1260,10 +1230,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum pname, GLfloat* data)
+	static OpenGlCommand* get(GLenum pname, GLfloat* data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetFloatvCommand>(poolId);
+		auto ptr = allocate<GlGetFloatvCommand>();
 		ptr->set(pname, data);
 		return ptr;
 	}
@@ -1292,29 +1261,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& textures)
+	static OpenGlCommand* get(GLsizei n, const GLuint* textures)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteTexturesCommand>(poolId);
+		auto ptr = allocate<GlDeleteTexturesCommand>();
 		ptr->set(n, textures);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDeleteTextures(m_n, reinterpret_cast<const GLuint*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_textures)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_textures);
+		ptrDeleteTextures(m_n, reinterpret_cast<const GLuint*>(m_textures.get()));
+		m_textures.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& textures)
+	void set(GLsizei n, const GLuint* textures)
 	{
 		m_n = n;
-		m_textures = textures;
+		m_textures.set(textures, n * sizeof(GLuint));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_textures;
+	CommandPayload m_textures;
 };
 
 class GlGenTexturesCommand : public OpenGlCommand
@@ -1325,10 +1293,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* textures)
+	static OpenGlCommand* get(GLsizei n, GLuint* textures)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGenTexturesCommand>(poolId);
+		auto ptr = allocate<GlGenTexturesCommand>();
 		ptr->set(n, textures);
 		return ptr;
 	}
@@ -1357,10 +1324,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum pname, GLfloat param)
+	static OpenGlCommand* get(GLenum target, GLenum pname, GLfloat param)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexParameterfCommand>(poolId);
+		auto ptr = allocate<GlTexParameterfCommand>();
 		ptr->set(target, pname, param);
 		return ptr;
 	}
@@ -1391,10 +1357,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum texture)
+	static OpenGlCommand* get(GLenum texture)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlActiveTextureCommand>(poolId);
+		auto ptr = allocate<GlActiveTextureCommand>();
 		ptr->set(texture);
 		return ptr;
 	}
@@ -1421,10 +1386,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+	static OpenGlCommand* get(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBlendColorCommand>(poolId);
+		auto ptr = allocate<GlBlendColorCommand>();
 		ptr->set(red, green, blue, alpha);
 		return ptr;
 	}
@@ -1457,10 +1421,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum src)
+	static OpenGlCommand* get(GLenum src)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlReadBufferCommand>(poolId);
+		auto ptr = allocate<GlReadBufferCommand>();
 		ptr->set(src);
 		return ptr;
 	}
@@ -1487,10 +1450,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum type, GLuint& returnValue)
+	static OpenGlCommand* get(GLenum type, GLuint& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCreateShaderCommand>(poolId);
+		auto ptr = allocate<GlCreateShaderCommand>();
 		ptr->set(type, returnValue);
 		return ptr;
 	}
@@ -1519,10 +1481,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint shader)
+	static OpenGlCommand* get(GLuint shader)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCompileShaderCommand>(poolId);
+		auto ptr = allocate<GlCompileShaderCommand>();
 		ptr->set(shader);
 		return ptr;
 	}
@@ -1549,10 +1510,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint shader, std::vector<std::string>& strings)
+	static OpenGlCommand* get(GLuint shader, std::vector<std::string>& strings)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlShaderSourceCommand>(poolId);
+		auto ptr = allocate<GlShaderSourceCommand>();
 		ptr->set(shader, strings);
 		return ptr;
 	}
@@ -1586,10 +1546,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint& returnValue)
+	static OpenGlCommand* get(GLuint& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCreateProgramCommand>(poolId);
+		auto ptr = allocate<GlCreateProgramCommand>();
 		ptr->set(returnValue);
 		return ptr;
 	}
@@ -1616,10 +1575,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLuint shader)
+	static OpenGlCommand* get(GLuint program, GLuint shader)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlAttachShaderCommand>(poolId);
+		auto ptr = allocate<GlAttachShaderCommand>();
 		ptr->set(program, shader);
 		return ptr;
 	}
@@ -1648,10 +1606,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program)
+	static OpenGlCommand* get(GLuint program)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlLinkProgramCommand>(poolId);
+		auto ptr = allocate<GlLinkProgramCommand>();
 		ptr->set(program);
 		return ptr;
 	}
@@ -1678,10 +1635,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program)
+	static OpenGlCommand* get(GLuint program)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUseProgramCommand>(poolId);
+		auto ptr = allocate<GlUseProgramCommand>();
 		ptr->set(program);
 		return ptr;
 	}
@@ -1708,10 +1664,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, const GLchar* name, GLint& returnValue)
+	static OpenGlCommand* get(GLuint program, const GLchar* name, GLint& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetUniformLocationCommand>(poolId);
+		auto ptr = allocate<GlGetUniformLocationCommand>();
 		ptr->set(program, name, returnValue);
 		return ptr;
 	}
@@ -1742,10 +1697,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLint v0)
+	static OpenGlCommand* get(GLint location, GLint v0)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform1iCommand>(poolId);
+		auto ptr = allocate<GlUniform1iCommand>();
 		ptr->set(location, v0);
 		return ptr;
 	}
@@ -1774,10 +1728,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLfloat v0)
+	static OpenGlCommand* get(GLint location, GLfloat v0)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform1fCommand>(poolId);
+		auto ptr = allocate<GlUniform1fCommand>();
 		ptr->set(location, v0);
 		return ptr;
 	}
@@ -1806,10 +1759,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLfloat v0, GLfloat v1)
+	static OpenGlCommand* get(GLint location, GLfloat v0, GLfloat v1)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform2fCommand>(poolId);
+		auto ptr = allocate<GlUniform2fCommand>();
 		ptr->set(location, v0, v1);
 		return ptr;
 	}
@@ -1841,10 +1793,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLint v0, GLint v1)
+	static OpenGlCommand* get(GLint location, GLint v0, GLint v1)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform2iCommand>(poolId);
+		auto ptr = allocate<GlUniform2iCommand>();
 		ptr->set(location, v0, v1);
 		return ptr;
 	}
@@ -1875,10 +1826,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
+	static OpenGlCommand* get(GLint location, GLint v0, GLint v1, GLint v2, GLint v3)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform4iCommand>(poolId);
+		auto ptr = allocate<GlUniform4iCommand>();
 		ptr->set(location, v0, v1, v2, v3);
 		return ptr;
 	}
@@ -1913,10 +1863,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+	static OpenGlCommand* get(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform4fCommand>(poolId);
+		auto ptr = allocate<GlUniform4fCommand>();
 		ptr->set(location, v0, v1, v2, v3);
 		return ptr;
 	}
@@ -1951,31 +1900,30 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLsizei count, const PoolBufferPointer& value)
+	static OpenGlCommand* get(GLint location, GLsizei count, const GLfloat* value)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform3fvCommand>(poolId);
+		auto ptr = allocate<GlUniform3fvCommand>();
 		ptr->set(location, count, value);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrUniform3fv(m_location, m_count, reinterpret_cast<const GLfloat*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_value)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_value);
+		ptrUniform3fv(m_location, m_count, reinterpret_cast<const GLfloat*>(m_value.get()));
+		m_value.release();
 	}
 
 private:
-	void set(GLint location, GLsizei count, const PoolBufferPointer& value)
+	void set(GLint location, GLsizei count, const GLfloat* value)
 	{
 		m_location = location;
 		m_count = count;
-		m_value = value;
+		m_value.set(value, 3 * sizeof(GLfloat) * count);
 	}
 
 	GLint m_location;
 	GLsizei m_count;
-	PoolBufferPointer m_value;
+	CommandPayload m_value;
 };
 
 class GlUniform4fvCommand : public OpenGlCommand
@@ -1986,31 +1934,30 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint location, GLsizei count, const PoolBufferPointer& value)
+	static OpenGlCommand* get(GLint location, GLsizei count, const GLfloat* value)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniform4fvCommand>(poolId);
+		auto ptr = allocate<GlUniform4fvCommand>();
 		ptr->set(location, count, value);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrUniform4fv(m_location, m_count, reinterpret_cast<const GLfloat*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_value)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_value);
+		ptrUniform4fv(m_location, m_count, reinterpret_cast<const GLfloat*>(m_value.get()));
+		m_value.release();
 	}
 
 private:
-	void set(GLint location, GLsizei count, const PoolBufferPointer& value)
+	void set(GLint location, GLsizei count, const GLfloat* value)
 	{
 		m_location = location;
 		m_count = count;
-		m_value = value;
+		m_value.set(value, 4 * sizeof(GLfloat) * count);
 	}
 
 	GLint m_location;
 	GLsizei m_count;
-	PoolBufferPointer m_value;
+	CommandPayload m_value;
 };
 
 class GlDetachShaderCommand : public OpenGlCommand
@@ -2021,10 +1968,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLuint shader)
+	static OpenGlCommand* get(GLuint program, GLuint shader)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDetachShaderCommand>(poolId);
+		auto ptr = allocate<GlDetachShaderCommand>();
 		ptr->set(program, shader);
 		return ptr;
 	}
@@ -2053,10 +1999,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint shader)
+	static OpenGlCommand* get(GLuint shader)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteShaderCommand>(poolId);
+		auto ptr = allocate<GlDeleteShaderCommand>();
 		ptr->set(shader);
 		return ptr;
 	}
@@ -2083,10 +2028,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program)
+	static OpenGlCommand* get(GLuint program)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteProgramCommand>(poolId);
+		auto ptr = allocate<GlDeleteProgramCommand>();
 		ptr->set(program);
 		return ptr;
 	}
@@ -2113,10 +2057,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+	static OpenGlCommand* get(GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetProgramInfoLogCommand>(poolId);
+		auto ptr = allocate<GlGetProgramInfoLogCommand>();
 		ptr->set(program, bufSize, length, infoLog);
 		return ptr;
 	}
@@ -2149,10 +2092,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+	static OpenGlCommand* get(GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetShaderInfoLogCommand>(poolId);
+		auto ptr = allocate<GlGetShaderInfoLogCommand>();
 		ptr->set(shader, bufSize, length, infoLog);
 		return ptr;
 	}
@@ -2185,10 +2127,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint shader, GLenum pname, GLint* params)
+	static OpenGlCommand* get(GLuint shader, GLenum pname, GLint* params)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetShaderivCommand>(poolId);
+		auto ptr = allocate<GlGetShaderivCommand>();
 		ptr->set(shader, pname, params);
 		return ptr;
 	}
@@ -2219,10 +2160,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLenum pname, GLint*& params)
+	static OpenGlCommand* get(GLuint program, GLenum pname, GLint*& params)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetProgramivCommand>(poolId);
+		auto ptr = allocate<GlGetProgramivCommand>();
 		ptr->set(program, pname, params);
 		return ptr;
 	}
@@ -2253,10 +2193,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index)
+	static OpenGlCommand* get(GLuint index)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlEnableVertexAttribArrayCommand>(poolId);
+		auto ptr = allocate<GlEnableVertexAttribArrayCommand>();
 		ptr->set(index);
 		return ptr;
 	}
@@ -2284,10 +2223,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index)
+	static OpenGlCommand* get(GLuint index)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDisableVertexAttribArrayCommand>(poolId);
+		auto ptr = allocate<GlDisableVertexAttribArrayCommand>();
 		ptr->set(index);
 		return ptr;
 	}
@@ -2315,11 +2253,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+	static OpenGlCommand* get(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
 		const GLvoid* offset)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlVertexAttribPointerBufferedCommand>(poolId);
+		auto ptr = allocate<GlVertexAttribPointerBufferedCommand>();
 		ptr->set(index, size, type, normalized, stride, offset);
 		return ptr;
 	}
@@ -2357,10 +2294,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLuint index, const std::string name)
+	static OpenGlCommand* get(GLuint program, GLuint index, const std::string name)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindAttribLocationCommand>(poolId);
+		auto ptr = allocate<GlBindAttribLocationCommand>();
 		ptr->set(program, index, name);
 		return ptr;
 	}
@@ -2391,10 +2327,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index, GLfloat x)
+	static OpenGlCommand* get(GLuint index, GLfloat x)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlVertexAttrib1fCommand>(poolId);
+		auto ptr = allocate<GlVertexAttrib1fCommand>();
 		ptr->set(index, x);
 		return ptr;
 	}
@@ -2423,10 +2358,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+	static OpenGlCommand* get(GLuint index, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlVertexAttrib4fCommand>(poolId);
+		auto ptr = allocate<GlVertexAttrib4fCommand>();
 		ptr->set(index, x, y, z, w);
 		return ptr;
 	}
@@ -2461,29 +2395,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint index, const PoolBufferPointer& v)
+	static OpenGlCommand* get(GLuint index, const GLfloat* v)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlVertexAttrib4fvCommand>(poolId);
+		auto ptr = allocate<GlVertexAttrib4fvCommand>();
 		ptr->set(index, v);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrVertexAttrib4fv(m_index, reinterpret_cast<const GLfloat*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_v)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_v);
+		ptrVertexAttrib4fv(m_index, reinterpret_cast<const GLfloat*>(m_v.get()));
+		m_v.release();
 	}
 
 private:
-	void set(GLuint index, const PoolBufferPointer& v)
+	void set(GLuint index, const GLfloat* v)
 	{
 		m_index = index;
-		m_v = v;
+		m_v.set(v, 4 * sizeof(GLfloat));
 	}
 
 	GLuint m_index;
-	PoolBufferPointer m_v;
+	CommandPayload m_v;
 };
 
 class GlDepthRangefCommand : public OpenGlCommand
@@ -2494,10 +2427,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat n, GLfloat f)
+	static OpenGlCommand* get(GLfloat n, GLfloat f)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDepthRangefCommand>(poolId);
+		auto ptr = allocate<GlDepthRangefCommand>();
 		ptr->set(n, f);
 		return ptr;
 	}
@@ -2526,10 +2458,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLfloat d)
+	static OpenGlCommand* get(GLfloat d)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlClearDepthfCommand>(poolId);
+		auto ptr = allocate<GlClearDepthfCommand>();
 		ptr->set(d);
 		return ptr;
 	}
@@ -2556,29 +2487,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& bufs)
+	static OpenGlCommand* get(GLsizei n, const GLenum* bufs)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDrawBuffersCommand>(poolId);
+		auto ptr = allocate<GlDrawBuffersCommand>();
 		ptr->set(n, bufs);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDrawBuffers(m_n, reinterpret_cast<const GLenum*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_bufs)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_bufs);
+		ptrDrawBuffers(m_n, reinterpret_cast<const GLenum*>(m_bufs.get()));
+		m_bufs.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& bufs)
+	void set(GLsizei n, const GLenum* bufs)
 	{
 		m_n = n;
-		m_bufs = bufs;
+		m_bufs.set(bufs, n * sizeof(GLenum));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_bufs;
+	CommandPayload m_bufs;
 };
 
 class GlGenFramebuffersCommand : public OpenGlCommand
@@ -2589,10 +2519,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* framebuffers)
+	static OpenGlCommand* get(GLsizei n, GLuint* framebuffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGenFramebuffersCommand>(poolId);
+		auto ptr = allocate<GlGenFramebuffersCommand>();
 		ptr->set(n, framebuffers);
 		return ptr;
 	}
@@ -2621,10 +2550,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint framebuffer)
+	static OpenGlCommand* get(GLenum target, GLuint framebuffer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindFramebufferCommand>(poolId);
+		auto ptr = allocate<GlBindFramebufferCommand>();
 		ptr->set(target, framebuffer);
 		return ptr;
 	}
@@ -2653,29 +2581,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& framebuffers)
+	static OpenGlCommand* get(GLsizei n, const GLuint* framebuffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteFramebuffersCommand>(poolId);
+		auto ptr = allocate<GlDeleteFramebuffersCommand>();
 		ptr->set(n, framebuffers);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDeleteFramebuffers(m_n, reinterpret_cast<const GLuint*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_framebuffers)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_framebuffers);
+		ptrDeleteFramebuffers(m_n, reinterpret_cast<const GLuint*>(m_framebuffers.get()));
+		m_framebuffers.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& framebuffers)
+	void set(GLsizei n, const GLuint* framebuffers)
 	{
 		m_n = n;
-		m_framebuffers = framebuffers;
+		m_framebuffers.set(framebuffers, n * sizeof(GLuint));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_framebuffers;
+	CommandPayload m_framebuffers;
 };
 
 class GlFramebufferTexture2DCommand : public OpenGlCommand
@@ -2686,10 +2613,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
+	static OpenGlCommand* get(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlFramebufferTexture2DCommand>(poolId);
+		auto ptr = allocate<GlFramebufferTexture2DCommand>();
 		ptr->set(target, attachment, textarget, texture, level);
 		return ptr;
 	}
@@ -2724,11 +2650,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width,
+	static OpenGlCommand* get(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width,
 		GLsizei height, GLboolean fixedsamplelocations)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexImage2DMultisampleCommand>(poolId);
+		auto ptr = allocate<GlTexImage2DMultisampleCommand>();
 		ptr->set(target, samples, internalformat, width, height, fixedsamplelocations);
 		return ptr;
 	}
@@ -2766,11 +2691,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width,
+	static OpenGlCommand* get(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width,
 		GLsizei height, GLboolean fixedsamplelocations)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexStorage2DMultisampleCommand>(poolId);
+		auto ptr = allocate<GlTexStorage2DMultisampleCommand>();
 		ptr->set(target, samples, internalformat, width, height, fixedsamplelocations);
 		return ptr;
 	}
@@ -2808,10 +2732,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* renderbuffers)
+	static OpenGlCommand* get(GLsizei n, GLuint* renderbuffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGenRenderbuffersCommand>(poolId);
+		auto ptr = allocate<GlGenRenderbuffersCommand>();
 		ptr->set(n, renderbuffers);
 		return ptr;
 	}
@@ -2840,10 +2763,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint renderbuffer)
+	static OpenGlCommand* get(GLenum target, GLuint renderbuffer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindRenderbufferCommand>(poolId);
+		auto ptr = allocate<GlBindRenderbufferCommand>();
 		ptr->set(target, renderbuffer);
 		return ptr;
 	}
@@ -2872,10 +2794,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
+	static OpenGlCommand* get(GLenum target, GLenum internalformat, GLsizei width, GLsizei height)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlRenderbufferStorageCommand>(poolId);
+		auto ptr = allocate<GlRenderbufferStorageCommand>();
 		ptr->set(target, internalformat, width, height);
 		return ptr;
 	}
@@ -2908,29 +2829,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& renderbuffers)
+	static OpenGlCommand* get(GLsizei n, const GLuint* renderbuffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteRenderbuffersCommand>(poolId);
+		auto ptr = allocate<GlDeleteRenderbuffersCommand>();
 		ptr->set(n, renderbuffers);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDeleteRenderbuffers(m_n, reinterpret_cast<const GLuint*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_renderbuffers)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_renderbuffers);
+		ptrDeleteRenderbuffers(m_n, reinterpret_cast<const GLuint*>(m_renderbuffers.get()));
+		m_renderbuffers.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& renderbuffers)
+	void set(GLsizei n, const GLuint* renderbuffers)
 	{
 		m_n = n;
-		m_renderbuffers = renderbuffers;
+		m_renderbuffers.set(renderbuffers, n * sizeof(GLuint));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_renderbuffers;
+	CommandPayload m_renderbuffers;
 };
 
 class GlFramebufferRenderbufferCommand : public OpenGlCommand
@@ -2941,10 +2861,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
+	static OpenGlCommand* get(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlFramebufferRenderbufferCommand>(poolId);
+		auto ptr = allocate<GlFramebufferRenderbufferCommand>();
 		ptr->set(target, attachment, renderbuffertarget, renderbuffer);
 		return ptr;
 	}
@@ -2977,10 +2896,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum& returnValue)
+	static OpenGlCommand* get(GLenum target, GLenum& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCheckFramebufferStatusCommand>(poolId);
+		auto ptr = allocate<GlCheckFramebufferStatusCommand>();
 		ptr->set(target, returnValue);
 		return ptr;
 	}
@@ -3009,11 +2927,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0,
+	static OpenGlCommand* get(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0,
 		GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBlitFramebufferCommand>(poolId);
+		auto ptr = allocate<GlBlitFramebufferCommand>();
 		ptr->set(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
 		return ptr;
 	}
@@ -3060,10 +2977,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* arrays)
+	static OpenGlCommand* get(GLsizei n, GLuint* arrays)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGenVertexArraysCommand>(poolId);
+		auto ptr = allocate<GlGenVertexArraysCommand>();
 		ptr->set(n, arrays);
 		return ptr;
 	}
@@ -3092,10 +3008,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint array)
+	static OpenGlCommand* get(GLuint array)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindVertexArrayCommand>(poolId);
+		auto ptr = allocate<GlBindVertexArrayCommand>();
 		ptr->set(array);
 		return ptr;
 	}
@@ -3122,29 +3037,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& arrays)
+	static OpenGlCommand* get(GLsizei n, const GLuint* arrays)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteVertexArraysCommand>(poolId);
+		auto ptr = allocate<GlDeleteVertexArraysCommand>();
 		ptr->set(n, arrays);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDeleteVertexArrays(m_n, reinterpret_cast<const GLuint*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_arrays)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_arrays);
+		ptrDeleteVertexArrays(m_n, reinterpret_cast<const GLuint*>(m_arrays.get()));
+		m_arrays.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& arrays)
+	void set(GLsizei n, const GLuint* arrays)
 	{
 		m_n = n;
-		m_arrays = arrays;
+		m_arrays.set(arrays, n * sizeof(GLuint));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_arrays;
+	CommandPayload m_arrays;
 };
 
 class GlGenBuffersCommand : public OpenGlCommand
@@ -3155,10 +3069,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* buffers)
+	static OpenGlCommand* get(GLsizei n, GLuint* buffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGenBuffersCommand>(poolId);
+		auto ptr = allocate<GlGenBuffersCommand>();
 		ptr->set(n, buffers);
 		return ptr;
 	}
@@ -3187,10 +3100,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint buffer)
+	static OpenGlCommand* get(GLenum target, GLuint buffer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindBufferCommand>(poolId);
+		auto ptr = allocate<GlBindBufferCommand>();
 		ptr->set(target, buffer);
 		return ptr;
 	}
@@ -3238,10 +3150,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizeiptr size, const PoolBufferPointer& data, GLenum usage)
+	static OpenGlCommand* get(GLenum target, GLsizeiptr size, const PoolBufferPointer& data, GLenum usage)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBufferDataCommand>(poolId);
+		auto ptr = allocate<GlBufferDataCommand>();
 		ptr->set(target, size, data, usage);
 		return ptr;
 	}
@@ -3275,10 +3186,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLenum access)
+	static OpenGlCommand* get(GLenum target, GLenum access)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlMapBufferCommand>(poolId);
+		auto ptr = allocate<GlMapBufferCommand>();
 		ptr->set(target, access);
 		return ptr;
 	}
@@ -3307,11 +3217,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access,
+	static OpenGlCommand* get(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access,
 		void*& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlMapBufferRangeCommand>(poolId);
+		auto ptr = allocate<GlMapBufferRangeCommand>();
 		ptr->set(target, offset, length, access, returnValue);
 		return ptr;
 	}
@@ -3347,11 +3256,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLintptr offset, GLsizeiptr length,
+	static OpenGlCommand* get(GLenum target, GLintptr offset, GLsizeiptr length,
 		GLbitfield access, const PoolBufferPointer& data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlMapBufferRangeWriteAsyncCommand>(poolId);
+		auto ptr = allocate<GlMapBufferRangeWriteAsyncCommand>();
 		ptr->set(target, offset, length, access, data);
 		return ptr;
 	}
@@ -3438,11 +3346,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLintptr offset, GLsizeiptr length,
+	static OpenGlCommand* get(GLenum target, GLintptr offset, GLsizeiptr length,
 		GLbitfield access)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlMapBufferRangeReadAsyncCommand>(poolId);
+		auto ptr = allocate<GlMapBufferRangeReadAsyncCommand>();
 		ptr->set(target, offset, length, access);
 		return ptr;
 	}
@@ -3499,10 +3406,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLboolean& returnValue)
+	static OpenGlCommand* get(GLenum target, GLboolean& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUnmapBufferCommand>(poolId);
+		auto ptr = allocate<GlUnmapBufferCommand>();
 		ptr->set(target, returnValue);
 		return ptr;
 	}
@@ -3531,10 +3437,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target)
+	static OpenGlCommand* get(GLenum target)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUnmapBufferAsyncCommand>(poolId);
+		auto ptr = allocate<GlUnmapBufferAsyncCommand>();
 		ptr->set(target);
 		return ptr;
 	}
@@ -3561,29 +3466,28 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, const PoolBufferPointer& buffers)
+	static OpenGlCommand* get(GLsizei n, const GLuint* buffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteBuffersCommand>(poolId);
+		auto ptr = allocate<GlDeleteBuffersCommand>();
 		ptr->set(n, buffers);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrDeleteBuffers(m_n, reinterpret_cast<const GLuint*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_buffers)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_buffers);
+		ptrDeleteBuffers(m_n, reinterpret_cast<const GLuint*>(m_buffers.get()));
+		m_buffers.release();
 	}
 
 private:
-	void set(GLsizei n, const PoolBufferPointer& buffers)
+	void set(GLsizei n, const GLuint* buffers)
 	{
 		m_n = n;
-		m_buffers = buffers;
+		m_buffers.set(buffers, n * sizeof(GLuint));
 	}
 
 	GLsizei m_n;
-	PoolBufferPointer m_buffers;
+	CommandPayload m_buffers;
 };
 
 class GlBindImageTextureCommand : public OpenGlCommand
@@ -3594,11 +3498,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
+	static OpenGlCommand* get(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer,
 		GLenum access, GLenum format)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindImageTextureCommand>(poolId);
+		auto ptr = allocate<GlBindImageTextureCommand>();
 		ptr->set(unit, texture, level, layered, layer, access, format);
 		return ptr;
 	}
@@ -3638,10 +3541,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLbitfield barriers)
+	static OpenGlCommand* get(GLbitfield barriers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlMemoryBarrierCommand>(poolId);
+		auto ptr = allocate<GlMemoryBarrierCommand>();
 		ptr->set(barriers);
 		return ptr;
 	}
@@ -3668,10 +3570,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get()
+	static OpenGlCommand* get()
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureBarrierCommand>(poolId);
+		auto ptr = allocate<GlTextureBarrierCommand>();
 		ptr->set();
 		return ptr;
 	}
@@ -3695,10 +3596,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get()
+	static OpenGlCommand* get()
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureBarrierNVCommand>(poolId);
+		auto ptr = allocate<GlTextureBarrierNVCommand>();
 		ptr->set();
 		return ptr;
 	}
@@ -3722,10 +3622,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum name, GLuint index, const GLubyte*& returnValue)
+	static OpenGlCommand* get(GLenum name, GLuint index, const GLubyte*& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetStringiCommand>(poolId);
+		auto ptr = allocate<GlGetStringiCommand>();
 		ptr->set(name, index, returnValue);
 		return ptr;
 	}
@@ -3756,31 +3655,30 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizei numAttachments, const PoolBufferPointer& attachments)
+	static OpenGlCommand* get(GLenum target, GLsizei numAttachments, const GLenum* attachments)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlInvalidateFramebufferCommand>(poolId);
+		auto ptr = allocate<GlInvalidateFramebufferCommand>();
 		ptr->set(target, numAttachments, attachments);
 		return ptr;
 	}
 
 	void commandToExecute() override
 	{
-		ptrInvalidateFramebuffer(m_target, m_numAttachments, reinterpret_cast<const GLenum*>(OpenGlCommand::m_ringBufferPool.getBufferFromPool(m_attachments)));
-		OpenGlCommand::m_ringBufferPool.removeBufferFromPool(m_attachments);
+		ptrInvalidateFramebuffer(m_target, m_numAttachments, reinterpret_cast<const GLenum*>(m_attachments.get()));
+		m_attachments.release();
 	}
 
 private:
-	void set(GLenum target, GLsizei numAttachments, const PoolBufferPointer& attachments)
+	void set(GLenum target, GLsizei numAttachments, const GLenum* attachments)
 	{
 		m_target = target;
 		m_numAttachments = numAttachments;
-		m_attachments = attachments;
+		m_attachments.set(attachments, numAttachments * sizeof(GLenum));
 	}
 
 	GLenum m_target;
 	GLsizei m_numAttachments;
-	PoolBufferPointer m_attachments;
+	CommandPayload m_attachments;
 };
 
 class GlBufferStorageCommand : public OpenGlCommand
@@ -3791,10 +3689,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizeiptr size, const PoolBufferPointer& data, GLbitfield flags)
+	static OpenGlCommand* get(GLenum target, GLsizeiptr size, const PoolBufferPointer& data, GLbitfield flags)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBufferStorageCommand>(poolId);
+		auto ptr = allocate<GlBufferStorageCommand>();
 		ptr->set(target, size, data, flags);
 		return ptr;
 	}
@@ -3828,10 +3725,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum condition, GLbitfield flags, GLsync& returnValue)
+	static OpenGlCommand* get(GLenum condition, GLbitfield flags, GLsync& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlFenceSyncCommand>(poolId);
+		auto ptr = allocate<GlFenceSyncCommand>();
 		ptr->set(condition, flags, returnValue);
 		return ptr;
 	}
@@ -3862,10 +3758,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsync sync, GLbitfield flags, GLuint64 timeout)
+	static OpenGlCommand* get(GLsync sync, GLbitfield flags, GLuint64 timeout)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlClientWaitSyncCommand>(poolId);
+		auto ptr = allocate<GlClientWaitSyncCommand>();
 		ptr->set(sync, flags, timeout);
 		return ptr;
 	}
@@ -3896,10 +3791,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsync sync)
+	static OpenGlCommand* get(GLsync sync)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDeleteSyncCommand>(poolId);
+		auto ptr = allocate<GlDeleteSyncCommand>();
 		ptr->set(sync);
 		return ptr;
 	}
@@ -3926,10 +3820,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, const GLchar* uniformBlockName, GLuint& returnValue)
+	static OpenGlCommand* get(GLuint program, const GLchar* uniformBlockName, GLuint& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetUniformBlockIndexCommand>(poolId);
+		auto ptr = allocate<GlGetUniformBlockIndexCommand>();
 		ptr->set(program, uniformBlockName, returnValue);
 		return ptr;
 	}
@@ -3960,10 +3853,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+	static OpenGlCommand* get(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlUniformBlockBindingCommand>(poolId);
+		auto ptr = allocate<GlUniformBlockBindingCommand>();
 		ptr->set(program, uniformBlockIndex, uniformBlockBinding);
 		return ptr;
 	}
@@ -3994,10 +3886,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params)
+	static OpenGlCommand* get(GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetActiveUniformBlockivCommand>(poolId);
+		auto ptr = allocate<GlGetActiveUniformBlockivCommand>();
 		ptr->set(program, uniformBlockIndex, pname, params);
 		return ptr;
 	}
@@ -4030,11 +3921,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLsizei uniformCount, const GLchar* const* uniformNames,
+	static OpenGlCommand* get(GLuint program, GLsizei uniformCount, const GLchar* const* uniformNames,
 		GLuint* uniformIndices)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetUniformIndicesCommand>(poolId);
+		auto ptr = allocate<GlGetUniformIndicesCommand>();
 		ptr->set(program, uniformCount, uniformNames, uniformIndices);
 		return ptr;
 	}
@@ -4068,11 +3958,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname,
+	static OpenGlCommand* get(GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname,
 		GLint* params)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetActiveUniformsivCommand>(poolId);
+		auto ptr = allocate<GlGetActiveUniformsivCommand>();
 		ptr->set(program, uniformCount, uniformIndices, pname, params);
 		return ptr;
 	}
@@ -4108,10 +3997,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLuint index, GLuint buffer)
+	static OpenGlCommand* get(GLenum target, GLuint index, GLuint buffer)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBindBufferBaseCommand>(poolId);
+		auto ptr = allocate<GlBindBufferBaseCommand>();
 		ptr->set(target, index, buffer);
 		return ptr;
 	}
@@ -4142,10 +4030,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLintptr offset, GLsizeiptr size, const PoolBufferPointer& data)
+	static OpenGlCommand* get(GLenum target, GLintptr offset, GLsizeiptr size, const PoolBufferPointer& data)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlBufferSubDataCommand>(poolId);
+		auto ptr = allocate<GlBufferSubDataCommand>();
 		ptr->set(target, offset, size, data);
 		return ptr;
 	}
@@ -4179,10 +4066,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+	static OpenGlCommand* get(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlGetProgramBinaryCommand>(poolId);
+		auto ptr = allocate<GlGetProgramBinaryCommand>();
 		ptr->set(program, bufSize, length, binaryFormat, binary);
 		return ptr;
 	}
@@ -4217,10 +4103,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLenum binaryFormat, const PoolBufferPointer& binary, GLsizei length)
+	static OpenGlCommand* get(GLuint program, GLenum binaryFormat, const PoolBufferPointer& binary, GLsizei length)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlProgramBinaryCommand>(poolId);
+		auto ptr = allocate<GlProgramBinaryCommand>();
 		ptr->set(program, binaryFormat, binary, length);
 		return ptr;
 	}
@@ -4254,10 +4139,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint program, GLenum pname, GLint value)
+	static OpenGlCommand* get(GLuint program, GLenum pname, GLint value)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlProgramParameteriCommand>(poolId);
+		auto ptr = allocate<GlProgramParameteriCommand>();
 		ptr->set(program, pname, value);
 		return ptr;
 	}
@@ -4288,10 +4172,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
+	static OpenGlCommand* get(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTexStorage2DCommand>(poolId);
+		auto ptr = allocate<GlTexStorage2DCommand>();
 		ptr->set(target, levels, internalformat, width, height);
 		return ptr;
 	}
@@ -4326,10 +4209,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
+	static OpenGlCommand* get(GLuint texture, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureStorage2DCommand>(poolId);
+		auto ptr = allocate<GlTextureStorage2DCommand>();
 		ptr->set(texture, levels, internalformat, width, height);
 		return ptr;
 	}
@@ -4364,11 +4246,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+	static OpenGlCommand* get(GLuint texture, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
 		GLsizei height, GLenum format, GLenum type, const PoolBufferPointer& pixels)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureSubImage2DUnbufferedCommand>(poolId);
+		auto ptr = allocate<GlTextureSubImage2DUnbufferedCommand>();
 		ptr->set(texture, level, xoffset, yoffset, width, height, format, type, pixels);
 		return ptr;
 	}
@@ -4414,11 +4295,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLenum target, GLsizei samples, GLenum internalformat,
+	static OpenGlCommand* get(GLuint texture, GLenum target, GLsizei samples, GLenum internalformat,
 		GLsizei width, GLsizei height, GLboolean fixedsamplelocations)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureStorage2DMultisampleCommand>(poolId);
+		auto ptr = allocate<GlTextureStorage2DMultisampleCommand>();
 		ptr->set(texture, target, samples, internalformat, width, height, fixedsamplelocations);
 		return ptr;
 	}
@@ -4459,10 +4339,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLenum pname, GLint param)
+	static OpenGlCommand* get(GLuint texture, GLenum pname, GLint param)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureParameteriCommand>(poolId);
+		auto ptr = allocate<GlTextureParameteriCommand>();
 		ptr->set(texture, pname, param);
 		return ptr;
 	}
@@ -4493,10 +4372,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint texture, GLenum pname, GLfloat param)
+	static OpenGlCommand* get(GLuint texture, GLenum pname, GLfloat param)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlTextureParameterfCommand>(poolId);
+		auto ptr = allocate<GlTextureParameterfCommand>();
 		ptr->set(texture, pname, param);
 		return ptr;
 	}
@@ -4527,10 +4405,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLsizei n, GLuint* textures)
+	static OpenGlCommand* get(GLenum target, GLsizei n, GLuint* textures)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCreateTexturesCommand>(poolId);
+		auto ptr = allocate<GlCreateTexturesCommand>();
 		ptr->set(target, n, textures);
 		return ptr;
 	}
@@ -4561,10 +4438,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* buffers)
+	static OpenGlCommand* get(GLsizei n, GLuint* buffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCreateBuffersCommand>(poolId);
+		auto ptr = allocate<GlCreateBuffersCommand>();
 		ptr->set(n, buffers);
 		return ptr;
 	}
@@ -4593,10 +4469,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLsizei n, GLuint* framebuffers)
+	static OpenGlCommand* get(GLsizei n, GLuint* framebuffers)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCreateFramebuffersCommand>(poolId);
+		auto ptr = allocate<GlCreateFramebuffersCommand>();
 		ptr->set(n, framebuffers);
 		return ptr;
 	}
@@ -4625,10 +4500,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
+	static OpenGlCommand* get(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlNamedFramebufferTextureCommand>(poolId);
+		auto ptr = allocate<GlNamedFramebufferTextureCommand>();
 		ptr->set(framebuffer, attachment, texture, level);
 		return ptr;
 	}
@@ -4661,11 +4535,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type,
+	static OpenGlCommand* get(GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type,
 		const u16* indices, GLint basevertex)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDrawRangeElementsBaseVertexCommand>(poolId);
+		auto ptr = allocate<GlDrawRangeElementsBaseVertexCommand>();
 		ptr->set(mode, start, end, count, type, indices, basevertex);
 		return ptr;
 	}
@@ -4705,10 +4578,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLintptr offset, GLsizeiptr length)
+	static OpenGlCommand* get(GLenum target, GLintptr offset, GLsizeiptr length)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlFlushMappedBufferRangeCommand>(poolId);
+		auto ptr = allocate<GlFlushMappedBufferRangeCommand>();
 		ptr->set(target, offset, length);
 		return ptr;
 	}
@@ -4739,10 +4611,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get()
+	static OpenGlCommand* get()
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlFinishCommand>(poolId);
+		auto ptr = allocate<GlFinishCommand>();
 		ptr->set();
 		return ptr;
 	}
@@ -4767,10 +4638,9 @@ public:
     {
     }
 
-    static std::shared_ptr<OpenGlCommand> get()
+    static OpenGlCommand* get()
     {
-        static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-        auto ptr = getFromPool<GlFlushCommand>(poolId);
+        auto ptr = allocate<GlFlushCommand>();
         ptr->set();
         return ptr;
     }
@@ -4795,10 +4665,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
+	static OpenGlCommand* get(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlCopyTexImage2DCommand>(poolId);
+		auto ptr = allocate<GlCopyTexImage2DCommand>();
 		ptr->set(target, level, internalformat, x, y, width, height, border);
 		return ptr;
 	}
@@ -4831,6 +4700,35 @@ private:
 	GLint m_border;
 };
 
+class GlMaxShaderCompilerThreadsKHRCommand : public OpenGlCommand
+{
+public:
+	GlMaxShaderCompilerThreadsKHRCommand() :
+			OpenGlCommand(false, false, "glMaxShaderCompilerThreadsKHR")
+	{
+	}
+
+	static OpenGlCommand* get(GLuint count)
+	{
+		auto ptr = allocate<GlMaxShaderCompilerThreadsKHRCommand>();
+		ptr->set(count);
+		return ptr;
+	}
+
+	void commandToExecute() override
+	{
+		ptrMaxShaderCompilerThreadsKHR(m_count);
+	}
+
+private:
+	void set(GLuint count)
+	{
+		m_count = count;
+	}
+
+	GLuint m_count;
+};
+
 class GlDebugMessageCallbackCommand : public OpenGlCommand
 {
 	public:
@@ -4839,10 +4737,9 @@ class GlDebugMessageCallbackCommand : public OpenGlCommand
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLDEBUGPROC callback, const void *userParam)
+	static OpenGlCommand* get(GLDEBUGPROC callback, const void *userParam)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDebugMessageCallbackCommand>(poolId);
+		auto ptr = allocate<GlDebugMessageCallbackCommand>();
 		ptr->set(callback, userParam);
 		return ptr;
 	}
@@ -4871,10 +4768,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled)
+	static OpenGlCommand* get(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlDebugMessageControlCommand>(poolId);
+		auto ptr = allocate<GlDebugMessageControlCommand>();
 		ptr->set(source, type, severity, count, ids, enabled);
 		return ptr;
 	}
@@ -4911,10 +4807,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, void* image)
+	static OpenGlCommand* get(GLenum target, void* image)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlEGLImageTargetTexture2DOESCommand>(poolId);
+		auto ptr = allocate<GlEGLImageTargetTexture2DOESCommand>();
 		ptr->set(target, image);
 		return ptr;
 	}
@@ -4943,10 +4838,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(GLenum target, void* image)
+	static OpenGlCommand* get(GLenum target, void* image)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<GlEGLImageTargetRenderbufferStorageOESCommand>(poolId);
+		auto ptr = allocate<GlEGLImageTargetRenderbufferStorageOESCommand>();
 		ptr->set(target, image);
 		return ptr;
 	}
@@ -4975,10 +4869,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get()
+	static OpenGlCommand* get()
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<ShutdownCommand>(poolId);
+		auto ptr = allocate<ShutdownCommand>();
 		return ptr;
 	}
 
@@ -5007,10 +4900,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(const AHardwareBuffer *buffer, EGLClientBuffer& returnValue)
+	static OpenGlCommand* get(const AHardwareBuffer *buffer, EGLClientBuffer& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<EglGetNativeClientBufferANDROIDCommand>(poolId);
+		auto ptr = allocate<EglGetNativeClientBufferANDROIDCommand>();
 		ptr->set(buffer, returnValue);
 		return ptr;
 	}
@@ -5041,10 +4933,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(m64p_error& returnValue)
+	static OpenGlCommand* get(m64p_error& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoInitCommand>(poolId);
+		auto ptr = allocate<CoreVideoInitCommand>();
 		ptr->set(returnValue);
 		return ptr;
 	}
@@ -5072,10 +4963,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get()
+	static OpenGlCommand* get()
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoQuitCommand>(poolId);
+		auto ptr = allocate<CoreVideoQuitCommand>();
 		ptr->set();
 		return ptr;
 	}
@@ -5101,11 +4991,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(int screenWidth, int screenHeight, int bitsPerPixel, m64p_video_mode mode,
+	static OpenGlCommand* get(int screenWidth, int screenHeight, int bitsPerPixel, m64p_video_mode mode,
 		m64p_video_flags flags, m64p_error& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoSetVideoModeCommand>(poolId);
+		auto ptr = allocate<CoreVideoSetVideoModeCommand>();
 		ptr->set(screenWidth, screenHeight, bitsPerPixel, mode, flags, returnValue);
 		return ptr;
 	}
@@ -5150,11 +5039,10 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(int screenWidth, int screenHeight, int refreshRate, int bitsPerPixel, m64p_video_mode mode,
+	static OpenGlCommand* get(int screenWidth, int screenHeight, int refreshRate, int bitsPerPixel, m64p_video_mode mode,
 		m64p_video_flags flags, m64p_error& returnValue)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoSetVideoModeWithRateCommand>(poolId);
+		auto ptr = allocate<CoreVideoSetVideoModeWithRateCommand>();
 		ptr->set(screenWidth, screenHeight, refreshRate, bitsPerPixel, mode, flags, returnValue);
 		return ptr;
 	}
@@ -5201,10 +5089,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(m64p_GLattr attribute, int value)
+	static OpenGlCommand* get(m64p_GLattr attribute, int value)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoGLSetAttributeCommand>(poolId);
+		auto ptr = allocate<CoreVideoGLSetAttributeCommand>();
 		ptr->set(attribute, value);
 		return ptr;
 	}
@@ -5235,10 +5122,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(m64p_GLattr attribute, int* value)
+	static OpenGlCommand* get(m64p_GLattr attribute, int* value)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoGLGetAttributeCommand>(poolId);
+		auto ptr = allocate<CoreVideoGLGetAttributeCommand>();
 		ptr->set(attribute, value);
 		return ptr;
 	}
@@ -5269,10 +5155,9 @@ public:
 	{
 	}
 
-	static std::shared_ptr<OpenGlCommand> get(std::function<void()> swapBuffersCallback)
+	static OpenGlCommand* get(std::function<void()> swapBuffersCallback)
 	{
-		static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-		auto ptr = getFromPool<CoreVideoGLSwapBuffersCommand>(poolId);
+		auto ptr = allocate<CoreVideoGLSwapBuffersCommand>();
 		ptr->set(swapBuffersCallback);
 		return ptr;
 	}
@@ -5309,10 +5194,9 @@ private:
 		{
 		}
 
-		static std::shared_ptr<OpenGlCommand> get(bool& returnValue)
+		static OpenGlCommand* get(bool& returnValue)
 		{
-			static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-			auto ptr = getFromPool<WindowsStartCommand>(poolId);
+			auto ptr = allocate<WindowsStartCommand>();
 			ptr->set(returnValue);
 			return ptr;
 		}
@@ -5339,10 +5223,9 @@ private:
 		{
 		}
 
-		static std::shared_ptr<OpenGlCommand> get()
+		static OpenGlCommand* get()
 		{
-			static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-			auto ptr = getFromPool<WindowsStopCommand>(poolId);
+			auto ptr = allocate<WindowsStopCommand>();
 			ptr->set();
 			return ptr;
 		}
@@ -5366,10 +5249,9 @@ private:
 		{
 		}
 
-		static std::shared_ptr<OpenGlCommand> get(std::function<void()> swapBuffersCallback)
+		static OpenGlCommand* get(std::function<void()> swapBuffersCallback)
 		{
-			static int poolId = OpenGlCommandPool::get().getNextAvailablePool();
-			auto ptr = getFromPool<WindowsSwapBuffersCommand>(poolId);
+			auto ptr = allocate<WindowsSwapBuffersCommand>();
 			ptr->set(swapBuffersCallback);
 			return ptr;
 		}
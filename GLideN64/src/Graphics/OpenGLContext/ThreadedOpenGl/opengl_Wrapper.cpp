@@ -27,65 +27,84 @@ namespace opengl {
 	std::map<std::string, FunctionWrapper::FunctionProfilingData> FunctionWrapper::m_functionProfiling;
 	std::chrono::time_point<std::chrono::high_resolution_clock> FunctionWrapper::m_lastProfilingOutput;
 #endif
-	BlockingReaderWriterQueue<std::shared_ptr<OpenGlCommand>> FunctionWrapper::m_commandQueue;
-	BlockingReaderWriterQueue<std::shared_ptr<OpenGlCommand>> FunctionWrapper::m_commandQueueHighPriority;
+	std::atomic<OpenGlCommand*> FunctionWrapper::m_priorityCommand(nullptr);
 
 
-	void FunctionWrapper::executeCommand(std::shared_ptr<OpenGlCommand> _command)
+	void FunctionWrapper::executeCommand(OpenGlCommand* _command)
 	{
 #if !defined(GL_DEBUG)
-		m_commandQueue.enqueue(_command);
-		_command->waitOnCommand();
+		const bool synced = _command->isSynced();
+		OpenGlCommand::m_commandRing.commit(synced);
+		if (synced)
+			OpenGlCommand::m_commandRing.waitUntilEmpty();
 #elif !defined(GL_PROFILE)
-		_command->performCommandSingleThreaded();
+		executeCommandSingleThreaded(_command);
 #else
 		auto callStartTime = std::chrono::high_resolution_clock::now();
-		_command->performCommandSingleThreaded();
+		const std::string functionName = _command->getFunctionName();
+		executeCommandSingleThreaded(_command);
 		std::chrono::duration<double> callDuration = std::chrono::high_resolution_clock::now() - callStartTime;
 
-		++m_functionProfiling[_command->getFunctionName()].m_callCount;
-		m_functionProfiling[_command->getFunctionName()].m_totalTime += callDuration.count();
+		++m_functionProfiling[functionName].m_callCount;
+		m_functionProfiling[functionName].m_totalTime += callDuration.count();
 
 		logProfilingData();
 #endif
 	}
 
-	void FunctionWrapper::executePriorityCommand(std::shared_ptr<OpenGlCommand> _command)
+	void FunctionWrapper::executePriorityCommand(OpenGlCommand* _command)
 	{
 #if !defined(GL_DEBUG)
-		m_commandQueueHighPriority.enqueue(_command);
-		m_commandQueue.enqueue(nullptr);
-		_command->waitOnCommand();
+		// Runs ahead of the queued commands; the record is never committed to the ring
+		m_priorityCommand.store(_command);
+		OpenGlCommand::m_commandRing.interrupt();
+		{
+			std::unique_lock<std::mutex> lock(m_condvarMutex);
+			m_condition.wait(lock, []{ return m_priorityCommand.load() == nullptr; });
+		}
+		OpenGlCommand::m_commandRing.discard();
 #elif !defined(GL_PROFILE)
-                _command->performCommandSingleThreaded();
+		executeCommandSingleThreaded(_command);
 #else
 		auto callStartTime = std::chrono::high_resolution_clock::now();
-		_command->performCommandSingleThreaded();
+		const std::string functionName = _command->getFunctionName();
+		executeCommandSingleThreaded(_command);
 		std::chrono::duration<double> callDuration = std::chrono::high_resolution_clock::now() - callStartTime;
 
-		++m_functionProfiling[_command->getFunctionName()].m_callCount;
-		m_functionProfiling[_command->getFunctionName()].m_totalTime += callDuration.count();
+		++m_functionProfiling[functionName].m_callCount;
+		m_functionProfiling[functionName].m_totalTime += callDuration.count();
 
 		logProfilingData();
 #endif
 	}
 
+	void FunctionWrapper::executeCommandSingleThreaded(OpenGlCommand* _command)
+	{
+		_command->performCommandSingleThreaded();
+		OpenGlCommand::m_commandRing.discard();
+	}
+
 	void FunctionWrapper::commandLoop()
 	{
 		bool timeToShutdown = false;
 		threaded_gl_safe_shutdown = false;
         
 		while (!timeToShutdown) {
-			std::shared_ptr<OpenGlCommand> command;
+			OpenGlCommand* command = m_priorityCommand.load();
 
-			if (m_commandQueueHighPriority.peek() != nullptr) {
-				while (m_commandQueueHighPriority.try_dequeue(command)) {
-					command->performCommand();
+			if (command != nullptr) {
+				command->performCommand();
+				{
+					std::unique_lock<std::mutex> lock(m_condvarMutex);
+					m_priorityCommand.store(nullptr);
 				}
+				m_condition.notify_all();
 			} else {
-				if (m_commandQueue.wait_dequeue_timed(command, std::chrono::milliseconds(10)) && command != nullptr) {
+				command = OpenGlCommand::m_commandRing.front(std::chrono::milliseconds(10));
+				if (command != nullptr) {
 					command->performCommand();
 					timeToShutdown = command->isTimeToShutdown();
+					OpenGlCommand::m_commandRing.pop();
 				}
 			}
 			if(!retro_savestate_complete)
@@ -477,8 +496,7 @@ namespace opengl {
 			numValues = 1;
 		}
 
-		PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(value), numValues*sizeof(GLfloat));
-		executeCommand(GlClearBufferfvCommand::get(buffer, drawbuffer, values));
+		executeCommand(GlClearBufferfvCommand::get(buffer, drawbuffer, value, numValues));
 	}
 
 	void FunctionWrapper::wrGetFloatv(GLenum pname, GLfloat* data)
@@ -491,10 +509,8 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteTextures(GLsizei n, const GLuint *textures)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer texture = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(textures), n*sizeof(GLuint));
-			executeCommand(GlDeleteTexturesCommand::get(n, texture));
-		}
+		if (m_threaded_wrapper)
+			executeCommand(GlDeleteTexturesCommand::get(n, textures));
 		else
 			ptrDeleteTextures(n, textures);
 	}
@@ -680,19 +696,17 @@ namespace opengl {
 
 	void FunctionWrapper::wrUniform3fv(GLint location, GLsizei count, const GLfloat *value)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(value), 3 * sizeof(GLfloat) * count);
-			executeCommand(GlUniform3fvCommand::get(location, count, values));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlUniform3fvCommand::get(location, count, value));
+		else
 			ptrUniform3fv(location, count, value);
 	}
 
 	void FunctionWrapper::wrUniform4fv(GLint location, GLsizei count, const GLfloat *value)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(value), 4 * sizeof(GLfloat) * count);
-			executeCommand(GlUniform4fvCommand::get(location, count, values));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlUniform4fvCommand::get(location, count, value));
+		else
 			ptrUniform4fv(location, count, value);
 	}
 
@@ -811,10 +825,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrVertexAttrib4fv(GLuint index, const GLfloat *v)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer values = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(v), 4 * sizeof(GLfloat));
-			executeCommand(GlVertexAttrib4fvCommand::get(index, values));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlVertexAttrib4fvCommand::get(index, v));
+		else
 			ptrVertexAttrib4fv(index, v);
 	}
 
@@ -836,10 +849,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrDrawBuffers(GLsizei n, const GLenum *bufs)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer bufsPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(bufs), n*sizeof(GLenum));
-			executeCommand(GlDrawBuffersCommand::get(n, bufsPtr));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlDrawBuffersCommand::get(n, bufs));
+		else
 			ptrDrawBuffers(n, bufs);
 	}
 
@@ -861,10 +873,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer framebuffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(framebuffers), n*sizeof(GLuint));
-			executeCommand(GlDeleteFramebuffersCommand::get(n, framebuffersPtr));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlDeleteFramebuffersCommand::get(n, framebuffers));
+		else
 			ptrDeleteFramebuffers(n, framebuffers);
 	}
 
@@ -918,10 +929,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer renderbuffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(renderbuffers), n*sizeof(GLuint));
-			executeCommand(GlDeleteRenderbuffersCommand::get(n, renderbuffersPtr));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlDeleteRenderbuffersCommand::get(n, renderbuffers));
+		else
 			ptrDeleteRenderbuffers(n, renderbuffers);
 	}
 
@@ -975,10 +985,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteVertexArrays(GLsizei n, const GLuint *arrays)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer arraysPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(arrays), n*sizeof(GLuint));
-			executeCommand(GlDeleteVertexArraysCommand::get(n, arraysPtr));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlDeleteVertexArraysCommand::get(n, arrays));
+		else
 			ptrDeleteVertexArrays(n, arrays);
 	}
 
@@ -1080,10 +1089,8 @@ namespace opengl {
 
 	void FunctionWrapper::wrDeleteBuffers(GLsizei n, const GLuint *buffers)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer buffersPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(buffers), n*sizeof(GLuint));
-			executeCommand(GlDeleteBuffersCommand::get(n, buffersPtr));
-		}
+		if (m_threaded_wrapper)
+			executeCommand(GlDeleteBuffersCommand::get(n, buffers));
 		else
 			ptrDeleteBuffers(n, buffers);
 	}
@@ -1134,10 +1141,9 @@ namespace opengl {
 
 	void FunctionWrapper::wrInvalidateFramebuffer(GLenum target, GLsizei numAttachments, const GLenum *attachments)
 	{
-		if (m_threaded_wrapper) {
-			PoolBufferPointer attachmentsPtr = OpenGlCommand::m_ringBufferPool.createPoolBuffer(reinterpret_cast<const char*>(attachments), numAttachments*sizeof(GLenum));
-			executeCommand(GlInvalidateFramebufferCommand::get(target, numAttachments, attachmentsPtr));
-		} else
+		if (m_threaded_wrapper)
+			executeCommand(GlInvalidateFramebufferCommand::get(target, numAttachments, attachments));
+		else
 			ptrInvalidateFramebuffer(target, numAttachments, attachments);
 	}
 
@@ -1407,6 +1413,14 @@ namespace opengl {
 			ptrCopyTexImage2D(target, level, internalformat, x, y, width, height, border);
 	}
 
+	void FunctionWrapper::wrMaxShaderCompilerThreadsKHR(GLuint count)
+	{
+		if (m_threaded_wrapper)
+			executeCommand(GlMaxShaderCompilerThreadsKHRCommand::get(count));
+		else
+			ptrMaxShaderCompilerThreadsKHR(count);
+	}
+
 	void FunctionWrapper::wrDebugMessageCallback(GLDEBUGPROC callback, const void *userParam)
 	{
 		if (m_threaded_wrapper)
@@ -1461,7 +1475,7 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoInitCommand::get(returnValue));
 		else
-			CoreVideoInitCommand::get(returnValue)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoInitCommand::get(returnValue));
 		return returnValue;
 	}
 
@@ -1470,9 +1484,10 @@ namespace opengl {
 		if (m_threaded_wrapper) {
 			executeCommand(CoreVideoQuitCommand::get());
 			executeCommand(ShutdownCommand::get());
+			OpenGlCommand::m_commandRing.flush();
 		}
 		else
-			CoreVideoQuitCommand::get()->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoQuitCommand::get());
 
 		m_shutdown = true;
 
@@ -1491,7 +1506,7 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoSetVideoModeCommand::get(screenWidth, screenHeight, bitsPerPixel, mode, flags, returnValue));
 		else
-			CoreVideoSetVideoModeCommand::get(screenWidth, screenHeight, bitsPerPixel, mode, flags, returnValue)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoSetVideoModeCommand::get(screenWidth, screenHeight, bitsPerPixel, mode, flags, returnValue));
 
 		return returnValue;
 	}
@@ -1503,7 +1518,7 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoSetVideoModeWithRateCommand::get(screenWidth, screenHeight, refreshRate, bitsPerPixel, mode, flags, returnValue));
 		else
-			CoreVideoSetVideoModeWithRateCommand::get(screenWidth, screenHeight, refreshRate, bitsPerPixel, mode, flags, returnValue)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoSetVideoModeWithRateCommand::get(screenWidth, screenHeight, refreshRate, bitsPerPixel, mode, flags, returnValue));
 
 		return returnValue;
 	}
@@ -1513,7 +1528,7 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoGLSetAttributeCommand::get(attribute, value));
 		else
-			CoreVideoGLSetAttributeCommand::get(attribute, value)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoGLSetAttributeCommand::get(attribute, value));
 	}
 
 	void FunctionWrapper::CoreVideo_GL_GetAttribute(m64p_GLattr attribute, int *value)
@@ -1521,17 +1536,19 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(CoreVideoGLGetAttributeCommand::get(attribute, value));
 		else
-			CoreVideoGLGetAttributeCommand::get(attribute, value)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(CoreVideoGLGetAttributeCommand::get(attribute, value));
 	}
 
 	void FunctionWrapper::CoreVideo_GL_SwapBuffers()
 	{
 		++m_swapBuffersQueued;
 
-		if (m_threaded_wrapper)
+		if (m_threaded_wrapper) {
 			executeCommand(CoreVideoGLSwapBuffersCommand::get([]{ReduceSwapBuffersQueued();}));
-		else
-			CoreVideoGLSwapBuffersCommand::get([]{ReduceSwapBuffersQueued();})->performCommandSingleThreaded();
+			// End of the frame, do not leave the rest of the batch waiting
+			OpenGlCommand::m_commandRing.flush();
+		} else
+			executeCommandSingleThreaded(CoreVideoGLSwapBuffersCommand::get([]{ReduceSwapBuffersQueued();}));
 	}
 #else
 	bool FunctionWrapper::windowsStart()
@@ -1541,7 +1558,7 @@ namespace opengl {
 		if (m_threaded_wrapper)
 			executeCommand(WindowsStartCommand::get(returnValue));
 		else
-			WindowsStartCommand::get(returnValue)->performCommandSingleThreaded();
+			executeCommandSingleThreaded(WindowsStartCommand::get(returnValue));
 
 		return returnValue;
 	}
@@ -1551,8 +1568,9 @@ namespace opengl {
 		if (m_threaded_wrapper) {
 			executeCommand(WindowsStopCommand::get());
 			executeCommand(ShutdownCommand::get());
+			OpenGlCommand::m_commandRing.flush();
 		} else
-			WindowsStopCommand::get()->performCommandSingleThreaded();
+			executeCommandSingleThreaded(WindowsStopCommand::get());
 
 		m_shutdown = true;
 
@@ -1568,10 +1586,12 @@ namespace opengl {
 	{
 		++m_swapBuffersQueued;
 
-		if (m_threaded_wrapper)
+		if (m_threaded_wrapper) {
 			executeCommand(WindowsSwapBuffersCommand::get([]{ReduceSwapBuffersQueued(); }));
-		else
-			WindowsSwapBuffersCommand::get([]{ReduceSwapBuffersQueued(); })->performCommandSingleThreaded();
+			// End of the frame, do not leave the rest of the batch waiting
+			OpenGlCommand::m_commandRing.flush();
+		} else
+			executeCommandSingleThreaded(WindowsSwapBuffersCommand::get([]{ReduceSwapBuffersQueued(); }));
 	}
 
 #endif
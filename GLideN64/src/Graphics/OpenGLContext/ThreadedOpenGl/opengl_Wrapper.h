@@ -1,9 +1,9 @@
 #pragma once
 
 #include "Graphics/OpenGLContext/GLFunctions.h"
-#include "readerwriterqueue.h"
 #include "opengl_WrappedFunctions.h"
 #include "opengl_Command.h"
+#include <atomic>
 #include <thread>
 #include <map>
 
@@ -11,8 +11,6 @@
 #include <mupenplus/GLideN64_mupenplus.h>
 #endif
 
-using namespace moodycamel;
-
 namespace opengl {
 
 	class FunctionWrapper
@@ -20,13 +18,13 @@ namespace opengl {
     public:
 		static void commandLoop();
 	private:
-		static void executeCommand(std::shared_ptr<OpenGlCommand> _command);
+		static void executeCommand(OpenGlCommand* _command);
 
-		static void executePriorityCommand(std::shared_ptr<OpenGlCommand> _command);
+		static void executePriorityCommand(OpenGlCommand* _command);
 
+		static void executeCommandSingleThreaded(OpenGlCommand* _command);
 
-		static BlockingReaderWriterQueue<std::shared_ptr<OpenGlCommand>> m_commandQueue;
-		static BlockingReaderWriterQueue<std::shared_ptr<OpenGlCommand>> m_commandQueueHighPriority;
+		static std::atomic<OpenGlCommand*> m_priorityCommand;
 
 		static bool m_threaded_wrapper;
 		static bool m_shutdown;
@@ -194,6 +192,7 @@ namespace opengl {
 		static void wrFinish();
 		static void wrFlush();
 		static void wrCopyTexImage2D(GLenum target, GLint level, GLenum internalformat, GLint x, GLint y, GLsizei width, GLsizei height, GLint border);
+		static void wrMaxShaderCompilerThreadsKHR(GLuint count);
 		static void wrDebugMessageCallback(GLDEBUGPROC callback, const void *userParam);
 		static void wrDebugMessageControl(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled);
 		static void wrEGLImageTargetTexture2DOES(GLenum target, void* image);
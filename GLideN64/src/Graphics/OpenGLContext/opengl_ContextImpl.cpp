@@ -437,6 +437,12 @@ bool ContextImpl::loadShadersStorage(graphics::Combiners & _combiners)
 	return storage.loadShadersStorage(_combiners);
 }
 
+bool ContextImpl::loadShadersCorpus(u32 _count, std::vector<u64> & _keys)
+{
+	glsl::ShaderStorage storage(m_glInfo, m_cachedFunctions->getCachedUseProgram());
+	return storage.loadShadersCorpus(_count, _keys);
+}
+
 graphics::ShaderProgram * ContextImpl::createDepthFogShader()
 {
 	return m_specialShadersFactory->createShadowMapShader();
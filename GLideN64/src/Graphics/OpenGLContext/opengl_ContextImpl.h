@@ -120,6 +120,8 @@ namespace opengl {
 
 		bool loadShadersStorage(graphics::Combiners & _combiners) override;
 
+		bool loadShadersCorpus(u32 _count, std::vector<u64> & _keys) override;
+
 		graphics::ShaderProgram * createDepthFogShader() override;
 
 		graphics::TexrectDrawerShaderProgram * createTexrectDrawerDrawShader() override;
@@ -205,6 +205,19 @@ void GLInfo::init() {
 	dual_source_blending = !isGLESX || (Utils::isExtensionSupported(*this, "GL_EXT_blend_func_extended") && !isAnyAdreno);
 	anisotropic_filtering = Utils::isExtensionSupported(*this, "GL_EXT_texture_filter_anisotropic");
 
+	// The ubershader used while a program links in the background indexes arrays with uniforms
+	parallelShaderCompile = !isGLES2 && (Utils::isExtensionSupported(*this, "GL_KHR_parallel_shader_compile") ||
+		Utils::isExtensionSupported(*this, "GL_ARB_parallel_shader_compile"));
+	if (config.generalEmulation.enableAsyncShaderCompile != 0) {
+		if (!parallelShaderCompile) {
+			config.generalEmulation.enableAsyncShaderCompile = 0;
+			LOG(LOG_WARNING, "Your GPU does not support asynchronous shader compilation.");
+		} else if (IS_GL_FUNCTION_VALID(MaxShaderCompilerThreadsKHR)) {
+			// Let the driver pick the number of compiler threads
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		}
+	}
+
 #ifdef OS_ANDROID
 	eglImage = eglImage &&
 	        ( (isGLES2 && GraphicBufferWrapper::isSupportAvailable()) || (isGLESX && GraphicBufferWrapper::isPublicSupportAvailable()) ) &&
@@ -17,6 +17,7 @@ namespace graphics {
 		virtual bool usesLOD() const override {return false;}
 		virtual bool usesHwLighting() const override {return false;}
 		virtual bool getBinaryForm(std::vector<char> & _buffer) override {return false;}
+		virtual bool isReady() const override {return true;}
 	};
 
 	class TexrectDrawerShaderProgram : public ShaderProgram
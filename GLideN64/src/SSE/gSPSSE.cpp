@@ -0,0 +1,180 @@
+#include <math.h>
+#include <stddef.h>
+#include <emmintrin.h>
+#include "Types.h"
+#include "GBI.h"
+#include "gSP.h"
+
+// x86 versions of the gSP vertex stages. A batch of 4 vertices is transposed
+// to structure of arrays, so every lane of a register holds the same
+// component of a different vertex. The arithmetic is done in the same order
+// as in the scalar templates in gSP.cpp, so results are bit identical.
+
+namespace {
+
+struct SoA4
+{
+	__m128 v[4];
+
+	void load(const SPVertex * spVtx, size_t offset)
+	{
+		for (u32 i = 0; i < 4; ++i)
+			v[i] = _mm_loadu_ps(reinterpret_cast<const f32*>(reinterpret_cast<const u8*>(&spVtx[i]) + offset));
+		_MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+	}
+
+	void store(SPVertex * spVtx, size_t offset)
+	{
+		__m128 r0 = v[0], r1 = v[1], r2 = v[2], r3 = v[3];
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		const __m128 rows[4] = { r0, r1, r2, r3 };
+		for (u32 i = 0; i < 4; ++i)
+			_mm_storeu_ps(reinterpret_cast<f32*>(reinterpret_cast<u8*>(&spVtx[i]) + offset), rows[i]);
+	}
+};
+
+#if defined(_MSC_VER)
+#define SSE_NOINLINE __declspec(noinline)
+#else
+#define SSE_NOINLINE __attribute__((noinline))
+#endif
+
+// Out of line, so that the compiler cannot swap in a vector acosf which rounds differently
+SSE_NOINLINE f32 texGenLinear(f32 x)
+{
+	return acosf(-x) * 325.94931f;
+}
+
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// v0[0]*v1[0] + v0[1]*v1[1] + v0[2]*v1[2], as DotProduct()
+inline __m128 dot3(const __m128 v[3], const f32 * l)
+{
+	__m128 d = _mm_mul_ps(v[0], _mm_set1_ps(l[0]));
+	d = _mm_add_ps(d, _mm_mul_ps(v[1], _mm_set1_ps(l[1])));
+	return _mm_add_ps(d, _mm_mul_ps(v[2], _mm_set1_ps(l[2])));
+}
+
+} // namespace
+
+void gSPTransformClipVertex4SSE(u32 v, SPVertex * spVtx, float mtx[4][4], bool billboard, f32 adjustScale)
+{
+	SPVertex * vtx = &spVtx[v];
+
+	SoA4 pos;
+	pos.load(vtx, offsetof(SPVertex, x));
+	const __m128 x = pos.v[0];
+	const __m128 y = pos.v[1];
+	const __m128 z = pos.v[2];
+
+	for (u32 i = 0; i < 4; ++i) {
+		__m128 res = _mm_mul_ps(x, _mm_set1_ps(mtx[0][i]));
+		res = _mm_add_ps(res, _mm_mul_ps(y, _mm_set1_ps(mtx[1][i])));
+		res = _mm_add_ps(res, _mm_mul_ps(z, _mm_set1_ps(mtx[2][i])));
+		pos.v[i] = _mm_add_ps(res, _mm_set1_ps(mtx[3][i]));
+	}
+
+	if (billboard) {
+		// The caller takes the scalar path for the batch which contains vertex 0
+		const f32 * vtx0 = &spVtx[0].x;
+		for (u32 i = 0; i < 4; ++i)
+			pos.v[i] = _mm_add_ps(pos.v[i], _mm_set1_ps(vtx0[i]));
+	}
+
+	pos.store(vtx, offsetof(SPVertex, x));
+
+	const __m128 w = pos.v[3];
+	const __m128 negW = _mm_xor_ps(w, _mm_set1_ps(-0.0f));
+	const __m128 scaledX = _mm_mul_ps(pos.v[0], _mm_set1_ps(adjustScale));
+	const int posX = _mm_movemask_ps(_mm_cmpgt_ps(scaledX, w));
+	const int negX = _mm_movemask_ps(_mm_cmplt_ps(scaledX, negW));
+	const int posY = _mm_movemask_ps(_mm_cmpgt_ps(pos.v[1], w));
+	const int negY = _mm_movemask_ps(_mm_cmplt_ps(pos.v[1], negW));
+	const int clipW = _mm_movemask_ps(_mm_cmplt_ps(w, _mm_set1_ps(0.01f)));
+
+	for (u32 j = 0; j < 4; ++j) {
+		u8 clip = 0;
+		if (posX & (1 << j)) clip |= CLIP_POSX;
+		if (negX & (1 << j)) clip |= CLIP_NEGX;
+		if (posY & (1 << j)) clip |= CLIP_POSY;
+		if (negY & (1 << j)) clip |= CLIP_NEGY;
+		if (clipW & (1 << j)) clip |= CLIP_W;
+		vtx[j].clip = clip;
+	}
+}
+
+void gSPLightVertex4SSE(u32 v, SPVertex * spVtx)
+{
+	SPVertex * vtx = &spVtx[v];
+
+	SoA4 normal;
+	normal.load(vtx, offsetof(SPVertex, nx));
+
+	// Even vertices use the first light color, odd ones the second.
+	const bool oddFirst = (v & 1) != 0;
+	auto lightColor = [oddFirst](u32 l, u32 c) {
+		const f32 first = gSP.lights.rgb[l][c];
+		const f32 second = gSP.lights.rgb2[l][c];
+		return oddFirst ? _mm_setr_ps(second, first, second, first) : _mm_setr_ps(first, second, first, second);
+	};
+
+	SoA4 color;
+	color.load(vtx, offsetof(SPVertex, r));
+	for (u32 c = 0; c < 3; ++c)
+		color.v[c] = lightColor(gSP.numLights, c);
+
+	for (u32 l = 0; l < gSP.numLights; ++l) {
+		const __m128 intensity = dot3(normal.v, gSP.lights.i_xyz[l]);
+		const __m128 lit = _mm_cmpgt_ps(intensity, _mm_setzero_ps());
+		if (_mm_movemask_ps(lit) == 0)
+			continue;
+		for (u32 c = 0; c < 3; ++c) {
+			const __m128 sum = _mm_add_ps(color.v[c], _mm_mul_ps(lightColor(l, c), intensity));
+			color.v[c] = select(lit, sum, color.v[c]);
+		}
+	}
+
+	// min(1.0f, c): keeps c only if it is less than 1
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (u32 c = 0; c < 3; ++c)
+		color.v[c] = _mm_min_ps(color.v[c], one);
+
+	color.store(vtx, offsetof(SPVertex, r));
+	for (u32 j = 0; j < 4; ++j)
+		vtx[j].HWLight = 0;
+}
+
+void gSPTextureGenVertex4SSE(u32 v, SPVertex * spVtx, bool linear)
+{
+	SPVertex * vtx = &spVtx[v];
+
+	SoA4 normal;
+	normal.load(vtx, offsetof(SPVertex, nx));
+	__m128 x = dot3(normal.v, gSP.lookat.i_xyz[0]);
+	__m128 y = dot3(normal.v, gSP.lookat.i_xyz[1]);
+
+	alignas(16) f32 s[4], t[4];
+	if (linear) {
+		// Clamp to [-1, 1] with the operand order of the scalar compares, so NaN passes through
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		_mm_store_ps(s, _mm_min_ps(one, _mm_max_ps(minusOne, x)));
+		_mm_store_ps(t, _mm_min_ps(one, _mm_max_ps(minusOne, y)));
+		for (u32 j = 0; j < 4; ++j) {
+			vtx[j].s = texGenLinear(s[j]);
+			vtx[j].t = texGenLinear(t[j]);
+		}
+	} else {
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(512.0f);
+		_mm_store_ps(s, _mm_mul_ps(_mm_add_ps(x, one), scale));
+		_mm_store_ps(t, _mm_mul_ps(_mm_add_ps(y, one), scale));
+		for (u32 j = 0; j < 4; ++j) {
+			vtx[j].s = s[j];
+			vtx[j].t = t[j];
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <osal_files.h>
+#include "ShaderCorpus.h"
+
+bool ShaderCorpus::addKeys(std::istream & _is)
+{
+	u32 version = 0;
+	_is >> std::hex >> version;
+	if (!_is || version != keysFormatVersion)
+		return false;
+
+	u32 szKeys = 0;
+	_is >> std::hex >> szKeys;
+	std::vector<u64> keys;
+	keys.reserve(szKeys);
+	for (u32 i = 0; i < szKeys; ++i) {
+		u64 mux;
+		if (!(_is >> std::hex >> mux))
+			return false;
+		keys.push_back(mux);
+	}
+
+	// Count each title once, whatever the file says
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	for (u64 mux : keys)
+		++m_counts[mux];
+	++m_titles;
+	return true;
+}
+
+bool ShaderCorpus::addCorpus(std::istream & _is)
+{
+	u32 version = 0;
+	_is >> std::hex >> version;
+	if (!_is || version != m_formatVersion)
+		return false;
+
+	u32 titles = 0, szKeys = 0;
+	_is >> std::hex >> titles >> szKeys;
+	std::vector<Entry> entries;
+	entries.reserve(szKeys);
+	for (u32 i = 0; i < szKeys; ++i) {
+		Entry entry;
+		if (!(_is >> std::hex >> entry.mux >> entry.titles))
+			return false;
+		entries.push_back(entry);
+	}
+
+	for (const Entry & entry : entries)
+		m_counts[entry.mux] += entry.titles;
+	m_titles += titles;
+	return true;
+}
+
+u32 ShaderCorpus::addFolder(const std::string & _folder, const std::string & _suffix)
+{
+	wchar_t folder[PLUGIN_PATH_SIZE];
+	std::mbstowcs(folder, _folder.c_str(), PLUGIN_PATH_SIZE);
+	if (!osal_path_existsW(folder) || !osal_is_directory(folder))
+		return 0;
+
+	void * dir = osal_search_dir_open(folder);
+	if (dir == nullptr)
+		return 0;
+
+	u32 added = 0;
+	char fileName[PLUGIN_PATH_SIZE * 4];
+	const wchar_t * foundFileName;
+	while ((foundFileName = osal_search_dir_read_next(dir)) != nullptr) {
+		if (std::wcstombs(fileName, foundFileName, sizeof(fileName)) == static_cast<size_t>(-1))
+			continue;
+		const std::string name(fileName);
+		if (name.size() <= _suffix.size() || name.compare(name.size() - _suffix.size(), _suffix.size(), _suffix) != 0)
+			continue;
+
+		const std::string path(_folder + "/" + name);
+#if defined(OS_WINDOWS) && !defined(MINGW)
+		std::ifstream fin(path);
+#else
+		std::ifstream fin(path.c_str());
+#endif
+		if (fin && addKeys(fin))
+			++added;
+	}
+	osal_search_dir_close(dir);
+	return added;
+}
+
+std::vector<ShaderCorpus::Entry> ShaderCorpus::getRanked(u32 _count) const
+{
+	std::vector<Entry> entries;
+	entries.reserve(m_counts.size());
+	for (const auto & count : m_counts)
+		entries.push_back(Entry{ count.first, count.second });
+
+	// Ties are broken by key, so the order does not depend on hashing
+	auto moreCommon = [](const Entry & _lhs, const Entry & _rhs) {
+		return _lhs.titles != _rhs.titles ? _lhs.titles > _rhs.titles : _lhs.mux < _rhs.mux;
+	};
+	if (_count < entries.size()) {
+		std::partial_sort(entries.begin(), entries.begin() + _count, entries.end(), moreCommon);
+		entries.resize(_count);
+	} else
+		std::sort(entries.begin(), entries.end(), moreCommon);
+	return entries;
+}
+
+void ShaderCorpus::write(std::ostream & _os) const
+{
+	const std::vector<Entry> entries(getRanked(static_cast<u32>(m_counts.size())));
+	_os << "0x" << std::hex << std::setfill('0') << std::setw(8) << m_formatVersion << "\n";
+	_os << "0x" << std::hex << std::setfill('0') << std::setw(8) << m_titles << "\n";
+	_os << "0x" << std::hex << std::setfill('0') << std::setw(8) << entries.size() << "\n";
+	for (const Entry & entry : entries)
+		_os << "0x" << std::hex << std::setfill('0') << std::setw(16) << entry.mux
+			<< " 0x" << std::setw(8) << entry.titles << "\n";
+}
@@ -0,0 +1,59 @@
+#ifndef SHADERCORPUS_H
+#define SHADERCORPUS_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Types.h"
+
+/*
+Combiner keys aggregated over the keys files of many titles, ranked by the
+number of titles which use them. A new title can compile the most common
+combiners before it needs them.
+
+Corpus has text format:
+line_1 Version in hex form
+line_2 Number of titles in hex form
+line_3 Count - numbers of combiners keys in hex form
+line_4..line_Count+3  combiner key and number of titles using it in hex form, one key per line
+*/
+class ShaderCorpus
+{
+public:
+	struct Entry
+	{
+		u64 mux;
+		u32 titles;
+	};
+
+	// Version of the per-title keys files written by the shader storage
+	static const u32 keysFormatVersion = 0x05;
+
+	// Adds a per-title keys file. Returns false if its format is not supported.
+	bool addKeys(std::istream & _is);
+
+	// Adds a corpus written by write(). Returns false if its format is not supported.
+	bool addCorpus(std::istream & _is);
+
+	// Adds every keys file in _folder whose name ends with _suffix.
+	// Returns the number of files added.
+	u32 addFolder(const std::string & _folder, const std::string & _suffix);
+
+	// Most common keys first, at most _count of them
+	std::vector<Entry> getRanked(u32 _count) const;
+
+	void write(std::ostream & _os) const;
+
+	u32 getTitles() const { return m_titles; }
+	size_t size() const { return m_counts.size(); }
+
+private:
+	static const u32 m_formatVersion = 0x01;
+
+	std::unordered_map<u64, u32> m_counts;
+	u32 m_titles = 0;
+};
+
+#endif // SHADERCORPUS_H
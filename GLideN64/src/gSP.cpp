@@ -510,6 +510,13 @@ void gSPLightVertexStandard(u32 v, SPVertex * spVtx)
 {
 #ifndef __NEON_OPT
 	if (!isHWLightingAllowed()) {
+#ifdef __SSE_OPT
+		if (VNUM == 4) {
+			void gSPLightVertex4SSE(u32 v, SPVertex * spVtx);
+			gSPLightVertex4SSE(v, spVtx);
+			return;
+		}
+#endif //__SSE_OPT
 		for(int j = 0; j < VNUM; ++j) {
 			SPVertex & vtx = spVtx[v+j];
 			const bool useFirstColor = ((v + j) & 1) == 0;
@@ -862,12 +869,21 @@ void gSPProcessVertex(u32 v, SPVertex * spVtx)
 		vtx.modify = 0;
 	}
 
-	gSPTransformVertex<VNUM>(v, spVtx, gSP.matrix.combined );
+#ifdef __SSE_OPT
+	// The billboard offset is vertex 0 itself, so its batch takes the scalar path
+	if (VNUM == 4 && (gSP.matrix.billboard == 0 || v != 0)) {
+		void gSPTransformClipVertex4SSE(u32 v, SPVertex * spVtx, float mtx[4][4], bool billboard, f32 adjustScale);
+		gSPTransformClipVertex4SSE(v, spVtx, gSP.matrix.combined, gSP.matrix.billboard != 0, dwnd().getAdjustScale());
+	} else
+#endif //__SSE_OPT
+	{
+		gSPTransformVertex<VNUM>(v, spVtx, gSP.matrix.combined );
 
-	if (gSP.matrix.billboard)
-		gSPBillboardVertex<VNUM>(v, spVtx);
+		if (gSP.matrix.billboard)
+			gSPBillboardVertex<VNUM>(v, spVtx);
 
-	gSPClipVertex<VNUM>(v, spVtx);
+		gSPClipVertex<VNUM>(v, spVtx);
+	}
 
 	if (gSP.geometryMode & G_LIGHTING) {
 		if (GBI.isLegacyVertexPipeline())
@@ -887,6 +903,12 @@ void gSPProcessVertex(u32 v, SPVertex * spVtx)
 
 		if ((gSP.geometryMode & G_TEXTURE_GEN) != 0) {
 			if (GBI.getMicrocodeType() != F3DFLX2) {
+#ifdef __SSE_OPT
+				if (VNUM == 4 && gSP.lookatEnable) {
+					void gSPTextureGenVertex4SSE(u32 v, SPVertex * spVtx, bool linear);
+					gSPTextureGenVertex4SSE(v, spVtx, (gSP.geometryMode & G_TEXTURE_GEN_LINEAR) != 0);
+				} else
+#endif //__SSE_OPT
 				for(int i = 0; i < VNUM; ++i) {
 					SPVertex & vtx = spVtx[v+i];
 					f32 vNormale[3] = {vtx.nx, vtx.ny, vtx.nz};
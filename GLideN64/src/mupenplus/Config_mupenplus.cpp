@@ -163,6 +163,12 @@ bool Config_SetDefault()
 	assert(res == M64ERR_SUCCESS);
 	res = ConfigSetDefaultBool(g_configVideoGliden64, "EnableShadersStorage", config.generalEmulation.enableShadersStorage, "Use persistent storage for compiled shaders.");
 	assert(res == M64ERR_SUCCESS);
+	res = ConfigSetDefaultBool(g_configVideoGliden64, "EnableAsyncShaderCompile", config.generalEmulation.enableAsyncShaderCompile, "Link new combiner shaders in the background and draw with a generic shader until they are ready. Needs GL_KHR_parallel_shader_compile.");
+	assert(res == M64ERR_SUCCESS);
+	res = ConfigSetDefaultInt(g_configVideoGliden64, "ShaderWarmupCount", config.generalEmulation.shaderWarmupCount, "Compile this many of the combiner shaders most used by all titles in the shader storage folder at startup. (0=off)");
+	assert(res == M64ERR_SUCCESS);
+	res = ConfigSetDefaultInt(g_configVideoGliden64, "ShaderWarmupTime", config.generalEmulation.shaderWarmupTime, "Time limit in milliseconds for compiling shaders at startup.");
+	assert(res == M64ERR_SUCCESS);
 	res = ConfigSetDefaultBool(g_configVideoGliden64, "EnableLegacyBlending", config.generalEmulation.enableLegacyBlending, "Do not use shaders to emulate N64 blending modes. Works faster on slow GPU. Can cause glitches.");
 	assert(res == M64ERR_SUCCESS);
 	res = ConfigSetDefaultBool(g_configVideoGliden64, "EnableHybridFilter", config.generalEmulation.enableHybridFilter, "Enable hybrid integer scaling filter. Can be slow with low-end GPUs.");
@@ -392,6 +398,12 @@ void Config_LoadCustomConfig()
 	if (result == M64ERR_SUCCESS) config.generalEmulation.enableClipping = atoi(value);
 	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\enableShadersStorage", value, sizeof(value));
 	if (result == M64ERR_SUCCESS) config.generalEmulation.enableShadersStorage = atoi(value);
+	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\enableAsyncShaderCompile", value, sizeof(value));
+	if (result == M64ERR_SUCCESS) config.generalEmulation.enableAsyncShaderCompile = atoi(value);
+	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\shaderWarmupCount", value, sizeof(value));
+	if (result == M64ERR_SUCCESS) config.generalEmulation.shaderWarmupCount = atoi(value);
+	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\shaderWarmupTime", value, sizeof(value));
+	if (result == M64ERR_SUCCESS) config.generalEmulation.shaderWarmupTime = atoi(value);
 	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\enableLegacyBlending", value, sizeof(value));
 	if (result == M64ERR_SUCCESS) config.generalEmulation.enableLegacyBlending = atoi(value);
 	result = ConfigExternalGetParameter(fileHandle, sectionName, "generalEmulation\\enableFragmentDepthWrite", value, sizeof(value));
@@ -526,6 +538,9 @@ void Config_LoadConfig()
 	config.generalEmulation.enableCoverage = ConfigGetParamBool(g_configVideoGliden64, "EnableCoverage");
 	config.generalEmulation.enableClipping = ConfigGetParamBool(g_configVideoGliden64, "enableClipping");
 	config.generalEmulation.enableShadersStorage = ConfigGetParamBool(g_configVideoGliden64, "EnableShadersStorage");
+	config.generalEmulation.enableAsyncShaderCompile = ConfigGetParamBool(g_configVideoGliden64, "EnableAsyncShaderCompile");
+	config.generalEmulation.shaderWarmupCount = ConfigGetParamInt(g_configVideoGliden64, "ShaderWarmupCount");
+	config.generalEmulation.shaderWarmupTime = ConfigGetParamInt(g_configVideoGliden64, "ShaderWarmupTime");
 	config.generalEmulation.enableLegacyBlending = ConfigGetParamBool(g_configVideoGliden64, "EnableLegacyBlending");
 	config.generalEmulation.enableHybridFilter = ConfigGetParamBool(g_configVideoGliden64, "EnableHybridFilter");
 	config.generalEmulation.enableInaccurateTextureCoordinates = ConfigGetParamBool(g_configVideoGliden64, "EnableInaccurateTextureCoordinates");
@@ -13,9 +13,29 @@
 #endif
 
 #include <libretro_private.h>
+#include <libretro_profiler.h>
+#include <mupen64plus-next_common.h>
+#include "../Combiner.h"
 
 extern retro_environment_t environ_cb;
 
+extern "C" bool retro_profiler_get_shader_stats(struct retro_shader_compile_stats *stats)
+{
+	if (stats == nullptr || current_rdp_type != RDP_PLUGIN_GLIDEN64)
+		return false;
+
+	const CombinerInfo::CompileStats & compileStats = CombinerInfo::get().getCompileStats();
+	stats->programs = compileStats.programs;
+	stats->stalls = compileStats.stalls;
+	stats->deferred = compileStats.deferred;
+	stats->fallback_draws = compileStats.fallbackDraws;
+	stats->compile_time_us = compileStats.compileTimeUs;
+	stats->max_compile_time_us = compileStats.maxCompileTimeUs;
+	stats->warmed_up = compileStats.warmedUp;
+	stats->warm_hits = compileStats.warmHits;
+	return true;
+}
+
 extern "C" void retroChangeWindow()
 {
 	dwnd().setToggleFullscreen();
@@ -183,6 +183,8 @@ extern "C" void Config_LoadConfig()
 #else
 	config.generalEmulation.enableShadersStorage = EnableShadersStorage;
 #endif
+	config.generalEmulation.enableAsyncShaderCompile = EnableAsyncShaderCompile;
+	config.generalEmulation.shaderWarmupCount = ShaderWarmupCount;
 
 	config.frameBufferEmulation.copyAuxToRDRAM = EnableCopyAuxToRDRAM;
 	config.textureFilter.txSaveCache = EnableTextureCache;
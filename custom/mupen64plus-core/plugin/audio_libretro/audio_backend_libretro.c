@@ -25,6 +25,7 @@
 #include "../../../../mupen64plus-core/src/main/main.h"
 #include "../../../../mupen64plus-core/src/device/device.h"
 #include "../../../../mupen64plus-core/src/main/rom.h"
+#include "../../../../mupen64plus-core/src/main/profile.h"
 #include "plugin/plugin.h"
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rcp/vi/vi_controller.h"
@@ -131,6 +132,8 @@ static void aiLenChanged(void* user_data, const void* buffer, size_t size)
    size_t frames     = size / 4;
    uint8_t *p        = (uint8_t*)buffer;
 
+   timed_section_start(TIMED_SECTION_AUDIO_RESAMPLE);
+
    for (i = 0; i < size; i += 4)
    {
       p[i ] ^= p[i + 2];
@@ -176,6 +179,8 @@ audio_batch:
       frames   = remain_frames;
       goto audio_batch;
    }
+
+   timed_section_end(TIMED_SECTION_AUDIO_RESAMPLE);
 }
 
 /* Abuse core & audio plugin implementation details to obtain the desired effect. */
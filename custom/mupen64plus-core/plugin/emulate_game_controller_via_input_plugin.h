@@ -30,4 +30,10 @@ int egcvip_is_connected(void* opaque, enum pak_type* pak);
 
 uint32_t egcvip_get_input(void* opaque);
 
+/* Called at each VI, the next controller read takes a new snapshot of the
+ * input. Returns 1 if the frontend gets polled right before that, which
+ * happens with late latching when the game read its controllers in the
+ * frame which ended, and polling is possible (can_poll). */
+int egcvip_new_frame(int can_poll);
+
 #endif
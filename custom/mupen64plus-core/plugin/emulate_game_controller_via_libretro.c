@@ -24,6 +24,7 @@
 
 #include "api/m64p_plugin.h"
 #include "device/controllers/game_controller.h"
+#include "main/profile.h"
 #include <libretro.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +38,7 @@
 
 extern retro_environment_t environ_cb;
 extern retro_input_state_t input_cb;
+extern retro_input_poll_t poll_cb;
 extern struct retro_rumble_interface rumble;
 extern int pad_pak_types[4];
 extern int pad_present[4];
@@ -47,8 +49,19 @@ extern int l_cbutton;
 extern int d_cbutton;
 extern int u_cbutton;
 extern bool alternate_mapping;
+extern bool input_late_latching;
 static bool libretro_supports_bitmasks = false;
 
+/* Controller input handed to the game, read from the frontend for all the
+ * ports at the first PIF read after a VI, however often the game polls */
+static struct
+{
+    BUTTONS keys[4];
+    unsigned int ports;     /* bitmask of the ports read */
+    bool taken;             /* since the last VI */
+    bool late_poll;         /* poll the frontend before taking it */
+} snapshot;
+
 extern m64p_rom_header ROM_HEADER;
 
 // Some stuff from n-rage plugin
@@ -308,7 +321,7 @@ static void inputGetKeys_reuse(int16_t analogX, int16_t analogY, int Control, BU
    }
 }
 
-void inputGetKeys_default( int Control, BUTTONS *Keys )
+static void inputGetKeys_read( int Control, BUTTONS *Keys )
 {
    unsigned i;
    bool cbuttons_mode = false;
@@ -381,6 +394,53 @@ void inputGetKeys_default( int Control, BUTTONS *Keys )
    inputGetKeys_reuse(analogX, analogY, Control, Keys);
 }
 
+static void input_take_snapshot(void)
+{
+   int i;
+
+   timed_section_start(TIMED_SECTION_INPUT);
+   if (snapshot.late_poll)
+   {
+      poll_cb();
+      profile_input_polled();
+   }
+
+   snapshot.ports = 0;
+   for (i = 0; i < 4; i++)
+   {
+      if (Controls[i].Present)
+      {
+         inputGetKeys_read(i, &snapshot.keys[i]);
+         snapshot.ports |= 1 << i;
+      }
+   }
+   snapshot.taken = true;
+   profile_input_sampled();
+   timed_section_end(TIMED_SECTION_INPUT);
+}
+
+void inputGetKeys_default( int Control, BUTTONS *Keys )
+{
+   if (!snapshot.taken)
+      input_take_snapshot();
+
+   /* netplay may read a port which isn't plugged in here */
+   if (!(snapshot.ports & (1 << Control)))
+   {
+      inputGetKeys_read(Control, &snapshot.keys[Control]);
+      snapshot.ports |= 1 << Control;
+   }
+
+   *Keys = snapshot.keys[Control];
+}
+
+int egcvip_new_frame(int can_poll)
+{
+   snapshot.late_poll = can_poll && input_late_latching && snapshot.taken;
+   snapshot.taken = false;
+   return snapshot.late_poll;
+}
+
 
 /******************************************************************
   Function: InitiateControllers
@@ -413,6 +473,7 @@ EXPORT void CALL inputInitiateControllers(CONTROL_INFO ControlInfo)
 
    getKeys = inputGetKeys_default;
    inputGetKeys_default_descriptor();
+   memset(&snapshot, 0, sizeof(snapshot));
 }
 
 /******************************************************************
@@ -136,5 +136,17 @@ typedef struct _rsp_plugin_functions
 
 extern rsp_plugin_functions rsp;
 
+/* HLE RSP extension, used to run audio tasks asynchronously */
+EXPORT void CALL hleSetTaskRegisters(unsigned int* mi_intr, unsigned int* sp_status);
+EXPORT int CALL hleAudioTaskFootprint(void (*add_range)(void*, uint32_t, uint32_t), void* opaque);
+
+/* HLE RSP instances besides the plugin's own one, each with its own task
+ * state and core callbacks */
+struct hle_plugin;
+EXPORT struct hle_plugin* CALL hleCreateInstance(RSP_INFO Rsp_Info);
+EXPORT void CALL hleDestroyInstance(struct hle_plugin* plugin);
+EXPORT unsigned int CALL hleInstanceDoRspCycles(struct hle_plugin* plugin, unsigned int Cycles);
+EXPORT void CALL hleInstanceRomClosed(struct hle_plugin* plugin);
+
 #endif
 
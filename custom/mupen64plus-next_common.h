@@ -113,6 +113,8 @@ extern uint32_t EnableFXAA;
 extern uint32_t MultiSampling;
 extern uint32_t EnableFragmentDepthWrite;
 extern uint32_t EnableShadersStorage;
+extern uint32_t EnableAsyncShaderCompile;
+extern uint32_t ShaderWarmupCount;
 extern uint32_t EnableTextureCache;
 extern uint32_t EnableFBEmulation;
 extern uint32_t EnableFrameDuping;
@@ -120,6 +122,8 @@ extern uint32_t EnableLODEmulation;
 extern uint32_t EnableFullspeed;
 extern uint32_t CountPerOp;
 extern uint32_t CountPerOpDenomPot;
+extern uint32_t CountPerOpCalibration;
+extern uint32_t IdleLoopSkip;
 extern uint32_t CountPerScanlineOverride;
 extern uint32_t BackgroundMode;
 extern uint32_t EnableEnhancedTextureStorage;
@@ -128,6 +132,8 @@ extern uint32_t EnableEnhancedHighResStorage;
 extern uint32_t EnableTxCacheCompression;
 extern uint32_t ForceDisableExtraMem;
 extern uint32_t IgnoreTLBExceptions;
+extern uint32_t EnableFrameProfiler;
+extern uint32_t EnableAsyncAudioRSP;
 extern uint32_t EnableNativeResFactor;
 extern uint32_t EnableN64DepthCompare;
 extern uint32_t EnableThreadedRenderer;
@@ -0,0 +1,281 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - fbconv_bench.cpp                                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* GLideN64 buffer copy row check, built with `make fbconvbench`.
+ *
+ * Writes random rows to RDRAM through writeRowToRdram with every converter
+ * of ColorBufferToRDRAM.cpp and DepthBufferToRDRAM.cpp, once as they are and
+ * once with convertRow disabled so that convert() does all pixels:
+ *
+ *   r8        RGBAtoR8
+ *   rgba32    RGBAtoRGBA32, with transparent pixels that keep RDRAM
+ *   rgba16    RGBAtoRGBA16 for the four dither / Paper Mario hack variants,
+ *             dithered with the bayer, magic square and blue noise tables
+ *   depth     FloatToUInt16, including negative, >= 1, infinite and NaN z
+ *
+ * Rows start at every offset in a swizzle group. The whole RDRAM buffer has
+ * to be bit-identical after both writes, the first difference is printed.
+ * The time of both paths over full 640 pixel rows is printed at the end.
+ *
+ * The two sources are built into this file to reach the converters in
+ * their anonymous namespaces; the rest comes from the core objects.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "BufferCopy/ColorBufferToRDRAM.cpp"
+#include "BufferCopy/DepthBufferToRDRAM.cpp"
+
+#ifdef __SSE_OPT
+
+#define FBCONV_WIDTH 640
+/* longest row of a case, and room for the start offset and a guard */
+#define FBCONV_ROW (FBCONV_WIDTH + 64)
+#define FBCONV_GUARD 16
+
+/* Forwards to a converter with convertRow disabled */
+template <class Converter>
+struct ScalarOnly
+{
+	const Converter & m_converter;
+
+	ScalarOnly(const Converter & _converter) : m_converter(_converter) {}
+
+	template <typename TSrc>
+	bool test(TSrc _c) const { return m_converter.test(_c); }
+
+	template <typename TSrc>
+	auto convert(TSrc _c, u32 x, u32 y) const -> decltype(m_converter.convert(_c, x, y))
+	{
+		return m_converter.convert(_c, x, y);
+	}
+
+	template <typename TSrc, typename TDst>
+	u32 convertRow(const TSrc * _src, TDst * _dst, u32 x, u32 _count, u32 y) const { return 0; }
+};
+
+struct bench_case
+{
+	u32 x;
+	u32 y;
+	u32 dstIdx;
+	u32 count;
+};
+
+static std::mt19937 rng;
+
+static u32 urand(u32 _lo, u32 _hi)
+{
+	return std::uniform_int_distribution<u32>(_lo, _hi)(rng);
+}
+
+static bench_case random_case()
+{
+	bench_case c;
+	c.x = urand(0, FBCONV_WIDTH);
+	c.y = urand(0, 479);
+	c.dstIdx = urand(0, 7);
+	c.count = urand(0, 3) == 0 ? urand(0, 16) : urand(0, FBCONV_WIDTH);
+	return c;
+}
+
+/* Pixels with the fields the converters branch on: zero words, zero alpha,
+ * blue around the Paper Mario range and channels near the clamp limits */
+static u32 random_color()
+{
+	u32 c = rng();
+	switch (urand(0, 7)) {
+	case 0:
+		return 0;
+	case 1:
+		return c & 0x00FFFFFF;
+	case 2:
+		return (c & 0xFF00FFFF) | (urand(0xF8, 0xFF) << 16);
+	case 3:
+		return (c & 0xFF00FFFF) | (urand(0, 4) << 16);
+	case 4:
+		return c | 0x00FCFCFC;
+	case 5:
+		return c & 0xFF030303;
+	default:
+		return c;
+	}
+}
+
+static f32 random_depth()
+{
+	switch (urand(0, 9)) {
+	case 0:
+		return -std::uniform_real_distribution<f32>(0.0f, 1.0f)(rng);
+	case 1:
+		return 1.0f + std::uniform_real_distribution<f32>(0.0f, 1.0f)(rng);
+	case 2: {
+		static const f32 special[] = {
+			0.0f, -0.0f, 1.0f, 0.99999994f, 1.0f / 524288.0f,
+			std::numeric_limits<f32>::infinity(), -std::numeric_limits<f32>::infinity(),
+			std::numeric_limits<f32>::quiet_NaN(), std::numeric_limits<f32>::denorm_min(),
+		};
+		return special[urand(0, sizeof(special) / sizeof(special[0]) - 1)];
+	}
+	case 3:
+		/* rounding boundaries of the LUT index */
+		return (urand(0, 0x3FFFF) + 0.5f) / 262144.0f;
+	default:
+		return std::uniform_real_distribution<f32>(0.0f, 1.0f)(rng);
+	}
+}
+
+static void random_dither(DitherTable & _table)
+{
+	static const u32 modes[] = {
+		Config::BufferDitheringMode::bdmBayer,
+		Config::BufferDitheringMode::bdmMagicSquare,
+		Config::BufferDitheringMode::bdmBlueNoise,
+	};
+	config.generalEmulation.enableDitheringPattern = 0;
+	config.generalEmulation.rdramImageDitheringMode = modes[urand(0, 2)];
+	fillDitherTable(_table, urand(0, 7));
+}
+
+template <typename TSrc, typename TDst, class Converter>
+static bool check(const char * _name, const Converter & _converter, u32 _xor,
+	TSrc (*_random)(), unsigned _cases)
+{
+	std::vector<TSrc> src(FBCONV_ROW);
+	std::vector<TDst> ref(FBCONV_ROW + FBCONV_GUARD), row(FBCONV_ROW + FBCONV_GUARD);
+
+	for (unsigned n = 0; n < _cases; ++n) {
+		const bench_case c = random_case();
+		for (TSrc & s : src)
+			s = _random();
+		for (TDst & d : ref)
+			d = (TDst)rng();
+		row = ref;
+
+		writeRowToRdram(src.data(), ref.data(), ScalarOnly<Converter>(_converter), _xor, c.dstIdx, c.x, c.count, c.y);
+		writeRowToRdram(src.data(), row.data(), _converter, _xor, c.dstIdx, c.x, c.count, c.y);
+
+		for (size_t i = 0; i < ref.size(); ++i) {
+			if (ref[i] == row[i])
+				continue;
+			printf("%-10s mismatch in case %u (x %u, y %u, dst %u, count %u) at pixel %u: 0x%08x != 0x%08x\n",
+				_name, n, c.x, c.y, c.dstIdx, c.count, (unsigned)i, (unsigned)ref[i], (unsigned)row[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename TSrc, typename TDst, class Converter>
+static double time_rows(const Converter & _converter, u32 _xor, const std::vector<TSrc> & _src,
+	std::vector<TDst> & _dst, unsigned _repeats)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned r = 0; r < _repeats; ++r)
+		for (u32 y = 0; y < 480; ++y)
+			writeRowToRdram(_src.data(), _dst.data(), _converter, _xor, 0, 0, FBCONV_WIDTH, y);
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename TSrc, typename TDst, class Converter>
+static void bench(const char * _name, const Converter & _converter, u32 _xor,
+	TSrc (*_random)(), unsigned _repeats)
+{
+	std::vector<TSrc> src(FBCONV_WIDTH);
+	std::vector<TDst> dst(FBCONV_WIDTH);
+	for (TSrc & s : src)
+		s = _random();
+
+	const double refMs = time_rows(ScalarOnly<Converter>(_converter), _xor, src, dst, _repeats);
+	const double rowMs = time_rows(_converter, _xor, src, dst, _repeats);
+	const double mpix = (double)FBCONV_WIDTH * 480 * _repeats / 1e6;
+	printf("%-10s scalar %8.2f ms %8.1f Mpix/s, sse %8.2f ms %8.1f Mpix/s  %.2fx\n",
+		_name, refMs, mpix * 1000.0 / refMs, rowMs, mpix * 1000.0 / rowMs, refMs / rowMs);
+}
+
+static u8 random_r8() { return (u8)rng(); }
+
+int main(int argc, char **argv)
+{
+	unsigned cases = 3000;
+	unsigned repeats = 100;
+	unsigned seed = 1;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			cases = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			repeats = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 0);
+		else {
+			fprintf(stderr,
+				"usage: %s [options]\n"
+				"  -n <n>        random rows per converter (default 3000)\n"
+				"  -r <n>        timed 640x480 frames per converter (default 100)\n"
+				"  -s <seed>     seed for the rows (default 1)\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	rng.seed(seed);
+
+	static DitherTable dither;
+	random_dither(dither);
+	const FloatToUInt16 depth;
+
+	bool ok = check<u8, u8>("r8", RGBAtoR8(), 3, random_r8, cases);
+	ok &= check<u32, u32>("rgba32", RGBAtoRGBA32(), 0, random_color, cases);
+	ok &= check<u32, u16>("rgba16", RGBAtoRGBA16<false, false>(dither), 1, random_color, cases);
+	ok &= check<u32, u16>("rgba16 pm", RGBAtoRGBA16<false, true>(dither), 1, random_color, cases);
+	/* a new table for every few rows, so that all modes are covered */
+	for (unsigned n = 0; n < cases && ok; n += 100) {
+		const unsigned count = std::min(100u, cases - n);
+		random_dither(dither);
+		ok &= check<u32, u16>("rgba16 d", RGBAtoRGBA16<true, false>(dither), 1, random_color, count);
+		ok &= check<u32, u16>("rgba16 dpm", RGBAtoRGBA16<true, true>(dither), 1, random_color, count);
+	}
+	ok &= check<f32, u16>("depth", depth, 1, random_depth, cases);
+
+	bench<u8, u8>("r8", RGBAtoR8(), 3, random_r8, repeats);
+	bench<u32, u32>("rgba32", RGBAtoRGBA32(), 0, random_color, repeats);
+	bench<u32, u16>("rgba16", RGBAtoRGBA16<false, false>(dither), 1, random_color, repeats);
+	bench<u32, u16>("rgba16 dpm", RGBAtoRGBA16<true, true>(dither), 1, random_color, repeats);
+	bench<f32, u16>("depth", depth, 1, random_depth, repeats);
+
+	printf(ok ? "all rows match the scalar converters\n" : "FAILED\n");
+	return ok ? 0 : 2;
+}
+
+#else
+
+int main(int argc, char **argv)
+{
+	fprintf(stderr, "%s: built without the SSE buffer copy (__SSE_OPT)\n", argv[0]);
+	return 1;
+}
+
+#endif // __SSE_OPT
@@ -0,0 +1,202 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - glcmd_bench.cpp                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Threaded GL command stream benchmark, built with `make glcmdbench`.
+ *
+ * Drives the threaded GLideN64 wrapper with a synthetic frame made of the
+ * state changes and draws a typical N64 frame produces, against a null GL
+ * backend: every GL entry point the frame uses is a stub which only counts
+ * its calls. What is measured is therefore the cost of queueing, handing
+ * over and dispatching commands, not of the driver.
+ *
+ * The GL side runs on a second thread as a coroutine, the same way the
+ * libretro frontend thread runs it. Every frame also creates and deletes a
+ * texture (glGenTextures jumps the queue) and ends with a synced
+ * glGetIntegerv and a buffer swap.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+#include <libco.h>
+#include "Graphics/OpenGLContext/ThreadedOpenGl/opengl_Wrapper.h"
+
+using namespace opengl;
+
+extern "C" {
+	extern cothread_t retro_thread;
+	extern bool retro_savestate_complete;
+	extern uint32_t EnableThreadedRenderer;
+	extern bool threaded_gl_safe_shutdown;
+	void gln64_thr_gl_invoke_command_loop();
+}
+
+/* only touched by the GL thread until it has shut down */
+static unsigned long long null_calls;
+static unsigned long long null_vertices;
+
+static void GLAPIENTRY null_BlendFunc(GLenum, GLenum) { null_calls++; }
+static void GLAPIENTRY null_Enable(GLenum) { null_calls++; }
+static void GLAPIENTRY null_Disable(GLenum) { null_calls++; }
+static void GLAPIENTRY null_DepthMask(GLboolean) { null_calls++; }
+static void GLAPIENTRY null_Scissor(GLint, GLint, GLsizei, GLsizei) { null_calls++; }
+static void GLAPIENTRY null_BindTexture(GLenum, GLuint) { null_calls++; }
+static void GLAPIENTRY null_UseProgram(GLuint) { null_calls++; }
+static void GLAPIENTRY null_Uniform1i(GLint, GLint) { null_calls++; }
+static void GLAPIENTRY null_Uniform2f(GLint, GLfloat, GLfloat) { null_calls++; }
+static void GLAPIENTRY null_Uniform4fv(GLint, GLsizei, const GLfloat *) { null_calls++; }
+static void GLAPIENTRY null_BindBuffer(GLenum, GLuint) { null_calls++; }
+static void GLAPIENTRY null_BufferData(GLenum, GLsizeiptr, const void *, GLenum) { null_calls++; }
+static void GLAPIENTRY null_DrawArrays(GLenum, GLint, GLsizei count) { null_calls++; null_vertices += count; }
+static void GLAPIENTRY null_GetIntegerv(GLenum, GLint *data) { null_calls++; *data = 1; }
+static void GLAPIENTRY null_GenTextures(GLsizei n, GLuint *textures) { null_calls++; while (n-- > 0) textures[n] = 1; }
+static void GLAPIENTRY null_DeleteTextures(GLsizei, const GLuint *) { null_calls++; }
+
+static void install_null_gl()
+{
+	ptrBlendFunc = null_BlendFunc;
+	ptrEnable = null_Enable;
+	ptrDisable = null_Disable;
+	ptrDepthMask = null_DepthMask;
+	ptrScissor = null_Scissor;
+	ptrBindTexture = null_BindTexture;
+	ptrUseProgram = null_UseProgram;
+	ptrUniform1i = null_Uniform1i;
+	ptrUniform2f = null_Uniform2f;
+	ptrUniform4fv = null_Uniform4fv;
+	ptrBindBuffer = null_BindBuffer;
+	ptrBufferData = null_BufferData;
+	ptrDrawArrays = null_DrawArrays;
+	ptrGetIntegerv = null_GetIntegerv;
+	ptrGenTextures = null_GenTextures;
+	ptrDeleteTextures = null_DeleteTextures;
+}
+
+/* stands in for the libretro frontend thread: keeps resuming the GL coroutine,
+ * which yields back on every buffer swap */
+static void gl_thread()
+{
+	retro_thread = co_active();
+	cothread_t gl_coroutine = co_create(65536 * sizeof(void*) * 16, gln64_thr_gl_invoke_command_loop);
+	while (!threaded_gl_safe_shutdown)
+		co_switch(gl_coroutine);
+	co_delete(gl_coroutine);
+}
+
+/* one draw call worth of state changes, 10 commands */
+static void draw(unsigned i)
+{
+	const GLfloat color[4] = { 1.0f, 0.5f, 0.25f, (GLfloat)(i & 0xff) };
+
+	FunctionWrapper::wrUseProgram(1 + (i & 7));
+	FunctionWrapper::wrUniform4fv(0, 1, color);
+	FunctionWrapper::wrUniform1i(1, i & 1);
+	FunctionWrapper::wrUniform2f(2, (GLfloat)i, 0.5f);
+	FunctionWrapper::wrBindTexture(GL_TEXTURE_2D, 1 + (i & 3));
+	if (i & 1)
+		FunctionWrapper::wrEnable(GL_BLEND);
+	else
+		FunctionWrapper::wrDisable(GL_BLEND);
+	FunctionWrapper::wrBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	FunctionWrapper::wrScissor(0, 0, 320, 240);
+	FunctionWrapper::wrDepthMask(i & 2 ? GL_TRUE : GL_FALSE);
+	FunctionWrapper::wrDrawArrays(GL_TRIANGLES, 0, 3 + (i & 15));
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -f <n>        frames (default 2000)\n"
+		"  -d <n>        draw calls per frame (default 500)\n",
+		argv0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned frames = 2000;
+	unsigned draws = 500;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-f") && i + 1 < argc)
+			frames = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			draws = strtoul(argv[++i], nullptr, 0);
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	install_null_gl();
+	retro_savestate_complete = true;
+	EnableThreadedRenderer = 1;
+	FunctionWrapper::setThreadedMode(1);
+	std::thread consumer(gl_thread);
+
+	/* real vertex buffers, so draws take the buffered path */
+	FunctionWrapper::wrBindBuffer(GL_ARRAY_BUFFER, 1);
+	FunctionWrapper::wrBufferData(GL_ARRAY_BUFFER, 4096, nullptr, GL_DYNAMIC_DRAW);
+	unsigned long long commands = 2;
+	unsigned long long vertices = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	double syncMs = 0.0;
+	for (unsigned f = 0; f < frames; f++) {
+		GLuint texture = 0;
+		FunctionWrapper::wrGenTextures(1, &texture);
+		commands++;
+
+		for (unsigned i = 0; i < draws; i++) {
+			draw(f * draws + i);
+			vertices += 3 + ((f * draws + i) & 15);
+		}
+		commands += draws * 10;
+
+		FunctionWrapper::wrDeleteTextures(1, &texture);
+		commands++;
+
+		auto syncStart = std::chrono::steady_clock::now();
+		GLint value = 0;
+		FunctionWrapper::wrGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+		syncMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - syncStart).count();
+		commands++;
+
+		FunctionWrapper::WaitForSwapBuffersQueued();
+		FunctionWrapper::CoreVideo_GL_SwapBuffers();
+	}
+	FunctionWrapper::CoreVideo_Quit();
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	consumer.join();
+
+	printf("frames:      %u x %u draws\n", frames, draws);
+	printf("commands:    %llu (%llu executed)\n", commands, null_calls);
+	printf("total:       %.2f ms, %.2f ms per frame\n", ms, ms / frames);
+	printf("per command: %.1f ns\n", ms * 1e6 / commands);
+	printf("sync wait:   %.2f ms per frame\n", syncMs / frames);
+
+	const bool ok = null_calls == commands && null_vertices == vertices;
+	if (!ok)
+		printf("MISMATCH: expected %llu commands and %llu vertices, got %llu and %llu\n",
+			commands, vertices, null_calls, null_vertices);
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,553 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - instances_bench.c                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Instances per core benchmark for the software render path, built with
+ * `make instbench`.
+ *
+ * Runs N independent HLE RSP and angrylion instances in one process, each
+ * with its own RDRAM, DMEM/IMEM and RSP, RDP and VI registers, driven
+ * round-robin from one thread the way a farm time-slices them on a core.
+ * Every frame, each instance
+ *
+ *   - runs an ABI1 audio task through its HLE instance: ADPCM decoding,
+ *     resampling and mixing of several voices, saved back to RDRAM
+ *   - renders shaded triangles over a cleared 320x240 frame buffer through
+ *     its angrylion instance
+ *   - scans the frame out through the angrylion VI
+ *
+ * Each instance is also run alone first. The audio output, frame buffer and
+ * VI output hashes of the interleaved run have to match the ones of the solo
+ * runs, so any state shared between instances fails the run.
+ *
+ * The core itself (r4300, devices, dynarec) still runs one instance per
+ * process, so it is not part of this benchmark.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "api/m64p_frontend.h"
+#include "plugin/plugin.h"
+
+#include "../mupen64plus-video-angrylion/n64video.h"
+#include "../mupen64plus-video-angrylion/vdac.h"
+
+#define RDRAM_SIZE          0x400000
+
+/* RDRAM layout of every instance */
+#define AUDIO_UCODE_DATA    0x100000
+#define AUDIO_ALIST         0x101000
+#define AUDIO_CODEBOOK      0x102000
+#define AUDIO_STATE         0x103000
+#define AUDIO_SAMPLES       0x110000
+#define AUDIO_OUT           0x120000
+#define RDP_LIST            0x130000
+#define FRAME_BUFFER        0x200000
+
+#define FB_WIDTH            320
+#define FB_HEIGHT           240
+
+#define VOICES              8
+#define TRIANGLES           24
+
+/* ABI1 audio commands and the DMEM buffers of the alist, relative to the
+ * ABI1 buffer base */
+enum { A_ADPCM = 1, A_CLEARBUFF = 2, A_LOADBUFF = 4, A_RESAMPLE = 5, A_SAVEBUFF = 6,
+       A_SETBUFF = 8, A_LOADADPCM = 11, A_MIXER = 12 };
+enum { BUF_IN = 0x000, BUF_DECODED = 0x200, BUF_RESAMPLED = 0x400, BUF_MIX = 0x600,
+       BUF_COUNT = 0x160 };
+
+/* OSTask fields in DMEM */
+enum { TASK_TYPE = 0xfc0, TASK_UCODE_BOOT_SIZE = 0xfcc, TASK_UCODE = 0xfd0,
+       TASK_UCODE_DATA = 0xfd8, TASK_UCODE_DATA_SIZE = 0xfdc, TASK_DATA_PTR = 0xff0,
+       TASK_DATA_SIZE = 0xff4 };
+
+struct instance
+{
+    uint8_t* rdram;
+    uint8_t dmem[0x1000];
+    uint8_t imem[0x1000];
+
+    unsigned int mi_intr;
+    unsigned int sp_reg[9];
+    uint32_t dp_reg[DP_NUM_REG];
+    uint32_t vi_reg[VI_NUM_REG];
+    uint32_t* dp_reg_ptr[DP_NUM_REG];
+    uint32_t* vi_reg_ptr[VI_NUM_REG];
+
+    struct hle_plugin* rsp;
+    struct n64video* video;
+
+    uint32_t seed;
+    uint32_t frame;
+
+    uint32_t audio_hash;
+    uint32_t vi_hash;
+};
+
+/* last frame written by the VI, the output functions are shared by all
+ * instances and only record what they were given */
+static uint32_t vdac_hash;
+
+void msg_error(const char* err, ...) { (void)err; }
+void msg_warning(const char* err, ...) { (void)err; }
+void msg_debug(const char* err, ...) { (void)err; }
+
+static uint32_t hash_bytes(uint32_t h, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+
+    while (size--)
+        h = (h ^ *p++) * 16777619u;
+
+    return h;
+}
+
+void vdac_init(struct n64video_config* cfg) { (void)cfg; }
+void vdac_read(struct frame_buffer* fb, bool alpha) { (void)fb; (void)alpha; }
+void vdac_sync(bool invalid) { (void)invalid; }
+void vdac_close(void) { }
+
+void vdac_write(struct frame_buffer* fb)
+{
+    uint32_t y;
+
+    vdac_hash = 2166136261u;
+    for (y = 0; y < fb->height; y++)
+        vdac_hash = hash_bytes(vdac_hash, &fb->pixels[y * fb->pitch], fb->width * sizeof(*fb->pixels));
+}
+
+EXPORT m64p_error CALL CoreDoCommand(m64p_command cmd, int param_int, void* param_ptr)
+{
+    (void)cmd; (void)param_int; (void)param_ptr;
+    return M64ERR_UNSUPPORTED;
+}
+
+static void check_interrupts(void) { }
+
+static double now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+static uint32_t rng(uint32_t* state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void rdram_write_u32(struct instance* inst, uint32_t address, uint32_t value)
+{
+    memcpy(&inst->rdram[address], &value, sizeof(value));
+}
+
+static void dmem_write_u32(struct instance* inst, uint32_t address, uint32_t value)
+{
+    memcpy(&inst->dmem[address], &value, sizeof(value));
+}
+
+static void instance_destroy(struct instance* inst)
+{
+    if (inst->video) {
+        n64video_close(inst->video);
+        n64video_destroy(inst->video);
+    }
+    if (inst->rsp) {
+        hleDestroyInstance(inst->rsp);
+    }
+    free(inst->rdram);
+    free(inst);
+}
+
+static struct instance* instance_create(uint32_t seed, uint32_t workers)
+{
+    static const uint32_t vi_setup[VI_NUM_REG] = {
+        0x0000320e, FRAME_BUFFER, FB_WIDTH, 0x00000002, 0, 0x03e52239, 0x0000020d,
+        0x00000c15, 0x0c150c15, 0x006c02ec, 0x002501ff, 0x000e0204, 0x00000200,
+        0x00000400
+    };
+    struct instance* inst = calloc(1, sizeof(*inst));
+    struct n64video_config config;
+    RSP_INFO rsp_info;
+    uint32_t i, state;
+
+    if (!inst || !(inst->rdram = calloc(1, RDRAM_SIZE))) {
+        free(inst);
+        return NULL;
+    }
+
+    inst->seed = seed;
+    state = seed;
+
+    for (i = 0; i < DP_NUM_REG; i++)
+        inst->dp_reg_ptr[i] = &inst->dp_reg[i];
+    for (i = 0; i < VI_NUM_REG; i++) {
+        inst->vi_reg[i] = vi_setup[i];
+        inst->vi_reg_ptr[i] = &inst->vi_reg[i];
+    }
+
+    /* the words the HLE identifies the ABI1 audio ucode by */
+    rdram_write_u32(inst, AUDIO_UCODE_DATA, 0x00000001);
+    rdram_write_u32(inst, AUDIO_UCODE_DATA + 0x28, 0x1e24138c);
+    rdram_write_u32(inst, AUDIO_UCODE_DATA + 0x30, 0xf0000f00);
+
+    /* small predictors, so the decoded samples don't just saturate */
+    for (i = 0; i < 0x80; i += 2) {
+        uint16_t coef = (rng(&state) & 0x7ff) - 0x400;
+        memcpy(&inst->rdram[AUDIO_CODEBOOK + i], &coef, sizeof(coef));
+    }
+    for (i = 0; i < VOICES * 0x1000; i += 4)
+        rdram_write_u32(inst, AUDIO_SAMPLES + i, rng(&state));
+
+    memset(&rsp_info, 0, sizeof(rsp_info));
+    rsp_info.RDRAM = inst->rdram;
+    rsp_info.DMEM = inst->dmem;
+    rsp_info.IMEM = inst->imem;
+    rsp_info.MI_INTR_REG = &inst->mi_intr;
+    rsp_info.SP_MEM_ADDR_REG = &inst->sp_reg[0];
+    rsp_info.SP_DRAM_ADDR_REG = &inst->sp_reg[1];
+    rsp_info.SP_RD_LEN_REG = &inst->sp_reg[2];
+    rsp_info.SP_WR_LEN_REG = &inst->sp_reg[3];
+    rsp_info.SP_STATUS_REG = &inst->sp_reg[4];
+    rsp_info.SP_DMA_FULL_REG = &inst->sp_reg[5];
+    rsp_info.SP_DMA_BUSY_REG = &inst->sp_reg[6];
+    rsp_info.SP_PC_REG = &inst->sp_reg[7];
+    rsp_info.SP_SEMAPHORE_REG = &inst->sp_reg[8];
+    rsp_info.DPC_START_REG = (unsigned int*)&inst->dp_reg[DP_START];
+    rsp_info.DPC_END_REG = (unsigned int*)&inst->dp_reg[DP_END];
+    rsp_info.DPC_CURRENT_REG = (unsigned int*)&inst->dp_reg[DP_CURRENT];
+    rsp_info.DPC_STATUS_REG = (unsigned int*)&inst->dp_reg[DP_STATUS];
+    rsp_info.DPC_CLOCK_REG = (unsigned int*)&inst->dp_reg[DP_CLOCK];
+    rsp_info.DPC_BUFBUSY_REG = (unsigned int*)&inst->dp_reg[DP_BUFBUSY];
+    rsp_info.DPC_PIPEBUSY_REG = (unsigned int*)&inst->dp_reg[DP_PIPEBUSY];
+    rsp_info.DPC_TMEM_REG = (unsigned int*)&inst->dp_reg[DP_TMEM];
+
+    inst->rsp = hleCreateInstance(rsp_info);
+    inst->video = n64video_create();
+    if (!inst->rsp || !inst->video) {
+        instance_destroy(inst);
+        return NULL;
+    }
+
+    n64video_config_init(&config);
+    config.gfx.rdram = inst->rdram;
+    config.gfx.rdram_size = RDRAM_SIZE;
+    config.gfx.dmem = inst->dmem;
+    config.gfx.vi_reg = inst->vi_reg_ptr;
+    config.gfx.dp_reg = inst->dp_reg_ptr;
+    config.gfx.mi_intr_reg = (uint32_t*)&inst->mi_intr;
+    config.gfx.mi_intr_cb = check_interrupts;
+    config.parallel = workers > 1;
+    config.num_workers = workers;
+    config.vi.pipeline = false;
+    n64video_init(inst->video, &config);
+
+    return inst;
+}
+
+static uint32_t put_acmd(struct instance* inst, uint32_t address, uint32_t w1, uint32_t w2)
+{
+    rdram_write_u32(inst, address, w1);
+    rdram_write_u32(inst, address + 4, w2);
+    return address + 8;
+}
+
+static void run_audio(struct instance* inst)
+{
+    uint32_t address = AUDIO_ALIST;
+    uint32_t v, init = inst->frame == 0 ? 0x01 : 0x00;
+    uint32_t state = inst->seed ^ (inst->frame * 0x9e3779b9u);
+
+    address = put_acmd(inst, address, A_LOADADPCM << 24 | 0x80, AUDIO_CODEBOOK);
+    address = put_acmd(inst, address, A_CLEARBUFF << 24 | BUF_MIX, BUF_COUNT);
+
+    for (v = 0; v < VOICES; v++) {
+        uint32_t samples = AUDIO_SAMPLES + v * 0x1000 + (inst->frame * 99) % 0xc00;
+        uint32_t pitch = 0x6000 + (rng(&state) & 0x3fff);
+        uint32_t gain = 0x1000 + (rng(&state) & 0x3fff);
+
+        address = put_acmd(inst, address, A_SETBUFF << 24 | BUF_IN, BUF_DECODED << 16 | BUF_COUNT);
+        address = put_acmd(inst, address, A_LOADBUFF << 24, samples);
+        address = put_acmd(inst, address, A_ADPCM << 24 | init << 16, AUDIO_STATE + v * 0x100);
+        address = put_acmd(inst, address, A_SETBUFF << 24 | BUF_DECODED, BUF_RESAMPLED << 16 | BUF_COUNT);
+        address = put_acmd(inst, address, A_RESAMPLE << 24 | init << 16 | pitch, AUDIO_STATE + v * 0x100 + 0x40);
+        address = put_acmd(inst, address, A_MIXER << 24 | gain, BUF_RESAMPLED << 16 | BUF_MIX);
+    }
+
+    address = put_acmd(inst, address, A_SETBUFF << 24 | BUF_IN, BUF_MIX << 16 | BUF_COUNT);
+    address = put_acmd(inst, address, A_SAVEBUFF << 24, AUDIO_OUT);
+
+    memset(inst->dmem, 0, sizeof(inst->dmem));
+    dmem_write_u32(inst, TASK_TYPE, 2);
+    dmem_write_u32(inst, TASK_UCODE_BOOT_SIZE, 0xd0);
+    dmem_write_u32(inst, TASK_UCODE, AUDIO_UCODE_DATA);
+    dmem_write_u32(inst, TASK_UCODE_DATA, AUDIO_UCODE_DATA);
+    dmem_write_u32(inst, TASK_UCODE_DATA_SIZE, 0x800);
+    dmem_write_u32(inst, TASK_DATA_PTR, AUDIO_ALIST);
+    dmem_write_u32(inst, TASK_DATA_SIZE, address - AUDIO_ALIST);
+
+    hleInstanceDoRspCycles(inst->rsp, 0);
+
+    inst->audio_hash = hash_bytes(inst->audio_hash, &inst->rdram[AUDIO_OUT], BUF_COUNT);
+}
+
+/* splits a pair of s15.16 values into the integer and fraction words of the
+ * RDP shade coefficients */
+static void put_shade_pair(uint32_t* w, int i, int32_t a, int32_t b)
+{
+    w[i] = ((uint32_t)a & 0xffff0000) | ((uint32_t)b >> 16);
+    w[i + 4] = ((uint32_t)a << 16) | ((uint32_t)b & 0xffff);
+}
+
+static uint32_t put_triangle(struct instance* inst, uint32_t address, uint32_t* state)
+{
+    int32_t x[3], y[3], t, i, j, lft;
+    int32_t dxhdy, dxmdy, dxldy;
+    uint32_t w[24];
+
+    for (i = 0; i < 3; i++) {
+        x[i] = rng(state) % FB_WIDTH;
+        y[i] = rng(state) % FB_HEIGHT;
+    }
+
+    /* sort by y, keeping the edges non-horizontal */
+    for (i = 0; i < 3; i++) {
+        for (j = i + 1; j < 3; j++) {
+            if (y[j] < y[i]) {
+                t = y[i]; y[i] = y[j]; y[j] = t;
+                t = x[i]; x[i] = x[j]; x[j] = t;
+            }
+        }
+    }
+    if (y[1] == y[0])
+        y[1]++;
+    if (y[2] <= y[1])
+        y[2] = y[1] + 1;
+
+    dxhdy = (int32_t)(((int64_t)(x[2] - x[0]) << 16) / (y[2] - y[0]));
+    dxmdy = (int32_t)(((int64_t)(x[1] - x[0]) << 16) / (y[1] - y[0]));
+    dxldy = (int32_t)(((int64_t)(x[2] - x[1]) << 16) / (y[2] - y[1]));
+
+    /* the major edge is on the left when the middle vertex is right of it */
+    lft = ((int64_t)x[1] << 16) > ((int64_t)x[0] << 16) + (int64_t)dxhdy * (y[1] - y[0]);
+
+    memset(w, 0, sizeof(w));
+    w[0] = 0x0c << 24 | lft << 23 | ((y[2] * 4) & 0x3fff);
+    w[1] = ((y[1] * 4) & 0x3fff) << 16 | ((y[0] * 4) & 0x3fff);
+    w[2] = (uint32_t)(x[1] << 16);
+    w[3] = (uint32_t)dxldy;
+    w[4] = (uint32_t)(x[0] << 16);
+    w[5] = (uint32_t)dxhdy;
+    w[6] = (uint32_t)(x[0] << 16);
+    w[7] = (uint32_t)dxmdy;
+
+    /* color, color per pixel along x, along the major edge and per line */
+    put_shade_pair(w, 8, (rng(state) & 0xff) << 16, (rng(state) & 0xff) << 16);
+    put_shade_pair(w, 9, (rng(state) & 0xff) << 16, 0xff << 16);
+    put_shade_pair(w, 10, 0x8000, -0x4000);
+    put_shade_pair(w, 11, 0x2000, 0);
+    put_shade_pair(w, 16, 0x10000, 0x4000);
+    put_shade_pair(w, 17, -0x8000, 0);
+    put_shade_pair(w, 18, 0x10000, 0x4000);
+    put_shade_pair(w, 19, -0x8000, 0);
+
+    for (i = 0; i < 24; i++)
+        rdram_write_u32(inst, address + i * 4, w[i]);
+
+    return address + sizeof(w);
+}
+
+static uint32_t put_rdp(struct instance* inst, uint32_t address, uint32_t w0, uint32_t w1)
+{
+    rdram_write_u32(inst, address, w0);
+    rdram_write_u32(inst, address + 4, w1);
+    return address + 8;
+}
+
+static void run_video(struct instance* inst)
+{
+    uint32_t address = RDP_LIST;
+    uint32_t state = inst->seed ^ (inst->frame * 0x85ebca6bu) ^ 1;
+    uint32_t i;
+
+    /* clear in fill mode */
+    address = put_rdp(inst, address, 0x3f000000 | 2 << 19 | (FB_WIDTH - 1), FRAME_BUFFER);
+    address = put_rdp(inst, address, 0x2d000000, (FB_WIDTH * 4) << 12 | FB_HEIGHT * 4);
+    address = put_rdp(inst, address, 0x2f300000, 0);
+    address = put_rdp(inst, address, 0x37000000, 0x00010001 * (inst->frame & 0xffff));
+    address = put_rdp(inst, address, 0x36000000 | ((FB_WIDTH - 1) * 4) << 12 | (FB_HEIGHT - 1) * 4, 0);
+    address = put_rdp(inst, address, 0x27000000, 0);
+
+    /* shaded triangles in one cycle mode, the combiner passes the shade */
+    address = put_rdp(inst, address, 0x2f000000, 0);
+    address = put_rdp(inst, address, 0x3c000000 | 15 << 20 | 31 << 15 | 7 << 12 | 7 << 9 | 15 << 5 | 31,
+                      15u << 28 | 15 << 24 | 7 << 21 | 7 << 18 | 4 << 15 | 7 << 12 | 4 << 9 | 4 << 6 | 7 << 3 | 4);
+    for (i = 0; i < TRIANGLES; i++)
+        address = put_triangle(inst, address, &state);
+    address = put_rdp(inst, address, 0x29000000, 0);
+
+    inst->dp_reg[DP_STATUS] = 0;
+    inst->dp_reg[DP_START] = inst->dp_reg[DP_CURRENT] = RDP_LIST;
+    inst->dp_reg[DP_END] = address;
+    n64video_process_list(inst->video);
+
+    inst->vi_reg[VI_V_CURRENT_LINE] = inst->frame & 1;
+    n64video_update_screen(inst->video);
+    inst->vi_hash = hash_bytes(inst->vi_hash, &vdac_hash, sizeof(vdac_hash));
+}
+
+static void run_frame(struct instance* inst)
+{
+    run_audio(inst);
+    run_video(inst);
+    inst->frame++;
+}
+
+static uint32_t frame_buffer_hash(const struct instance* inst)
+{
+    return hash_bytes(2166136261u, &inst->rdram[FRAME_BUFFER], FB_WIDTH * FB_HEIGHT * 2);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t max_instances = 8, frames = 60, workers = 1;
+    uint32_t (*solo)[3];
+    struct instance** insts;
+    double t_solo, t_solo_base = 0;
+    uint32_t n, k, f;
+    int i_arg, failed = 0;
+
+    for (i_arg = 1; i_arg < argc; ++i_arg) {
+        if (!strcmp(argv[i_arg], "-i") && i_arg + 1 < argc)
+            max_instances = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-f") && i_arg + 1 < argc)
+            frames = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-w") && i_arg + 1 < argc)
+            workers = strtoul(argv[++i_arg], NULL, 0);
+        else {
+            fprintf(stderr,
+                "usage: %s [options]\n"
+                "  -i <n>        run 1, 2, 4, ... up to n instances (default 8)\n"
+                "  -f <n>        frames per instance (default 60)\n"
+                "  -w <n>        angrylion workers, shared by all instances (default 1)\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    if (max_instances < 1 || frames < 1) {
+        fprintf(stderr, "need at least one instance and one frame\n");
+        return 1;
+    }
+
+    solo = calloc(max_instances, sizeof(*solo));
+    insts = calloc(max_instances, sizeof(*insts));
+    if (!solo || !insts) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%u frames per instance, %u angrylion worker(s)\n", frames, workers);
+    printf("%9s %12s %12s %14s %10s\n", "instances", "solo fps", "shared fps", "fps/instance", "scaling");
+
+    for (n = 1; n <= max_instances && !failed; n *= 2) {
+        double start, t_shared;
+
+        /* each instance alone, one after the other */
+        t_solo = 0;
+        for (k = 0; k < n; k++) {
+            struct instance* inst = instance_create(0x9e3779b9u * (k + 1), workers);
+            if (!inst) {
+                fprintf(stderr, "can't create instance %u\n", k);
+                return 1;
+            }
+            start = now_us();
+            for (f = 0; f < frames; f++)
+                run_frame(inst);
+            t_solo += now_us() - start;
+            solo[k][0] = inst->audio_hash;
+            solo[k][1] = frame_buffer_hash(inst);
+            solo[k][2] = inst->vi_hash;
+            instance_destroy(inst);
+        }
+
+        /* all of them side by side, one frame each in turn */
+        for (k = 0; k < n; k++) {
+            insts[k] = instance_create(0x9e3779b9u * (k + 1), workers);
+            if (!insts[k]) {
+                fprintf(stderr, "can't create instance %u of %u\n", k, n);
+                return 1;
+            }
+        }
+
+        start = now_us();
+        for (f = 0; f < frames; f++)
+            for (k = 0; k < n; k++)
+                run_frame(insts[k]);
+        t_shared = now_us() - start;
+
+        for (k = 0; k < n; k++) {
+            if (insts[k]->audio_hash != solo[k][0]
+                || frame_buffer_hash(insts[k]) != solo[k][1]
+                || insts[k]->vi_hash != solo[k][2]) {
+                fprintf(stderr, "instance %u of %u: output differs from its solo run "
+                    "(audio %08x/%08x, frame buffer %08x/%08x, vi %08x/%08x)\n",
+                    k, n, insts[k]->audio_hash, solo[k][0], frame_buffer_hash(insts[k]), solo[k][1],
+                    insts[k]->vi_hash, solo[k][2]);
+                failed = 1;
+            }
+            instance_destroy(insts[k]);
+        }
+
+        if (n == 1)
+            t_solo_base = t_shared;
+
+        printf("%9u %12.1f %12.1f %14.1f %9.2fx\n", n,
+            n * frames * 1e6 / t_solo, n * frames * 1e6 / t_shared,
+            frames * 1e6 / t_shared, n * t_solo_base / t_shared);
+    }
+
+    free(solo);
+    free(insts);
+
+    if (failed) {
+        fprintf(stderr, "FAILED\n");
+        return 1;
+    }
+
+    printf("all instances match their solo runs\n");
+    return 0;
+}
@@ -45,9 +45,11 @@
 #include "main/main.h"
 #include "api/callbacks.h"
 #include "main/cheat.h"
+#include "main/count_calibration.h"
 #include "main/version.h"
 #include "main/util.h"
 #include "main/savestates.h"
+#include "main/zip_stream.h"
 #include "main/mupen64plus.ini.h"
 #include "api/m64p_config.h"
 #include "osal_files.h"
@@ -56,6 +58,8 @@
 #include "device/rcp/pi/pi_controller.h"
 #include "device/pif/pif.h"
 #include "libretro_memory.h"
+#include "libretro_profiler.h"
+#include "libretro_memwatch.h"
 
 #include "audio_plugin.h"
 
@@ -81,15 +85,8 @@ void angrylion_set_overscan(unsigned value);
 void angrylion_set_synclevel(unsigned value);
 void angrylion_set_vi_dedither(unsigned value);
 void angrylion_set_vi(unsigned value);
-
-struct rgba
-{
-    uint8_t b;
-    uint8_t g;
-    uint8_t r;
-    uint8_t a;
-};
-extern struct rgba prescale[PRESCALE_WIDTH * PRESCALE_HEIGHT];
+void angrylion_set_vi_pipeline(unsigned value);
+void *angrylion_present_screen(void);
 #endif // HAVE_THR_AL
 
 #if defined(HAVE_PARALLEL_RDP)
@@ -124,9 +121,11 @@ int l_cbutton;
 int d_cbutton;
 int u_cbutton;
 bool alternate_mapping;
+bool input_late_latching;
 
 static uint8_t* game_data = NULL;
 static uint32_t game_size = 0;
+static const char* game_path = NULL;
 
 static bool     emu_initialized     = false;
 static unsigned audio_buffer_size   = 2048;
@@ -138,6 +137,8 @@ static bool     load_game_successful = false;
 
 static bool     context_setup_first_init = false;
 
+static struct memwatch* memwatch = NULL;
+
 bool libretro_swap_buffer;
 
 uint32_t *blitter_buf = NULL;
@@ -190,6 +191,8 @@ uint32_t EnableFXAA = 0;
 uint32_t MultiSampling = 0;
 uint32_t EnableFragmentDepthWrite = 0;
 uint32_t EnableShadersStorage = 0;
+uint32_t EnableAsyncShaderCompile = 0;
+uint32_t ShaderWarmupCount = 0;
 uint32_t EnableTextureCache = 0;
 uint32_t EnableFBEmulation = 0;
 uint32_t EnableFrameDuping = 0;
@@ -216,9 +219,18 @@ uint32_t OverscanBottom = 0;
 uint32_t EnableFullspeed = 0;
 uint32_t CountPerOp = 0;
 uint32_t CountPerOpDenomPot = 0;
+uint32_t CountPerOpCalibration = 0;
+uint32_t IdleLoopSkip = 0;
 uint32_t CountPerScanlineOverride = 0;
 uint32_t ForceDisableExtraMem = 0;
+uint32_t MapRomFile = 0;
+uint32_t ZipCacheSize = 0;
+uint32_t ZipCacheInSaveDir = 0;
 uint32_t IgnoreTLBExceptions = 0;
+uint32_t EnableFrameProfiler = 0;
+uint32_t EnableBlockProfiler = 0;
+uint32_t EnableFastmem = 0;
+uint32_t EnableAsyncAudioRSP = 0;
 
 extern struct device g_dev;
 extern unsigned int r4300_emumode;
@@ -393,6 +405,38 @@ static void cleanup_global_paths()
     }
 }
 
+static void write_profiler_trace(void)
+{
+    const char* dir = NULL;
+    char path[PATH_SIZE];
+
+    if (!environ_cb(RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY, &dir) || !dir || !*dir)
+        dir = ".";
+
+    snprintf(path, PATH_SIZE, "%s/%s.trace.json", dir, ROM_PARAMS.headername[0] ? ROM_PARAMS.headername : CORE_NAME);
+    if (profile_write_chrome_trace(path) && log_cb)
+        log_cb(RETRO_LOG_INFO, CORE_NAME ": Wrote frame profile to %s\n", path);
+}
+
+#ifdef NEW_DYNAREC
+static void write_block_report(void)
+{
+    const char* dir = NULL;
+    char path[PATH_SIZE];
+
+    if (!environ_cb(RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY, &dir) || !dir || !*dir)
+        dir = ".";
+
+    snprintf(path, PATH_SIZE, "%s/%s.blocks.txt", dir, ROM_PARAMS.headername[0] ? ROM_PARAMS.headername : CORE_NAME);
+    if (new_dynarec_write_block_report(path, 0) && log_cb)
+        log_cb(RETRO_LOG_INFO, CORE_NAME ": Wrote dynarec block profile to %s\n", path);
+
+    snprintf(path, PATH_SIZE, "%s/%s.idleloops.txt", dir, ROM_PARAMS.headername[0] ? ROM_PARAMS.headername : CORE_NAME);
+    if (new_dynarec_write_idle_loop_report(path) && log_cb)
+        log_cb(RETRO_LOG_INFO, CORE_NAME ": Wrote dynarec idle loops to %s\n", path);
+}
+#endif
+
 static void n64StateCallback(void *Context, m64p_core_param param_type, int new_value)
 {
     if(param_type == M64CORE_STATE_LOADCOMPLETE || param_type == M64CORE_STATE_SAVECOMPLETE)
@@ -404,17 +448,32 @@ static void n64StateCallback(void *Context, m64p_core_param param_type, int new_
 
 static bool emu_step_load_data()
 {
-    log_cb(RETRO_LOG_DEBUG, CORE_NAME ": [EmuThread] M64CMD_ROM_OPEN\n");
+    if(game_path)
+    {
+        log_cb(RETRO_LOG_DEBUG, CORE_NAME ": [EmuThread] M64CMD_ROM_OPEN_FILE\n");
 
-    if(CoreDoCommand(M64CMD_ROM_OPEN, game_size, (void*)game_data))
+        if(CoreDoCommand(M64CMD_ROM_OPEN_FILE, 0, (void*)game_path))
+        {
+            if (log_cb)
+                log_cb(RETRO_LOG_ERROR, CORE_NAME ": failed to map ROM\n");
+            goto load_fail;
+        }
+    }
+    else
     {
-        if (log_cb)
-            log_cb(RETRO_LOG_ERROR, CORE_NAME ": failed to load ROM\n");
-        goto load_fail;
+        log_cb(RETRO_LOG_DEBUG, CORE_NAME ": [EmuThread] M64CMD_ROM_OPEN\n");
+
+        if(CoreDoCommand(M64CMD_ROM_OPEN, game_size, (void*)game_data))
+        {
+            if (log_cb)
+                log_cb(RETRO_LOG_ERROR, CORE_NAME ": failed to load ROM\n");
+            goto load_fail;
+        }
     }
 
     free(game_data);
     game_data = NULL;
+    game_path = NULL;
 
     log_cb(RETRO_LOG_DEBUG, CORE_NAME ": [EmuThread] M64CMD_ROM_GET_HEADER\n");
 
@@ -430,6 +489,7 @@ static bool emu_step_load_data()
 load_fail:
     free(game_data);
     game_data = NULL;
+    game_path = NULL;
     //stop = 1;
 
     return false;
@@ -653,7 +713,7 @@ void retro_get_system_info(struct retro_system_info *info)
 {
     info->library_name = "Mupen64Plus-Next";
     info->library_version = "2.8" FLAVOUR_VERSION GIT_VERSION;
-    info->valid_extensions = "n64|v64|z64|bin|u1";
+    info->valid_extensions = "n64|v64|z64|bin|u1|zip";
     info->need_fullpath = false;
     info->block_extract = false;
 }
@@ -747,6 +807,9 @@ void retro_deinit(void)
     CoreShutdown();
     deinit_audio_libretro();
 
+    memwatch_destroy(memwatch);
+    memwatch = NULL;
+
     if (perf_cb.perf_log)
         perf_cb.perf_log();
 
@@ -909,6 +972,11 @@ void update_controllers()
         if (alternate_mapping != alternate_mapping_prev)
             inputGetKeys_default_descriptor();
     }
+
+    var.key = CORE_NAME "-input-late-latching";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+        input_late_latching = !strcmp(var.value, "False") ? 0 : 1;
 }
 
 static void update_variables(bool startup)
@@ -937,6 +1005,10 @@ static void update_variables(bool startup)
           {
              plugin_connect_rdp_api(RDP_PLUGIN_PARALLEL);
           }
+          else if (!strcmp(var.value, "none"))
+          {
+             plugin_connect_rdp_api(RDP_PLUGIN_NONE);
+          }
        }
        else
        {
@@ -1341,6 +1413,20 @@ static void update_variables(bool startup)
           EnableShadersStorage = !strcmp(var.value, "False") ? 0 : 1;
        }
 
+       var.key = CORE_NAME "-EnableAsyncShaderCompile";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          EnableAsyncShaderCompile = !strcmp(var.value, "False") ? 0 : 1;
+       }
+
+       var.key = CORE_NAME "-ShaderWarmupCount";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          ShaderWarmupCount = atoi(var.value);
+       }
+
        var.key = CORE_NAME "-EnableTextureCache";
        var.value = NULL;
        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1472,6 +1558,20 @@ static void update_variables(bool startup)
           CountPerOpDenomPot = atoi(var.value);
        }
 
+       var.key = CORE_NAME "-CountPerOpCalibration";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          CountPerOpCalibration = !strcmp(var.value, "False") ? 0 : 1;
+       }
+
+       var.key = CORE_NAME "-IdleLoopSkip";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          IdleLoopSkip = !strcmp(var.value, "False") ? 0 : 1;
+       }
+
        if(EnableFullspeed)
        {
           CountPerOp = 1; // Force CountPerOp == 1
@@ -1530,6 +1630,27 @@ static void update_variables(bool startup)
           ForceDisableExtraMem = !strcmp(var.value, "False") ? 0 : 1;
        }
 
+       var.key = CORE_NAME "-MapRomFile";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          MapRomFile = !strcmp(var.value, "False") ? 0 : 1;
+       }
+
+       var.key = CORE_NAME "-ZipCacheSize";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          ZipCacheSize = atoi(var.value);
+       }
+
+       var.key = CORE_NAME "-ZipCacheDir";
+       var.value = NULL;
+       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+       {
+          ZipCacheInSaveDir = !strcmp(var.value, "save") ? 1 : 0;
+       }
+
        var.key = CORE_NAME "-IgnoreTLBExceptions";
        var.value = NULL;
        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1549,9 +1670,15 @@ static void update_variables(bool startup)
         var.key = CORE_NAME "-parallel-rdp-synchronous";
         var.value = NULL;
         if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+        {
             parallel_set_synchronous_rdp(!strcmp(var.value, "True"));
+            parallel_set_hazard_tracking(!strcmp(var.value, "Tracked"));
+        }
         else
+        {
             parallel_set_synchronous_rdp(true);
+            parallel_set_hazard_tracking(false);
+        }
 
         var.key = CORE_NAME "-parallel-rdp-overscan";
         var.value = NULL;
@@ -1767,9 +1894,59 @@ static void update_variables(bool startup)
         {
            angrylion_set_overscan(0);
         }
+
+        var.key = CORE_NAME "-angrylion-vipipeline";
+        var.value = NULL;
+
+        if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+           angrylion_set_vi_pipeline(!strcmp(var.value, "enabled"));
+        else
+           angrylion_set_vi_pipeline(0);
     }
 #endif // HAVE_THR_AL
 
+    var.key = CORE_NAME "-FrameProfiler";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+        uint32_t EnableFrameProfilerPrev = EnableFrameProfiler;
+        EnableFrameProfiler = !strcmp(var.value, "False") ? 0 : 1;
+
+        // Dump what was captured so far when profiling gets switched off
+        if (EnableFrameProfilerPrev && !EnableFrameProfiler)
+            write_profiler_trace();
+    }
+    profile_set_enabled(EnableFrameProfiler);
+
+#ifdef NEW_DYNAREC
+    var.key = CORE_NAME "-BlockProfiler";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+        uint32_t EnableBlockProfilerPrev = EnableBlockProfiler;
+        EnableBlockProfiler = !strcmp(var.value, "False") ? 0 : 1;
+
+        if (EnableBlockProfilerPrev && !EnableBlockProfiler)
+            write_block_report();
+    }
+    new_dynarec_set_block_profiling(EnableBlockProfiler);
+
+    var.key = CORE_NAME "-Fastmem";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+        EnableFastmem = !strcmp(var.value, "False") ? 0 : 1;
+    }
+    new_dynarec_set_fastmem(EnableFastmem);
+#endif
+
+    var.key = CORE_NAME "-AsyncAudioRSP";
+    var.value = NULL;
+    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+    {
+        EnableAsyncAudioRSP = !strcmp(var.value, "False") ? 0 : 1;
+    }
+
     update_controllers();
 
     // Hide irrelevant options
@@ -1867,6 +2044,89 @@ static bool retro_init_vulkan(void)
 #endif
 }
 
+static bool is_zip_archive(const struct retro_game_info *game)
+{
+    static const uint8_t magic[4] = { 'P', 'K', 0x03, 0x04 };
+
+    return game->data && game->size >= sizeof(magic) && memcmp(game->data, magic, sizeof(magic)) == 0;
+}
+
+/* Inflated ROMs are kept in <system or save dir>/Mupen64plus/cache, so
+ * loading the same archive again skips the decompression */
+static bool get_zip_cache_dir(char* path, size_t size)
+{
+    const char* dir = NULL;
+    wchar_t w_path[PATH_SIZE];
+
+    if (!environ_cb(ZipCacheInSaveDir ? RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY : RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY, &dir) || !dir || !*dir)
+        return false;
+
+    snprintf(path, size, "%s/Mupen64plus/cache", dir);
+    mbstowcs(w_path, path, PATH_SIZE);
+    if (!osal_path_existsW(w_path) || !osal_is_directory(w_path))
+        osal_mkdirp(w_path);
+
+    return osal_is_directory(w_path);
+}
+
+/* The frontend hands zip archives over as is, the ROM is the first file in
+ * them that looks like one */
+static bool load_zipped_rom(const struct retro_game_info *game)
+{
+    const char* name = game->path ? game->path : "zip archive";
+    char cache_dir[PATH_SIZE];
+    bool use_cache;
+    struct zip_stream* stream;
+    size_t size;
+
+    use_cache = ZipCacheSize > 0 && get_zip_cache_dir(cache_dir, sizeof(cache_dir));
+    stream = zip_stream_open_memory(game->data, game->size, is_valid_rom,
+                                    use_cache ? cache_dir : NULL, (size_t)ZipCacheSize << 20);
+    if (stream == NULL)
+    {
+        if (log_cb)
+            log_cb(RETRO_LOG_ERROR, CORE_NAME ": no N64 ROM found in %s\n", name);
+        return false;
+    }
+
+    size = zip_stream_size(stream);
+    game_data = malloc(size);
+    if (game_data == NULL || !zip_stream_read(stream, game_data, size))
+    {
+        if (log_cb)
+            log_cb(RETRO_LOG_ERROR, CORE_NAME ": could not inflate ROM from %s\n", name);
+        zip_stream_close(stream);
+        free(game_data);
+        game_data = NULL;
+        return false;
+    }
+    game_size = size;
+
+    if (log_cb)
+        log_cb(RETRO_LOG_INFO, CORE_NAME ": Loaded ROM from %s%s\n", name,
+               zip_stream_cached(stream) ? " (cached)" : "");
+    zip_stream_close(stream);
+
+    return true;
+}
+
+/* The ROM can only be mapped from its file if the frontend didn't patch it
+ * or extract it from an archive */
+static bool rom_file_matches(const struct retro_game_info *game)
+{
+    const void* image;
+    size_t size;
+    bool matches;
+
+    if (!game->path || !game->data || map_file(game->path, &image, &size) != file_ok)
+        return false;
+
+    matches = size == game->size && memcmp(image, game->data, size) == 0;
+    unmap_file(image, size);
+
+    return matches;
+}
+
 bool retro_load_game(const struct retro_game_info *game)
 {
     char* gamePath;
@@ -1971,9 +2231,21 @@ bool retro_load_game(const struct retro_game_info *game)
     }
 #endif
 
-    game_data = malloc(game->size);
-    memcpy(game_data, game->data, game->size);
-    game_size = game->size;
+    if (is_zip_archive(game))
+    {
+        if (!load_zipped_rom(game))
+            return false;
+    }
+    else if (MapRomFile && rom_file_matches(game))
+    {
+        game_path = game->path;
+    }
+    else
+    {
+        game_data = malloc(game->size);
+        memcpy(game_data, game->data, game->size);
+        game_size = game->size;
+    }
 
     if (!emu_step_load_data())
         return false;
@@ -2022,6 +2294,17 @@ void retro_unload_game(void)
        CoreDoCommand(M64CMD_ROM_CLOSE, 0, NULL);
     }
 
+    if (EnableFrameProfiler)
+       write_profiler_trace();
+
+#ifdef NEW_DYNAREC
+    if (EnableBlockProfiler && r4300_emumode == EMUMODE_DYNAREC)
+       write_block_report();
+#endif
+
+    if (memwatch)
+       memwatch_clear(memwatch);
+
     cleanup_global_paths();
     
     emu_initialized = false;
@@ -2035,6 +2318,9 @@ void retro_run (void)
 {
     libretro_swap_buffer = false;
     static bool updated = false;
+#ifdef HAVE_THR_AL
+    void *angrylion_screen = NULL;
+#endif
 
     if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
        update_variables(false);
@@ -2059,6 +2345,13 @@ void retro_run (void)
     {
        glsm_ctl(GLSM_CTL_STATE_UNBIND, NULL);
     }
+#ifdef HAVE_THR_AL
+    else if(current_rdp_type == RDP_PLUGIN_ANGRYLION)
+    {
+       // Picks the frame to show when the VI is pipelined
+       angrylion_screen = angrylion_present_screen();
+    }
+#endif // HAVE_THR_AL
     
     if (libretro_swap_buffer)
     {
@@ -2069,7 +2362,7 @@ void retro_run (void)
 #ifdef HAVE_THR_AL
        else if(current_rdp_type == RDP_PLUGIN_ANGRYLION)
        {
-          video_cb(prescale, retro_screen_width, retro_screen_height, screen_pitch);
+          video_cb(angrylion_screen, retro_screen_width, retro_screen_height, screen_pitch);
        }
 #endif // HAVE_THR_AL
 #ifdef HAVE_PARALLEL_RDP
@@ -2081,6 +2374,7 @@ void retro_run (void)
            parallel_profile_video_refresh_end();
        }
 #endif
+       profile_frame_presented();
     }
     else if(EnableFrameDuping)
     {
@@ -2220,6 +2514,66 @@ void retro_set_controller_port_device(unsigned in_port, unsigned device) {
 
 unsigned retro_api_version(void) { return RETRO_API_VERSION; }
 
+bool retro_profiler_get_frame_stats(unsigned frames_back, struct profile_frame_stats *stats)
+{
+    return !!profile_get_frame_stats(frames_back, stats);
+}
+
+bool retro_profiler_write_trace(const char *path)
+{
+    return !!profile_write_chrome_trace(path);
+}
+
+bool retro_profiler_write_block_report(const char *path, unsigned max_blocks)
+{
+#ifdef NEW_DYNAREC
+    return !!new_dynarec_write_block_report(path, max_blocks);
+#else
+    return false;
+#endif
+}
+
+bool retro_profiler_write_idle_loop_report(const char *path)
+{
+#ifdef NEW_DYNAREC
+    return !!new_dynarec_write_idle_loop_report(path);
+#else
+    return false;
+#endif
+}
+
+bool retro_profiler_get_cpu_stats(struct retro_cpu_stats *stats)
+{
+    if (!g_dev.rdram.dram)
+        return false;
+
+    stats->emumode = get_r4300_emumode(&g_dev.r4300);
+    stats->count = r4300_cp0_regs(&g_dev.r4300.cp0)[CP0_COUNT_REG];
+    stats->count_per_op = g_dev.r4300.cp0.count_per_op;
+    stats->count_per_op_denom_pot = g_dev.r4300.cp0.count_per_op_denom_pot;
+    stats->idle_count = g_dev.r4300.cp0.idle_count;
+    stats->count_per_op_calibration = main_count_calibration()->state;
+    return true;
+}
+
+bool retro_memwatch_set(const struct memwatch_expr *exprs, unsigned count)
+{
+    if (!memwatch)
+        memwatch = memwatch_create();
+    if (!memwatch)
+        return false;
+
+    return !!memwatch_set(memwatch, exprs, count, RDRAM_MAX_SIZE);
+}
+
+unsigned retro_memwatch_poll(struct memwatch_result *results, unsigned max_results)
+{
+    if (!memwatch || !g_dev.rdram.dram)
+        return 0;
+
+    return (unsigned)memwatch_poll(memwatch, g_dev.rdram.dram, results, max_results);
+}
+
 void retro_cheat_reset(void)
 {
     cheat_delete_all(&g_cheat_ctx);
@@ -0,0 +1,582 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - libretro_bench.c                                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Headless benchmark frontend, built with `make bench`.
+ *
+ * Links the core statically, selects the dummy video/audio plugins and HLE RSP,
+ * and runs a ROM for a fixed number of frames as fast as possible, optionally
+ * starting from a savestate and replaying a recorded input stream.
+ * Reports frames/sec, the per-subsystem time from the frame profiler and an
+ * XXH3 hash of RDRAM after every frame, so two runs (or two CPU cores) can be
+ * diffed for determinism.
+ *
+ * Input stream format (little endian):
+ *   char     magic[4] = "N64I"
+ *   uint32_t version  = 1
+ *   then per frame, for each of the 4 ports:
+ *     uint16_t buttons  (RETRO_DEVICE_ID_JOYPAD_MASK bits)
+ *     int16_t  lx, ly, rx, ry
+ * Frames past the end of the stream read as neutral input.
+ *
+ * With -k, a synthetic CPU kernel is run instead of a ROM: a loop of address
+ * materialization, loads and stores, and compares and branches from SP DMEM,
+ * which sets up the VI so frames are delivered as usual. Guest MIPS are
+ * derived from the COUNT register, so comparing the CPU cores is
+ *   for c in pure_interpreter cached_interpreter dynamic_recompiler; do
+ *       mupen64plus_next_bench -k -c $c; done
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include "libretro.h"
+#include "libretro_profiler.h"
+
+#define BENCH_MAX_OPTIONS  512
+#define BENCH_INPUT_MAGIC  "N64I"
+#define BENCH_INPUT_PORTS  4
+#define BENCH_INPUT_STRIDE (BENCH_INPUT_PORTS * 5 * 2)
+
+struct bench_option
+{
+    char *key;
+    char *value;
+};
+
+static struct bench_option options[BENCH_MAX_OPTIONS];
+static unsigned num_options;
+
+static const char *system_dir = ".";
+static const char *save_dir = ".";
+static int verbose;
+
+static const uint8_t *input_frames;
+static size_t input_num_frames;
+static size_t input_frame;
+
+/* MIPS encodings for the synthetic kernel */
+#define MIPS_I(op, rs, rt, imm)       (((uint32_t)(op) << 26) | ((rs) << 21) | ((rt) << 16) | ((imm) & 0xffff))
+#define MIPS_R(rs, rt, rd, sa, funct) (((rs) << 21) | ((rt) << 16) | ((rd) << 11) | ((sa) << 6) | (funct))
+#define MIPS_J(op, target)            (((uint32_t)(op) << 26) | (((target) >> 2) & 0x3ffffff))
+
+enum { R0 = 0, T0 = 8, T1, T2, T3, T4, T5, T6, T7, S0, S1, S2, T8 = 24 };
+
+#define BENCH_KERNEL_ROM_SIZE 0x100000
+/* where the boot ROM copies and starts IPL3 */
+#define BENCH_KERNEL_START    0xa4000040
+
+static void put_be32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+static void *make_kernel_rom(size_t *size)
+{
+    static const uint32_t kernel[] =
+    {
+        /* VI_V_SYNC = 525, VI_V_INTR = 2: a VI per frame, with interrupts disabled */
+        MIPS_I(0x0f, R0, T0, 0xa440),               /* lui   t0, 0xa440 */
+        MIPS_I(0x09, R0, T1, 525),                  /* addiu t1, zero, 525 */
+        MIPS_I(0x2b, T0, T1, 0x18),                 /* sw    t1, 0x18(t0) */
+        MIPS_I(0x09, R0, T1, 2),                    /* addiu t1, zero, 2 */
+        MIPS_I(0x2b, T0, T1, 0x0c),                 /* sw    t1, 0x0c(t0) */
+        MIPS_I(0x0f, R0, S0, 0x8010),               /* lui   s0, 0x8010 */
+        MIPS_I(0x09, R0, S1, 0),                    /* addiu s1, zero, 0 */
+        /* loop: */
+        MIPS_I(0x0f, R0, T0, 0x8010),               /* lui   t0, 0x8010 */
+        MIPS_I(0x09, T0, T0, 0x1000),               /* addiu t0, t0, 0x1000 */
+        MIPS_I(0x0f, R0, T2, 0x8010),               /* lui   t2, 0x8010 */
+        MIPS_I(0x23, T2, T3, 0x2000),               /* lw    t3, 0x2000(t2) */
+        MIPS_I(0x23, T0, T4, 0),                    /* lw    t4, 0(t0) */
+        MIPS_R(T4, T3, T5, 0, 0x21),                /* addu  t5, t4, t3 */
+        MIPS_I(0x2b, T0, T5, 0),                    /* sw    t5, 0(t0) */
+        MIPS_R(0, S1, T6, 2, 0x00),                 /* sll   t6, s1, 2 */
+        MIPS_R(T6, S0, T6, 0, 0x21),                /* addu  t6, t6, s0 */
+        MIPS_I(0x23, T6, T7, 0),                    /* lw    t7, 0(t6) */
+        MIPS_R(T7, S1, T7, 0, 0x26),                /* xor   t7, t7, s1 */
+        MIPS_I(0x2b, T6, T7, 0),                    /* sw    t7, 0(t6) */
+        MIPS_I(0x09, S1, S1, 1),                    /* addiu s1, s1, 1 */
+        MIPS_I(0x0c, S1, S1, 0x3ff),                /* andi  s1, s1, 0x3ff */
+        MIPS_I(0x0a, S1, T8, 0x200),                /* slti  t8, s1, 0x200 */
+        MIPS_I(0x05, T8, R0, 2),                    /* bne   t8, zero, skip */
+        0,                                          /* nop */
+        MIPS_I(0x09, S2, S2, 1),                    /* addiu s2, s2, 1 */
+        /* skip: */
+        MIPS_J(0x02, BENCH_KERNEL_START + 7 * 4),   /* j     loop */
+        0,                                          /* nop */
+    };
+    uint8_t *rom = (uint8_t*)calloc(1, BENCH_KERNEL_ROM_SIZE);
+    size_t i;
+
+    if (rom == NULL)
+        return NULL;
+
+    /* big endian (.z64) header */
+    put_be32(rom + 0x00, 0x80371240);
+    put_be32(rom + 0x04, 0x0000000f);
+    put_be32(rom + 0x08, 0x80000400);
+    memcpy(rom + 0x20, "CPU KERNEL", 10);
+    for (i = 0; i < sizeof(kernel) / sizeof(kernel[0]); i++)
+        put_be32(rom + 0x40 + i * 4, kernel[i]);
+
+    *size = BENCH_KERNEL_ROM_SIZE;
+    return rom;
+}
+
+static int64_t now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (int64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void *read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    void *data = NULL;
+    long len;
+
+    if (fp == NULL)
+        return NULL;
+
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0)
+    {
+        rewind(fp);
+        data = malloc(len);
+        if (data != NULL && fread(data, 1, len, fp) != (size_t)len)
+        {
+            free(data);
+            data = NULL;
+        }
+        *size = len;
+    }
+
+    fclose(fp);
+    return data;
+}
+
+static struct bench_option *find_option(const char *key)
+{
+    unsigned i;
+    for (i = 0; i < num_options; i++)
+        if (!strcmp(options[i].key, key))
+            return &options[i];
+    return NULL;
+}
+
+/* Command line overrides are set before the core registers its defaults, so
+ * a default never replaces an existing value. */
+static void set_option(const char *key, const char *value, int override)
+{
+    struct bench_option *opt = find_option(key);
+
+    if (opt == NULL)
+    {
+        if (num_options == BENCH_MAX_OPTIONS)
+            return;
+        opt = &options[num_options++];
+        opt->key = strdup(key);
+        opt->value = NULL;
+    }
+    else if (!override)
+        return;
+
+    free(opt->value);
+    opt->value = strdup(value);
+}
+
+/* "Description; default|value|value" */
+static void register_variables(const struct retro_variable *vars)
+{
+    for (; vars->key != NULL; vars++)
+    {
+        const char *def;
+        char value[256];
+        size_t len;
+
+        if (vars->value == NULL || (def = strstr(vars->value, "; ")) == NULL)
+            continue;
+
+        def += 2;
+        len = strcspn(def, "|");
+        if (len >= sizeof(value))
+            len = sizeof(value) - 1;
+        memcpy(value, def, len);
+        value[len] = '\0';
+
+        set_option(vars->key, value, 0);
+    }
+}
+
+static void log_printf(enum retro_log_level level, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (level < RETRO_LOG_WARN && !verbose)
+        return;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+static bool environment(unsigned cmd, void *data)
+{
+    switch (cmd)
+    {
+        case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+            ((struct retro_log_callback*)data)->log = log_printf;
+            return true;
+        case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+            *(const char**)data = system_dir;
+            return true;
+        case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+            *(const char**)data = save_dir;
+            return true;
+        case RETRO_ENVIRONMENT_GET_CORE_OPTIONS_VERSION:
+            /* Ask for the legacy variable list, its defaults are easy to parse */
+            *(unsigned*)data = 0;
+            return true;
+        case RETRO_ENVIRONMENT_SET_VARIABLES:
+            register_variables((const struct retro_variable*)data);
+            return true;
+        case RETRO_ENVIRONMENT_GET_VARIABLE:
+        {
+            struct retro_variable *var = (struct retro_variable*)data;
+            struct bench_option *opt = find_option(var->key);
+            var->value = opt ? opt->value : NULL;
+            return opt != NULL;
+        }
+        case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+            *(bool*)data = false;
+            return true;
+        case RETRO_ENVIRONMENT_GET_INPUT_BITMASKS:
+        case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void video_refresh(const void *data, unsigned width, unsigned height, size_t pitch) { }
+static void audio_sample(int16_t left, int16_t right) { }
+static size_t audio_sample_batch(const int16_t *data, size_t frames) { return frames; }
+static void input_poll(void) { }
+
+static int16_t input_word(unsigned port, unsigned index)
+{
+    const uint8_t *p;
+
+    if (input_frames == NULL || input_frame >= input_num_frames || port >= BENCH_INPUT_PORTS)
+        return 0;
+
+    p = input_frames + input_frame * BENCH_INPUT_STRIDE + (port * 5 + index) * 2;
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static int16_t input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+    switch (device)
+    {
+        case RETRO_DEVICE_JOYPAD:
+        {
+            uint16_t buttons = (uint16_t)input_word(port, 0);
+            if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+                return (int16_t)buttons;
+            return (buttons >> id) & 1;
+        }
+        case RETRO_DEVICE_ANALOG:
+            if (index == RETRO_DEVICE_INDEX_ANALOG_LEFT)
+                return input_word(port, 1 + (id == RETRO_DEVICE_ID_ANALOG_Y));
+            if (index == RETRO_DEVICE_INDEX_ANALOG_RIGHT)
+                return input_word(port, 3 + (id == RETRO_DEVICE_ID_ANALOG_Y));
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <rom>\n"
+            "  -k            run the synthetic CPU kernel instead of a ROM\n"
+            "  -n <frames>   number of frames to run (default 1000)\n"
+            "  -s <state>    load a savestate before the timed run\n"
+            "  -i <input>    replay a recorded input stream\n"
+            "  -c <core>     pure_interpreter, cached_interpreter or dynamic_recompiler\n"
+            "  -H <file>     write the per-frame RDRAM hashes to <file> instead of stdout\n"
+            "  -o key=value  set a core option (e.g. mupen64plus-rsp-plugin=cxd4)\n"
+            "  -d <dir>      system and save directory (default .)\n"
+            "  -v            show core log messages\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    struct retro_game_info game = {0};
+    struct profile_frame_stats stats;
+    struct retro_cpu_stats cpu;
+    int64_t section_total[NUM_TIMED_SECTIONS] = {0};
+    uint32_t section_count[NUM_TIMED_SECTIONS] = {0};
+    const char *rom_path = NULL, *state_path = NULL, *input_path = NULL, *hash_path = NULL;
+    void *rom = NULL, *state = NULL, *input = NULL;
+    size_t rom_size = 0, state_size = 0, input_size = 0;
+    unsigned long frames = 1000, frame;
+    int64_t last_profiled_frame = -1;
+    uint64_t run_hash = 0;
+    double guest_ops = 0.0;
+    uint32_t last_count = 0;
+    int have_count = 0, kernel = 0;
+    int64_t emu_time = 0, ops_time = 0;
+    FILE *hash_out = stdout;
+    int i, ret = 1;
+
+    set_option("mupen64plus-rdp-plugin", "none", 1);
+    set_option("mupen64plus-rsp-plugin", "hle", 1);
+    set_option("mupen64plus-FrameProfiler", "True", 1);
+
+    for (i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+
+        if (arg[0] != '-' || arg[1] == '\0')
+        {
+            rom_path = arg;
+            continue;
+        }
+        if (arg[1] == 'v')
+        {
+            verbose = 1;
+            continue;
+        }
+        if (arg[1] == 'k')
+        {
+            kernel = 1;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        switch (arg[1])
+        {
+            case 'n': frames = strtoul(argv[++i], NULL, 0); break;
+            case 's': state_path = argv[++i]; break;
+            case 'i': input_path = argv[++i]; break;
+            case 'c': set_option("mupen64plus-cpucore", argv[++i], 1); break;
+            case 'H': hash_path = argv[++i]; break;
+            case 'd': system_dir = save_dir = argv[++i]; break;
+            case 'o':
+            {
+                char *kv = argv[++i];
+                char *eq = strchr(kv, '=');
+                if (eq == NULL)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                *eq = '\0';
+                set_option(kv, eq + 1, 1);
+                break;
+            }
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (kernel)
+        rom_path = "cpu_kernel.z64";
+    if (rom_path == NULL)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if ((rom = kernel ? make_kernel_rom(&rom_size) : read_file(rom_path, &rom_size)) == NULL)
+    {
+        fprintf(stderr, "Failed to read ROM %s\n", rom_path);
+        goto out;
+    }
+    if (state_path && (state = read_file(state_path, &state_size)) == NULL)
+    {
+        fprintf(stderr, "Failed to read savestate %s\n", state_path);
+        goto out;
+    }
+    if (input_path)
+    {
+        if ((input = read_file(input_path, &input_size)) == NULL || input_size < 8
+            || memcmp(input, BENCH_INPUT_MAGIC, 4) != 0 || ((uint8_t*)input)[4] != 1)
+        {
+            fprintf(stderr, "Invalid input stream %s\n", input_path);
+            goto out;
+        }
+        input_frames = (const uint8_t*)input + 8;
+        input_num_frames = (input_size - 8) / BENCH_INPUT_STRIDE;
+    }
+    if (hash_path && (hash_out = fopen(hash_path, "w")) == NULL)
+    {
+        fprintf(stderr, "Failed to open %s\n", hash_path);
+        goto out;
+    }
+
+    retro_set_environment(environment);
+    retro_set_video_refresh(video_refresh);
+    retro_set_audio_sample(audio_sample);
+    retro_set_audio_sample_batch(audio_sample_batch);
+    retro_set_input_poll(input_poll);
+    retro_set_input_state(input_state);
+    retro_init();
+
+    game.path = rom_path;
+    game.data = rom;
+    game.size = rom_size;
+    if (!retro_load_game(&game))
+    {
+        fprintf(stderr, "Failed to load %s\n", rom_path);
+        retro_deinit();
+        goto out;
+    }
+
+    if (state)
+    {
+        /* The emulation thread only accepts savestate jobs once it runs */
+        retro_run();
+        if (!retro_unserialize(state, state_size))
+        {
+            fprintf(stderr, "Failed to load savestate %s\n", state_path);
+            retro_unload_game();
+            retro_deinit();
+            goto out;
+        }
+    }
+
+    /* Only the timed frames are accounted for */
+    profile_reset();
+    if (retro_profiler_get_cpu_stats(&cpu))
+    {
+        last_count = cpu.count;
+        have_count = 1;
+    }
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        const void *rdram;
+        int64_t start, frame_time;
+        uint64_t hash;
+
+        input_frame = frame;
+
+        start = now_ns();
+        retro_run();
+        frame_time = now_ns() - start;
+        emu_time += frame_time;
+
+        /* RDRAM is only allocated once the first frame started */
+        rdram = retro_get_memory_data(RETRO_MEMORY_SYSTEM_RAM);
+        hash = XXH3_64bits(rdram, retro_get_memory_size(RETRO_MEMORY_SYSTEM_RAM));
+        run_hash = XXH3_64bits_withSeed(&hash, sizeof(hash), run_hash);
+        fprintf(hash_out, "%lu %016llx\n", frame, (unsigned long long)hash);
+
+        if (retro_profiler_get_cpu_stats(&cpu))
+        {
+            /* RDRAM, and so the CPU, only exists once the first frame started */
+            if (have_count && cpu.count_per_op != 0)
+            {
+                guest_ops += (double)(uint32_t)(cpu.count - last_count)
+                           * (1u << cpu.count_per_op_denom_pot) / cpu.count_per_op;
+                ops_time += frame_time;
+            }
+            last_count = cpu.count;
+            have_count = 1;
+        }
+
+        if (retro_profiler_get_frame_stats(0, &stats) && (int64_t)stats.frame != last_profiled_frame)
+        {
+            int s;
+            last_profiled_frame = stats.frame;
+            for (s = 0; s < NUM_TIMED_SECTIONS; s++)
+            {
+                section_total[s] += stats.time_in_section[s];
+                section_count[s] += stats.count_in_section[s];
+            }
+        }
+    }
+
+    printf("frames:      %lu\n", frames);
+    printf("time:        %.3f s\n", emu_time / 1e9);
+    printf("fps:         %.2f\n", emu_time > 0 ? frames * 1e9 / emu_time : 0.0);
+    if (have_count)
+        printf("cpu core:    %s\n", cpu.emumode == 0 ? "pure_interpreter"
+                                  : cpu.emumode == 1 ? "cached_interpreter" : "dynamic_recompiler");
+    printf("guest MIPS:  %.2f\n", ops_time > 0 ? guest_ops * 1e3 / ops_time : 0.0);
+    printf("rdram hash:  %016llx\n", (unsigned long long)run_hash);
+    printf("%-16s %12s %10s %10s %8s\n", "section", "total ms", "us/frame", "calls", "%");
+    for (i = 0; i < NUM_TIMED_SECTIONS; i++)
+    {
+        if (section_count[i] == 0 && section_total[i] == 0)
+            continue;
+        printf("%-16s %12.3f %10.1f %10u %7.1f%%\n",
+               timed_section_name((enum timed_section)i),
+               section_total[i] / 1e6,
+               frames ? section_total[i] / 1e3 / frames : 0.0,
+               section_count[i],
+               emu_time > 0 ? 100.0 * section_total[i] / emu_time : 0.0);
+    }
+
+    retro_unload_game();
+    retro_deinit();
+    ret = 0;
+
+out:
+    if (hash_out != stdout && hash_out != NULL)
+        fclose(hash_out);
+    free(input);
+    free(state);
+    free(rom);
+    for (i = 0; i < (int)num_options; i++)
+    {
+        free(options[i].key);
+        free(options[i].value);
+    }
+    return ret;
+}
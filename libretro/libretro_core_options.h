@@ -539,6 +539,37 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "True"
     },
+    {
+        CORE_NAME "-EnableAsyncShaderCompile",
+        "Asynchronous Shader Compilation",
+        NULL,
+        "(GLN64) Link new combiner shaders in the background and draw with a generic shader until they are ready, instead of stalling the frame. Needs GL_KHR_parallel_shader_compile.",
+        "Link new combiner shaders in the background and draw with a generic shader until they are ready, instead of stalling the frame. Needs GL_KHR_parallel_shader_compile.",
+        "gliden64",
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+    {
+        CORE_NAME "-ShaderWarmupCount",
+        "Shader Warm-up",
+        NULL,
+        "(GLN64) Compile this many of the shaders most used by all games played so far when a game starts, so a new game hitches less (0 = off). Needs Cache GPU Shaders.",
+        "Compile this many of the shaders most used by all games played so far when a game starts, so a new game hitches less (0 = off). Needs Cache GPU Shaders.",
+        "gliden64",
+        {
+            {"0", NULL},
+            {"64", NULL},
+            {"128", NULL},
+            {"256", NULL},
+            {"512", NULL},
+            { NULL, NULL },
+        },
+        "0"
+    },
 #endif
     {
         CORE_NAME "-EnableTextureCache",
@@ -1025,11 +1056,12 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         CORE_NAME "-parallel-rdp-synchronous",
         "(ParaLLEl-RDP) Synchronous RDP",
         "Synchronous RDP",
-        "Enable full accuracy for CPU accessed frame buffers.",
+        "Enable full accuracy for CPU accessed frame buffers. Hazard Tracking only waits for the RDP when the CPU or a DMA accesses a frame buffer it is still drawing, and falls back to Enabled with the dynarec.",
         NULL,
         "parallel_rdp",
         {
             { "True", "Enabled" },
+            { "Tracked", "Hazard Tracking" },
             { "False", "Disabled" },
             { NULL, NULL },
         }
@@ -1369,6 +1401,20 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "disabled"
     },
+    {
+        CORE_NAME "-angrylion-vipipeline",
+        "VI pipelining",
+        NULL,
+        "(AL) Run the VI filters on the worker threads while the next frame is emulated. Adds up to one frame of latency, needs more than one thread.",
+        "Run the VI filters on the worker threads while the next frame is emulated. Adds up to one frame of latency, needs more than one thread.",
+        "angrylion",
+        {
+            {"disabled", NULL},
+            {"enabled", NULL},
+            { NULL, NULL },
+        },
+        "disabled"
+    },
 #endif
     {
         CORE_NAME "-cpucore",
@@ -1410,6 +1456,20 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "hle"
     },
+    {
+        CORE_NAME "-AsyncAudioRSP",
+        "Threaded HLE Audio",
+        NULL,
+        "(HLE) Run audio tasks on a worker thread while the CPU keeps going until the task's interrupt. Helps multi-core devices. Has no effect with the dynamic recompiler.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
     {
         CORE_NAME "-FrameDuping",
         "Frame Duplication",
@@ -1471,6 +1531,51 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "False"
     },
+    {
+        CORE_NAME "-MapRomFile",
+        "Map ROM File",
+        NULL,
+        "Map uncompressed, unpatched ROM files instead of copying them into emulated memory. Parts of the ROM are only loaded once the game reads them, which saves memory for large carts. Takes effect on next game load.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+    {
+        CORE_NAME "-ZipCacheSize",
+        "Zipped ROM Cache Size",
+        NULL,
+        "Keep inflated copies of zipped ROMs on disk, up to this size, so loading them again skips the decompression. The least recently used ROMs are removed first. Takes effect on next game load.",
+        NULL,
+        NULL,
+        {
+            {"0", "Disabled"},
+            {"128", "128 MB"},
+            {"256", "256 MB"},
+            {"512", "512 MB"},
+            {"1024", "1024 MB"},
+            { NULL, NULL },
+        },
+        "0"
+    },
+    {
+        CORE_NAME "-ZipCacheDir",
+        "Zipped ROM Cache Location",
+        NULL,
+        "Directory the zipped ROM cache is kept in, as Mupen64plus/cache inside the frontend's system or save directory.",
+        NULL,
+        NULL,
+        {
+            {"system", "System Directory"},
+            {"save", "Save Directory"},
+            { NULL, NULL },
+        },
+        "system"
+    },
     {
         CORE_NAME "-IgnoreTLBExceptions",
         "Ignore emulated TLB Exceptions",
@@ -1504,6 +1609,34 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "0"
     },
+    {
+        CORE_NAME "-CountPerOpCalibration",
+        "Count Per Op Calibration",
+        NULL,
+        "Adjust the database Count per Op (1 to 3) from how much of each frame the game spends idle, then keep it. The chosen value is logged. Not used with a Count per Op set above, an overclock or netplay.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+    {
+        CORE_NAME "-IdleLoopSkip",
+        "Skip Polling Loops",
+        NULL,
+        "(Dynarec) Jump to the next scheduled event when the game spins in a loop reading memory or status registers. Lowers host CPU use, but may change timing. Games enabled in the ROM database always skip.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
     {
         CORE_NAME "-CountPerOpDenomPot",
         "Count Per Op Divider (Overclock)",
@@ -1528,6 +1661,50 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "0"
     },
+    {
+        CORE_NAME "-FrameProfiler",
+        "Frame Profiler",
+        NULL,
+        "Record per-frame timings of the CPU core, RSP tasks, RDP, VI, audio resampling, savestates and input polling. A Chrome trace (.trace.json) is written to the save directory when the game is unloaded or this option is disabled.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+#ifdef DYNAREC
+    {
+        CORE_NAME "-BlockProfiler",
+        "Dynarec Block Profiler",
+        NULL,
+        "Count how often each dynarec block runs and how often it gets recompiled. Applies to blocks compiled from then on. A report of the hottest blocks (.blocks.txt) is written to the save directory when the game is unloaded or this option is disabled.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+    {
+        CORE_NAME "-Fastmem",
+        "Dynarec Fastmem",
+        NULL,
+        "(x86_64/AArch64 Linux) Access RDRAM without range checks, relying on the host MMU to catch everything else. Faster loads and stores, applies after a restart.",
+        NULL,
+        NULL,
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
+#endif
     {
         CORE_NAME "-astick-deadzone",
         "Analog Deadzone (percent)",
@@ -1658,6 +1835,20 @@ struct retro_core_option_v2_definition option_defs_us[] = {
         },
         "False"
     },
+    {
+        CORE_NAME "-input-late-latching",
+        "Input Late Latching",
+        NULL,
+        "Poll the controllers when the game first reads them in a frame instead of at the end of the previous one, which can lower input latency.",
+        NULL,
+        "input",
+        {
+            {"False", NULL},
+            {"True", NULL},
+            { NULL, NULL },
+        },
+        "False"
+    },
     {
         CORE_NAME "-pak1",
         "Player 1 Pak",
@@ -0,0 +1,26 @@
+#ifndef _LIBRETRO_MEMWATCH_H
+#define _LIBRETRO_MEMWATCH_H
+
+#include <stdbool.h>
+
+#include "libretro.h"
+#include "main/memwatch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Replaces the RDRAM watches, see main/memwatch.h. Addresses are N64
+ * addresses, so no endianness fixups are needed. Watches are dropped when
+ * the game is unloaded. Returns false if an expression is invalid. */
+RETRO_API bool retro_memwatch_set(const struct memwatch_expr *exprs, unsigned count);
+
+/* Meant to be called once per retro_run. Returns how many watches changed
+ * since they were last reported and writes up to max_results of them. */
+RETRO_API unsigned retro_memwatch_poll(struct memwatch_result *results, unsigned max_results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef _LIBRETRO_PROFILER_H
+#define _LIBRETRO_PROFILER_H
+
+#include <stdbool.h>
+
+#include "libretro.h"
+#include "main/profile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Frame timing is only recorded while the FrameProfiler core option is enabled.
+ * frames_back == 0 returns the last completed frame. Its input_latency is
+ * set once the frame was presented, at the end of retro_run. */
+RETRO_API bool retro_profiler_get_frame_stats(unsigned frames_back, struct profile_frame_stats *stats);
+
+/* Writes the recorded frames and sections as Chrome trace event JSON
+ * (loadable in chrome://tracing or Perfetto). */
+RETRO_API bool retro_profiler_write_trace(const char *path);
+
+/* Writes the dynarec blocks compiled while the BlockProfiler core option was
+ * enabled, hottest first, with their entry counts, host code size and how
+ * often they were recompiled. max_blocks == 0 writes all of them.
+ * Returns false if the core was built without the dynarec. */
+RETRO_API bool retro_profiler_write_block_report(const char *path, unsigned max_blocks);
+
+/* Writes the polling loops the dynarec fast-forwards to the next event, with
+ * the addresses they read. How often each one branched back is only counted
+ * while the BlockProfiler core option is enabled, on x86 and x86-64.
+ * Returns false if the core was built without the dynarec. */
+RETRO_API bool retro_profiler_write_idle_loop_report(const char *path);
+
+/* Guest CPU counters, to derive the instruction throughput of a CPU core.
+ * COUNT advances by count_per_op / 2^count_per_op_denom_pot per executed
+ * instruction, and by the cycles of idle loops which were skipped. */
+struct retro_cpu_stats
+{
+   /* 0: pure interpreter, 1: cached interpreter, 2: dynamic recompiler */
+   unsigned emumode;
+   uint32_t count;
+   unsigned count_per_op;
+   unsigned count_per_op_denom_pot;
+   /* COUNT cycles skipped in idle loops, wraps like count */
+   uint32_t idle_count;
+   /* CountPerOpCalibration, 0: off, 1: measuring, 2: locked */
+   unsigned count_per_op_calibration;
+};
+
+/* Returns false until a game is running. */
+RETRO_API bool retro_profiler_get_cpu_stats(struct retro_cpu_stats *stats);
+
+/* GLideN64 combiner compilation since the last ROM load. */
+struct retro_shader_compile_stats
+{
+   uint32_t programs;
+   /* programs which blocked rendering until compiled */
+   uint32_t stalls;
+   /* programs linked in the background, see EnableAsyncShaderCompile */
+   uint32_t deferred;
+   /* draws done with the ubershader while a program was being linked */
+   uint32_t fallback_draws;
+   /* render thread time spent on new programs, in microseconds */
+   uint64_t compile_time_us;
+   uint64_t max_compile_time_us;
+   /* programs compiled at startup from the shader corpus, see ShaderWarmupCount */
+   uint32_t warmed_up;
+   /* warmed up programs this game has used */
+   uint32_t warm_hits;
+};
+
+/* Returns false unless GLideN64 is the active RDP plugin. */
+RETRO_API bool retro_profiler_get_shader_stats(struct retro_shader_compile_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - memwatch_bench.c                                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* RDRAM watch benchmark, built with `make memwatchbench`.
+ *
+ * Sets up random watches over a synthetic 8 MB RDRAM, then per frame
+ * changes a few bytes the way a running game would and polls the watches.
+ * Every frame is checked against a reference that reads RDRAM byte by byte
+ * through the S8 swizzle, the way a frontend scanning
+ * RETRO_MEMORY_SYSTEM_RAM does, and the run fails on any difference.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "main/memwatch.h"
+#include "osal/preproc.h"
+
+#define BENCH_DRAM_SIZE 0x800000
+
+struct reference
+{
+    uint32_t value;
+    uint8_t state;
+};
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+static uint32_t reference_read(const uint8_t* dram, const struct memwatch_expr* expr)
+{
+    uint32_t address = expr->address & UINT32_C(0x1fffffff);
+    uint32_t value = 0;
+    unsigned int i;
+
+    for (i = 0; i < expr->width; ++i) {
+        value = (value << 8) | dram[(address + i) ^ S8];
+    }
+
+    return value & (expr->mask ? expr->mask : UINT32_MAX);
+}
+
+static uint8_t reference_compare(const struct memwatch_expr* expr, uint32_t value)
+{
+    uint32_t operand = expr->value & (expr->width == 4 ? UINT32_MAX : ((UINT32_C(1) << (expr->width * 8)) - 1))
+                                   & (expr->mask ? expr->mask : UINT32_MAX);
+
+    switch (expr->cmp)
+    {
+    case MEMWATCH_EQ: return value == operand;
+    case MEMWATCH_NE: return value != operand;
+    case MEMWATCH_LT: return value < operand;
+    case MEMWATCH_LE: return value <= operand;
+    case MEMWATCH_GT: return value > operand;
+    case MEMWATCH_GE: return value >= operand;
+    default:          return 0;
+    }
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -f <n>        frames (default 10000)\n"
+        "  -n <n>        watches (default 2000)\n"
+        "  -w <n>        bytes written per frame (default 64)\n",
+        argv0);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int frames = 10000;
+    unsigned int count = 2000;
+    unsigned int writes = 64;
+    unsigned int f, i;
+    int i_arg;
+
+    for (i_arg = 1; i_arg < argc; ++i_arg) {
+        if (!strcmp(argv[i_arg], "-f") && i_arg + 1 < argc)
+            frames = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-n") && i_arg + 1 < argc)
+            count = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-w") && i_arg + 1 < argc)
+            writes = strtoul(argv[++i_arg], NULL, 0);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    uint32_t* dram = (uint32_t*)calloc(BENCH_DRAM_SIZE / 4, sizeof(uint32_t));
+    struct memwatch_expr* exprs = (struct memwatch_expr*)calloc(count, sizeof(*exprs));
+    struct memwatch_result* results = (struct memwatch_result*)calloc(count, sizeof(*results));
+    struct reference* reported = (struct reference*)calloc(count, sizeof(*reported));
+    uint8_t* seen = (uint8_t*)calloc(count, 1);
+    struct memwatch* mw = memwatch_create();
+
+    if (!dram || !exprs || !results || !reported || !seen || !mw) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    /* a game's variables are clustered, so are the watches */
+    for (i = 0; i < count; ++i) {
+        static const uint8_t widths[] = { 1, 1, 2, 4 };
+        uint8_t width = widths[rng() & 3];
+        uint32_t address = (0x100000 + (rng() & 0xffff)) & ~(uint32_t)(width - 1);
+
+        exprs[i].address = (rng() & 1) ? address | UINT32_C(0x80000000) : address;
+        exprs[i].width = width;
+        exprs[i].cmp = (uint8_t)(rng() % (MEMWATCH_GE + 1));
+        exprs[i].mask = (rng() & 7) == 0 ? (UINT32_C(1) << (rng() % (width * 8))) : 0;
+        exprs[i].value = rng() & 0x3;
+    }
+
+    if (!memwatch_set(mw, exprs, count, BENCH_DRAM_SIZE)) {
+        fprintf(stderr, "memwatch_set failed\n");
+        return 1;
+    }
+
+    double total_us = 0.0;
+    double max_us = 0.0;
+    unsigned long long changes = 0;
+    unsigned long long mismatches = 0;
+
+    for (f = 0; f < frames; ++f) {
+        uint8_t* bytes = (uint8_t*)dram;
+
+        /* small values, so the comparisons flip now and then */
+        for (i = 0; i < writes; ++i) {
+            bytes[((0x100000 + (rng() & 0xffff)) ^ S8)] = (uint8_t)(rng() & 0x3);
+        }
+
+        double start = now_us();
+        size_t n = memwatch_poll(mw, dram, results, count);
+        double us = now_us() - start;
+        total_us += us;
+        if (us > max_us)
+            max_us = us;
+        changes += n;
+
+        memset(seen, 0, count);
+        for (i = 0; i < n; ++i) {
+            const struct memwatch_result* result = &results[i];
+            const struct memwatch_expr* expr = &exprs[result->index];
+            uint32_t value = reference_read(bytes, expr);
+            uint8_t state = reference_compare(expr, value);
+
+            if (result->value != value || result->state != state)
+                ++mismatches;
+
+            seen[result->index] = 1;
+            reported[result->index].value = value;
+            reported[result->index].state = state;
+        }
+
+        /* everything not reported has to be unchanged */
+        for (i = 0; i < count; ++i) {
+            uint32_t value;
+
+            if (seen[i])
+                continue;
+
+            value = reference_read(bytes, &exprs[i]);
+            if (f == 0
+                || (exprs[i].cmp == MEMWATCH_CHANGED && value != reported[i].value)
+                || (exprs[i].cmp != MEMWATCH_CHANGED && reference_compare(&exprs[i], value) != reported[i].state))
+                ++mismatches;
+        }
+    }
+
+    printf("watches:     %u, %u bytes written per frame\n", count, writes);
+    printf("frames:      %u\n", frames);
+    printf("poll:        %.2f us per frame, %.2f us max\n", total_us / frames, max_us);
+    printf("changes:     %.1f per frame\n", (double)changes / frames);
+
+    memwatch_destroy(mw);
+    free(seen);
+    free(reported);
+    free(results);
+    free(exprs);
+    free(dram);
+
+    if (mismatches) {
+        printf("MISMATCH: %llu results differ from the reference\n", mismatches);
+        return 2;
+    }
+    return 0;
+}
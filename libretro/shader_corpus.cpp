@@ -0,0 +1,115 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - shader_corpus.cpp                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                  *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* GLideN64 shader corpus tool, built with `make shadercorpus`.
+ *
+ * Aggregates the per-game combiner keys files of the shader storage
+ * (GLideN64.<hash>.<OpenGL|GLES>.keys) into a corpus ranked by the number
+ * of games using each key. Written as GLideN64.<OpenGL|GLES>.corpus into a
+ * shader storage folder, the corpus is merged with the local keys files
+ * when ShaderWarmupCount is set.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+
+#include <osal_files.h>
+#include "ShaderCorpus.h"
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [options] <keys file or folder>...\n"
+		"  -t <OpenGL|GLES>  type of the keys files read from folders (default OpenGL)\n"
+		"  -c <file>         merge an existing corpus\n"
+		"  -o <file>         write the corpus\n"
+		"  -n <n>            number of top keys to print (default 32)\n",
+		argv0);
+}
+
+static bool is_directory(const char *path)
+{
+	wchar_t wpath[PLUGIN_PATH_SIZE];
+	mbstowcs(wpath, path, PLUGIN_PATH_SIZE);
+	return osal_is_directory(wpath) != 0;
+}
+
+int main(int argc, char **argv)
+{
+	std::string type = "OpenGL";
+	const char *output = nullptr;
+	unsigned top = 32;
+	ShaderCorpus corpus;
+	bool anyInput = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			type = argv[++i];
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			output = argv[++i];
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			top = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-c") && i + 1 < argc) {
+			std::ifstream fin(argv[++i]);
+			if (!fin || !corpus.addCorpus(fin)) {
+				fprintf(stderr, "%s: not a corpus\n", argv[i]);
+				return 1;
+			}
+			anyInput = true;
+		}
+		else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		}
+		else if (is_directory(argv[i])) {
+			const u32 added = corpus.addFolder(argv[i], "." + type + ".keys");
+			fprintf(stderr, "%s: %u keys files\n", argv[i], added);
+			anyInput = true;
+		}
+		else {
+			std::ifstream fin(argv[i]);
+			if (!fin || !corpus.addKeys(fin))
+				fprintf(stderr, "%s: not a supported keys file, skipped\n", argv[i]);
+			anyInput = true;
+		}
+	}
+
+	if (!anyInput) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	printf("games:  %u\n", corpus.getTitles());
+	printf("keys:   %u\n", (unsigned)corpus.size());
+	for (const ShaderCorpus::Entry & entry : corpus.getRanked(top))
+		printf("0x%016llX %u\n", (unsigned long long)entry.mux, entry.titles);
+
+	if (output != nullptr) {
+		std::ofstream fout(output, std::ofstream::trunc);
+		if (!fout) {
+			fprintf(stderr, "%s: cannot write\n", output);
+			return 1;
+		}
+		corpus.write(fout);
+	}
+	return 0;
+}
@@ -0,0 +1,329 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - tlb_bench.c                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* TLB lookup table benchmark, built with `make tlbbench`.
+ *
+ * Replays synthetic TLB traffic shaped after the games that lean on the TLB
+ * the most, against the two level lookup table of the core and against the
+ * flat 1M entry arrays it replaced:
+ *
+ *   goldeneye    a 256 KB window of 4 KB pages at 0x7F000000, a few entries
+ *                pointed at new physical pages every frame
+ *   perfectdark  page sizes from 4 KB to 64 KB over several regions of
+ *                kuseg, entries replaced at random like TLBWR does
+ *
+ * Every lookup is checked against the flat arrays, and the run fails on any
+ * difference. The table footprint is computed from the allocated leaves,
+ * the RSS growth is read from /proc on Linux.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "device/r4300/tlb_lut.h"
+
+#define BENCH_TLB_ENTRIES 64
+
+struct bench_entry
+{
+    uint32_t start;
+    uint32_t end;
+    uint32_t phys;
+    int dirty;
+    int valid;
+};
+
+struct scenario
+{
+    const char* name;
+    void (*generate)(struct bench_entry* e);
+};
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+static long rss_kb(void)
+{
+#ifdef __linux__
+    long pages = -1;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if (f == NULL)
+        return -1;
+    if (fscanf(f, "%*d %ld", &pages) != 1)
+        pages = -1;
+    fclose(f);
+    return pages < 0 ? -1 : pages * 4;
+#else
+    return -1;
+#endif
+}
+
+static void generate_goldeneye(struct bench_entry* e)
+{
+    e->start = UINT32_C(0x7F000000) + (rng() % 64) * 0x1000;
+    e->end = e->start + 0x1000;
+    e->phys = (rng() % 0x800) * 0x1000;
+    e->dirty = (rng() & 3) != 0;
+    e->valid = 1;
+}
+
+static void generate_perfectdark(struct bench_entry* e)
+{
+    static const uint32_t regions[] = {
+        UINT32_C(0x00000000), UINT32_C(0x00400000), UINT32_C(0x7F000000), UINT32_C(0x7F800000)
+    };
+    uint32_t size = UINT32_C(0x1000) << (2 * (rng() % 3));
+
+    e->start = regions[rng() % 4] + (rng() % 256) * size;
+    e->end = e->start + size;
+    e->phys = ((rng() % 0x800000) & ~(size - 1));
+    e->dirty = (rng() & 1);
+    e->valid = 1;
+}
+
+static const struct scenario scenarios[] = {
+    { "goldeneye",   generate_goldeneye },
+    { "perfectdark", generate_perfectdark },
+};
+
+/* same page walks as tlb_map/tlb_unmap */
+static void flat_set(uint32_t* lut_r, uint32_t* lut_w, const struct bench_entry* e, int map)
+{
+    uint32_t i;
+
+    for (i = e->start; i < e->end; i += 0x1000) {
+        uint32_t value = map ? (UINT32_C(0x80000000) | (e->phys + (i - e->start) + 0xFFF)) : 0;
+
+        lut_r[i >> 12] = value;
+        if (e->dirty)
+            lut_w[i >> 12] = value;
+    }
+}
+
+static int sparse_set(struct tlb_lut* lut_r, struct tlb_lut* lut_w, const struct bench_entry* e, int map)
+{
+    uint32_t i;
+    int ok = 1;
+
+    for (i = e->start; i < e->end; i += 0x1000) {
+        uint32_t value = map ? (UINT32_C(0x80000000) | (e->phys + (i - e->start) + 0xFFF)) : 0;
+
+        ok &= tlb_lut_set(lut_r, i >> 12, value);
+        if (e->dirty)
+            ok &= tlb_lut_set(lut_w, i >> 12, value);
+    }
+
+    return ok;
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -s <name>     goldeneye or perfectdark (default goldeneye)\n"
+        "  -f <n>        frames (default 2000)\n"
+        "  -l <n>        lookups per frame (default 20000)\n"
+        "  -c <n>        TLB writes per frame (default 8)\n",
+        argv0);
+}
+
+int main(int argc, char** argv)
+{
+    const struct scenario* scenario = &scenarios[0];
+    unsigned int frames = 2000;
+    unsigned int lookups = 20000;
+    unsigned int churn = 8;
+    unsigned int f, i;
+    int i_arg;
+
+    for (i_arg = 1; i_arg < argc; ++i_arg) {
+        if (!strcmp(argv[i_arg], "-s") && i_arg + 1 < argc) {
+            const char* name = argv[++i_arg];
+            scenario = NULL;
+            for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+                if (!strcmp(scenarios[i].name, name))
+                    scenario = &scenarios[i];
+            }
+            if (scenario == NULL) {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i_arg], "-f") && i_arg + 1 < argc)
+            frames = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-l") && i_arg + 1 < argc)
+            lookups = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-c") && i_arg + 1 < argc)
+            churn = strtoul(argv[++i_arg], NULL, 0);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    uint32_t* flat_r = (uint32_t*)malloc(TLB_LUT_PAGES * sizeof(uint32_t));
+    uint32_t* flat_w = (uint32_t*)malloc(TLB_LUT_PAGES * sizeof(uint32_t));
+    uint32_t* pages = (uint32_t*)malloc((lookups ? lookups : 1) * sizeof(uint32_t));
+    struct tlb_lut* sparse_r = (struct tlb_lut*)calloc(1, sizeof(struct tlb_lut));
+    struct tlb_lut* sparse_w = (struct tlb_lut*)calloc(1, sizeof(struct tlb_lut));
+    struct bench_entry entries[BENCH_TLB_ENTRIES];
+
+    if (!flat_r || !flat_w || !pages || !sparse_r || !sparse_w) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    /* the flat arrays were cleared on every poweron, so they were always resident */
+    memset(flat_r, 0, TLB_LUT_PAGES * sizeof(uint32_t));
+    memset(flat_w, 0, TLB_LUT_PAGES * sizeof(uint32_t));
+    memset(pages, 0, (lookups ? lookups : 1) * sizeof(uint32_t));
+    long rss_before = rss_kb();
+
+    tlb_lut_clear(sparse_r);
+    tlb_lut_clear(sparse_w);
+    memset(entries, 0, sizeof(entries));
+
+    double flat_map_us = 0.0, sparse_map_us = 0.0;
+    double flat_lookup_us = 0.0, sparse_lookup_us = 0.0;
+    unsigned long long mismatches = 0;
+    unsigned int max_leaves = 0;
+    int alloc_failed = 0;
+
+    for (f = 0; f < frames; ++f) {
+        /* TLBWI/TLBWR: unmap the old entry, map the new one */
+        for (i = 0; i < churn || (f == 0 && i < BENCH_TLB_ENTRIES); ++i) {
+            struct bench_entry* e = &entries[(f == 0) ? i : rng() % BENCH_TLB_ENTRIES];
+            struct bench_entry next;
+            double start;
+
+            scenario->generate(&next);
+
+            start = now_us();
+            if (e->valid)
+                flat_set(flat_r, flat_w, e, 0);
+            flat_set(flat_r, flat_w, &next, 1);
+            flat_map_us += now_us() - start;
+
+            start = now_us();
+            if (e->valid)
+                alloc_failed |= !sparse_set(sparse_r, sparse_w, e, 0);
+            alloc_failed |= !sparse_set(sparse_r, sparse_w, &next, 1);
+            sparse_map_us += now_us() - start;
+
+            *e = next;
+        }
+
+        /* mostly accesses through live entries, some misses */
+        for (i = 0; i < lookups; ++i) {
+            const struct bench_entry* e = &entries[rng() % BENCH_TLB_ENTRIES];
+
+            if ((rng() & 7) != 0)
+                pages[i] = (e->start + (rng() % (e->end - e->start))) >> 12;
+            else
+                pages[i] = rng() % TLB_LUT_PAGES;
+        }
+
+        uint32_t flat_sum = 0, sparse_sum = 0;
+        double start = now_us();
+        for (i = 0; i < lookups; ++i)
+            flat_sum += flat_r[pages[i]] ^ flat_w[pages[i]];
+        flat_lookup_us += now_us() - start;
+
+        start = now_us();
+        for (i = 0; i < lookups; ++i)
+            sparse_sum += tlb_lut_get(sparse_r, pages[i]) ^ tlb_lut_get(sparse_w, pages[i]);
+        sparse_lookup_us += now_us() - start;
+
+        if (flat_sum != sparse_sum)
+            ++mismatches;
+
+        unsigned int leaves = tlb_lut_leaves(sparse_r) + tlb_lut_leaves(sparse_w);
+        if (leaves > max_leaves)
+            max_leaves = leaves;
+    }
+
+    long rss_after = rss_kb();
+
+    for (i = 0; i < TLB_LUT_PAGES; ++i) {
+        if (flat_r[i] != tlb_lut_get(sparse_r, i) || flat_w[i] != tlb_lut_get(sparse_w, i))
+            ++mismatches;
+    }
+
+    double total_lookups = (double)frames * lookups * 2;
+    double total_writes = (double)frames * churn;
+
+    printf("scenario:    %s, %u frames, %u TLB writes and %u lookups per frame\n",
+        scenario->name, frames, churn, lookups);
+    printf("lookup:      flat %.2f ns, sparse %.2f ns\n",
+        flat_lookup_us * 1e3 / total_lookups, sparse_lookup_us * 1e3 / total_lookups);
+    printf("TLB write:   flat %.1f ns, sparse %.1f ns\n",
+        flat_map_us * 1e3 / total_writes, sparse_map_us * 1e3 / total_writes);
+    printf("footprint:   flat %u KB, sparse %u KB (%u leaves at most)\n",
+        (unsigned int)(2 * TLB_LUT_PAGES * sizeof(uint32_t) / 1024),
+        (unsigned int)((2 * sizeof(struct tlb_lut) + (size_t)max_leaves * TLB_LUT_LEAF_SIZE * sizeof(uint32_t)) / 1024),
+        max_leaves);
+    if (rss_before >= 0 && rss_after >= 0)
+        printf("rss:         +%ld KB for the sparse tables\n", rss_after - rss_before);
+
+    tlb_lut_clear(sparse_w);
+    tlb_lut_clear(sparse_r);
+    free(sparse_w);
+    free(sparse_r);
+    free(pages);
+    free(flat_w);
+    free(flat_r);
+
+    if (alloc_failed) {
+        printf("FAILED: out of memory for a leaf\n");
+        return 2;
+    }
+    if (mismatches) {
+        printf("MISMATCH: %llu lookups differ from the flat tables\n", mismatches);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,321 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - txfilter_bench.cpp                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* GLideNHQ texture enhancement benchmark, built with `make txbench`.
+ *
+ * Loads a corpus of N64 textures from PNG files (e.g. the texture dumps
+ * GLideN64 writes with "Dump textures" enabled), then runs every enhancement
+ * filter and the quantizers over the whole corpus with one worker thread and
+ * with the full pool. Reports the time for both and checks that the output
+ * is identical, as the filters must not depend on how rows are split across
+ * threads. Also checks that the pool hands out every band exactly once when
+ * it is resized between runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+#include <osal_files.h>
+#include "GLideNHQ/TextureFilters.h"
+#include "GLideNHQ/TxImage.h"
+#include "GLideNHQ/TxQuantize.h"
+#include "GLideNHQ/TxUtil.h"
+
+/* same limit as TxFilter */
+#define TXBENCH_MAX_SIZE 4096
+
+struct bench_texture
+{
+	std::string name;
+	int width;
+	int height;
+	std::vector<uint32> pixels;
+};
+
+struct bench_filter
+{
+	const char *name;
+	uint32 filter;
+	uint32 scale;
+};
+
+static const bench_filter filters[] =
+{
+	{ "2x",          X2_ENHANCEMENT,    2 },
+	{ "2xsai",       X2SAI_ENHANCEMENT, 2 },
+	{ "hq2x",        HQ2X_ENHANCEMENT,  2 },
+	{ "hq2xs",       HQ2XS_ENHANCEMENT, 2 },
+	{ "lq2x",        LQ2X_ENHANCEMENT,  2 },
+	{ "lq2xs",       LQ2XS_ENHANCEMENT, 2 },
+	{ "hq4x",        HQ4X_ENHANCEMENT,  4 },
+	{ "xbrz2",       BRZ2X_ENHANCEMENT, 2 },
+	{ "xbrz4",       BRZ4X_ENHANCEMENT, 4 },
+	{ "xbrz6",       BRZ6X_ENHANCEMENT, 6 },
+	{ "smooth1",     SMOOTH_FILTER_1,   1 },
+	{ "smooth4",     SMOOTH_FILTER_4,   1 },
+	{ "sharp1",      SHARP_FILTER_1,    1 },
+	{ "deposterize", DEPOSTERIZE | SMOOTH_FILTER_1, 1 },
+};
+
+/* timing and output hash of one pass over the corpus */
+struct bench_result
+{
+	double ms;
+	XXH64_hash_t hash;
+};
+
+static bool load_texture(const std::string &path, std::vector<bench_texture> &textures)
+{
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (fp == nullptr)
+		return false;
+
+	TxImage image;
+	int width, height;
+	ColorFormat format;
+	uint8 *data = image.readPNG(fp, &width, &height, &format);
+	fclose(fp);
+
+	if (data == nullptr)
+		return false;
+
+	if (format == graphics::internalcolorFormat::RGBA8 &&
+		width > 0 && height > 0 && width <= TXBENCH_MAX_SIZE && height <= TXBENCH_MAX_SIZE) {
+		bench_texture tex;
+		tex.name = path;
+		tex.width = width;
+		tex.height = height;
+		tex.pixels.assign((uint32*)data, (uint32*)data + width * height);
+		textures.push_back(std::move(tex));
+	}
+
+	free(data);
+	return true;
+}
+
+static void load_path(const char *path, std::vector<bench_texture> &textures)
+{
+	std::wstring wpath(strlen(path) + 1, L'\0');
+	wpath.resize(mbstowcs(&wpath[0], path, wpath.size()));
+
+	if (!osal_is_directory(wpath.c_str())) {
+		if (!load_texture(path, textures))
+			fprintf(stderr, "could not read %s\n", path);
+		return;
+	}
+
+	void *dir = osal_search_dir_open(wpath.c_str());
+	const wchar_t *entry;
+	while ((entry = osal_search_dir_read_next(dir)) != nullptr) {
+		char name[PATH_MAX];
+		size_t len = wcstombs(name, entry, sizeof(name));
+		if (len == (size_t)-1 || len < 4 || strcmp(name + len - 4, ".png") != 0)
+			continue;
+		load_texture(std::string(path) + "/" + name, textures);
+	}
+	osal_search_dir_close(dir);
+}
+
+static bench_result run_filter(const bench_filter &f, const std::vector<bench_texture> &textures,
+							   std::vector<uint32> &dest, unsigned repeats)
+{
+	bench_result res = { 0.0, 0 };
+	XXH64_state_t *state = XXH64_createState();
+	XXH64_reset(state, 0);
+
+	for (const bench_texture &tex : textures) {
+		const size_t size = (size_t)tex.width * tex.height * f.scale * f.scale;
+		if (dest.size() < size)
+			dest.resize(size);
+
+		/* the filters take a non-const source */
+		std::vector<uint32> src(tex.pixels);
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < repeats; i++)
+			filter_8888(src.data(), tex.width, tex.height, dest.data(), f.filter);
+		res.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		XXH64_update(state, dest.data(), size * sizeof(uint32));
+	}
+
+	res.hash = XXH64_digest(state);
+	XXH64_freeState(state);
+	return res;
+}
+
+static bench_result run_quantizer(ColorFormat srcFormat, ColorFormat destFormat,
+								  const std::vector<bench_texture> &textures, unsigned repeats)
+{
+	bench_result res = { 0.0, 0 };
+	XXH64_state_t *state = XXH64_createState();
+	XXH64_reset(state, 0);
+
+	TxQuantize quantize;
+	for (const bench_texture &tex : textures) {
+		const size_t size = (size_t)tex.width * tex.height;
+		std::vector<uint32> src(tex.pixels);
+		std::vector<uint32> dest(size);
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned i = 0; i < repeats; i++)
+			quantize.quantize((uint8*)src.data(), (uint8*)dest.data(), tex.width, tex.height, srcFormat, destFormat);
+		res.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		XXH64_update(state, dest.data(), size * sizeof(uint32));
+	}
+
+	res.hash = XXH64_digest(state);
+	XXH64_freeState(state);
+	return res;
+}
+
+static void print_result(const char *name, const bench_result &single, const bench_result &multi,
+						 double mpix, bool &ok)
+{
+	const bool same = single.hash == multi.hash;
+	ok &= same;
+	printf("%-12s %10.2f %10.2f %8.2fx %10.1f  %016llx %s\n", name, single.ms, multi.ms,
+		   multi.ms > 0.0 ? single.ms / multi.ms : 0.0,
+		   multi.ms > 0.0 ? mpix * 1000.0 / multi.ms : 0.0,
+		   (unsigned long long)multi.hash, same ? "" : "MISMATCH");
+}
+
+/* Workers spawned by init() must only pick up runs started after them. Each
+ * row is marked by the band that covers it, runBands must not return before
+ * all of them are done. */
+static bool check_pool_resize(TxThreadPool *pool, uint32 threads)
+{
+	const uint32 width = 64, height = 1024;
+	std::vector<std::atomic<uint32>> rows(height);
+	bool ok = true;
+
+	for (uint32 i = 0; i < 200 && ok; i++) {
+		pool->init(1 + i % threads);
+		for (uint32 run = 0; run < 4 && ok; run++) {
+			for (std::atomic<uint32> &row : rows)
+				row = 0;
+
+			pool->runBands(width, height, 1, [&](uint32 yFirst, uint32 yLast) {
+				for (uint32 y = yFirst; y < yLast; y++) {
+					/* slow enough that bands overlap */
+					volatile uint32 spin = 0;
+					for (uint32 x = 0; x < width * 4; x++)
+						spin += x;
+					rows[y]++;
+				}
+			});
+
+			for (uint32 y = 0; y < height && ok; y++)
+				ok = rows[y] == 1;
+		}
+	}
+
+	printf("pool resize: %s\n\n", ok ? "ok" : "FAILED");
+	return ok;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [options] <png file or directory>...\n"
+		"  -r <n>        filter every texture n times (default 10)\n"
+		"  -t <n>        worker threads for the parallel run (default: all cores)\n"
+		"  -f <name>     only run this filter (may be repeated)\n",
+		argv0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned repeats = 10;
+	unsigned threads = 0;
+	std::vector<const char *> only;
+	std::vector<bench_texture> textures;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			repeats = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+			only.push_back(argv[++i]);
+		else if (argv[i][0] == '-') {
+			usage(argv[0]);
+			return 1;
+		} else
+			load_path(argv[i], textures);
+	}
+
+	if (textures.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	double mpix = 0.0;
+	for (const bench_texture &tex : textures)
+		mpix += (double)tex.width * tex.height * repeats / 1e6;
+
+	TxMemBuf::getInstance()->init(TXBENCH_MAX_SIZE, TXBENCH_MAX_SIZE);
+	xbrz::init();
+
+	TxThreadPool *pool = TxThreadPool::getInstance();
+	pool->init(threads);
+	threads = pool->numThreads();
+
+	printf("textures:    %u (%.2f Mpixel per pass)\n", (unsigned)textures.size(), mpix / repeats);
+	printf("threads:     %u\n\n", threads);
+
+	bool ok = check_pool_resize(pool, threads);
+	pool->init(threads);
+
+	printf("%-12s %10s %10s %9s %10s  %-16s\n", "filter", "1 thr ms", "pool ms", "speedup", "Mpix/s", "hash");
+
+	std::vector<uint32> dest;
+	for (const bench_filter &f : filters) {
+		bool selected = only.empty();
+		for (const char *name : only)
+			selected |= !strcmp(name, f.name);
+		if (!selected)
+			continue;
+
+		pool->init(1);
+		bench_result single = run_filter(f, textures, dest, repeats);
+		pool->init(threads);
+		bench_result multi = run_filter(f, textures, dest, repeats);
+		print_result(f.name, single, multi, mpix, ok);
+	}
+
+	if (only.empty()) {
+		pool->init(1);
+		bench_result single = run_quantizer(graphics::internalcolorFormat::RGBA8, graphics::internalcolorFormat::RGBA4, textures, repeats);
+		pool->init(threads);
+		bench_result multi = run_quantizer(graphics::internalcolorFormat::RGBA8, graphics::internalcolorFormat::RGBA4, textures, repeats);
+		print_result("quant8888", single, multi, mpix, ok);
+	}
+
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,418 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - vertex_bench.cpp                                   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* GLideN64 vertex pipeline microbenchmark, built with `make vtxbench`.
+ *
+ * Runs the 4-wide SSE vertex stages (transform/billboard/clip, directional
+ * lighting and texture generation) against a scalar reference that mirrors
+ * the templates in gSP.cpp, over a set of recorded gSPVertex calls. Reports
+ * the time of both and fails if any output vertex differs in a single bit.
+ *
+ * Without a capture file a synthetic set is generated; -w writes it out so
+ * it can be replayed later.
+ *
+ * Capture format (little endian):
+ *   char     magic[4] = "GSPV"
+ *   uint32_t version  = 1
+ *   then per gSPVertex call:
+ *     float    combined[4][4]
+ *     float    light_rgb[12][3], light_rgb2[12][3], light_i_xyz[12][3]
+ *     float    lookat_i_xyz[2][3]
+ *     uint32_t num_lights, geometry_mode, billboard
+ *     float    adjust_scale
+ *     uint32_t v0, n
+ *     n * float x, y, z, nx, ny, nz, r, g, b, a, s, t
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Types.h"
+#include "GBI.h"
+#include "gSP.h"
+
+#define VTXBENCH_MAGIC   "GSPV"
+#define VTXBENCH_VERSION 1
+#define VTXBENCH_VERTICES 80
+
+#ifdef __SSE_OPT
+
+void gSPTransformClipVertex4SSE(u32 v, SPVertex * spVtx, float mtx[4][4], bool billboard, f32 adjustScale);
+void gSPLightVertex4SSE(u32 v, SPVertex * spVtx);
+void gSPTextureGenVertex4SSE(u32 v, SPVertex * spVtx, bool linear);
+
+struct bench_call
+{
+	f32 combined[4][4];
+	f32 rgb[12][3];
+	f32 rgb2[12][3];
+	f32 i_xyz[12][3];
+	f32 lookat[2][3];
+	u32 numLights;
+	u32 geometryMode;
+	u32 billboard;
+	f32 adjustScale;
+	u32 v0;
+	u32 n;
+	SPVertex vertices[VTXBENCH_VERTICES];
+};
+
+static void load_state(const bench_call &call)
+{
+	memcpy(gSP.lights.rgb, call.rgb, sizeof(call.rgb));
+	memcpy(gSP.lights.rgb2, call.rgb2, sizeof(call.rgb2));
+	memcpy(gSP.lights.i_xyz, call.i_xyz, sizeof(call.i_xyz));
+	memcpy(gSP.lookat.i_xyz, call.lookat, sizeof(call.lookat));
+	gSP.numLights = call.numLights;
+	gSP.lookatEnable = true;
+}
+
+/* Scalar reference, same arithmetic as gSPTransformVertex, gSPBillboardVertex and gSPClipVertex */
+static void ref_transform_clip(u32 v, SPVertex * spVtx, float mtx[4][4], bool billboard, f32 scale)
+{
+	for (u32 i = 0; i < 4; ++i) {
+		SPVertex & vtx = spVtx[v + i];
+		const f32 x = vtx.x, y = vtx.y, z = vtx.z;
+		vtx.x = x * mtx[0][0] + y * mtx[1][0] + z * mtx[2][0] + mtx[3][0];
+		vtx.y = x * mtx[0][1] + y * mtx[1][1] + z * mtx[2][1] + mtx[3][1];
+		vtx.z = x * mtx[0][2] + y * mtx[1][2] + z * mtx[2][2] + mtx[3][2];
+		vtx.w = x * mtx[0][3] + y * mtx[1][3] + z * mtx[2][3] + mtx[3][3];
+	}
+	if (billboard) {
+		SPVertex & vtx0 = spVtx[0];
+		for (u32 i = 0; i < 4; ++i) {
+			SPVertex & vtx = spVtx[v + i];
+			vtx.x += vtx0.x;
+			vtx.y += vtx0.y;
+			vtx.z += vtx0.z;
+			vtx.w += vtx0.w;
+		}
+	}
+	for (u32 i = 0; i < 4; ++i) {
+		SPVertex & vtx = spVtx[v + i];
+		vtx.clip = 0;
+		const f32 scaledX = vtx.x * scale;
+		if (scaledX > +vtx.w) vtx.clip |= CLIP_POSX;
+		if (scaledX < -vtx.w) vtx.clip |= CLIP_NEGX;
+		if (vtx.y > +vtx.w) vtx.clip |= CLIP_POSY;
+		if (vtx.y < -vtx.w) vtx.clip |= CLIP_NEGY;
+		if (vtx.w < 0.01f) vtx.clip |= CLIP_W;
+	}
+}
+
+/* Scalar reference, same arithmetic as gSPLightVertexStandard without HW lighting */
+static void ref_light(u32 v, SPVertex * spVtx)
+{
+	for (u32 j = 0; j < 4; ++j) {
+		SPVertex & vtx = spVtx[v + j];
+		const bool useFirstColor = ((v + j) & 1) == 0;
+		const f32 * pColor = useFirstColor ? gSP.lights.rgb[gSP.numLights] : gSP.lights.rgb2[gSP.numLights];
+		vtx.r = pColor[R];
+		vtx.g = pColor[G];
+		vtx.b = pColor[B];
+		vtx.HWLight = 0;
+		for (u32 i = 0; i < gSP.numLights; ++i) {
+			const f32 * l = gSP.lights.i_xyz[i];
+			const f32 intensity = vtx.nx * l[0] + vtx.ny * l[1] + vtx.nz * l[2];
+			if (intensity > 0.0f) {
+				const f32 * c = useFirstColor ? gSP.lights.rgb[i] : gSP.lights.rgb2[i];
+				vtx.r += c[R] * intensity;
+				vtx.g += c[G] * intensity;
+				vtx.b += c[B] * intensity;
+			}
+		}
+		vtx.r = std::min(1.0f, vtx.r);
+		vtx.g = std::min(1.0f, vtx.g);
+		vtx.b = std::min(1.0f, vtx.b);
+	}
+}
+
+/* Scalar reference, same arithmetic as the lookat texture generation in gSPProcessVertex */
+static void ref_texgen(u32 v, SPVertex * spVtx, bool linear)
+{
+	for (u32 j = 0; j < 4; ++j) {
+		SPVertex & vtx = spVtx[v + j];
+		const f32 n[3] = { vtx.nx, vtx.ny, vtx.nz };
+		const f32 * l0 = gSP.lookat.i_xyz[0];
+		const f32 * l1 = gSP.lookat.i_xyz[1];
+		f32 x = l0[0] * n[0] + l0[1] * n[1] + l0[2] * n[2];
+		f32 y = l1[0] * n[0] + l1[1] * n[1] + l1[2] * n[2];
+		if (linear) {
+			if (x < -1.0f) x = -1.0f;
+			if (x > 1.0f) x = 1.0f;
+			if (y < -1.0f) y = -1.0f;
+			if (y > 1.0f) y = 1.0f;
+			vtx.s = acosf(-x) * 325.94931f;
+			vtx.t = acosf(-y) * 325.94931f;
+		} else {
+			vtx.s = (x + 1.0f) * 512.0f;
+			vtx.t = (y + 1.0f) * 512.0f;
+		}
+	}
+}
+
+/* one gSPVertex call through the pipeline, in 4 vertex batches as gSPLoadVertexData<4> */
+static void process_call(bench_call &call, SPVertex * vtx, bool sse)
+{
+	const bool billboard = call.billboard != 0;
+	const bool linear = (call.geometryMode & G_TEXTURE_GEN_LINEAR) != 0;
+	const u32 end = call.v0 + call.n - call.n % 4;
+	for (u32 v = call.v0; v < end; v += 4) {
+		if (sse && (!billboard || v != 0))
+			gSPTransformClipVertex4SSE(v, vtx, call.combined, billboard, call.adjustScale);
+		else
+			ref_transform_clip(v, vtx, call.combined, billboard, call.adjustScale);
+
+		if ((call.geometryMode & G_LIGHTING) == 0)
+			continue;
+
+		if (sse)
+			gSPLightVertex4SSE(v, vtx);
+		else
+			ref_light(v, vtx);
+
+		if ((call.geometryMode & G_TEXTURE_GEN) == 0)
+			continue;
+
+		if (sse)
+			gSPTextureGenVertex4SSE(v, vtx, linear);
+		else
+			ref_texgen(v, vtx, linear);
+	}
+}
+
+static f32 frand(std::mt19937 &rng, f32 lo, f32 hi)
+{
+	return std::uniform_real_distribution<f32>(lo, hi)(rng);
+}
+
+static void generate(std::vector<bench_call> &calls, unsigned count, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	static const u32 modes[] = {
+		0,
+		G_LIGHTING,
+		G_LIGHTING | G_TEXTURE_GEN,
+		G_LIGHTING | G_TEXTURE_GEN | G_TEXTURE_GEN_LINEAR,
+	};
+
+	calls.resize(count);
+	for (bench_call &call : calls) {
+		memset(&call, 0, sizeof(call));
+		for (u32 i = 0; i < 4; ++i)
+			for (u32 j = 0; j < 4; ++j)
+				call.combined[i][j] = frand(rng, -2.0f, 2.0f);
+		call.combined[3][3] = frand(rng, 50.0f, 500.0f);
+		for (u32 l = 0; l < 12; ++l) {
+			for (u32 c = 0; c < 3; ++c) {
+				call.rgb[l][c] = frand(rng, 0.0f, 1.0f);
+				call.rgb2[l][c] = frand(rng, 0.0f, 1.0f);
+			}
+			const f32 x = frand(rng, -1.0f, 1.0f), y = frand(rng, -1.0f, 1.0f), z = frand(rng, -1.0f, 1.0f);
+			const f32 len = sqrtf(x * x + y * y + z * z) + 1e-6f;
+			call.i_xyz[l][0] = x / len;
+			call.i_xyz[l][1] = y / len;
+			call.i_xyz[l][2] = z / len;
+		}
+		for (u32 l = 0; l < 2; ++l)
+			for (u32 c = 0; c < 3; ++c)
+				call.lookat[l][c] = frand(rng, -1.0f, 1.0f);
+		call.numLights = rng() % 8;
+		call.geometryMode = modes[rng() % 4];
+		call.billboard = (rng() % 8) == 0;
+		call.adjustScale = (rng() % 2) ? 1.0f : 0.75f;
+		call.n = 4 + rng() % 29;
+		call.v0 = rng() % (VTXBENCH_VERTICES - call.n + 1);
+		for (SPVertex &vtx : call.vertices) {
+			vtx.x = floorf(frand(rng, -1000.0f, 1000.0f));
+			vtx.y = floorf(frand(rng, -1000.0f, 1000.0f));
+			vtx.z = floorf(frand(rng, -1000.0f, 1000.0f));
+			vtx.nx = floorf(frand(rng, -128.0f, 128.0f)) / 128.0f;
+			vtx.ny = floorf(frand(rng, -128.0f, 128.0f)) / 128.0f;
+			vtx.nz = floorf(frand(rng, -128.0f, 128.0f)) / 128.0f;
+			vtx.r = frand(rng, 0.0f, 1.0f);
+			vtx.g = frand(rng, 0.0f, 1.0f);
+			vtx.b = frand(rng, 0.0f, 1.0f);
+			vtx.a = frand(rng, 0.0f, 1.0f);
+			vtx.s = floorf(frand(rng, 0.0f, 1024.0f));
+			vtx.t = floorf(frand(rng, 0.0f, 1024.0f));
+		}
+	}
+}
+
+/* 12 input floats per vertex, see the format description above */
+static const size_t vertex_fields[] = {
+	offsetof(SPVertex, x), offsetof(SPVertex, y), offsetof(SPVertex, z),
+	offsetof(SPVertex, nx), offsetof(SPVertex, ny), offsetof(SPVertex, nz),
+	offsetof(SPVertex, r), offsetof(SPVertex, g), offsetof(SPVertex, b), offsetof(SPVertex, a),
+	offsetof(SPVertex, s), offsetof(SPVertex, t),
+};
+
+#define CALL_HEADER_SIZE offsetof(bench_call, v0)
+
+static bool write_capture(const char *path, const std::vector<bench_call> &calls)
+{
+	FILE *fp = fopen(path, "wb");
+	if (fp == nullptr)
+		return false;
+
+	const u32 version = VTXBENCH_VERSION;
+	fwrite(VTXBENCH_MAGIC, 1, 4, fp);
+	fwrite(&version, sizeof(version), 1, fp);
+	for (const bench_call &call : calls) {
+		fwrite(&call, CALL_HEADER_SIZE, 1, fp);
+		fwrite(&call.v0, sizeof(u32), 1, fp);
+		fwrite(&call.n, sizeof(u32), 1, fp);
+		for (u32 i = 0; i < call.n; ++i)
+			for (size_t field : vertex_fields)
+				fwrite(reinterpret_cast<const u8*>(&call.vertices[call.v0 + i]) + field, sizeof(f32), 1, fp);
+	}
+	return fclose(fp) == 0;
+}
+
+static bool read_capture(const char *path, std::vector<bench_call> &calls)
+{
+	FILE *fp = fopen(path, "rb");
+	if (fp == nullptr)
+		return false;
+
+	char magic[4];
+	u32 version;
+	if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, VTXBENCH_MAGIC, 4) != 0 ||
+		fread(&version, sizeof(version), 1, fp) != 1 || version != VTXBENCH_VERSION) {
+		fclose(fp);
+		return false;
+	}
+
+	bench_call call;
+	while (fread(&call, CALL_HEADER_SIZE, 1, fp) == 1) {
+		if (fread(&call.v0, sizeof(u32), 1, fp) != 1 || fread(&call.n, sizeof(u32), 1, fp) != 1 ||
+			call.n > VTXBENCH_VERTICES || call.v0 > VTXBENCH_VERTICES - call.n || call.numLights > 7)
+			break;
+		memset(call.vertices, 0, sizeof(call.vertices));
+		for (u32 i = 0; i < call.n; ++i)
+			for (size_t field : vertex_fields)
+				fread(reinterpret_cast<u8*>(&call.vertices[call.v0 + i]) + field, sizeof(f32), 1, fp);
+		calls.push_back(call);
+	}
+
+	fclose(fp);
+	return !calls.empty();
+}
+
+static double run(std::vector<bench_call> &calls, std::vector<SPVertex> &out, unsigned repeats, bool sse)
+{
+	out.resize(calls.size() * VTXBENCH_VERTICES);
+	double ms = 0.0;
+	for (size_t c = 0; c < calls.size(); ++c) {
+		bench_call &call = calls[c];
+		SPVertex *vtx = &out[c * VTXBENCH_VERTICES];
+		load_state(call);
+
+		for (unsigned i = 0; i < repeats; ++i) {
+			memcpy(vtx, call.vertices, sizeof(call.vertices));
+			auto start = std::chrono::steady_clock::now();
+			process_call(call, vtx, sse);
+			ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+	}
+	return ms;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned repeats = 1000;
+	unsigned count = 4096;
+	unsigned seed = 1;
+	const char *capture = nullptr;
+	const char *write = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			repeats = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			count = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			seed = strtoul(argv[++i], nullptr, 0);
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			write = argv[++i];
+		else if (argv[i][0] != '-' && capture == nullptr)
+			capture = argv[i];
+		else {
+			fprintf(stderr,
+				"usage: %s [options] [capture file]\n"
+				"  -r <n>        process every call n times (default 1000)\n"
+				"  -n <n>        number of synthetic calls (default 4096)\n"
+				"  -s <seed>     seed for the synthetic calls (default 1)\n"
+				"  -w <file>     write the synthetic calls as a capture file\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<bench_call> calls;
+	if (capture != nullptr) {
+		if (!read_capture(capture, calls)) {
+			fprintf(stderr, "could not read capture %s\n", capture);
+			return 1;
+		}
+	} else {
+		generate(calls, count, seed);
+		if (write != nullptr && !write_capture(write, calls)) {
+			fprintf(stderr, "could not write %s\n", write);
+			return 1;
+		}
+	}
+
+	size_t vertices = 0;
+	for (const bench_call &call : calls)
+		vertices += call.n - call.n % 4;
+
+	std::vector<SPVertex> ref, sse;
+	const double refMs = run(calls, ref, repeats, false);
+	const double sseMs = run(calls, sse, repeats, true);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < ref.size(); ++i)
+		mismatches += memcmp(&ref[i], &sse[i], sizeof(SPVertex)) != 0;
+
+	const double mvtx = (double)vertices * repeats / 1e6;
+	printf("calls:       %u (%u vertices in 4 vertex batches)\n", (unsigned)calls.size(), (unsigned)vertices);
+	printf("scalar:      %10.2f ms %8.1f Mvtx/s\n", refMs, mvtx * 1000.0 / refMs);
+	printf("sse:         %10.2f ms %8.1f Mvtx/s  %.2fx\n", sseMs, mvtx * 1000.0 / sseMs, refMs / sseMs);
+	printf("mismatches:  %u\n", (unsigned)mismatches);
+	return mismatches == 0 ? 0 : 2;
+}
+
+#else
+
+int main(int argc, char **argv)
+{
+	fprintf(stderr, "%s: built without the SSE vertex pipeline (__SSE_OPT)\n", argv[0]);
+	return 1;
+}
+
+#endif // __SSE_OPT
@@ -0,0 +1,364 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - vi_simd_bench.c                                    *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Angrylion VI row kernel check, built with `make visimdbench`.
+ *
+ * Runs the SSE2 row kernels of n64video/vi/simd.c over random rows and
+ * compares them with the per-pixel filters they replace:
+ *
+ *   fetch   vi_fetch_filter16/32 for both pixel types, every AA mode,
+ *           with and without the restore filter and for each fetch bug
+ *           state, over random RDRAM and coverage, including rows that
+ *           run past the end of RDRAM
+ *   divot   divot_filter
+ *   lerp    the three vi_vl_lerp of vi_process_full_parallel, on random
+ *           source positions and fractions
+ *
+ * The output has to be bit-exact, the run fails on the first difference.
+ * The time per row of both paths is printed at the end.
+ *
+ * n64video.c is built into this file so that the static kernels and filters
+ * can be called directly; the output, message and worker functions it needs
+ * are stubbed below.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "../mupen64plus-video-angrylion/n64video.c"
+
+void msg_error(const char* err, ...) { (void)err; }
+void msg_warning(const char* err, ...) { (void)err; }
+void msg_debug(const char* err, ...) { (void)err; }
+
+void vdac_init(struct n64video_config* cfg) { (void)cfg; }
+void vdac_read(struct frame_buffer* fb, bool alpha) { (void)fb; (void)alpha; }
+void vdac_write(struct frame_buffer* fb) { (void)fb; }
+void vdac_sync(bool invaid) { (void)invaid; }
+void vdac_close(void) { }
+
+void parallel_alinit(uint32_t num) { (void)num; }
+void parallel_run(void task(uint32_t)) { task(0); }
+uint32_t parallel_num_workers(void) { return 1; }
+void parallel_run_async(void task(uint32_t)) { (void)task; }
+bool parallel_done(void) { return true; }
+void parallel_sync(void) { }
+void parallel_close(void) { }
+
+#if defined(__SSE2__)
+
+/* room for the entries the kernels write past the end of a row */
+#define BENCH_ROW (VI_ROW_MAX + VI_ROW_PAD)
+
+static uint8_t bench_rdram[RDRAM_MAX_SIZE];
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+static struct rgba random_rgba(void)
+{
+    struct rgba c;
+    uint32_t v = rng();
+
+    c.r = v;
+    c.g = v >> 8;
+    c.b = v >> 16;
+    c.a = (v >> 24) & 7;
+    return c;
+}
+
+static void bench_rdram_init(uint32_t size)
+{
+    uint32_t i;
+
+    video->config.gfx.rdram = bench_rdram;
+    video->config.gfx.rdram_size = size;
+    rdram_init();
+
+    for (i = 0; i < size; i += 4) {
+        uint32_t v = rng();
+        memcpy(&bench_rdram[i], &v, sizeof(v));
+    }
+
+    /* mostly full coverage, like real frame buffers, so that both the
+     * vector lanes and the scalar fallback get exercised */
+    for (i = 0; i < RDRAM_MAX_SIZE / 2; i++) {
+        rdram_hidden[i] = (rng() & 7) ? 3 : (rng() & 3);
+    }
+
+    vi->rdram32 = rdram32;
+    vi->rdram16 = rdram16;
+    vi->rdram_hidden = rdram_hidden;
+}
+
+static int report(const char* what, uint32_t iter, uint32_t c, const struct rgba* ref, const struct rgba* res)
+{
+    fprintf(stderr, "%s: mismatch at iteration %u, entry %u: scalar %02x%02x%02x/%u, sse2 %02x%02x%02x/%u\n",
+        what, iter, c, ref->r, ref->g, ref->b, ref->a, res->r, res->g, res->b, res->a);
+    return 1;
+}
+
+static int check_fetch(uint32_t iterations, double* t_scalar, double* t_simd)
+{
+    static struct rgba ref[BENCH_ROW];
+    static struct rgba res[BENCH_ROW];
+    uint32_t iter, c;
+
+    for (iter = 0; iter < iterations; iter++) {
+        struct vi_reg_ctrl vctrl;
+        uint32_t hres_w = 16 + rng() % 1024;
+        uint32_t c_begin = rng() % 4;
+        uint32_t c_end = c_begin + 1 + rng() % (PRESCALE_WIDTH + 4);
+        uint32_t fetchstate = rng() % 3;
+        uint32_t fboffset, pixels;
+        double t0, t1, t2;
+
+        memset(&vctrl, 0, sizeof(vctrl));
+        vctrl.type = (rng() & 1) ? VI_TYPE_RGBA8888 : VI_TYPE_RGBA5551;
+        vctrl.aa_mode = rng() % 4;
+        vctrl.dither_filter_enable = rng() & 1;
+
+        /* one row in 8 runs into the end of RDRAM */
+        fboffset = (rng() % video->config.gfx.rdram_size) & ~7u;
+        if ((rng() & 7) == 0) {
+            fboffset = video->config.gfx.rdram_size - (rng() % 0x1000 & ~7u);
+        }
+        pixels = hres_w * (rng() % 4);
+
+        memset(ref, 0, sizeof(ref));
+        memset(res, 0, sizeof(res));
+
+        t0 = now_us();
+        for (c = c_begin; c < c_end; c++) {
+            if (vctrl.type & 1) {
+                vi_fetch_filter32(&ref[c], fboffset, pixels + c - 1, vctrl, hres_w, fetchstate);
+            } else {
+                vi_fetch_filter16(&ref[c], fboffset, pixels + c - 1, vctrl, hres_w, fetchstate);
+            }
+        }
+        t1 = now_us();
+        vi_select_fetch_row(vctrl)(res, c_begin, c_end, pixels, fboffset, vctrl, hres_w, fetchstate);
+        t2 = now_us();
+
+        *t_scalar += t1 - t0;
+        *t_simd += t2 - t1;
+
+        for (c = c_begin; c < c_end; c++) {
+            if (memcmp(&ref[c], &res[c], sizeof(ref[c]))) {
+                fprintf(stderr, "fetch: type %u, aa %u, restore %d, fetch bug %u, offset %x, hres %u\n",
+                    vctrl.type, vctrl.aa_mode, vctrl.dither_filter_enable, fetchstate, fboffset, hres_w);
+                return report("fetch", iter, c, &ref[c], &res[c]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int check_divot(uint32_t iterations, double* t_scalar, double* t_simd)
+{
+    static struct rgba src[BENCH_ROW];
+    static struct rgba ref[BENCH_ROW];
+    static struct rgba res[BENCH_ROW];
+    uint32_t iter, c;
+
+    for (iter = 0; iter < iterations; iter++) {
+        uint32_t c_begin = 1 + rng() % 4;
+        uint32_t c_end = c_begin + 1 + rng() % PRESCALE_WIDTH;
+        double t0, t1, t2;
+
+        for (c = 0; c < BENCH_ROW; c++) {
+            src[c] = random_rgba();
+            /* neighbours that are all fully covered skip the filter */
+            if (rng() & 1) {
+                src[c].a = 7;
+            }
+        }
+
+        t0 = now_us();
+        for (c = c_begin; c < c_end; c++) {
+            divot_filter(&ref[c], src[c], src[c - 1], src[c + 1]);
+        }
+        t1 = now_us();
+        vi_divot_row(res, src, c_begin, c_end);
+        t2 = now_us();
+
+        *t_scalar += t1 - t0;
+        *t_simd += t2 - t1;
+
+        for (c = c_begin; c < c_end; c++) {
+            if (memcmp(&ref[c], &res[c], sizeof(ref[c]))) {
+                return report("divot", iter, c, &ref[c], &res[c]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int check_lerp(uint32_t iterations, double* t_scalar, double* t_simd)
+{
+    static struct rgba cur[BENCH_ROW];
+    static struct rgba next[BENCH_ROW];
+    static struct rgba ref[PRESCALE_WIDTH + 4];
+    static struct rgba res[PRESCALE_WIDTH + 4];
+    static uint16_t cx[PRESCALE_WIDTH + 4];
+    static uint16_t xfrac[PRESCALE_WIDTH + 4];
+    uint32_t iter, c;
+    int32_t x;
+
+    for (iter = 0; iter < iterations; iter++) {
+        int32_t num = 1 + rng() % PRESCALE_WIDTH;
+        uint32_t x_offs = rng() & 0xfff;
+        uint32_t x_step = 0x100 + rng() % 0x700;
+        uint32_t yfrac = rng() & 0x1f;
+        bool lerp = (rng() & 3) != 0;
+        double t0, t1, t2;
+
+        for (c = 0; c < BENCH_ROW; c++) {
+            cur[c] = random_rgba();
+            next[c] = random_rgba();
+        }
+
+        /* same layout as vi_process_full_rows */
+        for (x = 0; x < num; x++, x_offs += x_step) {
+            cx[x] = (x_offs >> 10) + 1;
+            xfrac[x] = (x_offs >> 5) & 0x1f;
+        }
+        for (; x < PRESCALE_WIDTH + 4; x++) {
+            cx[x] = cx[0];
+            xfrac[x] = 0;
+        }
+
+        t0 = now_us();
+        for (x = 0; x < num; x++) {
+            struct rgba color = cur[cx[x]];
+
+            if (lerp) {
+                struct rgba nextcolor = cur[cx[x] + 1];
+                vi_vl_lerp(&color, next[cx[x]], yfrac);
+                vi_vl_lerp(&nextcolor, next[cx[x] + 1], yfrac);
+                vi_vl_lerp(&color, nextcolor, xfrac[x]);
+            }
+
+            ref[x] = color;
+        }
+        t1 = now_us();
+        vi_lerp_row(res, cur, next, cx, xfrac, yfrac, num, lerp);
+        t2 = now_us();
+
+        *t_scalar += t1 - t0;
+        *t_simd += t2 - t1;
+
+        for (x = 0; x < num; x++) {
+            if (memcmp(&ref[x], &res[x], sizeof(ref[x]))) {
+                return report("lerp", iter, x, &ref[x], &res[x]);
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    static const uint32_t rdram_sizes[] = { 0x400000, 0x800000 };
+    uint32_t iterations = 20000;
+    double t_fetch[2] = { 0, 0 }, t_divot[2] = { 0, 0 }, t_lerp[2] = { 0, 0 };
+    size_t s;
+    int i_arg;
+
+    for (i_arg = 1; i_arg < argc; ++i_arg) {
+        if (!strcmp(argv[i_arg], "-n") && i_arg + 1 < argc)
+            iterations = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-s") && i_arg + 1 < argc)
+            rng_state = strtoul(argv[++i_arg], NULL, 0) | 1;
+        else {
+            fprintf(stderr,
+                "usage: %s [options]\n"
+                "  -n <n>        rows per kernel and RDRAM size (default 20000)\n"
+                "  -s <seed>     random seed\n",
+                argv[0]);
+            return 1;
+        }
+    }
+
+    if (!n64video_create()) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    vi_restore_init();
+
+    for (s = 0; s < sizeof(rdram_sizes) / sizeof(rdram_sizes[0]); s++) {
+        bench_rdram_init(rdram_sizes[s]);
+
+        if (check_fetch(iterations, &t_fetch[0], &t_fetch[1])
+            || check_divot(iterations, &t_divot[0], &t_divot[1])
+            || check_lerp(iterations, &t_lerp[0], &t_lerp[1])) {
+            fprintf(stderr, "FAILED with %u KB of RDRAM\n", rdram_sizes[s] >> 10);
+            return 1;
+        }
+    }
+
+    iterations *= (uint32_t)(sizeof(rdram_sizes) / sizeof(rdram_sizes[0]));
+    printf("%-8s %12s %12s\n", "kernel", "scalar us", "sse2 us");
+    printf("%-8s %12.3f %12.3f\n", "fetch", t_fetch[0] / iterations, t_fetch[1] / iterations);
+    printf("%-8s %12.3f %12.3f\n", "divot", t_divot[0] / iterations, t_divot[1] / iterations);
+    printf("%-8s %12.3f %12.3f\n", "lerp", t_lerp[0] / iterations, t_lerp[1] / iterations);
+    printf("all rows bit-exact\n");
+
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    printf("the SSE2 VI kernels are not built for this target\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,395 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus-Next - zip_bench.c                                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+/* Zipped state loading benchmark, built with `make zipbench`.
+ *
+ * Writes a PJ64 sized zipped state into a scratch directory, then loads it
+ * the way savestates_load_pj64 does (an 8 byte header, then the rest in one
+ * read) four ways: with minizip directly, through zip_stream from the file
+ * and from the archive in memory, and through zip_stream with a warm cache.
+ * Each load is checked against the original data. The state has to be found
+ * behind a readme in the archive, a damaged cache image has to be inflated
+ * again, and a state whose CRC doesn't match has to be refused.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <unzip.h>
+#include <zip.h>
+
+#include "main/zip_stream.h"
+
+#define BENCH_HEADER_SIZE 8
+
+static const unsigned char state_magic[4] = { 0xc8, 0xa6, 0xd8, 0x23 };
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static double now_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1e6 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+#endif
+}
+
+static void make_dir(const char* path)
+{
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+/* RDRAM compresses like a game's: runs of zeroes, tables and some noise */
+static void fill_state(unsigned char* data, size_t size)
+{
+    size_t i = 0;
+
+    while (i < size) {
+        size_t run = 64 + (rng() & 0xfff);
+        unsigned int kind = rng() & 3;
+        size_t j;
+
+        if (run > size - i)
+            run = size - i;
+        for (j = 0; j < run; ++j) {
+            switch (kind)
+            {
+            case 0:  data[i + j] = 0; break;
+            case 1:  data[i + j] = (unsigned char)(j & 0x3f); break;
+            case 2:  data[i + j] = (unsigned char)rng(); break;
+            default: data[i + j] = (unsigned char)((j >> 4) ^ (j << 3)); break;
+            }
+        }
+        i += run;
+    }
+}
+
+static int is_state(const unsigned char* header, unsigned int size)
+{
+    return memcmp(header, state_magic, sizeof(state_magic)) == 0;
+}
+
+/* with a readme, the state is the second file in the archive */
+static int write_zip(const char* path, const unsigned char* data, size_t size, const char* readme)
+{
+    zipFile zip = zipOpen(path, APPEND_STATUS_CREATE);
+    int ok = 1;
+
+    if (zip == NULL)
+        return 0;
+
+    if (readme != NULL) {
+        ok = zipOpenNewFileInZip(zip, "readme.txt", NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION) == ZIP_OK
+            && zipWriteInFileInZip(zip, readme, (unsigned)strlen(readme)) == ZIP_OK;
+        zipCloseFileInZip(zip);
+    }
+
+    ok = ok && zipOpenNewFileInZip(zip, "state.pj", NULL, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION) == ZIP_OK
+        && zipWriteInFileInZip(zip, data, (unsigned)size) == ZIP_OK;
+    zipCloseFileInZip(zip);
+    zipClose(zip, "");
+    return ok;
+}
+
+/* the path savestates_load_pj64_zip used before zip_stream */
+static int load_minizip(const char* path, unsigned char* out, size_t size)
+{
+    unzFile zip = unzOpen(path);
+    int ok;
+
+    if (zip == NULL)
+        return 0;
+
+    ok = unzGoToFirstFile(zip) == UNZ_OK
+        && unzOpenCurrentFile(zip) == UNZ_OK
+        && unzReadCurrentFile(zip, out, BENCH_HEADER_SIZE) == BENCH_HEADER_SIZE
+        && unzReadCurrentFile(zip, out + BENCH_HEADER_SIZE, (unsigned)(size - BENCH_HEADER_SIZE)) == (int)(size - BENCH_HEADER_SIZE);
+    unzCloseCurrentFile(zip);
+    unzClose(zip);
+    return ok;
+}
+
+/* reads the archive from memory when zip isn't NULL */
+static int load_stream(const char* path, const unsigned char* zip, size_t zip_size,
+                       const char* cache_dir, size_t cache_size,
+                       unsigned char* out, size_t size, int* cached)
+{
+    struct zip_stream* stream = (zip != NULL)
+        ? zip_stream_open_memory(zip, zip_size, is_state, cache_dir, cache_size)
+        : zip_stream_open(path, is_state, cache_dir, cache_size);
+    int ok;
+
+    if (stream == NULL)
+        return 0;
+
+    ok = zip_stream_size(stream) == size
+        && zip_stream_read(stream, out, BENCH_HEADER_SIZE)
+        && zip_stream_read(stream, out + BENCH_HEADER_SIZE, size - BENCH_HEADER_SIZE);
+    if (cached != NULL)
+        *cached = zip_stream_cached(stream);
+    zip_stream_close(stream);
+    return ok;
+}
+
+static int flip_byte(const char* path, long offset)
+{
+    FILE* f = fopen(path, "r+b");
+    int c, ok;
+
+    if (f == NULL)
+        return 0;
+    ok = fseek(f, offset, SEEK_SET) == 0 && (c = fgetc(f)) != EOF
+        && fseek(f, offset, SEEK_SET) == 0 && fputc(c ^ 0xff, f) != EOF;
+    return (fclose(f) == 0) && ok;
+}
+
+/* damages the image the cache index lists */
+static int corrupt_cache(const char* cache_dir)
+{
+    char index[1024], key[64], image[1024];
+    FILE* f;
+    int ok;
+
+    snprintf(index, sizeof(index), "%s/index", cache_dir);
+    f = fopen(index, "r");
+    if (f == NULL)
+        return 0;
+    ok = fscanf(f, "%63s", key) == 1;
+    fclose(f);
+
+    snprintf(image, sizeof(image), "%s/%s", cache_dir, key);
+    return ok && flip_byte(image, 0x1234);
+}
+
+static unsigned char* read_file(const char* path, size_t* size)
+{
+    unsigned char* data;
+    long length;
+    FILE* f = fopen(path, "rb");
+
+    if (f == NULL)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = (length > 0) ? (unsigned char*)malloc(length) : NULL;
+    if (data == NULL || fread(data, 1, length, f) != (size_t)length) {
+        fclose(f);
+        free(data);
+        return NULL;
+    }
+    fclose(f);
+
+    *size = (size_t)length;
+    return data;
+}
+
+/* changes the CRC recorded in the local and central headers */
+static int patch_crc(const char* path)
+{
+    unsigned char* zip;
+    size_t size_read;
+    long size, i;
+    int patched = 0;
+
+    zip = read_file(path, &size_read);
+    if (zip == NULL)
+        return 0;
+    size = (long)size_read;
+
+    /* the only file, so the local header is first and the central one last */
+    if (size >= 30 && !memcmp(zip, "PK\3\4", 4))
+        patched += flip_byte(path, 14);
+    for (i = size - 46; i >= 0; --i) {
+        if (!memcmp(zip + i, "PK\1\2", 4)) {
+            patched += flip_byte(path, i + 16);
+            break;
+        }
+    }
+    free(zip);
+    return patched == 2;
+}
+
+static void usage(const char* argv0)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -d <dir>      scratch directory (default zipbench.tmp)\n"
+        "  -n <n>        loads per mode (default 20)\n"
+        "  -s <mb>       RDRAM size in MB (default 8)\n",
+        argv0);
+}
+
+int main(int argc, char** argv)
+{
+    const char* dir = "zipbench.tmp";
+    unsigned int loads = 20;
+    size_t size = 8 << 20;
+    unsigned int i;
+    int i_arg;
+
+    for (i_arg = 1; i_arg < argc; ++i_arg) {
+        if (!strcmp(argv[i_arg], "-d") && i_arg + 1 < argc)
+            dir = argv[++i_arg];
+        else if (!strcmp(argv[i_arg], "-n") && i_arg + 1 < argc)
+            loads = strtoul(argv[++i_arg], NULL, 0);
+        else if (!strcmp(argv[i_arg], "-s") && i_arg + 1 < argc)
+            size = strtoul(argv[++i_arg], NULL, 0) << 20;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* RDRAM plus the PJ64 register block */
+    size += 0x2754;
+
+    char path[1024], readme_path[1024], bad_path[1024], cache_dir[1024];
+    snprintf(path, sizeof(path), "%s/state.zip", dir);
+    snprintf(readme_path, sizeof(readme_path), "%s/readme.zip", dir);
+    snprintf(bad_path, sizeof(bad_path), "%s/bad.zip", dir);
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+    make_dir(dir);
+    make_dir(cache_dir);
+
+    unsigned char* data = (unsigned char*)malloc(size);
+    unsigned char* out = (unsigned char*)malloc(size);
+    if (!data || !out) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    fill_state(data, size);
+    memcpy(data, state_magic, sizeof(state_magic));
+    if (!write_zip(path, data, size, NULL)) {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+
+    size_t zip_size;
+    unsigned char* zip = read_file(path, &zip_size);
+    if (!zip) {
+        fprintf(stderr, "could not read %s\n", path);
+        return 1;
+    }
+
+    unsigned long long mismatches = 0;
+    double minizip_us = 0.0, stream_us = 0.0, memory_us = 0.0, cached_us = 0.0;
+    int cached = 0;
+
+    for (i = 0; i < loads; ++i) {
+        double start;
+
+        memset(out, 0, size);
+        start = now_us();
+        if (!load_minizip(path, out, size) || memcmp(out, data, size))
+            ++mismatches;
+        minizip_us += now_us() - start;
+
+        memset(out, 0, size);
+        start = now_us();
+        if (!load_stream(path, NULL, 0, NULL, 0, out, size, NULL) || memcmp(out, data, size))
+            ++mismatches;
+        stream_us += now_us() - start;
+
+        memset(out, 0, size);
+        start = now_us();
+        if (!load_stream(NULL, zip, zip_size, NULL, 0, out, size, NULL) || memcmp(out, data, size))
+            ++mismatches;
+        memory_us += now_us() - start;
+
+        /* the first cached load inflates and fills the cache */
+        memset(out, 0, size);
+        start = now_us();
+        if (!load_stream(path, NULL, 0, cache_dir, 4 * size, out, size, &cached) || memcmp(out, data, size))
+            ++mismatches;
+        if (i > 0) {
+            cached_us += now_us() - start;
+            if (!cached)
+                ++mismatches;
+        }
+    }
+
+    /* a damaged cache image is noticed and the state inflated again */
+    if (!corrupt_cache(cache_dir)
+        || !load_stream(path, NULL, 0, cache_dir, 4 * size, out, size, &cached)
+        || memcmp(out, data, size) || cached)
+        ++mismatches;
+
+    /* the state is found behind other files */
+    if (!write_zip(readme_path, data, size, "not a state\n")) {
+        fprintf(stderr, "could not write %s\n", readme_path);
+        return 1;
+    }
+    memset(out, 0, size);
+    if (!load_stream(readme_path, NULL, 0, NULL, 0, out, size, NULL) || memcmp(out, data, size))
+        ++mismatches;
+
+    /* a state that doesn't match its recorded CRC is refused */
+    if (!write_zip(bad_path, data, size, NULL) || !patch_crc(bad_path)) {
+        fprintf(stderr, "could not write %s\n", bad_path);
+        return 1;
+    }
+    if (load_stream(bad_path, NULL, 0, NULL, 0, out, size, NULL))
+        ++mismatches;
+
+    printf("state:       %.2f MB\n", size / 1048576.0);
+    printf("minizip:     %.2f ms per load\n", minizip_us / loads / 1000.0);
+    printf("zip_stream:  %.2f ms per load\n", stream_us / loads / 1000.0);
+    printf("from memory: %.2f ms per load\n", memory_us / loads / 1000.0);
+    if (loads > 1)
+        printf("cached:      %.2f ms per load\n", cached_us / (loads - 1) / 1000.0);
+
+    free(zip);
+    free(out);
+    free(data);
+
+    if (mismatches) {
+        printf("MISMATCH: %llu loads returned wrong data\n", mismatches);
+        return 2;
+    }
+    return 0;
+}
@@ -145,6 +145,18 @@ EXPORT m64p_error CALL CoreDoCommand(m64p_command Command, int ParamInt, void *P
                 cheat_init(&g_cheat_ctx);
             }
             return rval;
+        case M64CMD_ROM_OPEN_FILE:
+            if (g_EmulatorRunning || l_DiskOpen || l_ROMOpen)
+                return M64ERR_INVALID_STATE;
+            if (ParamPtr == NULL)
+                return M64ERR_INPUT_ASSERT;
+            rval = open_rom_file((const char *) ParamPtr);
+            if (rval == M64ERR_SUCCESS)
+            {
+                l_ROMOpen = 1;
+                cheat_init(&g_cheat_ctx);
+            }
+            return rval;
         case M64CMD_ROM_CLOSE:
             if (g_EmulatorRunning || !l_ROMOpen)
                 return M64ERR_INVALID_STATE;
@@ -383,6 +395,7 @@ EXPORT m64p_error CALL CoreGetRomSettings(m64p_rom_settings *RomSettings, int Ro
     RomSettings->savetype = entry->savetype;
     RomSettings->sidmaduration = entry->sidmaduration;
     RomSettings->aidmamodifier = entry->aidmamodifier;
+    RomSettings->idleloopskip = entry->idleloopskip;
 
     return M64ERR_SUCCESS;
 }
@@ -171,7 +171,8 @@ typedef enum {
   M64CMD_PIF_OPEN,
   M64CMD_ROM_SET_SETTINGS,
   M64CMD_DISK_OPEN,
-  M64CMD_DISK_CLOSE
+  M64CMD_DISK_CLOSE,
+  M64CMD_ROM_OPEN_FILE
 } m64p_command;
 
 typedef struct {
@@ -287,6 +288,7 @@ typedef struct
    unsigned int countperop; /* Number of CPU cycles per instruction. */
    unsigned int sidmaduration; /* Default SI DMA duration */
    unsigned int aidmamodifier; /* Percentage modifier for AI DMA duration */
+   unsigned char idleloopskip; /* 0 - No, 1 - Yes, 2 - Unset, skipping polling loops in the dynarec */
 } m64p_rom_settings;
 
 /* ----------------------------------------- */
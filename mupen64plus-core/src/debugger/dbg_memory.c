@@ -373,7 +373,7 @@ uint32_t get_memory_flags(struct device* dev, uint32_t addr)
     switch(type)
     {
         case M64P_MEM_NOMEM:
-            if(dev->r4300.cp0.tlb.LUT_r[addr>>12])
+            if(tlb_lut_get(&dev->r4300.cp0.tlb.LUT_r, addr>>12))
                 flags = M64P_MEM_FLAG_READABLE | M64P_MEM_FLAG_WRITABLE_EMUONLY;
             break;
         case M64P_MEM_NOTHING:
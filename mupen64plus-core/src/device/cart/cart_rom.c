@@ -28,6 +28,7 @@
 #include "device/memory/memory.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/pi/pi_controller.h"
+#include "main/rom.h"
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -64,6 +65,7 @@ void read_cart_rom(void* opaque, uint32_t address, uint32_t* value)
     }
     else
     {
+        rom_pages_touch(addr, 4);
         *value = *(uint32_t*)(cart_rom->rom + addr);
     }
 }
@@ -99,6 +101,8 @@ unsigned int cart_rom_dma_write(void* opaque, uint8_t* dram, uint32_t dram_addr,
 
     cart_addr &= CART_ROM_ADDR_MASK;
 
+    rom_pages_touch(cart_addr, length);
+
     if (cart_addr + length < cart_rom->rom_size)
     {
         for(i = 0; i < length; ++i) {
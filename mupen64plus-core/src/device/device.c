@@ -185,14 +185,14 @@ void init_device(struct device* dev,
             emumode, count_per_op, count_per_op_denom_pot, no_compiled_jump, randomize_interrupt, start_address);
     init_rdp(&dev->dp, &dev->sp, &dev->mi, &dev->mem, &dev->rdram, &dev->r4300);
     init_rsp(&dev->sp, mem_base_u32(base, MM_RSP_MEM), &dev->mi, &dev->dp, &dev->ri);
-    init_ai(&dev->ai, &dev->mi, &dev->ri, &dev->vi, aout, iaout, dma_modifier);
+    init_ai(&dev->ai, &dev->mi, &dev->ri, &dev->sp, &dev->vi, aout, iaout, dma_modifier);
     init_mi(&dev->mi, &dev->r4300);
     init_pi(&dev->pi,
             get_pi_dma_handler,
             &dev->cart, &dev->dd,
-            &dev->mi, &dev->ri, &dev->dp);
+            &dev->mi, &dev->ri, &dev->dp, &dev->sp);
     init_ri(&dev->ri, &dev->rdram);
-    init_si(&dev->si, si_dma_duration, &dev->mi, &dev->pif, &dev->ri);
+    init_si(&dev->si, si_dma_duration, &dev->mi, &dev->pif, &dev->ri, &dev->sp);
     init_vi(&dev->vi, vi_clock, expected_refresh_rate, &dev->mi, &dev->dp);
 
     /*
@@ -146,6 +146,7 @@ void cached_interp_##name##_IDLE(void) \
         if(*cp0_cycle_count < 0) \
         { \
             cp0_regs[CP0_COUNT_REG] -= *cp0_cycle_count; \
+            r4300->cp0.idle_count -= *cp0_cycle_count; \
             *cp0_cycle_count = 0; \
         } \
     } \
@@ -340,6 +341,84 @@ static void (*const ci_table[R4300_OPCODES_COUNT])(void) =
 };
 #undef X
 
+// -----------------------------------------------------------
+// Fused instruction pairs
+// -----------------------------------------------------------
+/* Common pairs run as one handler, saving a dispatch per pair: address
+ * materialization (LUI + ADDIU/ORI/LW/SW), compare and branch, and a load
+ * followed by its first use. The second instruction still has its own
+ * handler, so jumping to it directly works as before. If the first one
+ * raises an exception, the second one is not executed. */
+#define FUSED_PAIRS \
+    X(LUI, ADDIU) \
+    X(LUI, ORI) \
+    X(LUI, LW) \
+    X(LUI, SW) \
+    X(SLT, BEQ) X(SLT, BEQ_OUT) X(SLT, BNE) X(SLT, BNE_OUT) \
+    X(SLTU, BEQ) X(SLTU, BEQ_OUT) X(SLTU, BNE) X(SLTU, BNE_OUT) \
+    X(SLTI, BEQ) X(SLTI, BEQ_OUT) X(SLTI, BNE) X(SLTI, BNE_OUT) \
+    X(SLTIU, BEQ) X(SLTIU, BEQ_OUT) X(SLTIU, BNE) X(SLTIU, BNE_OUT) \
+    X(LW, ADDU) \
+    X(LW, ADDIU) \
+    X(LW, ANDI) \
+    X(LW, SLL)
+
+#define X(first, second) \
+static void cached_interp_##first##_##second(void) \
+{ \
+    DECLARE_R4300 \
+    const struct precomp_instr* next = (*r4300_pc_struct(r4300)) + 1; \
+    cached_interp_##first(); \
+    if ((*r4300_pc_struct(r4300)) == next) { \
+        cached_interp_##second(); \
+    } \
+}
+FUSED_PAIRS
+#undef X
+
+static const struct
+{
+    enum r4300_opcode first;
+    enum r4300_opcode second;
+    void (*ops)(void);
+} ci_fused_table[] =
+{
+#define X(first, second) { R4300_OP_##first, R4300_OP_##second, cached_interp_##first##_##second },
+    FUSED_PAIRS
+#undef X
+};
+
+static void (*get_fused_ops(enum r4300_opcode first, enum r4300_opcode second))(void)
+{
+    size_t i;
+    for (i = 0; i < sizeof(ci_fused_table) / sizeof(ci_fused_table[0]); ++i)
+    {
+        if (ci_fused_table[i].first == first && ci_fused_table[i].second == second) {
+            return ci_fused_table[i].ops;
+        }
+    }
+    return NULL;
+}
+
+/* instructions with a delay slot, which runs through its own handler */
+static int has_delay_slot(enum r4300_opcode opcode)
+{
+    switch (opcode)
+    {
+    case R4300_OP_BC0F: case R4300_OP_BC0FL: case R4300_OP_BC0T: case R4300_OP_BC0TL:
+    case R4300_OP_BC1F: case R4300_OP_BC1FL: case R4300_OP_BC1T: case R4300_OP_BC1TL:
+    case R4300_OP_BC2F: case R4300_OP_BC2FL: case R4300_OP_BC2T: case R4300_OP_BC2TL:
+    case R4300_OP_BEQ: case R4300_OP_BEQL: case R4300_OP_BNE: case R4300_OP_BNEL:
+    case R4300_OP_BGEZ: case R4300_OP_BGEZAL: case R4300_OP_BGEZALL: case R4300_OP_BGEZL:
+    case R4300_OP_BGTZ: case R4300_OP_BGTZL: case R4300_OP_BLEZ: case R4300_OP_BLEZL:
+    case R4300_OP_BLTZ: case R4300_OP_BLTZAL: case R4300_OP_BLTZALL: case R4300_OP_BLTZL:
+    case R4300_OP_J: case R4300_OP_JAL: case R4300_OP_JALR: case R4300_OP_JR:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 /* return 0:normal, 1:idle, 2:out */
 static int infer_jump_sub_type(uint32_t target, uint32_t pc, uint32_t next_iw, const struct precomp_block* block)
 {
@@ -830,7 +909,8 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
 {
     int i, length, length2, finished;
     struct precomp_instr* inst;
-    enum r4300_opcode opcode;
+    enum r4300_opcode opcode, prev_opcode = R4300_OP_NOP;
+    const int first = (func & 0xFFF) / 4;
 
     /* ??? not sure why we need these 2 different tests */
     int block_start_in_tlb = ((block->start & UINT32_C(0xc0000000)) != UINT32_C(0x80000000));
@@ -843,7 +923,7 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
     block->xxhash = 0;
 
 
-    for (i = (func & 0xFFF) / 4, finished = 0; finished != 2; ++i)
+    for (i = first, finished = 0; finished != 2; ++i)
     {
         inst = block->block + i;
 
@@ -861,6 +941,20 @@ void cached_interp_recompile_block(struct r4300_core* r4300, const uint32_t* iw,
         /* decode instruction */
         opcode = r4300_decode(inst, r4300, r4300_get_idec(iw[i]), iw[i], iw[i+1], block);
 
+#if !defined(DBG) && !defined(COMPARE_CORE)
+        /* fuse with the previous instruction of this page, unless that one
+         * is a delay slot: branches run their delay slot on its own */
+        if (i > first && i >= 2 && i < length
+         && !has_delay_slot(r4300_get_idec(iw[i-2])->opcode))
+        {
+            void (*fused)(void) = get_fused_ops(prev_opcode, opcode);
+            if (fused != NULL) {
+                block->block[i-1].ops = fused;
+            }
+        }
+        prev_opcode = opcode;
+#endif
+
         /* decode ending conditions */
         if (i >= length2) { finished = 2; }
         if (i >= (length-1)
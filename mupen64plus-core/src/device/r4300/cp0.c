@@ -74,6 +74,7 @@ void poweron_cp0(struct cp0* cp0)
     *cp0_next_interrupt = 0;
     *cp0_cycle_count = 0;
     cp0->last_addr = UINT32_C(0xbfc00000);
+    cp0->idle_count = 0;
 
     init_interrupt(cp0);
 
@@ -212,6 +212,9 @@ struct cp0
     unsigned int count_per_op_denom_pot;
 
     struct tlb tlb;
+
+    /* COUNT cycles skipped in idle loops, wraps like COUNT */
+    uint32_t idle_count;
 };
 
 #ifndef NEW_DYNAREC
@@ -5,7 +5,7 @@
 #define offsetof_struct_cp0_tlb (0x000001a0)
 #define offsetof_struct_tlb_entries (0x00000000)
 #define offsetof_struct_tlb_LUT_r (0x00000680)
-#define offsetof_struct_tlb_LUT_w (0x00400680)
+#define offsetof_struct_tlb_LUT_w (0x00001680)
 #define offsetof_struct_r4300_core_cached_interp (0x00000098)
 #define offsetof_struct_cached_interp_invalid_code (0x00000000)
 #define offsetof_struct_r4300_core_new_dynarec_hot_state (0x02501000)
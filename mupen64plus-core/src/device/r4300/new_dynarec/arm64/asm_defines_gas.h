@@ -2,10 +2,10 @@
 #define offsetof_struct_r4300_core_cp0 (0x031017e8)
 #define offsetof_struct_cp0_last_addr (0x000002a8)
 #define offsetof_struct_cp0_count_per_op (0x000002ac)
-#define offsetof_struct_cp0_tlb (0x000002b4)
+#define offsetof_struct_cp0_tlb (0x000002b8)
 #define offsetof_struct_tlb_entries (0x00000000)
 #define offsetof_struct_tlb_LUT_r (0x00000680)
-#define offsetof_struct_tlb_LUT_w (0x00400680)
+#define offsetof_struct_tlb_LUT_w (0x00002680)
 #define offsetof_struct_r4300_core_cached_interp (0x000000e0)
 #define offsetof_struct_cached_interp_invalid_code (0x00000000)
 #define offsetof_struct_r4300_core_new_dynarec_hot_state (0x02901000)
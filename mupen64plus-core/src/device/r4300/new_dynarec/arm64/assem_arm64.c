@@ -4579,6 +4579,35 @@ static void invalidate_addr(u_int addr)
   invalidate_block(addr>>12);
 }
 
+#ifdef HAVE_FASTMEM
+#define FASTMEM_PATCH_SIZE 4
+
+// Every site ends with the access, so there's always room for the branch
+static void emit_fastmem_pad(intptr_t start)
+{
+  assert((intptr_t)out>=start+FASTMEM_PATCH_SIZE);
+}
+
+static void fastmem_patch(u_char *site,u_char *stub)
+{
+  intptr_t offset=(intptr_t)stub-(intptr_t)site;
+  assert(offset>=-134217728LL&&offset<134217728LL);
+  *(u_int *)site=0x14000000|((offset>>2)&0x3ffffff);
+  intptr_t site_rx=((intptr_t)site-(intptr_t)base_addr)+(intptr_t)base_addr_rx;
+  cache_flush((void*)site_rx, (void*)(site_rx+4));
+}
+
+static uintptr_t *fastmem_context_pc(ucontext_t *uc)
+{
+  return (uintptr_t *)&uc->uc_mcontext.pc;
+}
+
+static uintptr_t *fastmem_context_reg(ucontext_t *uc,int r)
+{
+  return (uintptr_t *)&uc->uc_mcontext.regs[r];
+}
+#endif
+
 // CPU-architecture-specific initialization
 static void arch_init(void) {
 
@@ -4589,6 +4618,11 @@ static void arch_init(void) {
   g_dev.r4300.new_dynarec_hot_state.rounding_modes[3]=0x2<<22; // floor
 
   #ifdef RAM_OFFSET
+  #ifdef HAVE_FASTMEM
+  if(fastmem_window)
+    g_dev.r4300.new_dynarec_hot_state.ram_offset=(intptr_t)fastmem_window>>2;
+  else
+  #endif
   g_dev.r4300.new_dynarec_hot_state.ram_offset=((intptr_t)g_dev.rdram.dram-(intptr_t)0x80000000)>>2;
   #endif
 
@@ -15,6 +15,9 @@
 //#define HAVE_CONDITIONAL_CALL 1
 #define RAM_OFFSET 1
 #define USE_MINI_HT 1
+#if defined(__linux__)
+#define HAVE_FASTMEM 1 // Unchecked RDRAM accesses, patched when they fault
+#endif
 
 /* ARM calling convention:
    x0-x18: caller-save
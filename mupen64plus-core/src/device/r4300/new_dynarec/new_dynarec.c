@@ -18,8 +18,13 @@
  *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // ucontext register names, for the fastmem fault handler
+#endif
+
 #include <stdio.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h> // needed for u_int, u_char, etc
@@ -72,6 +77,16 @@ void recomp_dbg_block(int addr);
 #error Unsupported dynarec architecture
 #endif
 
+#if defined(HAVE_FASTMEM) && defined(RECOMP_DBG)
+#undef HAVE_FASTMEM
+#endif
+#ifdef HAVE_FASTMEM
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 /* debug */
 #define ASSEM_DEBUG 0
 #define INV_DEBUG 0
@@ -298,6 +313,71 @@ static int expirep;
 static u_int dirty_entry_count;
 static u_int copy_size;
 static struct ll_entry* hash_table[65536][2];
+
+/* Block profiling */
+#define PROFILE_BLOCKS 32768
+struct block_profile
+{
+  uint64_t entries; // Incremented by the compiled code
+  u_int vaddr;
+  u_int slen;
+  u_int code_size;
+  u_int recompiles;
+};
+static struct block_profile block_profiles[PROFILE_BLOCKS];
+static u_int block_profile_count;
+static u_int block_profile_dropped;
+static int block_profiling;
+
+/* Idle loops */
+#define IDLE_LOOPS 1024
+#define IDLE_LOOP_POLLS 4
+struct idle_loop_info
+{
+  uint64_t passes; // Incremented by the compiled code while profiling
+  u_int head;
+  u_int branch;
+  u_int polled[IDLE_LOOP_POLLS];
+  u_int polls;
+  u_int compiles;
+};
+static struct idle_loop_info idle_loops[IDLE_LOOPS];
+static u_int idle_loop_count;
+static int idle_loop_skip=1;
+static u_int pending_count_per_op;
+static char idle_loop[MAXBLOCK];
+static struct idle_loop_info *idle_loop_entry[MAXBLOCK];
+
+/* Fastmem */
+static int fastmem_requested;
+#ifdef HAVE_FASTMEM
+#define FASTMEM_SITES_BITS 19 // Hash table entries, a site is filed under each 64 bytes it touches
+#define FASTMEM_SITES (1<<FASTMEM_SITES_BITS)
+#define FASTMEM_MAX_SITES (FASTMEM_SITES/4*3)
+#define FASTMEM_WINDOW_SIZE (((size_t)1<<32)+65536) // With a guard for accesses at the very end
+struct fastmem_site
+{
+  u_int start; // Offset in the translation cache, where the jump to the stub goes
+  u_int line; // (start-base_addr)>>6 this entry is filed under
+  int stub; // Relative to start
+  u_short size; // 0 if the entry is free
+  signed char undo_reg; // Host register to xor with undo_xor before the stub
+  u_char undo_xor;
+};
+static struct fastmem_site *fastmem_sites;
+static u_int fastmem_site_count;
+static struct
+{
+  intptr_t start;
+  intptr_t end;
+  signed char undo_reg;
+  u_char undo_xor;
+} fastmem_pending[MAXBLOCK];
+static int fastmem_pending_count;
+static int fastmem_pending_next;
+static u_char *fastmem_window; // 4 GB, with RDRAM mapped again at +0x80000000
+static struct sigaction fastmem_old_sigsegv;
+#endif
 static struct ll_entry *jump_in[4096];
 static struct ll_entry *jump_dirty[4096];
 static struct ll_entry *jump_out[4096];
@@ -1935,16 +2015,16 @@ static void TLBWI_new(int pcaddr, int count)
      for fast look up. */
   for (i=r4300->cp0.tlb.entries[state->cp0_regs[CP0_INDEX_REG]&0x3F].start_even>>12; i<=r4300->cp0.tlb.entries[state->cp0_regs[CP0_INDEX_REG]&0x3F].end_even>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -1956,16 +2036,16 @@ static void TLBWI_new(int pcaddr, int count)
   }
   for (i=r4300->cp0.tlb.entries[state->cp0_regs[CP0_INDEX_REG]&0x3F].start_odd>>12; i<=r4300->cp0.tlb.entries[state->cp0_regs[CP0_INDEX_REG]&0x3F].end_odd>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -2011,16 +2091,16 @@ static void TLBWR_new(int pcaddr, int count)
      for fast look up. */
   for (i=r4300->cp0.tlb.entries[state->cp0_regs[CP0_RANDOM_REG]&0x3F].start_even>>12; i<=r4300->cp0.tlb.entries[state->cp0_regs[CP0_RANDOM_REG]&0x3F].end_even>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -2032,16 +2112,16 @@ static void TLBWR_new(int pcaddr, int count)
   }
   for (i=r4300->cp0.tlb.entries[state->cp0_regs[CP0_RANDOM_REG]&0x3F].start_odd>>12; i<=r4300->cp0.tlb.entries[state->cp0_regs[CP0_RANDOM_REG]&0x3F].end_odd>>12; i++)
   {
-    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,r4300->cp0.tlb.LUT_r[i],r4300->cp0.tlb.LUT_w[i]);
+    //DebugMessage(M64MSG_VERBOSE, "%x: r:%8x w:%8x",i,tlb_lut_get(&r4300->cp0.tlb.LUT_r, i),tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
     if(i<0x80000||i>0xBFFFF)
     {
-      if(r4300->cp0.tlb.LUT_r[i]) {
-        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((r4300->cp0.tlb.LUT_r[i]&0xFFFFF000)-0x80000000)-(i<<12))>>2;
+      if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)) {
+        state->memory_map[i]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)&0xFFFFF000)-0x80000000)-(i<<12))>>2;
         // FIXME: should make sure the physical page is invalid too
-        if(!r4300->cp0.tlb.LUT_w[i]||!r4300->cached_interp.invalid_code[i]) {
+        if(!tlb_lut_get(&r4300->cp0.tlb.LUT_w, i)||!r4300->cached_interp.invalid_code[i]) {
           state->memory_map[i]|=WRITE_PROTECT; // Write protect
         }else{
-          assert(r4300->cp0.tlb.LUT_r[i]==r4300->cp0.tlb.LUT_w[i]);
+          assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, i)==tlb_lut_get(&r4300->cp0.tlb.LUT_w, i));
         }
         if(!using_tlb) DebugMessage(M64MSG_VERBOSE, "Enabled TLB");
         // Tell the dynamic recompiler to generate tlb lookup code
@@ -2296,6 +2376,196 @@ static void SDR_new(int pcaddr, int count)
 #error Unsupported dynarec architecture
 #endif
 
+#ifdef HAVE_FASTMEM
+/* Loads and stores are emitted without the range check, against a 4 GB
+ * window where RDRAM is mapped at the KSEG0 addresses and everything else
+ * faults. A faulting access is patched to jump to its slow path stub, and
+ * resumes there. */
+
+static u_int fastmem_hash(u_int line)
+{
+  return (line*0x9E3779B1u)>>(32-FASTMEM_SITES_BITS);
+}
+
+static struct fastmem_site *fastmem_lookup(u_int offset)
+{
+  u_int n=fastmem_hash(offset>>6);
+  while(fastmem_sites[n].size) {
+    struct fastmem_site *site=&fastmem_sites[n];
+    if(offset-site->start<site->size) return site;
+    n=(n+1)&(FASTMEM_SITES-1);
+  }
+  return NULL;
+}
+
+static void fastmem_insert(const struct fastmem_site *site)
+{
+  u_int n=fastmem_hash(site->line);
+  while(fastmem_sites[n].size) n=(n+1)&(FASTMEM_SITES-1);
+  fastmem_sites[n]=*site;
+  fastmem_site_count++;
+}
+
+// Whether one more site fits, every site takes up to 3 entries
+static int fastmem_available(void)
+{
+  return fastmem_window&&fastmem_site_count+3*(fastmem_pending_count+1)<=FASTMEM_MAX_SITES;
+}
+
+// The site's stub comes later, it's filed by fastmem_add_site then
+static void fastmem_add_pending(intptr_t start,intptr_t end,int undo_reg,int undo_xor)
+{
+  assert(fastmem_pending_count<MAXBLOCK);
+  fastmem_pending[fastmem_pending_count].start=start;
+  fastmem_pending[fastmem_pending_count].end=end;
+  fastmem_pending[fastmem_pending_count].undo_reg=undo_reg;
+  fastmem_pending[fastmem_pending_count].undo_xor=undo_xor;
+  fastmem_pending_count++;
+}
+
+// Stubs are emitted in the order of the sites
+static void fastmem_add_site(intptr_t stub)
+{
+  struct fastmem_site site;
+  assert(fastmem_pending_next<fastmem_pending_count);
+  intptr_t start=fastmem_pending[fastmem_pending_next].start;
+  u_int end=fastmem_pending[fastmem_pending_next].end-(intptr_t)base_addr;
+  site.start=start-(intptr_t)base_addr;
+  site.stub=stub-start;
+  site.size=end-site.start;
+  site.undo_reg=fastmem_pending[fastmem_pending_next].undo_reg;
+  site.undo_xor=fastmem_pending[fastmem_pending_next].undo_xor;
+  assert(((end-1)>>6)-(site.start>>6)<3);
+  for(site.line=site.start>>6;site.line<=(end-1)>>6;site.line++)
+    fastmem_insert(&site);
+  fastmem_pending_next++;
+}
+
+// Drops the sites of an expired part of the cache. Everything else is
+// reinserted, in probe order from a free slot so that no chain is broken.
+static void fastmem_expire(intptr_t base,int shift)
+{
+  u_int first=base-(intptr_t)base_addr;
+  u_int empty=0,n;
+  if(!fastmem_site_count) return;
+  while(fastmem_sites[empty].size) empty++;
+  for(n=1;n<=FASTMEM_SITES;n++) {
+    struct fastmem_site *slot=&fastmem_sites[(empty+n)&(FASTMEM_SITES-1)];
+    struct fastmem_site site=*slot;
+    if(!site.size) continue;
+    slot->size=0;
+    fastmem_site_count--;
+    if(site.start-first>=(1u<<shift)) fastmem_insert(&site);
+  }
+}
+
+static void fastmem_sigsegv(int sig,siginfo_t *info,void *context)
+{
+  ucontext_t *uc=(ucontext_t *)context;
+  uintptr_t *pc=fastmem_context_pc(uc);
+  uintptr_t offset=*pc-(uintptr_t)base_addr_rx;
+  struct fastmem_site *site=NULL;
+
+  if(offset<((uintptr_t)1<<TARGET_SIZE_2)) site=fastmem_lookup((u_int)offset);
+  if(!site) {
+    // Not a guest access, pass it on
+    if(fastmem_old_sigsegv.sa_flags&SA_SIGINFO)
+      fastmem_old_sigsegv.sa_sigaction(sig,info,context);
+    else if(fastmem_old_sigsegv.sa_handler!=SIG_DFL&&fastmem_old_sigsegv.sa_handler!=SIG_IGN)
+      fastmem_old_sigsegv.sa_handler(sig);
+    else
+      sigaction(SIGSEGV,&fastmem_old_sigsegv,NULL); // Faults again, with the default action
+    return;
+  }
+
+  // Sub-word accesses swizzle the address in place
+  if(site->undo_reg>=0) *fastmem_context_reg(uc,site->undo_reg)^=site->undo_xor;
+  fastmem_patch((u_char *)base_addr+site->start,(u_char *)base_addr+site->start+site->stub);
+  *pc=(uintptr_t)base_addr_rx+site->start+site->stub;
+}
+
+static void fastmem_init(void)
+{
+  u_char *dram=(u_char *)g_dev.rdram.dram;
+  long page=sysconf(_SC_PAGESIZE);
+  u_char *window;
+  struct sigaction sa;
+  int fd;
+
+  fastmem_window=NULL;
+  if(!fastmem_requested) return;
+  if(page<=0||((uintptr_t)dram&(page-1))) {
+    DebugMessage(M64MSG_WARNING, "Fastmem disabled, RDRAM isn't page aligned");
+    return;
+  }
+
+  fastmem_sites=(struct fastmem_site *)calloc(FASTMEM_SITES,sizeof(struct fastmem_site));
+  fastmem_site_count=0;
+  if(!fastmem_sites) {
+    DebugMessage(M64MSG_WARNING, "Fastmem disabled, out of memory");
+    return;
+  }
+
+  // RDRAM is moved to a memfd, so that it can be mapped again into the window
+  fd=syscall(SYS_memfd_create,"rdram",1 /* MFD_CLOEXEC */);
+  window=(u_char *)mmap(NULL,FASTMEM_WINDOW_SIZE,PROT_NONE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE,-1,0);
+  if(fd<0||ftruncate(fd,RDRAM_MAX_SIZE)<0||window==MAP_FAILED||
+     mmap(window+0x80000000,RDRAM_MAX_SIZE,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_FIXED,fd,0)==MAP_FAILED) {
+    DebugMessage(M64MSG_WARNING, "Fastmem disabled, couldn't map the address space window");
+    if(window!=MAP_FAILED) munmap(window,FASTMEM_WINDOW_SIZE);
+    if(fd>=0) close(fd);
+    free(fastmem_sites);
+    fastmem_sites=NULL;
+    return;
+  }
+  memcpy(window+0x80000000,dram,RDRAM_MAX_SIZE);
+  if(mmap(dram,RDRAM_MAX_SIZE,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_FIXED,fd,0)==MAP_FAILED) {
+    DebugMessage(M64MSG_ERROR, "Fastmem disabled, couldn't remap RDRAM");
+    munmap(window,FASTMEM_WINDOW_SIZE);
+    close(fd);
+    free(fastmem_sites);
+    fastmem_sites=NULL;
+    return;
+  }
+  close(fd);
+
+  memset(&sa,0,sizeof(sa));
+  sa.sa_sigaction=fastmem_sigsegv;
+  sa.sa_flags=SA_SIGINFO;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGSEGV,&sa,&fastmem_old_sigsegv);
+
+  fastmem_window=window;
+  DebugMessage(M64MSG_INFO, "Fastmem enabled");
+}
+
+static void fastmem_cleanup(void)
+{
+  u_char *dram=(u_char *)g_dev.rdram.dram;
+  if(!fastmem_window) return;
+
+  sigaction(SIGSEGV,&fastmem_old_sigsegv,NULL);
+
+  // RDRAM outlives the dynarec, give it back anonymous memory
+  if(mmap(dram,RDRAM_MAX_SIZE,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED,-1,0)==MAP_FAILED)
+    DebugMessage(M64MSG_ERROR, "Couldn't restore RDRAM mapping");
+  else
+    memcpy(dram,fastmem_window+0x80000000,RDRAM_MAX_SIZE);
+  munmap(fastmem_window,FASTMEM_WINDOW_SIZE);
+  fastmem_window=NULL;
+  free(fastmem_sites);
+  fastmem_sites=NULL;
+}
+#endif
+
+void new_dynarec_set_fastmem(int enabled)
+{
+  fastmem_requested=enabled;
+#ifndef HAVE_FASTMEM
+  if(enabled) DebugMessage(M64MSG_WARNING, "Fastmem isn't supported on this architecture");
+#endif
+}
+
 static void tlb_speed_hacks()
 {
   // Goldeneye hack
@@ -2319,6 +2589,8 @@ static void tlb_speed_hacks()
         addr=0;
         break;
     }
+    // The TLB maps the rom straight into memory_map, so it all has to be loaded
+    rom_pages_touch(0, (uint32_t)g_rom_size);
     uintptr_t rom_addr=(uintptr_t)g_dev.cart.cart_rom.rom;
     #ifdef ROM_COPY
     // Since memory_map is 32-bit, on 64-bit systems the rom needs to be
@@ -2480,7 +2752,7 @@ static void ll_kill_pointers(struct ll_entry *head,intptr_t addr,int shift)
 static void add_link(u_int vaddr,void *src)
 {
   u_int page=(vaddr^0x80000000)>>12;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>4095) page=2048+(page&2047);
   inv_debug("add_link: %x -> %x (%d)\n",(intptr_t)src,vaddr,page);
   (void)ll_add(jump_out+page,vaddr,src,src,0,NULL,0);
@@ -2491,7 +2763,7 @@ static void add_link(u_int vaddr,void *src)
 static struct ll_entry *get_clean(struct r4300_core* r4300,u_int vaddr,u_int flags)
 {
   u_int page=(vaddr^0x80000000)>>12;
-  if(page>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) page=(r4300->cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   struct ll_entry *head;
   head=jump_in[page];
@@ -2508,9 +2780,9 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
 {
   u_int page=(vaddr^0x80000000)>>12;
   u_int vpage=page;
-  if(page>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) page=(r4300->cp0.tlb.LUT_r[vaddr>>12]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
-  if(vpage>262143&&r4300->cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+  if(vpage>262143&&tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
   if(vpage>2048) vpage=2048+(vpage&2047);
   struct ll_entry *head;
   head=jump_dirty[vpage];
@@ -2522,9 +2794,9 @@ static struct ll_entry *get_dirty(struct r4300_core* r4300,u_int vaddr,u_int fla
           r4300->cached_interp.invalid_code[vaddr>>12]=0;
           r4300->new_dynarec_hot_state.memory_map[vaddr>>12]|=WRITE_PROTECT;
           if(vpage<2048) {
-            if(r4300->cp0.tlb.LUT_r[vaddr>>12]) {
-              r4300->cached_interp.invalid_code[r4300->cp0.tlb.LUT_r[vaddr>>12]>>12]=0;
-              r4300->new_dynarec_hot_state.memory_map[r4300->cp0.tlb.LUT_r[vaddr>>12]>>12]|=WRITE_PROTECT;
+            if(tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)) {
+              r4300->cached_interp.invalid_code[tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)>>12]=0;
+              r4300->new_dynarec_hot_state.memory_map[tlb_lut_get(&r4300->cp0.tlb.LUT_r, vaddr>>12)>>12]|=WRITE_PROTECT;
             }
             restore_candidate[vpage>>3]|=1<<(vpage&7);
           }
@@ -2590,7 +2862,7 @@ void *dynamic_linker(void * src, u_int vaddr)
   int r=new_recompile_block(vaddr);
   if(r==0) return dynamic_linker(src,vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2648,7 +2920,7 @@ void *dynamic_linker_ds(void * src, u_int vaddr)
   int r=new_recompile_block((vaddr&0xFFFFFFF8)+1);
   if(r==0) return dynamic_linker_ds(src,vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2686,7 +2958,7 @@ void *get_addr(u_int vaddr)
   int r=new_recompile_block(vaddr);
   if(r==0) return get_addr(vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2737,7 +3009,7 @@ void *get_addr_32(u_int vaddr,u_int flags)
   int r=new_recompile_block(vaddr);
   if(r==0) return get_addr(vaddr);
   // Execute in unmapped page, generate pagefault execption
-  assert(r4300->cp0.tlb.LUT_r[(vaddr&~1) >> 12] == 0);
+  assert(tlb_lut_get(&r4300->cp0.tlb.LUT_r, (vaddr&~1) >> 12) == 0);
   assert((intptr_t)r4300->new_dynarec_hot_state.memory_map[(vaddr&~1) >> 12] < 0);
   r4300->delay_slot = vaddr&1;
   TLB_refill_exception(r4300, vaddr&~1, 2);
@@ -2822,7 +3094,7 @@ void invalidate_block(u_int block)
 {
   u_int page;
   page=block^0x80000;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[block]) page=(g_dev.r4300.cp0.tlb.LUT_r[block]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
   inv_debug("INVALIDATE: %x (%d)\n",block<<12,page);
   u_int first,last;
@@ -2880,10 +3152,10 @@ void invalidate_block(u_int block)
   // Don't trap writes
   g_dev.r4300.cached_interp.invalid_code[block]=1;
   // If there is a valid TLB entry for this page, remove write protect
-  if(g_dev.r4300.cp0.tlb.LUT_w[block]) {
-    assert(g_dev.r4300.cp0.tlb.LUT_r[block]==g_dev.r4300.cp0.tlb.LUT_w[block]);
-    g_dev.r4300.new_dynarec_hot_state.memory_map[block]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((g_dev.r4300.cp0.tlb.LUT_w[block]&0xFFFFF000)-0x80000000)-(block<<12))>>2;
-    u_int real_block=g_dev.r4300.cp0.tlb.LUT_w[block]>>12;
+  if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)) {
+    assert(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, block)==tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block));
+    g_dev.r4300.new_dynarec_hot_state.memory_map[block]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)&0xFFFFF000)-0x80000000)-(block<<12))>>2;
+    u_int real_block=tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, block)>>12;
     g_dev.r4300.cached_interp.invalid_code[real_block]=1;
     if(real_block>=0x80000&&real_block<0x80800) g_dev.r4300.new_dynarec_hot_state.memory_map[real_block]=((uintptr_t)g_dev.rdram.dram-(uintptr_t)0x80000000)>>2;
   }
@@ -2915,9 +3187,9 @@ static void invalidate_all_pages(void)
   #endif
   // TLB
   for(page=0;page<0x100000;page++) {
-    if(g_dev.r4300.cp0.tlb.LUT_r[page]) {
-      g_dev.r4300.new_dynarec_hot_state.memory_map[page]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((g_dev.r4300.cp0.tlb.LUT_r[page]&0xFFFFF000)-0x80000000)-(page<<12))>>2;
-      if(!g_dev.r4300.cp0.tlb.LUT_w[page]||!g_dev.r4300.cached_interp.invalid_code[page])
+    if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page)) {
+      g_dev.r4300.new_dynarec_hot_state.memory_map[page]=((uintptr_t)g_dev.rdram.dram+(uintptr_t)((tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page)&0xFFFFF000)-0x80000000)-(page<<12))>>2;
+      if(!tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_w, page)||!g_dev.r4300.cached_interp.invalid_code[page])
         g_dev.r4300.new_dynarec_hot_state.memory_map[page]|=WRITE_PROTECT; // Write protect
     }
     else g_dev.r4300.new_dynarec_hot_state.memory_map[page]=(uintptr_t)-1;
@@ -2926,6 +3198,22 @@ static void invalidate_all_pages(void)
   tlb_speed_hacks();
 }
 
+// Unlike invalidate_all_pages, unmodified blocks aren't reused
+static void flush_all_blocks(void)
+{
+  int n;
+  invalidate_all_pages();
+  for(n=0;n<4096;n++) ll_clear(jump_dirty+n);
+  for(n=0;n<65536;n++)
+    hash_table[n][0]=hash_table[n][1]=NULL;
+  memset(restore_candidate,0,sizeof(restore_candidate));
+}
+
+void new_dynarec_set_count_per_op(unsigned int count_per_op)
+{
+  pending_count_per_op=count_per_op;
+}
+
 void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t address, size_t size)
 {
     size_t i;
@@ -2992,7 +3280,7 @@ void clean_blocks(u_int page)
           if(!inv) {
             if((((uintptr_t)head->clean_addr-(uintptr_t)out)<<(32-TARGET_SIZE_2))>0x60000000+(MAX_OUTPUT_BLOCK_SIZE<<(32-TARGET_SIZE_2))) {
               u_int ppage=page;
-              if(page<2048&&g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]) ppage=(g_dev.r4300.cp0.tlb.LUT_r[head->vaddr>>12]^0x80000000)>>12;
+              if(page<2048&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, head->vaddr>>12)) ppage=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, head->vaddr>>12)^0x80000000)>>12;
               inv_debug("INV: Restored %x (%x/%x)\n",head->vaddr, (intptr_t)head->addr, (intptr_t)head->clean_addr);
               //DebugMessage(M64MSG_VERBOSE, "page=%x, addr=%x",page,head->vaddr);
               //assert(head->vaddr>>12==(page|0x80000));
@@ -3030,6 +3318,11 @@ void dynarec_gen_interrupt(void)
 {
     struct r4300_core* r4300 = &g_dev.r4300;
     struct new_dynarec_hot_state* state = &r4300->new_dynarec_hot_state;
+    if(state->idle_cycle_count<0)
+    {
+        r4300->cp0.idle_count-=state->idle_cycle_count;
+        state->idle_cycle_count=0;
+    }
     cp0_update_count(r4300);
     uint32_t page = ((state->cp0_regs[CP0_COUNT_REG]>>19)&0x1fc);
     unsigned int *candidate = (unsigned int *)&restore_candidate[page];
@@ -3047,6 +3340,15 @@ void dynarec_gen_interrupt(void)
     }
 
     gen_interrupt(r4300);
+
+    if(pending_count_per_op)
+    {
+        // The blocks have count_per_op built in, carry on at pcaddr in new ones
+        r4300->cp0.count_per_op=pending_count_per_op;
+        pending_count_per_op=0;
+        flush_all_blocks();
+        state->pending_exception=1;
+    }
 }
 
 /**** Register allocation ****/
@@ -4459,6 +4761,30 @@ static void emit_extjump_ds(intptr_t addr, int target)
   emit_extjump2(addr, target, (intptr_t)dyna_linker_ds);
 }
 
+// Raises the cycle count to the next event if it's below, CC=max(CC,0).
+// The cycles skipped are counted in dynarec_gen_interrupt.
+static void emit_cc_fastforward(void)
+{
+  emit_writeword(HOST_CCREG,(intptr_t)&g_dev.r4300.new_dynarec_hot_state.idle_cycle_count);
+  emit_test(HOST_CCREG,HOST_CCREG);
+#if NEW_DYNAREC >= NEW_DYNAREC_ARM
+  emit_cmovs_imm(0,HOST_CCREG);
+#else
+  emit_cmovs(&const_zero,HOST_CCREG);
+#endif
+}
+
+// Back edge of a polling loop found by find_idle_loops, nothing the loop
+// reads can change before the next event so the cycles in between are skipped
+static void do_idle_loop_skip(int i)
+{
+  assem_debug("idle loop skip");
+  #ifdef HAVE_EMIT_INCMEM
+  if(block_profiling&&idle_loop_entry[i]) emit_incmem64((intptr_t)&idle_loop_entry[i]->passes);
+  #endif
+  emit_cc_fastforward();
+}
+
 static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int invert)
 {
   int count;
@@ -4483,17 +4809,13 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
   if(taken==TAKEN && i==(ba[i]-start)>>2 && source[i+1]==0) {
     // Idle loop
     idle=(intptr_t)out;
-    emit_test(HOST_CCREG,HOST_CCREG);
-#if NEW_DYNAREC >= NEW_DYNAREC_ARM
-    emit_cmovs_imm(0,HOST_CCREG);
-#else
-    emit_cmovs(&const_zero,HOST_CCREG);
-#endif
+    emit_cc_fastforward();
     emit_addimm(HOST_CCREG,CLOCK_DIVIDER*2,HOST_CCREG);
     jaddr=(intptr_t)out;
     emit_jmp(0);
   }
   else if(*adj==0||invert) {
+    if(taken==TAKEN&&idle_loop[i]) do_idle_loop_skip(i);
     if(g_dev.r4300.cp0.count_per_op_denom_pot) {
       count += (1 << g_dev.r4300.cp0.count_per_op_denom_pot) - 1;
       count >>= g_dev.r4300.cp0.count_per_op_denom_pot;
@@ -4504,6 +4826,7 @@ static void do_cc(int i,signed char i_regmap[],int *adj,int addr,int taken,int i
   }
   else
   {
+    if(taken==TAKEN&&idle_loop[i]) do_idle_loop_skip(i);
     emit_cmpimm(HOST_CCREG,-(int)CLOCK_DIVIDER*(count+2));
     jaddr=(intptr_t)out;
     emit_jns(0);
@@ -4790,6 +5113,11 @@ static void do_readstub(int n)
 {
   assem_debug("do_readstub %x",start+stubs[n][3]*4);
   literal_pool(256);
+#ifdef HAVE_FASTMEM
+  if(!stubs[n][1])
+    fastmem_add_site((intptr_t)out);
+  else
+#endif
   set_jump_target(stubs[n][1],(intptr_t)out);
   int type=stubs[n][0];
   int i=stubs[n][3];
@@ -5015,6 +5343,11 @@ static void do_writestub(int n)
 {
   assem_debug("do_writestub %x",start+stubs[n][3]*4);
   literal_pool(256);
+#ifdef HAVE_FASTMEM
+  if(!stubs[n][1])
+    fastmem_add_site((intptr_t)out);
+  else
+#endif
   set_jump_target(stubs[n][1],(intptr_t)out);
   int type=stubs[n][0];
   int i=stubs[n][3];
@@ -6116,6 +6449,9 @@ static void load_assemble(int i,struct regstat *i_regs)
   signed char s,th,tl,addr,map=-1,cache=-1;
   int offset,type=0,memtarget=0,c=0;
   intptr_t jaddr=0;
+  #ifdef HAVE_FASTMEM
+  intptr_t fastmem_start=0;
+  #endif
   u_int hr,reglist=0;
   int agr=AGEN1+(i&1);
   th=get_reg(i_regs->regmap,rt1[i]|64);
@@ -6154,6 +6490,12 @@ static void load_assemble(int i,struct regstat *i_regs)
 #ifndef INTERPRET_LOAD
   if(!using_tlb) {
     if(!c) {
+      #ifdef HAVE_FASTMEM
+      // No range check, the access faults outside of RDRAM
+      if(!dummy&&opcode[i]!=0x37&&fastmem_available())
+        fastmem_start=(intptr_t)out;
+      else
+      #endif
 //#define R29_HACK 1
       #ifdef R29_HACK
       // Strmnnrmn's speed hack
@@ -6274,6 +6616,16 @@ static void load_assemble(int i,struct regstat *i_regs)
       emit_readdword_indexed_tlb(0,addr,map,th,tl);
     }
   }
+  #ifdef HAVE_FASTMEM
+  if(fastmem_start) {
+    int x=0;
+    if (opcode[i]==0x20||opcode[i]==0x24) x=3; // LB/LBU
+    if (opcode[i]==0x21||opcode[i]==0x25) x=2; // LH/LHU
+    emit_fastmem_pad(fastmem_start);
+    fastmem_add_pending(fastmem_start,(intptr_t)out,(x&&addr==temp)?temp:-1,x);
+    add_stub(type,0,(intptr_t)out,i,addr,(intptr_t)i_regs,ccadj[i],reglist);
+  } else
+  #endif
   if(jaddr) {
     add_stub(type,jaddr,(intptr_t)out,i,addr,(intptr_t)i_regs,ccadj[i],reglist);
   } else if(c&&!memtarget) {
@@ -6297,6 +6649,9 @@ static void store_assemble(int i,struct regstat *i_regs)
   signed char s,th,tl,real_addr,addr,temp,map=-1,cache=-1;
   int offset,type=0,memtarget=0,c=0;
   intptr_t jaddr=0;
+  #ifdef HAVE_FASTMEM
+  intptr_t fastmem_start=0;
+  #endif
   u_int hr,reglist=0;
   int agr=AGEN1+(i&1);
   th=get_reg(i_regs->regmap,rs2[i]|64);
@@ -6330,24 +6685,32 @@ static void store_assemble(int i,struct regstat *i_regs)
 #ifndef INTERPRET_STORE
   if(!using_tlb) {
     if(!c) {
-      #ifdef R29_HACK
-      // Strmnnrmn's speed hack
-      memtarget=1;
-      if(rs1[i]!=29||start<0x80001000||start>=0x80800000)
-      #endif
-      emit_cmpimm(addr,0x800000);
-      #ifdef R29_HACK
-      if(rs1[i]!=29||start<0x80001000||start>=0x80800000)
+      #ifdef HAVE_FASTMEM
+      // No range check, the access faults outside of RDRAM
+      if(opcode[i]!=0x3F&&fastmem_available())
+        fastmem_start=(intptr_t)out;
+      else
       #endif
       {
-        jaddr=(intptr_t)out;
-        #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
-        // Hint to branch predictor that the branch is unlikely to be taken
-        if(rs1[i]>=28)
-          emit_jno_unlikely(0);
-        else
+        #ifdef R29_HACK
+        // Strmnnrmn's speed hack
+        memtarget=1;
+        if(rs1[i]!=29||start<0x80001000||start>=0x80800000)
         #endif
-        emit_jno(0);
+        emit_cmpimm(addr,0x800000);
+        #ifdef R29_HACK
+        if(rs1[i]!=29||start<0x80001000||start>=0x80800000)
+        #endif
+        {
+          jaddr=(intptr_t)out;
+          #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
+          // Hint to branch predictor that the branch is unlikely to be taken
+          if(rs1[i]>=28)
+            emit_jno_unlikely(0);
+          else
+          #endif
+          emit_jno(0);
+        }
       }
       #ifdef DESTRUCTIVE_SHIFT
       if(s==addr) emit_mov(s,temp);
@@ -6419,6 +6782,16 @@ static void store_assemble(int i,struct regstat *i_regs)
       #endif
     }
   }
+  #ifdef HAVE_FASTMEM
+  if(fastmem_start) {
+    int x=0;
+    if (opcode[i]==0x28) x=3; // SB
+    if (opcode[i]==0x29) x=2; // SH
+    emit_fastmem_pad(fastmem_start);
+    fastmem_add_pending(fastmem_start,(intptr_t)out,(x&&real_addr==temp)?temp:-1,x);
+    add_stub(type,0,(intptr_t)out,i,real_addr,(intptr_t)i_regs,ccadj[i],reglist);
+  } else
+  #endif
   if(jaddr) {
     add_stub(type,jaddr,(intptr_t)out,i,real_addr,(intptr_t)i_regs,ccadj[i],reglist);
   } else if(c&&!memtarget) {
@@ -7284,7 +7657,7 @@ static void cjump_assemble(int i,struct regstat *i_regs)
   int invert=0;
   int branch_internal=internal_branch(branch_regs[i].is32,ba[i]);
   if(i==(ba[i]-start)>>2) assem_debug("idle loop");
-  if(!match) invert=1;
+  if(!match||idle_loop[i]) invert=1; // Idle loops skip cycles on the taken path
   #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
   if(i>(ba[i]-start)>>2) invert=1;
   #endif
@@ -7469,6 +7842,7 @@ static void cjump_assemble(int i,struct regstat *i_regs)
       }
       if(invert) {
         if(taken) set_jump_target(taken,(intptr_t)out);
+        if(idle_loop[i]) do_idle_loop_skip(i);
         #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
         if(match&&(!branch_internal||!is_ds[(ba[i]-start)>>2])) {
           if(adj) {
@@ -7673,7 +8047,7 @@ static void sjump_assemble(int i,struct regstat *i_regs)
   int invert=0;
   int branch_internal=internal_branch(branch_regs[i].is32,ba[i]);
   if(i==(ba[i]-start)>>2) assem_debug("idle loop");
-  if(!match) invert=1;
+  if(!match||idle_loop[i]) invert=1; // Idle loops skip cycles on the taken path
   #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
   if(i>(ba[i]-start)>>2) invert=1;
   #endif
@@ -7824,6 +8198,7 @@ static void sjump_assemble(int i,struct regstat *i_regs)
       } // if(!only32)
 
       if(invert) {
+        if(idle_loop[i]) do_idle_loop_skip(i);
         #ifdef CORTEX_A8_BRANCH_PREDICTION_HACK
         if(match&&(!branch_internal||!is_ds[(ba[i]-start)>>2])) {
           if(adj) {
@@ -8528,9 +8903,9 @@ static void pagespan_ds(void)
   u_int vaddr=start+1;
   u_int page=(0x80000000^vaddr)>>12;
   u_int vpage=page;
-  if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[page^0x80000]^0x80000000)>>12;
+  if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page^0x80000)^0x80000000)>>12;
   if(page>2048) page=2048+(page&2047);
-  if(vpage>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+  if(vpage>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
   if(vpage>2048) vpage=2048+(vpage&2047);
   struct ll_entry *head=ll_add(jump_dirty+vpage,vaddr,(void *)out,NULL,start,copy,slen*4);
   dirty_entry_count++;
@@ -8634,6 +9009,253 @@ static void pagespan_ds(void)
 #ifdef HAVE_LIBNX
 ALIGN(4096, char jit_memory[33554432]) __attribute__((section(".text")));
 #endif
+/**** Block profiling ****/
+
+// The table is static so that x64 code can reach the counters rip-relative,
+// and records never move since compiled code points at them.
+static struct block_profile *block_profile_get(u_int vaddr)
+{
+  u_int n=((vaddr>>2)*2654435761u)&(PROFILE_BLOCKS-1);
+  while(block_profiles[n].recompiles) {
+    if(block_profiles[n].vaddr==vaddr) return &block_profiles[n];
+    n=(n+1)&(PROFILE_BLOCKS-1);
+  }
+  // Keep probe sequences short
+  if(block_profile_count>=PROFILE_BLOCKS*3/4) {
+    block_profile_dropped++;
+    return NULL;
+  }
+  block_profile_count++;
+  block_profiles[n].vaddr=vaddr;
+  return &block_profiles[n];
+}
+
+void new_dynarec_set_block_profiling(int enabled)
+{
+  block_profiling=enabled;
+#ifndef HAVE_EMIT_INCMEM
+  // Only recompiles and code size are recorded
+  if(enabled) DebugMessage(M64MSG_WARNING, "Block entry counters aren't supported on this architecture");
+#endif
+}
+
+static int block_profile_cmp(const void *a,const void *b)
+{
+  const struct block_profile *pa=*(const struct block_profile **)a;
+  const struct block_profile *pb=*(const struct block_profile **)b;
+  uint64_t ca=pa->entries*pa->slen;
+  uint64_t cb=pb->entries*pb->slen;
+  if(ca!=cb) return ca<cb?1:-1;
+  if(pa->recompiles!=pb->recompiles) return pa->recompiles<pb->recompiles?1:-1;
+  return pa->vaddr<pb->vaddr?-1:1;
+}
+
+int new_dynarec_write_block_report(const char *path,u_int max_blocks)
+{
+  struct block_profile **sorted;
+  uint64_t total_entries=0,total_instrs=0;
+  u_int total_recompiles=0,recompiled_blocks=0,total_code=0;
+  u_int count=0,n;
+  FILE *f;
+
+  sorted=(struct block_profile **)malloc(sizeof(*sorted)*(block_profile_count+1));
+  if(!sorted) return 0;
+  for(n=0;n<PROFILE_BLOCKS;n++) {
+    struct block_profile *bp=&block_profiles[n];
+    if(!bp->recompiles) continue;
+    sorted[count++]=bp;
+    total_entries+=bp->entries;
+    total_instrs+=bp->entries*bp->slen;
+    total_recompiles+=bp->recompiles;
+    total_code+=bp->code_size;
+    if(bp->recompiles>1) recompiled_blocks++;
+  }
+  qsort(sorted,count,sizeof(*sorted),block_profile_cmp);
+
+  f=fopen(path,"w");
+  if(!f) {
+    free(sorted);
+    return 0;
+  }
+  fprintf(f,"blocks: %u, compiled %u times, %u compiled more than once, %u not profiled\n",
+    count,total_recompiles,recompiled_blocks,block_profile_dropped);
+  fprintf(f,"block entries: %" PRIu64 ", guest instructions (upper bound): %" PRIu64 ", cycles (upper bound): %" PRIu64 "\n",
+    total_entries,total_instrs,total_instrs*CLOCK_DIVIDER);
+  fprintf(f,"host code of the last compiles: %u bytes\n\n",total_code);
+  fprintf(f,"%-10s %14s %8s %16s %6s %10s %10s\n","vaddr","entries","instrs","cycles","%","host size","recompiles");
+  for(n=0;n<count&&(!max_blocks||n<max_blocks);n++) {
+    struct block_profile *bp=sorted[n];
+    uint64_t instrs=bp->entries*bp->slen;
+    fprintf(f,"%08x   %14" PRIu64 " %8u %16" PRIu64 " %6.2f %10u %10u\n",
+      bp->vaddr,bp->entries,bp->slen,instrs*CLOCK_DIVIDER,
+      total_instrs?100.0*(double)instrs/(double)total_instrs:0.0,bp->code_size,bp->recompiles);
+  }
+  fclose(f);
+  free(sorted);
+  return 1;
+}
+
+/**** Idle loops ****/
+
+static struct idle_loop_info *idle_loop_get(u_int branch)
+{
+  u_int n=((branch>>2)*2654435761u)&(IDLE_LOOPS-1);
+  while(idle_loops[n].compiles) {
+    if(idle_loops[n].branch==branch) return &idle_loops[n];
+    n=(n+1)&(IDLE_LOOPS-1);
+  }
+  if(idle_loop_count>=IDLE_LOOPS*3/4) return NULL;
+  idle_loop_count++;
+  idle_loops[n].branch=branch;
+  return &idle_loops[n];
+}
+
+void new_dynarec_set_idle_loop_skip(int enabled)
+{
+  idle_loop_skip=enabled;
+}
+
+// Loads which read the same value until an event is serviced. VI_CURRENT,
+// AI_LEN and the DPC counters are left out as they move along with count.
+static int idle_loop_address(u_int addr)
+{
+  u_int phys=addr&0x1FFFFFFF;
+  if((addr&0xC0000000)!=0x80000000) return 0; // Mapped through the TLB
+  if(phys<0x800000) return 1; // RDRAM
+  if(phys>=0x4000000&&phys<0x4002000) return 1; // SP DMEM/IMEM
+  phys&=~3;
+  return phys==0x4040010  // SP_STATUS
+       ||phys==0x4040018  // SP_DMA_BUSY
+       ||phys==0x4300008  // MI_INTR
+       ||phys==0x4600010  // PI_STATUS
+       ||phys==0x4800018; // SI_STATUS
+}
+
+// Tracks lui/addiu/ori register constants, enough for load addresses
+static void idle_loop_const(int k,uint64_t *known,u_int value[])
+{
+  u_int op=opcode[k];
+  if(itype[k]==IMM16&&rt1[k]) {
+    if(op==0x0f) { // LUI
+      value[rt1[k]]=(u_int)imm[k]<<16;
+      *known|=1LL<<rt1[k];
+      return;
+    }
+    if((op==0x09||op==0x0d)&&(rs1[k]==0||((*known>>rs1[k])&1))) { // ADDIU/ORI
+      u_int base=rs1[k]?value[rs1[k]]:0;
+      value[rt1[k]]=op==0x09?base+(u_int)imm[k]:base|(u_int)imm[k];
+      *known|=1LL<<rt1[k];
+      return;
+    }
+  }
+  if(rt1[k]) *known&=~(1LL<<rt1[k]);
+  if(rt2[k]) *known&=~(1LL<<rt2[k]);
+}
+
+// Finds backward branches to loops which do nothing but poll memory that
+// can't change before the next event: loads from constant addresses,
+// register arithmetic, no stores or calls. Every register such a loop reads
+// is either left alone by it or recomputed before being read, so once it
+// branches back it would keep doing so until an interrupt is taken.
+static void find_idle_loops(void)
+{
+  int i,k,t;
+  memset(idle_loop,0,slen);
+  memset(idle_loop_entry,0,slen*sizeof(idle_loop_entry[0]));
+  if(!idle_loop_skip) return;
+  for(i=0;i<slen-1;i++)
+  {
+    uint64_t written=0,defined=0,known=0;
+    u_int value[32];
+    u_int polled[IDLE_LOOP_POLLS];
+    u_int polls=0;
+    int pure=1;
+    if(itype[i]!=CJUMP&&itype[i]!=SJUMP) continue;
+    if(rt1[i]==31||is_ds[i]) continue; // BLTZAL/BGEZAL
+    if(itype[i]==CJUMP&&rs1[i]==0&&rs2[i]==0&&(opcode[i]&1)) continue; // Never taken
+    if(ba[i]<start||ba[i]>start+i*4) continue;
+    t=(ba[i]-start)>>2;
+    if(t==i&&source[i+1]==0) continue; // Handled in do_cc
+    for(k=t;k<=i+1&&pure;k++) {
+      if(k==i) continue;
+      if(k>t&&bt[k]) pure=0; // Entered half way
+      else if(itype[k]==LOAD||itype[k]==ALU||itype[k]==IMM16||itype[k]==SHIFTIMM||itype[k]==SHIFT) {
+        if(rt1[k]) written|=1LL<<rt1[k];
+        if(rt2[k]) written|=1LL<<rt2[k];
+      }
+      else if(itype[k]!=NOP) pure=0;
+    }
+    if(!pure) continue;
+
+    // Nothing read may carry over from the previous pass
+    for(k=t;k<=i+1&&pure;k++) {
+      int r1=rs1[k],r2=rs2[k];
+      if(r1&&((written&~defined)>>r1)&1) pure=0;
+      if(r2&&((written&~defined)>>r2)&1) pure=0;
+      if(k==i) continue;
+      if(rt1[k]) defined|=1LL<<rt1[k];
+      if(rt2[k]) defined|=1LL<<rt2[k];
+    }
+    if(!pure) continue;
+
+    // Constants on entry, only if the loop head is reached by falling through
+    for(k=0;k<slen;k++) {
+      if(k!=i&&(itype[k]==CJUMP||itype[k]==SJUMP||itype[k]==UJUMP||itype[k]==FJUMP)&&ba[k]==start+t*4) break;
+    }
+    if(k==slen) {
+      for(k=0;k<t;k++) {
+        if(bt[k]) known=0;
+        if(k>=2&&(itype[k-2]==UJUMP||itype[k-2]==RJUMP||(source[k-2]>>16)==0x1000)) known=0;
+        idle_loop_const(k,&known,value);
+      }
+    }
+    known&=~written;
+
+    for(k=t;k<=i+1&&pure;k++) {
+      if(k==i) continue;
+      if(itype[k]==LOAD) {
+        u_int addr;
+        if(rs1[k]&&!((known>>rs1[k])&1)) { pure=0; break; }
+        addr=(rs1[k]?value[rs1[k]]:0)+(u_int)imm[k];
+        if(!idle_loop_address(addr)) { pure=0; break; }
+        if(polls<IDLE_LOOP_POLLS) polled[polls++]=addr;
+      }
+      idle_loop_const(k,&known,value);
+    }
+    if(!pure) continue;
+
+    idle_loop[i]=1;
+    idle_loop_entry[i]=idle_loop_get(start+i*4);
+    if(idle_loop_entry[i]) {
+      struct idle_loop_info *info=idle_loop_entry[i];
+      info->head=ba[i];
+      info->polls=polls;
+      memcpy(info->polled,polled,polls*sizeof(polled[0]));
+      info->compiles++;
+    }
+    assem_debug("idle loop %x-%x",ba[i],start+i*4);
+  }
+}
+
+int new_dynarec_write_idle_loop_report(const char *path)
+{
+  u_int n,p;
+  FILE *f=fopen(path,"w");
+  if(!f) return 0;
+  fprintf(f,"idle loops: %u, skipping %s\n\n",idle_loop_count,idle_loop_skip?"enabled":"disabled");
+  fprintf(f,"%-10s %-10s %8s %14s %8s  %s\n","head","branch","instrs","passes","compiles","polled");
+  for(n=0;n<IDLE_LOOPS;n++) {
+    struct idle_loop_info *info=&idle_loops[n];
+    if(!info->compiles) continue;
+    fprintf(f,"%08x   %08x   %8u %14" PRIu64 " %8u ",
+      info->head,info->branch,(info->branch-info->head)/4+2,info->passes,info->compiles);
+    for(p=0;p<info->polls;p++) fprintf(f," %08x",info->polled[p]);
+    fprintf(f,"\n");
+  }
+  fclose(f);
+  return 1;
+}
+
 void new_dynarec_init(void)
 {
   DebugMessage(M64MSG_INFO, "Init new dynarec");
@@ -8733,6 +9355,8 @@ void new_dynarec_init(void)
   copy_size=0;
   expirep=16384; // Expiry pointer, +2 blocks
   g_dev.r4300.new_dynarec_hot_state.pending_exception=0;
+  g_dev.r4300.new_dynarec_hot_state.idle_cycle_count=0;
+  pending_count_per_op=0;
   literalcount=0;
 #if defined(HOST_IMM8) || defined(NEED_INVC_PTR)
   // Copy this into local area so we don't have to put it in every literal pool
@@ -8752,10 +9376,37 @@ void new_dynarec_init(void)
   for(n=526336;n<1048576;n++) // 0x80800000 .. 0xFFFFFFFF
     g_dev.r4300.new_dynarec_hot_state.memory_map[n]=(uintptr_t)-1;
 
+  memset(block_profiles,0,sizeof(block_profiles));
+  block_profile_count=0;
+  block_profile_dropped=0;
+  memset(idle_loops,0,sizeof(idle_loops));
+  idle_loop_count=0;
+
   tlb_speed_hacks();
+#ifdef HAVE_FASTMEM
+  fastmem_init();
+#endif
   arch_init();
 }
 
+// Hard reset. The translation cache is kept: like after loading a state,
+// invalidate_all_pages has made every block a candidate which is reused
+// once its source is found unchanged, so boot and game code compiled
+// before the reset isn't compiled again. This is not a cache shared between
+// instances, see new_dynarec.h.
+void new_dynarec_reset(void)
+{
+  g_dev.r4300.new_dynarec_hot_state.pc = &g_dev.r4300.new_dynarec_hot_state.fake_pc;
+  g_dev.r4300.new_dynarec_hot_state.pending_exception=0;
+  g_dev.r4300.new_dynarec_hot_state.idle_cycle_count=0;
+#ifdef HAVE_LIBNX
+  stop_after_jal=0;
+#else
+  stop_after_jal=1;
+#endif
+  using_tlb=0;
+}
+
 void new_dynarec_cleanup(void)
 {
 #if defined(RECOMPILER_DEBUG) && !defined(RECOMP_DBG)
@@ -8767,6 +9418,9 @@ void new_dynarec_cleanup(void)
   for(n=0;n<4096;n++) ll_clear(jump_out+n);
   for(n=0;n<4096;n++) ll_clear(jump_dirty+n);
   assert(copy_size==0);
+#ifdef HAVE_FASTMEM
+  fastmem_cleanup();
+#endif
 #if !defined(RECOMP_DBG)
   #if defined(WIN32)
     VirtualFree(base_addr, 0, MEM_RELEASE);
@@ -8808,8 +9462,8 @@ int new_recompile_block(int addr)
   }
   else if ((signed int)addr >= (signed int)0xC0000000) {
     //DebugMessage(M64MSG_VERBOSE, "addr=%x mm=%x",(u_int)addr,(g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]<<2));
-    //if(g_dev.r4300.cp0.tlb.LUT_r[start>>12])
-    //source = (u_int *)(((intptr_t)g_dev.rdram.dram)+(g_dev.r4300.cp0.tlb.LUT_r[start>>12]&0xFFFFF000)+(((int)addr)&0xFFF)-(intptr_t)0x80000000);
+    //if(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, start>>12))
+    //source = (u_int *)(((intptr_t)g_dev.rdram.dram)+(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, start>>12)&0xFFFFF000)+(((int)addr)&0xFFF)-(intptr_t)0x80000000);
     if((intptr_t)g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]>=0) {
       source = (u_int *)((uintptr_t)(start+(uintptr_t)(g_dev.r4300.new_dynarec_hot_state.memory_map[start>>12]<<2)));
       pagelimit=(start+4096)&0xFFFFF000;
@@ -11504,8 +12158,13 @@ int new_recompile_block(int addr)
     bt[slen-1]=1; // Mark as a branch target so instruction can restart after exception
   }
 
+  find_idle_loops();
+
   /* Pass 8 - Assembly */
   linkcount=0;stubcount=0;
+#ifdef HAVE_FASTMEM
+  fastmem_pending_count=fastmem_pending_next=0;
+#endif
   ds=0;is_delayslot=0;
   cop1_usable=0;
   dirty_entry_count=0;
@@ -11521,6 +12180,9 @@ int new_recompile_block(int addr)
   //DebugMessage(M64MSG_VERBOSE, "Currently used memory for copy: %d",copy_size);
 
   uintptr_t beginning=(uintptr_t)out;
+  // Blocks starting in a delay slot are left out
+  struct block_profile *profile=NULL;
+  if(block_profiling&&!((u_int)addr&1)) profile=block_profile_get(start);
   if((u_int)addr&1) {
     ds=1;
     pagespan_ds();
@@ -11561,6 +12223,10 @@ int new_recompile_block(int addr)
       // branch target entry point
       instr_addr[i]=(uintptr_t)out;
       assem_debug("<->");
+      #ifdef HAVE_EMIT_INCMEM
+      // Counts entries from other blocks as well as loops within this one
+      if(i==0&&profile) emit_incmem64((intptr_t)&profile->entries);
+      #endif
       // load regs
       if(regs[i].regmap_entry[HOST_CCREG]==CCREG&&regs[i].regmap[HOST_CCREG]!=CCREG)
         wb_register(CCREG,regs[i].regmap_entry,regs[i].wasdirty,regs[i].was32);
@@ -11773,9 +12439,9 @@ int new_recompile_block(int addr)
         u_int vaddr=start+i*4;
         u_int page=(0x80000000^vaddr)>>12;
         u_int vpage=page;
-        if(page>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) page=(g_dev.r4300.cp0.tlb.LUT_r[page^0x80000]^0x80000000)>>12;
+        if(page>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) page=(tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, page^0x80000)^0x80000000)>>12;
         if(page>2048) page=2048+(page&2047);
-        if(vpage>262143&&g_dev.r4300.cp0.tlb.LUT_r[vaddr>>12]) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
+        if(vpage>262143&&tlb_lut_get(&g_dev.r4300.cp0.tlb.LUT_r, vaddr>>12)) vpage&=2047; // jump_dirty uses a hash of the virtual address instead
         if(vpage>2048) vpage=2048+(vpage&2047);
         literal_pool(256);
         //if(!(is32[i]&(~unneeded_reg_upper[i])&~(1LL<<CCREG)))
@@ -11829,6 +12495,11 @@ int new_recompile_block(int addr)
   if(((uintptr_t)out)&7) emit_addnop(13);
   #endif
   assert((uintptr_t)out-beginning<MAX_OUTPUT_BLOCK_SIZE);
+  if(profile) {
+    profile->slen=slen;
+    profile->code_size=(u_int)((uintptr_t)out-beginning);
+    profile->recompiles++;
+  }
   memcpy(copy,(char*)source,slen*4);
   u_int *ptr=(u_int*)copy;
   ptr[slen]=dirty_entry_count;
@@ -11869,6 +12540,10 @@ int new_recompile_block(int addr)
     switch((expirep>>11)&3)
     {
       case 0:
+        #ifdef HAVE_FASTMEM
+        if((expirep&2047)==0)
+          fastmem_expire(base,shift);
+        #endif
         // Clear jump_in and jump_dirty
         ll_remove_matching_addrs(jump_in+(expirep&2047),base,shift);
         ll_remove_matching_addrs(jump_dirty+(expirep&2047),base,shift);
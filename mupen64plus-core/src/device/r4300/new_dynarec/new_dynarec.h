@@ -63,6 +63,7 @@ struct new_dynarec_hot_state
     uint32_t wword;
     uint32_t cp1_fcr0;
     uint32_t cp1_fcr31;
+    int idle_cycle_count; /* cycle_count before the last idle loop skip */
     int64_t  regs[32];
     int64_t  hi;
     int64_t  lo;
@@ -93,5 +94,33 @@ void invalidate_cached_code_new_dynarec(struct r4300_core* r4300, uint32_t addre
 void new_dynarec_init(void);
 void new_dyna_start(void);
 void new_dynarec_cleanup(void);
+/* Call on hard reset, after invalidate_cached_code_new_dynarec(r4300, 0, 0).
+ * Unchanged blocks survive it, within this process only. Sharing blocks
+ * between instances needs the core to run per instance first: generated
+ * code reaches g_dev through addresses fixed at compile time (rip-relative
+ * on x64, absolute on x86, FP loaded from g_dev on arm/arm64), so it can't
+ * run against another instance's state. */
+void new_dynarec_reset(void);
+
+/* Blocks compiled while profiling is enabled count their entries. The
+ * profile is kept until the next new_dynarec_init. */
+void new_dynarec_set_block_profiling(int enabled);
+/* Writes the profiled blocks sorted by estimated cycles, all of them if
+ * max_blocks is 0. Returns 0 on failure. */
+int new_dynarec_write_block_report(const char* path, unsigned int max_blocks);
+/* Takes effect at the next new_dynarec_init. Loads and stores with a
+ * register address are then emitted without the RDRAM range check, the
+ * ones faulting outside of RDRAM get patched to their slow path. */
+void new_dynarec_set_fastmem(int enabled);
+/* Backward branches to loops which only poll memory, waiting for an
+ * interrupt, jump straight to the next event. Applies to blocks compiled
+ * afterwards. */
+void new_dynarec_set_idle_loop_skip(int enabled);
+/* Writes the idle loops found since new_dynarec_init, with the addresses
+ * they poll. Returns 0 on failure. */
+int new_dynarec_write_idle_loop_report(const char* path);
+/* Switches to count_per_op at the next interrupt check, dropping all the
+ * compiled blocks. */
+void new_dynarec_set_count_per_op(unsigned int count_per_op);
 
 #endif /* M64P_DEVICE_R4300_NEW_DYNAREC_H */
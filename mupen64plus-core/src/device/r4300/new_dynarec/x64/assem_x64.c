@@ -1934,6 +1934,18 @@ static void emit_submem64(intptr_t addr,int hr)
   output_w32((intptr_t)addr-(intptr_t)out-4); // Note: rip-relative in 64-bit mode
 }
 
+// Increments a 64-bit counter, leaves all registers alone but clobbers flags
+static void emit_incmem64(intptr_t addr)
+{
+  assert(addr-(intptr_t)out>-2147483648LL&&addr-(intptr_t)out<2147483647LL);
+  assem_debug("addq $1,(%llx)",addr);
+  output_rex(1,0,0,0);
+  output_byte(0x83);
+  output_modrm(0,5,0);
+  output_w32(addr-(intptr_t)out-5); // Note: rip-relative, the immediate follows
+  output_byte(1);
+}
+
 static void emit_readword(intptr_t addr, int rt)
 {
   assert((intptr_t)addr-(intptr_t)out>=-2147483648LL&&(intptr_t)addr-(intptr_t)out<2147483647LL);
@@ -4286,6 +4298,39 @@ static void do_miniht_insert(int return_address,int rt,int temp) {
 static void literal_pool(int n) {}
 static void literal_pool_jumpover(int n) {}
 
+#ifdef HAVE_FASTMEM
+#define FASTMEM_PATCH_SIZE 5
+
+// Room for the jump a faulting site gets patched with
+static void emit_fastmem_pad(intptr_t start)
+{
+  while((intptr_t)out<start+FASTMEM_PATCH_SIZE) {
+    assem_debug("nop");
+    output_byte(0x90);
+  }
+}
+
+static void fastmem_patch(u_char *site,u_char *stub)
+{
+  intptr_t offset=(intptr_t)stub-((intptr_t)site+5);
+  assert(offset>=-2147483648LL&&offset<2147483647LL);
+  int rel=(int)offset;
+  site[0]=0xE9;
+  memcpy(site+1,&rel,4);
+}
+
+static uintptr_t *fastmem_context_pc(ucontext_t *uc)
+{
+  return (uintptr_t *)&uc->uc_mcontext.gregs[REG_RIP];
+}
+
+static uintptr_t *fastmem_context_reg(ucontext_t *uc,int r)
+{
+  static const int gregs[HOST_REGS]={REG_RAX,REG_RCX,REG_RDX,REG_RBX,REG_RSP,REG_RBP,REG_RSI,REG_RDI};
+  return (uintptr_t *)&uc->uc_mcontext.gregs[gregs[r]];
+}
+#endif
+
 // CPU-architecture-specific initialization
 static void arch_init()
 {
@@ -4294,5 +4339,10 @@ static void arch_init()
   g_dev.r4300.new_dynarec_hot_state.rounding_modes[2]=0xB3F; // ceil
   g_dev.r4300.new_dynarec_hot_state.rounding_modes[3]=0x73F; // floor
 
+#ifdef HAVE_FASTMEM
+  if(fastmem_window)
+    g_dev.r4300.new_dynarec_hot_state.ram_offset=(intptr_t)fastmem_window;
+  else
+#endif
   g_dev.r4300.new_dynarec_hot_state.ram_offset=(intptr_t)g_dev.rdram.dram-(intptr_t)0x80000000LL;
 }
@@ -40,6 +40,10 @@
 //#define DESTRUCTIVE_WRITEBACK 1
 #define DESTRUCTIVE_SHIFT 1
 #define USE_MINI_HT 1
+#define HAVE_EMIT_INCMEM 1 // Memory counters without a scratch register
+#if defined(__linux__)
+#define HAVE_FASTMEM 1 // Unchecked RDRAM accesses, patched when they fault
+#endif
 
 #define TARGET_SIZE_2 25 // 2^25 = 32 megabytes
 #define JUMP_TABLE_SIZE 0 // Not needed for x86
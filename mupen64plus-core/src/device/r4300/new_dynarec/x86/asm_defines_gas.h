@@ -1,11 +1,11 @@
 #define offsetof_struct_device_r4300 (0x00000000)
-#define offsetof_struct_r4300_core_cp0 (0x029014d0)
+#define offsetof_struct_r4300_core_cp0 (0x029014d4)
 #define offsetof_struct_cp0_last_addr (0x00000194)
 #define offsetof_struct_cp0_count_per_op (0x00000198)
 #define offsetof_struct_cp0_tlb (0x000001a0)
 #define offsetof_struct_tlb_entries (0x00000000)
 #define offsetof_struct_tlb_LUT_r (0x00000680)
-#define offsetof_struct_tlb_LUT_w (0x00400680)
+#define offsetof_struct_tlb_LUT_w (0x00001680)
 #define offsetof_struct_r4300_core_cached_interp (0x00000098)
 #define offsetof_struct_cached_interp_invalid_code (0x00000000)
 #define offsetof_struct_r4300_core_new_dynarec_hot_state (0x02501000)
@@ -18,18 +18,18 @@
 #define offsetof_struct_new_dynarec_hot_state_invc_ptr (0x00000050)
 #define offsetof_struct_new_dynarec_hot_state_cp1_fcr0 (0x0000006c)
 #define offsetof_struct_new_dynarec_hot_state_cp1_fcr31 (0x00000070)
-#define offsetof_struct_new_dynarec_hot_state_regs (0x00000074)
-#define offsetof_struct_new_dynarec_hot_state_hi (0x00000174)
-#define offsetof_struct_new_dynarec_hot_state_lo (0x0000017c)
-#define offsetof_struct_new_dynarec_hot_state_cp0_regs (0x00000184)
-#define offsetof_struct_new_dynarec_hot_state_cp1_regs_simple (0x0000020c)
-#define offsetof_struct_new_dynarec_hot_state_cp1_regs_double (0x0000028c)
-#define offsetof_struct_new_dynarec_hot_state_rounding_modes (0x00000314)
-#define offsetof_struct_new_dynarec_hot_state_branch_target (0x00000324)
-#define offsetof_struct_new_dynarec_hot_state_pc (0x00000328)
-#define offsetof_struct_new_dynarec_hot_state_fake_pc (0x0000032c)
-#define offsetof_struct_new_dynarec_hot_state_rs (0x000003b0)
-#define offsetof_struct_new_dynarec_hot_state_rt (0x000003b8)
-#define offsetof_struct_new_dynarec_hot_state_rd (0x000003c0)
-#define offsetof_struct_new_dynarec_hot_state_mini_ht (0x000003cc)
-#define offsetof_struct_new_dynarec_hot_state_memory_map (0x000004cc)
+#define offsetof_struct_new_dynarec_hot_state_regs (0x00000078)
+#define offsetof_struct_new_dynarec_hot_state_hi (0x00000178)
+#define offsetof_struct_new_dynarec_hot_state_lo (0x00000180)
+#define offsetof_struct_new_dynarec_hot_state_cp0_regs (0x00000188)
+#define offsetof_struct_new_dynarec_hot_state_cp1_regs_simple (0x00000210)
+#define offsetof_struct_new_dynarec_hot_state_cp1_regs_double (0x00000290)
+#define offsetof_struct_new_dynarec_hot_state_rounding_modes (0x00000318)
+#define offsetof_struct_new_dynarec_hot_state_branch_target (0x00000328)
+#define offsetof_struct_new_dynarec_hot_state_pc (0x0000032c)
+#define offsetof_struct_new_dynarec_hot_state_fake_pc (0x00000330)
+#define offsetof_struct_new_dynarec_hot_state_rs (0x000003b4)
+#define offsetof_struct_new_dynarec_hot_state_rt (0x000003bc)
+#define offsetof_struct_new_dynarec_hot_state_rd (0x000003c4)
+#define offsetof_struct_new_dynarec_hot_state_mini_ht (0x000003d0)
+#define offsetof_struct_new_dynarec_hot_state_memory_map (0x000004d0)
@@ -1756,6 +1756,20 @@ static void emit_jmpmem_indexed(u_int addr,u_int r)
   output_w32(addr);
 }
 
+// Increments a 64-bit counter, leaves all registers alone but clobbers flags
+static void emit_incmem64(int addr)
+{
+  assem_debug("addl $1,(%x); adcl $0,(%x)",addr,addr+4);
+  output_byte(0x83);
+  output_modrm(0,5,0);
+  output_w32(addr);
+  output_byte(1);
+  output_byte(0x83);
+  output_modrm(0,5,2);
+  output_w32(addr+4);
+  output_byte(0);
+}
+
 static void emit_readword(int addr, int rt)
 {
   assem_debug("mov %x,%%%s",addr,regname[rt]);
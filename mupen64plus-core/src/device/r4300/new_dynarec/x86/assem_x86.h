@@ -22,6 +22,7 @@
 #define DESTRUCTIVE_SHIFT 1
 
 #define USE_MINI_HT 1
+#define HAVE_EMIT_INCMEM 1 // Memory counters without a scratch register
 
 #define TARGET_SIZE_2 25 // 2^25 = 32 megabytes
 #define JUMP_TABLE_SIZE 0 // Not needed for 32-bit x86
@@ -86,6 +86,7 @@ static void InterpretOpcode(struct r4300_core* r4300);
          if(*cp0_cycle_count < 0) \
          { \
              cp0_regs[CP0_COUNT_REG] -= *cp0_cycle_count; \
+             r4300->cp0.idle_count -= *cp0_cycle_count; \
              *cp0_cycle_count = 0; \
          } \
       } \
@@ -35,6 +35,7 @@
 #include "debugger/dbg_debugger.h"
 #endif
 #include "main/main.h"
+#include "main/rom.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -247,35 +248,6 @@ unsigned int* r4300_llbit(struct r4300_core* r4300)
     return &r4300->llbit;
 }
 
-uint32_t* r4300_pc(struct r4300_core* r4300)
-{
-#ifdef NEW_DYNAREC
-    return (r4300->emumode == EMUMODE_DYNAREC)
-        ? (uint32_t*)&r4300->new_dynarec_hot_state.pcaddr
-        : &(*r4300_pc_struct(r4300))->addr;
-#else
-    return &(*r4300_pc_struct(r4300))->addr;
-#endif
-}
-
-struct precomp_instr** r4300_pc_struct(struct r4300_core* r4300)
-{
-#ifndef NEW_DYNAREC
-    return &r4300->pc;
-#else
-    return &r4300->new_dynarec_hot_state.pc;
-#endif
-}
-
-int* r4300_stop(struct r4300_core* r4300)
-{
-#ifndef NEW_DYNAREC
-    return &r4300->stop;
-#else
-    return &r4300->new_dynarec_hot_state.stop;
-#endif
-}
-
 unsigned int get_r4300_emumode(struct r4300_core* r4300)
 {
     return r4300->emumode;
@@ -294,6 +266,9 @@ uint32_t *fast_mem_access(struct r4300_core* r4300, uint32_t address)
 
     address &= UINT32_C(0x1ffffffc);
 
+    if (address >= MM_CART_ROM && address < MM_CART_ROM + CART_ROM_MAX_SIZE)
+        rom_pages_touch(address - MM_CART_ROM, 4);
+
     return mem_base_u32(r4300->mem->base, address);
 }
 
@@ -422,6 +397,25 @@ void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, si
     }
 }
 
+void r4300_set_count_per_op(struct r4300_core* r4300, unsigned int count_per_op)
+{
+    if (count_per_op == r4300->cp0.count_per_op)
+        return;
+
+#ifdef NEW_DYNAREC
+    if (r4300->emumode == EMUMODE_DYNAREC)
+    {
+        /* compiled blocks have it built in, switched at the next interrupt check */
+        new_dynarec_set_count_per_op(count_per_op);
+        return;
+    }
+#endif
+
+    /* account the instructions run so far at the old rate */
+    cp0_update_count(r4300);
+    r4300->cp0.count_per_op = count_per_op;
+}
+
 
 void generic_jump_to(struct r4300_core* r4300, uint32_t address)
 {
@@ -223,9 +223,36 @@ int64_t* r4300_regs(struct r4300_core* r4300);
 int64_t* r4300_mult_hi(struct r4300_core* r4300);
 int64_t* r4300_mult_lo(struct r4300_core* r4300);
 unsigned int* r4300_llbit(struct r4300_core* r4300);
-uint32_t* r4300_pc(struct r4300_core* r4300);
-struct precomp_instr** r4300_pc_struct(struct r4300_core* r4300);
-int* r4300_stop(struct r4300_core* r4300);
+
+/* Inlined, as the interpreters go through them for every instruction */
+static osal_inline struct precomp_instr** r4300_pc_struct(struct r4300_core* r4300)
+{
+#ifndef NEW_DYNAREC
+    return &r4300->pc;
+#else
+    return &r4300->new_dynarec_hot_state.pc;
+#endif
+}
+
+static osal_inline uint32_t* r4300_pc(struct r4300_core* r4300)
+{
+#ifdef NEW_DYNAREC
+    return (r4300->emumode == EMUMODE_DYNAREC)
+        ? (uint32_t*)&r4300->new_dynarec_hot_state.pcaddr
+        : &(*r4300_pc_struct(r4300))->addr;
+#else
+    return &(*r4300_pc_struct(r4300))->addr;
+#endif
+}
+
+static osal_inline int* r4300_stop(struct r4300_core* r4300)
+{
+#ifndef NEW_DYNAREC
+    return &r4300->stop;
+#else
+    return &r4300->new_dynarec_hot_state.stop;
+#endif
+}
 
 unsigned int get_r4300_emumode(struct r4300_core* r4300);
 
@@ -247,6 +274,9 @@ int r4300_write_aligned_dword(struct r4300_core* r4300, uint32_t address, uint64
  */
 void invalidate_r4300_cached_code(struct r4300_core* r4300, uint32_t address, size_t size);
 
+/* Changes the COUNT cycles each instruction takes while running */
+void r4300_set_count_per_op(struct r4300_core* r4300, unsigned int count_per_op);
+
 /* Jump to the given address. This works for all r4300 emulator, but is slower.
  * Use this for common code which can be executed from any r4300 emulator. */
 void generic_jump_to(struct r4300_core* r4300, unsigned int address);
@@ -22,6 +22,7 @@
 #include "tlb.h"
 #include <mupen64plus-next_common.h>
 
+#include "api/callbacks.h"
 #include "api/m64p_types.h"
 #include "device/r4300/r4300_core.h"
 #include "device/rdram/rdram.h"
@@ -33,8 +34,15 @@ void poweron_tlb(struct tlb* tlb)
 {
     /* clear TLB entries */
     memset(tlb->entries, 0, 32 * sizeof(tlb->entries[0]));
-    memset(tlb->LUT_r, 0, 0x100000 * sizeof(tlb->LUT_r[0]));
-    memset(tlb->LUT_w, 0, 0x100000 * sizeof(tlb->LUT_w[0]));
+    tlb_lut_clear(&tlb->LUT_r);
+    tlb_lut_clear(&tlb->LUT_w);
+}
+
+void poweroff_tlb(struct tlb* tlb)
+{
+    /* release the LUT leaves allocated while running */
+    tlb_lut_clear(&tlb->LUT_r);
+    tlb_lut_clear(&tlb->LUT_w);
 }
 
 void tlb_unmap(struct tlb* tlb, size_t entry)
@@ -48,22 +56,28 @@ void tlb_unmap(struct tlb* tlb, size_t entry)
     if (e->v_even)
     {
         for (i=e->start_even; i<e->end_even; i += 0x1000)
-            tlb->LUT_r[i>>12] = 0;
+            tlb_lut_set(&tlb->LUT_r, i>>12, 0);
         if (e->d_even)
             for (i=e->start_even; i<e->end_even; i += 0x1000)
-                tlb->LUT_w[i>>12] = 0;
+                tlb_lut_set(&tlb->LUT_w, i>>12, 0);
     }
 
     if (e->v_odd)
     {
         for (i=e->start_odd; i<e->end_odd; i += 0x1000)
-            tlb->LUT_r[i>>12] = 0;
+            tlb_lut_set(&tlb->LUT_r, i>>12, 0);
         if (e->d_odd)
             for (i=e->start_odd; i<e->end_odd; i += 0x1000)
-                tlb->LUT_w[i>>12] = 0;
+                tlb_lut_set(&tlb->LUT_w, i>>12, 0);
     }
 }
 
+static void tlb_lut_map(struct tlb_lut* lut, uint32_t page, uint32_t value)
+{
+    if (!tlb_lut_set(lut, page, value))
+        DebugMessage(M64MSG_ERROR, "Failed to allocate TLB lookup table for page %08x", page << 12);
+}
+
 void tlb_map(struct tlb* tlb, size_t entry)
 {
     unsigned int i;
@@ -79,10 +93,10 @@ void tlb_map(struct tlb* tlb, size_t entry)
             e->phys_even < 0x20000000)
         {
             for (i=e->start_even;i<e->end_even;i+=0x1000)
-                tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF);
+                tlb_lut_map(&tlb->LUT_r, i>>12, UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF));
             if (e->d_even)
                 for (i=e->start_even;i<e->end_even;i+=0x1000)
-                    tlb->LUT_w[i>>12] = UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF);
+                    tlb_lut_map(&tlb->LUT_w, i>>12, UINT32_C(0x80000000) | (e->phys_even + (i - e->start_even) + 0xFFF));
         }
     }
 
@@ -93,10 +107,10 @@ void tlb_map(struct tlb* tlb, size_t entry)
             e->phys_odd < 0x20000000)
         {
             for (i=e->start_odd;i<e->end_odd;i+=0x1000)
-                tlb->LUT_r[i>>12] = UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF);
+                tlb_lut_map(&tlb->LUT_r, i>>12, UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF));
             if (e->d_odd)
                 for (i=e->start_odd;i<e->end_odd;i+=0x1000)
-                    tlb->LUT_w[i>>12] = UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF);
+                    tlb_lut_map(&tlb->LUT_w, i>>12, UINT32_C(0x80000000) | (e->phys_odd + (i - e->start_odd) + 0xFFF));
         }
     }
 }
@@ -105,21 +119,23 @@ uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address,
 {
     const struct tlb* tlb = &r4300->cp0.tlb;
     unsigned int addr = address >> 12;
+    uint32_t lut_r = tlb_lut_get(&tlb->LUT_r, addr);
+    uint32_t lut_w = tlb_lut_get(&tlb->LUT_w, addr);
 
 #ifdef NEW_DYNAREC
     if (r4300->emumode == EMUMODE_DYNAREC)
     {
         intptr_t map = r4300->new_dynarec_hot_state.memory_map[addr];
-        if ((tlb->LUT_w[addr]) && (w == 1))
+        if ((lut_w) && (w == 1))
         {
-            assert(map == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb->LUT_w[addr] & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
+            assert(map == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((lut_w & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
         }
-        else if ((tlb->LUT_r[addr]) && (w == 0))
+        else if ((lut_r) && (w == 0))
         {
-            assert((map&~WRITE_PROTECT) == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((tlb->LUT_r[addr] & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
+            assert((map&~WRITE_PROTECT) == (((uintptr_t)r4300->rdram->dram + (uintptr_t)((lut_r & 0xFFFFF000) - 0x80000000) - (address & 0xFFFFF000)) >> 2));
             if (map & WRITE_PROTECT)
             {
-                assert(tlb->LUT_w[addr] == 0);
+                assert(lut_w == 0);
             }
         }
         else {
@@ -130,13 +146,13 @@ uint32_t virtual_to_physical_address(struct r4300_core* r4300, uint32_t address,
 
     if (w == 1)
     {
-        if (tlb->LUT_w[addr])
-            return (tlb->LUT_w[addr] & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
+        if (lut_w)
+            return (lut_w & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
     }
     else
     {
-        if (tlb->LUT_r[addr])
-            return (tlb->LUT_r[addr] & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
+        if (lut_r)
+            return (lut_r & UINT32_C(0xFFFFF000)) | (address & UINT32_C(0xFFF));
     }
     //printf("tlb exception !!! @ %x, %x, add:%x\n", address, w, r4300->pc->addr);
     //getchar();
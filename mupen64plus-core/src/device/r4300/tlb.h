@@ -25,6 +25,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "tlb_lut.h"
+
 struct r4300_core;
 
 struct tlb_entry
@@ -55,11 +57,12 @@ struct tlb_entry
 struct tlb
 {
     struct tlb_entry entries[32];
-    uint32_t LUT_r[0x100000];
-    uint32_t LUT_w[0x100000];
+    struct tlb_lut LUT_r;
+    struct tlb_lut LUT_w;
 };
 
 void poweron_tlb(struct tlb* tlb);
+void poweroff_tlb(struct tlb* tlb);
 
 void tlb_unmap(struct tlb* tlb, size_t entry);
 void tlb_map(struct tlb* tlb, size_t entry);
@@ -0,0 +1,75 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - tlb_lut.c                                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "tlb_lut.h"
+
+#include <stdlib.h>
+
+const uint32_t tlb_lut_unmapped[TLB_LUT_LEAF_SIZE] = { 0 };
+
+void tlb_lut_clear(struct tlb_lut* lut)
+{
+    size_t i;
+
+    for (i = 0; i < TLB_LUT_DIR_SIZE; ++i) {
+        if (lut->dir[i] != tlb_lut_unmapped) {
+            free((void*)lut->dir[i]);
+        }
+        lut->dir[i] = tlb_lut_unmapped;
+    }
+}
+
+int tlb_lut_set(struct tlb_lut* lut, uint32_t page, uint32_t value)
+{
+    size_t i = page >> TLB_LUT_LEAF_BITS;
+    uint32_t* leaf;
+
+    if (lut->dir[i] == tlb_lut_unmapped) {
+        if (value == 0) {
+            return 1;
+        }
+
+        /* Leaves are kept until the next clear, as games tend to remap
+         * the same ranges over and over */
+        leaf = (uint32_t*)calloc(TLB_LUT_LEAF_SIZE, sizeof(uint32_t));
+        if (leaf == NULL) {
+            return 0;
+        }
+        lut->dir[i] = leaf;
+    }
+    else {
+        leaf = (uint32_t*)lut->dir[i];
+    }
+
+    leaf[page & (TLB_LUT_LEAF_SIZE - 1)] = value;
+    return 1;
+}
+
+unsigned int tlb_lut_leaves(const struct tlb_lut* lut)
+{
+    unsigned int count = 0;
+    size_t i;
+
+    for (i = 0; i < TLB_LUT_DIR_SIZE; ++i) {
+        count += (lut->dir[i] != tlb_lut_unmapped);
+    }
+
+    return count;
+}
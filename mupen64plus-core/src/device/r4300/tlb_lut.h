@@ -0,0 +1,61 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - tlb_lut.h                                               *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_DEVICE_R4300_TLB_LUT_H
+#define M64P_DEVICE_R4300_TLB_LUT_H
+
+#include <stdint.h>
+
+#include "osal/preproc.h"
+
+/* Lookup table from the 0x100000 virtual pages to their TLB translation,
+ * kept as a two level table. Games only ever map a few regions, so leaves
+ * are allocated for the 4 MB ranges that had a page mapped, and every other
+ * directory entry points to one shared leaf of zeroes. A lookup is always
+ * two loads, whether the page is mapped or not. */
+
+#define TLB_LUT_PAGES      0x100000
+#define TLB_LUT_LEAF_BITS  10
+#define TLB_LUT_LEAF_SIZE  (1 << TLB_LUT_LEAF_BITS)
+#define TLB_LUT_DIR_SIZE   (TLB_LUT_PAGES >> TLB_LUT_LEAF_BITS)
+
+struct tlb_lut
+{
+    const uint32_t* dir[TLB_LUT_DIR_SIZE];
+};
+
+extern const uint32_t tlb_lut_unmapped[TLB_LUT_LEAF_SIZE];
+
+/* Points every range to the shared leaf, freeing the ones that were
+ * allocated. The table must have been zeroed or cleared before. */
+void tlb_lut_clear(struct tlb_lut* lut);
+
+/* Returns 0 if the leaf couldn't be allocated, the entry is then left unmapped */
+int tlb_lut_set(struct tlb_lut* lut, uint32_t page, uint32_t value);
+
+/* Number of allocated leaves */
+unsigned int tlb_lut_leaves(const struct tlb_lut* lut);
+
+static osal_inline uint32_t tlb_lut_get(const struct tlb_lut* lut, uint32_t page)
+{
+    return lut->dir[page >> TLB_LUT_LEAF_BITS][page & (TLB_LUT_LEAF_SIZE - 1)];
+}
+
+#endif /* M64P_DEVICE_R4300_TLB_LUT_H */
@@ -30,6 +30,7 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rcp/vi/vi_controller.h"
 #include "device/rdram/rdram.h"
+#include "device/rcp/rsp/rsp_core.h"
 
 
 #define AI_STATUS_BUSY UINT32_C(0x40000000)
@@ -142,6 +143,7 @@ static void fifo_pop(struct ai_controller* ai)
 void init_ai(struct ai_controller* ai,
              struct mi_controller* mi,
              struct ri_controller* ri,
+             struct rsp_core* sp,
              struct vi_controller* vi,
              void* aout,
              const struct audio_out_backend_interface* iaout,
@@ -149,6 +151,7 @@ void init_ai(struct ai_controller* ai,
 {
     ai->mi = mi;
     ai->ri = ri;
+    ai->sp = sp;
     ai->vi = vi;
     ai->aout = aout;
     ai->iaout = iaout;
@@ -175,7 +178,11 @@ void read_ai_regs(void* opaque, uint32_t address, uint32_t* value)
         if (*value < ai->last_read)
         {
             unsigned int diff = ai->fifo[0].length - ai->last_read;
-            unsigned char *p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
+            unsigned char *p;
+
+            /* samples may still be produced by an async audio task */
+            rsp_wait_task(ai->sp);
+            p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
             ai->iaout->push_samples(ai->aout, p + diff, ai->last_read - *value);
             ai->last_read = *value;
         }
@@ -226,7 +233,10 @@ void ai_end_of_dma_event(void* opaque)
     if (ai->last_read != 0)
     {
         unsigned int diff = ai->fifo[0].length - ai->last_read;
-        unsigned char *p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
+        unsigned char *p;
+
+        rsp_wait_task(ai->sp);
+        p = (unsigned char*)&ai->ri->rdram->dram[ai->fifo[0].address/4];
         ai->iaout->push_samples(ai->aout, p + diff, ai->last_read);
         ai->last_read = 0;
     }
@@ -29,6 +29,7 @@
 
 struct mi_controller;
 struct ri_controller;
+struct rsp_core;
 struct vi_controller;
 struct audio_out_backend_interface;
 
@@ -63,6 +64,7 @@ struct ai_controller
 
     struct mi_controller* mi;
     struct ri_controller* ri;
+    struct rsp_core* sp;
     struct vi_controller* vi;
 
     void* aout;
@@ -77,6 +79,7 @@ static osal_inline uint32_t ai_reg(uint32_t address)
 void init_ai(struct ai_controller* ai,
              struct mi_controller* mi,
              struct ri_controller* ri,
+             struct rsp_core* sp,
              struct vi_controller* vi,
              void* aout,
              const struct audio_out_backend_interface* iaout,
@@ -33,6 +33,7 @@
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rdp/rdp_core.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "device/rcp/ri/ri_controller.h"
 
 #define __STDC_FORMAT_MACROS
@@ -68,7 +69,8 @@ static void dma_pi_read(struct pi_controller* pi)
         return;
     }
 
-    pre_framebuffer_read(&pi->dp->fb, dram_addr);
+    pre_framebuffer_read_range(&pi->dp->fb, dram_addr, length);
+    rsp_wait_task(pi->sp);
 
     /* PI seems to treat the first 128 bytes differently, see https://n64brew.dev/wiki/Peripheral_Interface#Unaligned_DMA_transfer */
     if (length >= 0x7f && (length & 1))
@@ -106,6 +108,9 @@ static void dma_pi_write(struct pi_controller* pi)
         return;
     }
 
+    /* an async audio task may be reading the destination */
+    rsp_wait_task(pi->sp);
+
     /* PI seems to treat the first 128 bytes differently, see https://n64brew.dev/wiki/Peripheral_Interface#Unaligned_DMA_transfer */
     if (length >= 0x7f && (length & 1))
         length += 1;
@@ -133,7 +138,8 @@ void init_pi(struct pi_controller* pi,
              struct dd_controller* dd,
              struct mi_controller* mi,
              struct ri_controller* ri,
-             struct rdp_core* dp)
+             struct rdp_core* dp,
+             struct rsp_core* sp)
 {
     pi->get_pi_dma_handler = get_pi_dma_handler;
     pi->cart = cart;
@@ -141,6 +147,7 @@ void init_pi(struct pi_controller* pi,
     pi->mi = mi;
     pi->ri = ri;
     pi->dp = dp;
+    pi->sp = sp;
 }
 
 void poweron_pi(struct pi_controller* pi)
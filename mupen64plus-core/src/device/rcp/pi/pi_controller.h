@@ -32,6 +32,7 @@ struct dd_controller;
 struct mi_controller;
 struct ri_controller;
 struct rdp_core;
+struct rsp_core;
 
 enum pi_registers
 {
@@ -83,6 +84,7 @@ struct pi_controller
     struct mi_controller* mi;
     struct ri_controller* ri;
     struct rdp_core* dp;
+    struct rsp_core* sp;
 };
 
 static osal_inline uint32_t pi_reg(uint32_t address)
@@ -98,7 +100,8 @@ void init_pi(struct pi_controller* pi,
              struct dd_controller* dd,
              struct mi_controller* mi,
              struct ri_controller* ri,
-             struct rdp_core* dp);
+             struct rdp_core* dp,
+             struct rsp_core* sp);
 
 void poweron_pi(struct pi_controller* pi);
 
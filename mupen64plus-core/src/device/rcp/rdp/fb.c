@@ -63,6 +63,34 @@ void pre_framebuffer_read(struct fb* fb, uint32_t address)
     }
 }
 
+void pre_framebuffer_read_range(struct fb* fb, uint32_t address, uint32_t length)
+{
+    if (!fb->infos[0].addr || length == 0) {
+        return;
+    }
+
+    uint32_t page;
+
+    /* dirty flags are per page, so one address per page is enough */
+    pre_framebuffer_read(fb, address);
+    for (page = (address & ~UINT32_C(0xfff)) + 0x1000; page < address + length; page += 0x1000) {
+        pre_framebuffer_read(fb, page);
+    }
+}
+
+void pre_framebuffer_read_all(struct fb* fb)
+{
+    size_t i;
+
+    /* the gfx plugin waits for whatever is still drawing to each fb,
+     * dirty or not */
+    for (i = 0; i < FB_INFOS_COUNT; ++i) {
+        if (fb->infos[i].addr != 0) {
+            gfx.fBRead(fb->infos[i].addr);
+        }
+    }
+}
+
 void post_framebuffer_write(struct fb* fb, uint32_t address, uint32_t length)
 {
     if (!fb->infos[0].addr) {
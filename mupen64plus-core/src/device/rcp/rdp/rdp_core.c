@@ -26,6 +26,7 @@
 #include "device/memory/memory.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/rsp/rsp_core.h"
+#include "main/profile.h"
 #include "plugin/plugin.h"
 
 static void update_dpc_status(struct rdp_core* dp, uint32_t w)
@@ -42,7 +43,11 @@ static void update_dpc_status(struct rdp_core* dp, uint32_t w)
         if (dp->do_on_unfreeze & DELAY_DP_INT)
             signal_rcp_interrupt(dp->mi, MI_INTR_DP);
         if (dp->do_on_unfreeze & DELAY_UPDATESCREEN)
+        {
+            timed_section_start(TIMED_SECTION_VI);
             gfx.updateScreen();
+            timed_section_end(TIMED_SECTION_VI);
+        }
         dp->do_on_unfreeze = 0;
     }
     if (w & DPC_SET_FREEZE) dp->dpc_regs[DPC_STATUS_REG] |= DPC_STATUS_FREEZE;
@@ -114,8 +119,13 @@ void write_dpc_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
         dp->dpc_regs[DPC_CURRENT_REG] = dp->dpc_regs[DPC_START_REG];
         break;
     case DPC_END_REG:
+        /* the list may read what an async audio task writes, and the
+         * framebuffer mappings below would replace its hazard ones */
+        rsp_wait_task(dp->sp);
         unprotect_framebuffers(&dp->fb);
+        timed_section_start(TIMED_SECTION_RDP);
         gfx.processRDPList();
+        timed_section_end(TIMED_SECTION_RDP);
         protect_framebuffers(&dp->fb);
         signal_rcp_interrupt(dp->mi, MI_INTR_DP);
         break;
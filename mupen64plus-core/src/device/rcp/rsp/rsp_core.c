@@ -30,11 +30,16 @@
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
 #include "main/main.h"
-#if defined(PROFILE)
 #include "main/profile.h"
-#endif
 #include "plugin/plugin.h"
 #include "api/callbacks.h"
+#include <mupen64plus-next_common.h>
+
+/* OSTask header fields in DMEM */
+enum
+{
+    TASK_TYPE = 0xfc0
+};
 
 static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
 {
@@ -73,7 +78,7 @@ static void do_sp_dma(struct rsp_core* sp, const struct sp_dma* dma)
     {
         for(j=0; j<count; j++) {
             if (dramaddr < 0x800000)
-                pre_framebuffer_read(&sp->dp->fb, dramaddr);
+                pre_framebuffer_read_range(&sp->dp->fb, dramaddr, length);
 
             for(i=0; i<length; i++) {
                 spmem[(memaddr^S8) & 0xfff] = dram[(dramaddr^S8) & 0x7fffff];
@@ -225,6 +230,8 @@ void init_rsp(struct rsp_core* sp,
 
 void poweron_rsp(struct rsp_core* sp)
 {
+    rsp_wait_task(sp);
+
     memset(sp->mem, 0, SP_MEM_SIZE);
     memset(sp->regs, 0, SP_REGS_COUNT*sizeof(uint32_t));
     memset(sp->regs2, 0, SP_REGS2_COUNT*sizeof(uint32_t));
@@ -243,6 +250,8 @@ void read_rsp_mem(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->mem[addr];
 }
 
@@ -251,6 +260,8 @@ void write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t addr = rsp_mem_address(address);
 
+    rsp_wait_task(sp);
+
     masked_write(&sp->mem[addr], value, mask);
 }
 
@@ -260,6 +271,8 @@ void read_rsp_regs(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs[reg];
 
     if (reg == SP_SEMAPHORE_REG)
@@ -273,6 +286,8 @@ void write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg(address);
 
+    rsp_wait_task(sp);
+
     switch(reg)
     {
     case SP_STATUS_REG:
@@ -304,6 +319,8 @@ void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value)
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     *value = sp->regs2[reg];
 
     if (reg == SP_PC_REG)
@@ -316,31 +333,269 @@ void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t ma
     struct rsp_core* sp = (struct rsp_core*)opaque;
     uint32_t reg = rsp_reg2(address);
 
+    rsp_wait_task(sp);
+
     if (reg == SP_PC_REG)
         mask &= 0xffc;
 
     masked_write(&sp->regs2[reg], value, mask);
 }
 
+/* Returns whether the task raised an SP interrupt. When the SP_INT event has
+ * already been queued for the task (async tasks), it is dropped if unneeded
+ * instead of being scheduled. */
+static int finish_sp_task(struct rsp_core* sp, uint32_t sp_delay_time, int event_queued)
+{
+    int raised = 0;
+
+    sp->rsp_task_locked = 0;
+    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
+    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
+    {
+        sp->rsp_task_locked = 1;
+        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
+        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
+    }
+    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
+    {
+        if (!event_queued)
+        {
+            cp0_update_count(sp->mi->r4300);
+            add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, sp_delay_time);
+        }
+        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
+        raised = 1;
+    }
+    else if (event_queued)
+    {
+        remove_event(&sp->mi->r4300->cp0.q, SP_INT);
+    }
+
+    sp->regs[SP_STATUS_REG] &=
+        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
+
+    return raised;
+}
+
+static void* rsp_async_thread(void* opaque)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+
+    pthread_mutex_lock(&sp->async.lock);
+    for (;;)
+    {
+        while (!sp->async.busy && !sp->async.quit)
+            pthread_cond_wait(&sp->async.cond, &sp->async.lock);
+
+        if (sp->async.quit)
+            break;
+
+        pthread_mutex_unlock(&sp->async.lock);
+        rsp.doRspCycles(0xffffffff);
+        pthread_mutex_lock(&sp->async.lock);
+
+        sp->async.busy = 0;
+        pthread_cond_broadcast(&sp->async.cond);
+    }
+    pthread_mutex_unlock(&sp->async.lock);
+
+    return NULL;
+}
+
+static void add_task_hazard(void* opaque, uint32_t address, uint32_t length)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+    uint32_t dram_size = sp->ri->rdram->dram_size;
+    uint32_t end;
+
+    address &= 0xffffff;
+    if (length == 0 || address >= dram_size)
+        return;
+
+    end = (length > dram_size - address) ? dram_size - 1 : address + length - 1;
+    for (address >>= 16; address <= (end >> 16); ++address)
+        sp->async.hazard[address] = 1;
+}
+
+static int can_run_task_async(struct rsp_core* sp)
+{
+    /* the dynarec accesses RDRAM without going through the memory handlers,
+     * and the task must own the SP interrupt event */
+    if (!EnableAsyncAudioRSP || current_rsp_type != RSP_PLUGIN_HLE
+        || sp->mi->r4300->emumode == EMUMODE_DYNAREC
+        || get_event(&sp->mi->r4300->cp0.q, SP_INT))
+        return 0;
+
+    /* only audio lists have an RDRAM footprint known in advance */
+    memset(sp->async.hazard, 0, sizeof(sp->async.hazard));
+    if (!hleAudioTaskFootprint(add_task_hazard, sp))
+        return 0;
+
+    if (!sp->async.thread_created)
+    {
+        pthread_mutex_init(&sp->async.lock, NULL);
+        pthread_cond_init(&sp->async.cond, NULL);
+        sp->async.busy = 0;
+        sp->async.quit = 0;
+
+        if (pthread_create(&sp->async.thread, NULL, rsp_async_thread, sp) != 0)
+        {
+            DebugMessage(M64MSG_WARNING, "Failed to create RSP worker thread, running audio tasks synchronously.");
+            pthread_cond_destroy(&sp->async.cond);
+            pthread_mutex_destroy(&sp->async.lock);
+            EnableAsyncAudioRSP = 0;
+            return 0;
+        }
+        sp->async.thread_created = 1;
+    }
+
+    return 1;
+}
+
+static void start_async_task(struct rsp_core* sp, uint32_t save_pc)
+{
+    struct mem_mapping mapping = { 0, 0, M64P_MEM_RDRAM, { sp, read_rdram_sp_hazard, write_rdram_sp_hazard } };
+    struct memory* mem = sp->mi->r4300->mem;
+    uint32_t i;
+
+    sp->regs2[SP_PC_REG] &= 0xfff;
+    sp->async.save_pc = save_pc;
+    sp->async.pending = 1;
+
+    /* the r4300 keeps updating MI_INTR meanwhile, so the task works on copies */
+    sp->async.mi_intr = 0;
+    sp->async.sp_status = sp->regs[SP_STATUS_REG];
+    hleSetTaskRegisters(&sp->async.mi_intr, &sp->async.sp_status);
+
+    /* keep the current handlers (framebuffer protection) to restore them */
+    for (i = 0; i < SP_HAZARD_BLOCKS; ++i)
+    {
+        if (!sp->async.hazard[i])
+            continue;
+
+        sp->async.saved_handlers[i] = *mem_get_handler(mem, i << 16);
+        mapping.begin = i << 16;
+        mapping.end = mapping.begin + 0xffff;
+        apply_mem_mapping(mem, &mapping);
+    }
+
+    /* Schedule the SP interrupt as if the task completed right away,
+     * which is when the synchronous path would have scheduled it. */
+    cp0_update_count(sp->mi->r4300);
+    add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, 4000);
+
+    pthread_mutex_lock(&sp->async.lock);
+    sp->async.busy = 1;
+    pthread_cond_broadcast(&sp->async.cond);
+    pthread_mutex_unlock(&sp->async.lock);
+}
+
+/* Returns whether the task raised an SP interrupt */
+static int complete_async_task(struct rsp_core* sp, int event_queued)
+{
+    struct mem_mapping mapping = { 0, 0, M64P_MEM_RDRAM, { NULL, NULL, NULL } };
+    struct memory* mem = sp->mi->r4300->mem;
+    uint32_t i;
+
+    /* only the time the r4300 spends waiting is accounted */
+    timed_section_start(TIMED_SECTION_AUDIO);
+    pthread_mutex_lock(&sp->async.lock);
+    while (sp->async.busy)
+        pthread_cond_wait(&sp->async.cond, &sp->async.lock);
+    pthread_mutex_unlock(&sp->async.lock);
+    timed_section_end(TIMED_SECTION_AUDIO);
+
+    sp->async.pending = 0;
+
+    /* SP_STATUS accesses wait for the task, so its copy is still current */
+    hleSetTaskRegisters(NULL, NULL);
+    sp->regs[SP_STATUS_REG] = sp->async.sp_status;
+    sp->mi->regs[MI_INTR_REG] |= sp->async.mi_intr;
+
+    for (i = 0; i < SP_HAZARD_BLOCKS; ++i)
+    {
+        if (!sp->async.hazard[i])
+            continue;
+
+        sp->async.hazard[i] = 0;
+
+        /* blocks remapped meanwhile (RDRAM init) keep their new handler */
+        if (mem_get_handler(mem, i << 16)->read32 != read_rdram_sp_hazard)
+            continue;
+
+        mapping.begin = i << 16;
+        mapping.end = mapping.begin + 0xffff;
+        mapping.handler = sp->async.saved_handlers[i];
+        apply_mem_mapping(mem, &mapping);
+    }
+
+    sp->regs2[SP_PC_REG] |= sp->async.save_pc;
+
+    return finish_sp_task(sp, 4000, event_queued);
+}
+
+void rsp_sync_task(struct rsp_core* sp)
+{
+    if (sp->async.pending)
+        complete_async_task(sp, 1);
+}
+
+void poweroff_rsp(struct rsp_core* sp)
+{
+    rsp_wait_task(sp);
+
+    if (!sp->async.thread_created)
+        return;
+
+    pthread_mutex_lock(&sp->async.lock);
+    sp->async.quit = 1;
+    pthread_cond_broadcast(&sp->async.cond);
+    pthread_mutex_unlock(&sp->async.lock);
+
+    pthread_join(sp->async.thread, NULL);
+    pthread_cond_destroy(&sp->async.cond);
+    pthread_mutex_destroy(&sp->async.lock);
+    sp->async.thread_created = 0;
+}
+
+/* Mapped over whole 64k blocks the task may access, which get their
+ * previous handler back once it completes */
+void read_rdram_sp_hazard(void* opaque, uint32_t address, uint32_t* value)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+
+    rsp_wait_task(sp);
+    mem_read32(mem_get_handler(sp->mi->r4300->mem, address), address, value);
+}
+
+void write_rdram_sp_hazard(void* opaque, uint32_t address, uint32_t value, uint32_t mask)
+{
+    struct rsp_core* sp = (struct rsp_core*)opaque;
+
+    rsp_wait_task(sp);
+    mem_write32(mem_get_handler(sp->mi->r4300->mem, address), address, value, mask);
+}
+
 void do_SP_Task(struct rsp_core* sp)
 {
     uint32_t save_pc = sp->regs2[SP_PC_REG] & ~0xfff;
 
     uint32_t sp_delay_time;
 
-    if (sp->mem[0xfc0/4] == 1)
+    /* LLE RSPs DMA from RDRAM on their own, without the checks of do_sp_dma,
+     * so frame buffers still being drawn have to be finished beforehand */
+    if (current_rsp_type != RSP_PLUGIN_HLE)
+        pre_framebuffer_read_all(&sp->dp->fb);
+
+    if (sp->mem[TASK_TYPE/4] == 1)
     {
         unprotect_framebuffers(&sp->dp->fb);
 
         //gfx.processDList();
         sp->regs2[SP_PC_REG] &= 0xfff;
-#if defined(PROFILE)
         timed_section_start(TIMED_SECTION_GFX);
-#endif
         rsp.doRspCycles(0xffffffff);
-#if defined(PROFILE)
         timed_section_end(TIMED_SECTION_GFX);
-#endif
         sp->regs2[SP_PC_REG] |= save_pc;
         new_frame();
 
@@ -358,17 +613,19 @@ void do_SP_Task(struct rsp_core* sp)
 
         protect_framebuffers(&sp->dp->fb);
     }
-    else if (sp->mem[0xfc0/4] == 2)
+    else if (sp->mem[TASK_TYPE/4] == 2)
     {
+        if (can_run_task_async(sp))
+        {
+            start_async_task(sp, save_pc);
+            return;
+        }
+
         //audio.processAList();
         sp->regs2[SP_PC_REG] &= 0xfff;
-#if defined(PROFILE)
         timed_section_start(TIMED_SECTION_AUDIO);
-#endif
         rsp.doRspCycles(0xffffffff);
-#if defined(PROFILE)
         timed_section_end(TIMED_SECTION_AUDIO);
-#endif
         sp->regs2[SP_PC_REG] |= save_pc;
 
         sp_delay_time = 4000;
@@ -376,35 +633,26 @@ void do_SP_Task(struct rsp_core* sp)
     else
     {
         sp->regs2[SP_PC_REG] &= 0xfff;
+        timed_section_start(TIMED_SECTION_RSP);
         rsp.doRspCycles(0xffffffff);
+        timed_section_end(TIMED_SECTION_RSP);
         sp->regs2[SP_PC_REG] |= save_pc;
 
         sp_delay_time = 0;
     }
 
-    sp->rsp_task_locked = 0;
-    sp->mi->r4300->cp0.interrupt_unsafe_state &= ~INTR_UNSAFE_RSP;
-    if ((sp->regs[SP_STATUS_REG] & (SP_STATUS_HALT | SP_STATUS_BROKE)) == 0)
-    {
-        sp->rsp_task_locked = 1;
-        sp->mi->r4300->cp0.interrupt_unsafe_state |= INTR_UNSAFE_RSP;
-        sp->mi->regs[MI_INTR_REG] |= MI_INTR_SP;
-    }
-    if (sp->mi->regs[MI_INTR_REG] & MI_INTR_SP)
-    {
-        cp0_update_count(sp->mi->r4300);
-        add_interrupt_event(&sp->mi->r4300->cp0, SP_INT, sp_delay_time);
-        sp->mi->regs[MI_INTR_REG] &= ~MI_INTR_SP;
-    }
-
-    sp->regs[SP_STATUS_REG] &=
-        ~(SP_STATUS_TASKDONE | SP_STATUS_BROKE | SP_STATUS_HALT);
+    finish_sp_task(sp, sp_delay_time, 0);
 }
 
 void rsp_interrupt_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
 
+    /* this is the event queued for the async task, which may turn out
+     * not to raise an interrupt after all */
+    if (sp->async.pending && !complete_async_task(sp, 0))
+        return;
+
     if (!sp->rsp_task_locked)
     {
         sp->regs[SP_STATUS_REG] |=
@@ -420,5 +668,8 @@ void rsp_interrupt_event(void* opaque)
 void rsp_end_of_dma_event(void* opaque)
 {
     struct rsp_core* sp = (struct rsp_core*)opaque;
+
+    /* the queued DMA writes SP memory and SP_STATUS */
+    rsp_wait_task(sp);
     fifo_pop(sp);
 }
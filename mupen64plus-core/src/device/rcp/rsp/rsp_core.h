@@ -22,8 +22,10 @@
 #ifndef M64P_DEVICE_RCP_RSP_RSP_CORE_H
 #define M64P_DEVICE_RCP_RSP_RSP_CORE_H
 
+#include <pthread.h>
 #include <stdint.h>
 
+#include "device/memory/memory.h"
 #include "osal/preproc.h"
 
 struct mi_controller;
@@ -91,12 +93,37 @@ struct sp_dma
     uint32_t dramaddr;
 };
 
+/* 64k memory mapping blocks of the largest RDRAM */
+enum { SP_HAZARD_BLOCKS = 0x80 };
+
+/* HLE audio task running on a worker thread while the r4300 keeps going.
+ * Any access to SP state, audio DMA or the task's RDRAM ranges waits for it. */
+struct rsp_async_task
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int thread_created;
+    int busy;
+    int quit;
+
+    int pending;
+    uint32_t save_pc;
+    /* the task's MI_INTR and SP_STATUS writes, merged on completion */
+    uint32_t mi_intr;
+    uint32_t sp_status;
+    /* RDRAM blocks the task may access, and the handlers they had */
+    uint8_t hazard[SP_HAZARD_BLOCKS];
+    struct mem_handler saved_handlers[SP_HAZARD_BLOCKS];
+};
+
 struct rsp_core
 {
     uint32_t* mem;
     uint32_t regs[SP_REGS_COUNT];
     uint32_t regs2[SP_REGS2_COUNT];
     uint32_t rsp_task_locked;
+    struct rsp_async_task async;
 
     struct mi_controller* mi;
     struct rdp_core* dp;
@@ -126,6 +153,16 @@ void init_rsp(struct rsp_core* sp,
               struct ri_controller* ri);
 
 void poweron_rsp(struct rsp_core* sp);
+void poweroff_rsp(struct rsp_core* sp);
+
+void rsp_sync_task(struct rsp_core* sp);
+
+/* wait for an asynchronous RSP task before touching state it may modify */
+static osal_inline void rsp_wait_task(struct rsp_core* sp)
+{
+    if (sp->async.pending)
+        rsp_sync_task(sp);
+}
 
 void read_rsp_mem(void* opaque, uint32_t address, uint32_t* value);
 void write_rsp_mem(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
@@ -136,6 +173,9 @@ void write_rsp_regs(void* opaque, uint32_t address, uint32_t value, uint32_t mas
 void read_rsp_regs2(void* opaque, uint32_t address, uint32_t* value);
 void write_rsp_regs2(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
 
+void read_rdram_sp_hazard(void* opaque, uint32_t address, uint32_t* value);
+void write_rdram_sp_hazard(void* opaque, uint32_t address, uint32_t value, uint32_t mask);
+
 void do_SP_Task(struct rsp_core* sp);
 
 void rsp_interrupt_event(void* opaque);
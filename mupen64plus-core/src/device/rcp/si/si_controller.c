@@ -31,6 +31,7 @@
 #include "device/rcp/mi/mi_controller.h"
 #include "device/rcp/ri/ri_controller.h"
 #include "device/rdram/rdram.h"
+#include "device/rcp/rsp/rsp_core.h"
 #include "osal/preproc.h"
 
 static int validate_dma(struct si_controller* si, uint32_t reg)
@@ -59,6 +60,8 @@ static void copy_pif_rdram(struct si_controller* si)
     uint32_t* pif_ram = (uint32_t*)si->pif->ram;
     uint32_t* dram = (uint32_t*)(&si->ri->rdram->dram[rdram_dram_address(dram_addr)]);
 
+    rsp_wait_task(si->sp);
+
     if (si->dma_dir == SI_DMA_WRITE) {
         for(i = 0; i < (PIF_RAM_SIZE / 4); ++i) {
             pif_ram[i] = fromhl(dram[i]);
@@ -103,12 +106,14 @@ void init_si(struct si_controller* si,
              unsigned int dma_duration,
              struct mi_controller* mi,
              struct pif* pif,
-             struct ri_controller* ri)
+             struct ri_controller* ri,
+             struct rsp_core* sp)
 {
     si->dma_duration = dma_duration;
     si->mi = mi;
     si->pif = pif;
     si->ri = ri;
+    si->sp = sp;
 }
 
 void poweron_si(struct si_controller* si)
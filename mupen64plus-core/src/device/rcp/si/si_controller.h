@@ -28,6 +28,7 @@
 
 struct mi_controller;
 struct ri_controller;
+struct rsp_core;
 struct pif;
 
 enum si_dma_dir
@@ -68,6 +69,7 @@ struct si_controller
     struct mi_controller* mi;
     struct pif* pif;
     struct ri_controller* ri;
+    struct rsp_core* sp;
 };
 
 static osal_inline uint32_t si_reg(uint32_t address)
@@ -80,7 +82,8 @@ void init_si(struct si_controller* si,
              unsigned int dma_duration,
              struct mi_controller* mi,
              struct pif* pif,
-             struct ri_controller* ri);
+             struct ri_controller* ri,
+             struct rsp_core* sp);
 
 void poweron_si(struct si_controller* si);
 
@@ -28,6 +28,7 @@
 #include "device/r4300/r4300_core.h"
 #include "device/rcp/mi/mi_controller.h"
 #include "main/main.h"
+#include "main/profile.h"
 #include "plugin/plugin.h"
 #include <mupen64plus-next_common.h>
 
@@ -170,7 +171,11 @@ void vi_vertical_interrupt_event(void* opaque)
     if (vi->dp->do_on_unfreeze & DELAY_DP_INT)
         vi->dp->do_on_unfreeze |= DELAY_UPDATESCREEN;
     else
+    {
+        timed_section_start(TIMED_SECTION_VI);
         gfx.updateScreen();
+        timed_section_end(TIMED_SECTION_VI);
+    }
 
     /* allow main module to do things on VI event */
     new_vi();
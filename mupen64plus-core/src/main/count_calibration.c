@@ -0,0 +1,131 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - count_calibration.c                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "count_calibration.h"
+
+#include <string.h>
+
+/* VIs per measurement, about a second */
+enum { CALIBRATION_WINDOW_VIS = 60 };
+/* busy per mille above which the game is short of instructions */
+enum { CALIBRATION_BUSY_HIGH = 950 };
+/* a higher count_per_op must keep the busy time it would lead to below this */
+enum { CALIBRATION_BUSY_TARGET = 800 };
+/* windows in a row asking for the same change before it's made */
+enum { CALIBRATION_HYSTERESIS = 3 };
+/* a longer VI means COUNT jumped, e.g. a state was loaded */
+enum { CALIBRATION_MAX_VI_CYCLES = 1 << 24 };
+/* windows without a change, or changes, after which the value is locked */
+enum { CALIBRATION_SETTLE_WINDOWS = 30 };
+enum { CALIBRATION_MAX_CHANGES = 6 };
+
+void count_calibration_start(struct count_calibration* cal, unsigned int count_per_op,
+                             unsigned int min_count_per_op, unsigned int max_count_per_op,
+                             uint32_t count, uint32_t idle_count)
+{
+    memset(cal, 0, sizeof(*cal));
+
+    if (count_per_op < min_count_per_op)
+        count_per_op = min_count_per_op;
+    if (count_per_op > max_count_per_op)
+        count_per_op = max_count_per_op;
+
+    cal->state = COUNT_CALIBRATION_MEASURING;
+    cal->count_per_op = count_per_op;
+    cal->initial_count_per_op = count_per_op;
+    cal->min_count_per_op = min_count_per_op;
+    cal->max_count_per_op = max_count_per_op;
+    cal->last_count = count;
+    cal->last_idle_count = idle_count;
+    cal->busy = 1000;
+}
+
+void count_calibration_lock(struct count_calibration* cal)
+{
+    if (cal->state == COUNT_CALIBRATION_MEASURING)
+        cal->state = COUNT_CALIBRATION_LOCKED;
+}
+
+unsigned int count_calibration_vi(struct count_calibration* cal, uint32_t count, uint32_t idle_count)
+{
+    uint32_t vi_cycles = count - cal->last_count;
+    uint32_t vi_idle_cycles = idle_count - cal->last_idle_count;
+    unsigned int busy;
+
+    if (cal->state != COUNT_CALIBRATION_MEASURING)
+        return cal->count_per_op;
+
+    cal->last_count = count;
+    cal->last_idle_count = idle_count;
+    if (vi_cycles > CALIBRATION_MAX_VI_CYCLES) {
+        cal->vis = 0;
+        cal->cycles = 0;
+        cal->idle_cycles = 0;
+        return cal->count_per_op;
+    }
+
+    /* both counters wrap */
+    cal->cycles += vi_cycles;
+    cal->idle_cycles += vi_idle_cycles;
+
+    if (++cal->vis < CALIBRATION_WINDOW_VIS)
+        return cal->count_per_op;
+
+    if (cal->idle_cycles >= cal->cycles)
+        busy = 0;
+    else
+        busy = (unsigned int)(1000 - cal->idle_cycles * 1000 / cal->cycles);
+    cal->busy = busy;
+    cal->vis = 0;
+    cal->cycles = 0;
+    cal->idle_cycles = 0;
+
+    /* Instructions per VI scale with 1 / count_per_op */
+    if (busy >= CALIBRATION_BUSY_HIGH && cal->count_per_op > cal->min_count_per_op) {
+        ++cal->busy_windows;
+        cal->idle_windows = 0;
+    }
+    else if (cal->count_per_op < cal->max_count_per_op
+          && busy * (cal->count_per_op + 1) < CALIBRATION_BUSY_TARGET * cal->count_per_op) {
+        ++cal->idle_windows;
+        cal->busy_windows = 0;
+    }
+    else {
+        cal->busy_windows = 0;
+        cal->idle_windows = 0;
+    }
+
+    if (cal->busy_windows >= CALIBRATION_HYSTERESIS || cal->idle_windows >= CALIBRATION_HYSTERESIS) {
+        if (cal->busy_windows)
+            --cal->count_per_op;
+        else
+            ++cal->count_per_op;
+        cal->busy_windows = 0;
+        cal->idle_windows = 0;
+        cal->stable_windows = 0;
+        if (++cal->changes >= CALIBRATION_MAX_CHANGES)
+            cal->state = COUNT_CALIBRATION_LOCKED;
+    }
+    else if (++cal->stable_windows >= CALIBRATION_SETTLE_WINDOWS) {
+        cal->state = COUNT_CALIBRATION_LOCKED;
+    }
+
+    return cal->count_per_op;
+}
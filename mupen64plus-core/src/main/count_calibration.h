@@ -0,0 +1,79 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - count_calibration.h                                     *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_COUNT_CALIBRATION_H
+#define M64P_MAIN_COUNT_CALIBRATION_H
+
+#include <stdint.h>
+
+/* Picks count_per_op from how busy the game keeps the CPU.
+ *
+ * Every VI the COUNT cycles elapsed are compared to the cycles the CPU
+ * spent in idle loops, which the cores skip. A game which never idles is
+ * short of instructions and gets a lower count_per_op, one which idles most
+ * of the frame even at a higher count_per_op gets that, saving host time.
+ * A change needs several windows in a row pointing the same way, and the
+ * value is locked once it held long enough or changed too often. */
+
+enum count_calibration_state
+{
+    COUNT_CALIBRATION_OFF,
+    COUNT_CALIBRATION_MEASURING,
+    COUNT_CALIBRATION_LOCKED
+};
+
+struct count_calibration
+{
+    enum count_calibration_state state;
+    unsigned int count_per_op;
+    unsigned int initial_count_per_op;
+    unsigned int min_count_per_op;
+    unsigned int max_count_per_op;
+
+    /* current window */
+    unsigned int vis;
+    uint32_t last_count;
+    uint32_t last_idle_count;
+    uint64_t cycles;
+    uint64_t idle_cycles;
+
+    /* consecutive windows asking for a lower / higher value */
+    unsigned int busy_windows;
+    unsigned int idle_windows;
+    unsigned int stable_windows;
+    unsigned int changes;
+    /* per mille of the last window the CPU wasn't idle */
+    unsigned int busy;
+};
+
+/* Starts measuring at count_per_op, which is kept within [min, max] */
+void count_calibration_start(struct count_calibration* cal, unsigned int count_per_op,
+                             unsigned int min_count_per_op, unsigned int max_count_per_op,
+                             uint32_t count, uint32_t idle_count);
+
+/* Leaves count_per_op as it is from now on */
+void count_calibration_lock(struct count_calibration* cal);
+
+/* Call on each VI with the current COUNT and idle cycle counter.
+ * Returns the count_per_op to run with. A window in which COUNT jumps
+ * is dropped. */
+unsigned int count_calibration_vi(struct count_calibration* cal, uint32_t count, uint32_t idle_count);
+
+#endif /* M64P_MAIN_COUNT_CALIBRATION_H */
@@ -54,6 +54,7 @@
 #include "backends/clock_ctime_plus_delta.h"
 #include "backends/file_storage.h"
 #include "cheat.h"
+#include "count_calibration.h"
 #include "device/device.h"
 #include "device/dd/disk.h"
 #include "device/controllers/vru_controller.h"
@@ -67,9 +68,8 @@
 #include "main.h"
 #include "callbacks.h"
 #include "plugin/plugin.h"
-#if defined(PROFILE)
+#include "plugin/emulate_game_controller_via_input_plugin.h"
 #include "profile.h"
-#endif
 #include "rom.h"
 #include "savestates.h"
 #include "screenshot.h"
@@ -150,6 +150,11 @@ static size_t l_pak_type_idx[6];
 /* PRNG state - used for Mempaks ID generation */
 struct xoshiro256pp_state l_mpk_idgen;
 
+/* count_per_op picked from the measured workload, if enabled */
+static struct count_calibration l_count_calibration;
+static int l_count_calibration_pending;
+static unsigned int l_database_count_per_op;
+
 /*********************************************************************************************************
 * static functions
 */
@@ -256,10 +261,16 @@ static void main_check_inputs(void)
 #ifdef WITH_LIRC
     lircCheckInput();
 #endif
-    if(!(current_rdp_type == RDP_PLUGIN_GLIDEN64 && EnableThreadedRenderer))
+    // Input Polling will be forced to early if Threaded GLideN64
+    int can_poll = !(current_rdp_type == RDP_PLUGIN_GLIDEN64 && EnableThreadedRenderer);
+
+    /* with late latching the first controller read of the next frame polls */
+    if (!egcvip_new_frame(can_poll) && can_poll)
     {
-        // Input Polling will be forced to early if Threaded GLideN64
+        timed_section_start(TIMED_SECTION_INPUT);
         poll_cb();
+        profile_input_polled();
+        timed_section_end(TIMED_SECTION_INPUT);
     }
 }
 
@@ -812,16 +823,53 @@ static void pause_loop(void)
     }
 }
 
+static void main_count_calibration_vi(void)
+{
+    struct r4300_core* r4300 = &g_dev.r4300;
+    const uint32_t* cp0_regs = r4300_cp0_regs(&r4300->cp0);
+    enum count_calibration_state state = l_count_calibration.state;
+    unsigned int count_per_op;
+
+    /* start on the first VI, once COUNT runs */
+    if (l_count_calibration_pending) {
+        l_count_calibration_pending = 0;
+        count_calibration_start(&l_count_calibration, r4300->cp0.count_per_op,
+            1, (r4300->cp0.count_per_op > 3) ? r4300->cp0.count_per_op : 3,
+            cp0_regs[CP0_COUNT_REG], r4300->cp0.idle_count);
+        r4300_set_count_per_op(r4300, l_count_calibration.count_per_op);
+        return;
+    }
+
+    if (state != COUNT_CALIBRATION_MEASURING)
+        return;
+
+    count_per_op = count_calibration_vi(&l_count_calibration, cp0_regs[CP0_COUNT_REG], r4300->cp0.idle_count);
+    r4300_set_count_per_op(r4300, count_per_op);
+
+    if (l_count_calibration.state == COUNT_CALIBRATION_LOCKED) {
+        DebugMessage(M64MSG_INFO, "CountPerOp calibrated to %u (database %u, %u%% busy), for the ini: CountPerOp=%u",
+            count_per_op, l_database_count_per_op, l_count_calibration.busy / 10, count_per_op);
+    }
+}
+
+const struct count_calibration* main_count_calibration(void)
+{
+    return &l_count_calibration;
+}
+
 /* called on vertical interrupt.
  * Allow the core to perform various things */
 void new_vi(void)
 {
-#if defined(PROFILE)
+    /* keep frame boundaries deterministic */
+    rsp_wait_task(&g_dev.sp);
+
     timed_sections_refresh();
-#endif
 
     gs_apply_cheats(&g_cheat_ctx);
 
+    main_count_calibration_vi();
+
     // apply_speed_limiter();
     main_check_inputs();
 
@@ -1431,9 +1479,24 @@ m64p_error main_run(void)
 
     si_dma_duration = ROM_SETTINGS.sidmaduration;
 
+#ifdef NEW_DYNAREC
+    /* An explicit No in the ROM database wins over the core option */
+    if (ROM_SETTINGS.idleloopskip == IDLE_LOOP_SKIP_NO)
+        new_dynarec_set_idle_loop_skip(0);
+    else
+        new_dynarec_set_idle_loop_skip(IdleLoopSkip || ROM_SETTINGS.idleloopskip == IDLE_LOOP_SKIP_YES);
+#endif
+
     //During netplay, player 1 is the source of truth for these settings
     netplay_sync_settings(&count_per_op, &count_per_op_denom_pot, &disable_extra_mem, &si_dma_duration, &emumode, &no_compiled_jump);
 
+    /* Only the database value is calibrated, and neither overclocked nor
+     * under netplay, where each side would pick its own */
+    memset(&l_count_calibration, 0, sizeof(l_count_calibration));
+    l_database_count_per_op = ROM_SETTINGS.countperop;
+    l_count_calibration_pending = CountPerOpCalibration && CountPerOp == 0
+        && count_per_op_denom_pot == 0 && !netplay_is_init();
+
     rdram_size = (disable_extra_mem == 0) ? 0x800000 : 0x400000;
 
     cheat_add_hacks(&g_cheat_ctx, ROM_PARAMS.cheats);
@@ -1728,6 +1791,8 @@ m64p_error main_run(void)
     pif_bootrom_hle_execute(&g_dev.r4300);
 
     run_device(&g_dev);
+    poweroff_rsp(&g_dev.sp);
+    poweroff_tlb(&g_dev.r4300.cp0.tlb);
 
     /* release gb_carts */
     for(i = 0; i < GAME_CONTROLLERS_COUNT; ++i) {
@@ -62,6 +62,9 @@ const char* get_savestatefilename(void);
 void new_frame(void);
 void new_vi(void);
 
+struct count_calibration;
+const struct count_calibration* main_count_calibration(void);
+
 void main_switch_next_pak(int control_id);
 void main_switch_plugin_pak(int control_id);
 void main_change_gb_cart(int control_id);
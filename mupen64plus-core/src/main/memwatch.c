@@ -0,0 +1,289 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - memwatch.c                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "memwatch.h"
+
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+enum { MEMWATCH_LANES = 4 };
+
+#define SIGN_BIAS UINT32_C(0x80000000)
+
+/* Comparators as lane masks:
+ * state = ((eq & sel_eq) | (lt & sel_lt) | (gt & sel_gt)) ^ invert */
+static const struct
+{
+    uint32_t sel_eq;
+    uint32_t sel_lt;
+    uint32_t sel_gt;
+    uint32_t invert;
+    uint32_t track_value;
+} cmp_table[] = {
+    /* MEMWATCH_CHANGED */ { 0,          0,          0,          0,          UINT32_MAX },
+    /* MEMWATCH_EQ */      { UINT32_MAX, 0,          0,          0,          0 },
+    /* MEMWATCH_NE */      { UINT32_MAX, 0,          0,          UINT32_MAX, 0 },
+    /* MEMWATCH_LT */      { 0,          UINT32_MAX, 0,          0,          0 },
+    /* MEMWATCH_LE */      { 0,          0,          UINT32_MAX, UINT32_MAX, 0 },
+    /* MEMWATCH_GT */      { 0,          0,          UINT32_MAX, 0,          0 },
+    /* MEMWATCH_GE */      { 0,          UINT32_MAX, 0,          UINT32_MAX, 0 },
+};
+
+/* Watches are kept as a structure of arrays, padded to whole vectors.
+ * A naturally aligned watch always lies within one host RDRAM word, so it
+ * is compared in place: the word is masked to the watched bits and compared
+ * against the operand shifted to the same bits, which keeps the unsigned
+ * order. Only reported values are ever shifted down. */
+struct memwatch
+{
+    size_t count;
+    size_t padded;
+    uint32_t* table;
+
+    uint32_t* word;
+    uint32_t* shift;
+    uint32_t* mask;
+    /* xored with SIGN_BIAS, as SSE2 only has signed compares */
+    uint32_t* operand;
+    uint32_t* sel_eq;
+    uint32_t* sel_lt;
+    uint32_t* sel_gt;
+    uint32_t* invert;
+    uint32_t* track_value;
+
+    /* masked words and comparison results of the last poll */
+    uint32_t* current;
+    uint32_t* state;
+    /* as last reported, pending is set until the first report */
+    uint32_t* reported_value;
+    uint32_t* reported_state;
+    uint32_t* pending;
+};
+
+enum { MEMWATCH_ARRAYS = 14 };
+
+struct memwatch* memwatch_create(void)
+{
+    return (struct memwatch*)calloc(1, sizeof(struct memwatch));
+}
+
+void memwatch_destroy(struct memwatch* mw)
+{
+    if (mw == NULL) {
+        return;
+    }
+
+    free(mw->table);
+    free(mw);
+}
+
+void memwatch_clear(struct memwatch* mw)
+{
+    free(mw->table);
+    mw->table = NULL;
+    mw->count = 0;
+    mw->padded = 0;
+}
+
+static int memwatch_expr_is_valid(const struct memwatch_expr* expr, size_t dram_size)
+{
+    uint32_t address = expr->address & UINT32_C(0x1fffffff);
+
+    if (expr->width != 1 && expr->width != 2 && expr->width != 4) {
+        return 0;
+    }
+
+    if (expr->cmp > MEMWATCH_GE) {
+        return 0;
+    }
+
+    return (address & (expr->width - 1)) == 0
+        && (size_t)address + expr->width <= dram_size;
+}
+
+int memwatch_set(struct memwatch* mw, const struct memwatch_expr* exprs, size_t count, size_t dram_size)
+{
+    size_t i;
+    size_t padded = (count + MEMWATCH_LANES - 1) & ~(size_t)(MEMWATCH_LANES - 1);
+    uint32_t* table;
+
+    for (i = 0; i < count; ++i) {
+        if (!memwatch_expr_is_valid(&exprs[i], dram_size)) {
+            return 0;
+        }
+    }
+
+    table = NULL;
+    if (padded != 0) {
+        /* padding lanes watch no bits and track their value, so they never change */
+        table = (uint32_t*)calloc(padded * MEMWATCH_ARRAYS, sizeof(uint32_t));
+        if (table == NULL) {
+            return 0;
+        }
+    }
+
+    free(mw->table);
+    mw->table = table;
+    mw->count = count;
+    mw->padded = padded;
+
+    mw->word           = table + 0 * padded;
+    mw->shift          = table + 1 * padded;
+    mw->mask           = table + 2 * padded;
+    mw->operand        = table + 3 * padded;
+    mw->sel_eq         = table + 4 * padded;
+    mw->sel_lt         = table + 5 * padded;
+    mw->sel_gt         = table + 6 * padded;
+    mw->invert         = table + 7 * padded;
+    mw->track_value    = table + 8 * padded;
+    mw->current        = table + 9 * padded;
+    mw->state          = table + 10 * padded;
+    mw->reported_value = table + 11 * padded;
+    mw->reported_state = table + 12 * padded;
+    mw->pending        = table + 13 * padded;
+
+    for (i = 0; i < padded; ++i) {
+        mw->operand[i] = SIGN_BIAS;
+        mw->track_value[i] = UINT32_MAX;
+    }
+
+    for (i = 0; i < count; ++i) {
+        const struct memwatch_expr* expr = &exprs[i];
+        uint32_t address = expr->address & UINT32_C(0x1fffffff);
+        uint32_t width_mask = (expr->width == 4) ? UINT32_MAX : ((UINT32_C(1) << (expr->width * 8)) - 1);
+        uint32_t mask = width_mask & (expr->mask ? expr->mask : UINT32_MAX);
+
+        /* N64 memory is big endian, so lower addresses are the upper bits of a word */
+        uint32_t shift = (4 - expr->width - (address & 3)) * 8;
+
+        mw->word[i]        = address >> 2;
+        mw->shift[i]       = shift;
+        mw->mask[i]        = mask << shift;
+        mw->operand[i]     = ((expr->value & mask) << shift) ^ SIGN_BIAS;
+        mw->sel_eq[i]      = cmp_table[expr->cmp].sel_eq;
+        mw->sel_lt[i]      = cmp_table[expr->cmp].sel_lt;
+        mw->sel_gt[i]      = cmp_table[expr->cmp].sel_gt;
+        mw->invert[i]      = cmp_table[expr->cmp].invert;
+        mw->track_value[i] = cmp_table[expr->cmp].track_value;
+        mw->pending[i]     = UINT32_MAX;
+    }
+
+    return 1;
+}
+
+/* Evaluates the watches from i on, returns a bit per changed lane */
+#if defined(__SSE2__)
+static unsigned int memwatch_eval_lanes(struct memwatch* mw, size_t i)
+{
+#define LOAD(array) _mm_loadu_si128((const __m128i*)&mw->array[i])
+    const __m128i bias = _mm_set1_epi32((int)SIGN_BIAS);
+    __m128i current = LOAD(current);
+    __m128i biased = _mm_xor_si128(current, bias);
+    __m128i operand = LOAD(operand);
+    __m128i track_value = LOAD(track_value);
+
+    __m128i eq = _mm_and_si128(_mm_cmpeq_epi32(biased, operand), LOAD(sel_eq));
+    __m128i lt = _mm_and_si128(_mm_cmplt_epi32(biased, operand), LOAD(sel_lt));
+    __m128i gt = _mm_and_si128(_mm_cmpgt_epi32(biased, operand), LOAD(sel_gt));
+    __m128i state = _mm_xor_si128(_mm_or_si128(eq, _mm_or_si128(lt, gt)), LOAD(invert));
+    _mm_storeu_si128((__m128i*)&mw->state[i], state);
+
+    __m128i value_kept = _mm_cmpeq_epi32(current, LOAD(reported_value));
+    __m128i value_changed = _mm_andnot_si128(value_kept, track_value);
+    __m128i state_changed = _mm_andnot_si128(track_value, _mm_xor_si128(state, LOAD(reported_state)));
+    __m128i changed = _mm_or_si128(LOAD(pending), _mm_or_si128(value_changed, state_changed));
+#undef LOAD
+
+    return (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(changed));
+}
+#else
+static unsigned int memwatch_eval_lanes(struct memwatch* mw, size_t i)
+{
+    unsigned int lanes = 0;
+    size_t j;
+
+    for (j = i; j < i + MEMWATCH_LANES; ++j) {
+        uint32_t biased = mw->current[j] ^ SIGN_BIAS;
+        uint32_t eq = (biased == mw->operand[j]) ? mw->sel_eq[j] : 0;
+        uint32_t lt = ((int32_t)biased < (int32_t)mw->operand[j]) ? mw->sel_lt[j] : 0;
+        uint32_t gt = ((int32_t)biased > (int32_t)mw->operand[j]) ? mw->sel_gt[j] : 0;
+        uint32_t changed;
+
+        mw->state[j] = (eq | lt | gt) ^ mw->invert[j];
+
+        if (mw->track_value[j]) {
+            changed = mw->current[j] != mw->reported_value[j];
+        } else {
+            changed = mw->state[j] != mw->reported_state[j];
+        }
+
+        if (changed || mw->pending[j]) {
+            lanes |= 1u << (j - i);
+        }
+    }
+
+    return lanes;
+}
+#endif
+
+size_t memwatch_poll(struct memwatch* mw, const uint32_t* dram,
+                     struct memwatch_result* results, size_t max_results)
+{
+    size_t i;
+    size_t changes = 0;
+
+    for (i = 0; i < mw->count; ++i) {
+        mw->current[i] = dram[mw->word[i]] & mw->mask[i];
+    }
+
+    for (i = 0; i < mw->padded; i += MEMWATCH_LANES) {
+        unsigned int lanes = memwatch_eval_lanes(mw, i);
+        unsigned int lane;
+
+        if (lanes == 0) {
+            continue;
+        }
+
+        for (lane = 0; lane < MEMWATCH_LANES; ++lane) {
+            size_t j = i + lane;
+
+            if (!(lanes & (1u << lane)) || j >= mw->count) {
+                continue;
+            }
+
+            if (changes < max_results) {
+                struct memwatch_result* result = &results[changes];
+                result->index = (uint32_t)j;
+                result->value = mw->current[j] >> mw->shift[j];
+                result->state = mw->state[j] != 0;
+
+                mw->reported_value[j] = mw->current[j];
+                mw->reported_state[j] = mw->state[j];
+                mw->pending[j] = 0;
+            }
+            ++changes;
+        }
+    }
+
+    return changes;
+}
@@ -0,0 +1,85 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - memwatch.h                                              *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_MEMWATCH_H
+#define M64P_MAIN_MEMWATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Watches over RDRAM for achievement checks and RAM search, evaluated in
+ * one pass over the host RDRAM words. Addresses are N64 addresses, the
+ * byte swapping of RDRAM on little endian hosts is handled here. */
+
+enum memwatch_cmp
+{
+    /* reports the value whenever it changes */
+    MEMWATCH_CHANGED,
+    /* unsigned comparisons against memwatch_expr.value,
+     * reported whenever their result changes */
+    MEMWATCH_EQ,
+    MEMWATCH_NE,
+    MEMWATCH_LT,
+    MEMWATCH_LE,
+    MEMWATCH_GT,
+    MEMWATCH_GE
+};
+
+struct memwatch_expr
+{
+    /* physical or KSEG0/KSEG1 address, aligned to width */
+    uint32_t address;
+    /* 1, 2 or 4 bytes */
+    uint8_t width;
+    /* enum memwatch_cmp */
+    uint8_t cmp;
+    /* bits of the value to look at, 0 for all of them */
+    uint32_t mask;
+    uint32_t value;
+};
+
+struct memwatch_result
+{
+    /* index of the watch in the list given to memwatch_set */
+    uint32_t index;
+    /* masked value */
+    uint32_t value;
+    /* result of the comparison, always 0 for MEMWATCH_CHANGED */
+    uint8_t state;
+};
+
+struct memwatch;
+
+struct memwatch* memwatch_create(void);
+void memwatch_destroy(struct memwatch* mw);
+
+/* Replaces all watches. Fails without changing anything if an expression
+ * is out of range of dram_size or misaligned. */
+int memwatch_set(struct memwatch* mw, const struct memwatch_expr* exprs, size_t count, size_t dram_size);
+void memwatch_clear(struct memwatch* mw);
+
+/* Returns the number of watches which changed since they were last
+ * reported, and writes up to max_results of them. The first poll after
+ * memwatch_set reports every watch. Watches that don't fit are reported
+ * by the next poll. */
+size_t memwatch_poll(struct memwatch* mw, const uint32_t* dram,
+                     struct memwatch_result* results, size_t max_results);
+
+#endif
@@ -23,12 +23,58 @@
 
 #include "profile.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #include "api/callbacks.h"
 #include "api/m64p_types.h"
 
 static long long int time_in_section[NUM_TIMED_SECTIONS];
 static long long int last_start[NUM_TIMED_SECTIONS];
 
+struct profile_event
+{
+    long long int start;
+    long long int end;
+    uint32_t frame;
+    uint8_t section;
+};
+
+#if defined(PROFILE)
+static int l_enabled = 1;
+#else
+static int l_enabled = 0;
+#endif
+static unsigned int l_depth;
+static long long int l_epoch;
+static long long int l_frame_start;
+static long long int l_toplevel_time;
+static struct profile_frame_stats l_current;
+static struct profile_frame_stats l_frames[PROFILE_FRAME_HISTORY];
+static uint32_t l_frame_count;
+static struct profile_event l_events[PROFILE_EVENT_HISTORY];
+static uint32_t l_event_count;
+/* last poll of the frontend, the one the current frame's input comes from
+ * and the one of the frame waiting to be presented */
+static long long int l_input_poll;
+static long long int l_input_used;
+static long long int l_input_presented;
+
+static const char* const l_section_names[NUM_TIMED_SECTIONS] =
+{
+    "all",
+    "rsp_gfx",
+    "rsp_audio",
+    "compiler",
+    "idle",
+    "rsp_other",
+    "rdp",
+    "vi_update",
+    "audio_resample",
+    "savestate",
+    "input_poll"
+};
+
 #if defined(WIN32) && !defined(__MINGW32__)
   // timing
   #include <windows.h>
@@ -63,20 +109,109 @@ static long long int last_start[NUM_TIMED_SECTIONS];
   }
 #endif
 
+void profile_reset(void)
+{
+   memset(time_in_section, 0, sizeof(time_in_section));
+   memset(last_start, 0, sizeof(last_start));
+   memset(&l_current, 0, sizeof(l_current));
+   l_depth = 0;
+   l_toplevel_time = 0;
+   l_frame_count = 0;
+   l_event_count = 0;
+   l_input_poll = l_input_used = l_input_presented = 0;
+   l_epoch = l_frame_start = get_time();
+}
+
+void profile_set_enabled(int enabled)
+{
+   if (!enabled == !l_enabled)
+      return;
+
+   if (enabled)
+      profile_reset();
+
+   l_enabled = enabled;
+}
+
+int profile_is_enabled(void)
+{
+   return l_enabled;
+}
+
+const char* timed_section_name(enum timed_section section)
+{
+   return (section < NUM_TIMED_SECTIONS) ? l_section_names[section] : "unknown";
+}
+
 void timed_section_start(enum timed_section section)
 {
+   if (!l_enabled)
+      return;
+
    last_start[section] = get_time();
+   ++l_depth;
 }
 
 void timed_section_end(enum timed_section section)
 {
-   long long int end = get_time();
-   time_in_section[section] += end - last_start[section];
+   long long int end, elapsed;
+   struct profile_event* event;
+
+   /* ignore sections which were opened before profiling got enabled */
+   if (!l_enabled || last_start[section] == 0)
+      return;
+
+   end = get_time();
+   elapsed = end - last_start[section];
+   time_in_section[section] += elapsed;
+
+   l_current.time_in_section[section] += time_to_nsec(elapsed);
+   l_current.count_in_section[section]++;
+
+   /* only top level sections are subtracted from the frame to obtain cpu time */
+   if (l_depth > 0 && --l_depth == 0)
+      l_toplevel_time += elapsed;
+
+   event = &l_events[l_event_count % PROFILE_EVENT_HISTORY];
+   event->start = last_start[section];
+   event->end = end;
+   event->frame = l_frame_count;
+   event->section = (uint8_t)section;
+   ++l_event_count;
+
+   last_start[section] = 0;
+}
+
+static void profile_end_frame(long long int curr_time)
+{
+   l_current.frame = l_frame_count;
+   l_current.start = time_to_nsec(l_frame_start - l_epoch);
+   l_current.duration = time_to_nsec(curr_time - l_frame_start);
+   l_current.cpu = time_to_nsec(curr_time - l_frame_start - l_toplevel_time);
+   l_current.input_latency = -1;
+
+   l_frames[l_frame_count % PROFILE_FRAME_HISTORY] = l_current;
+   ++l_frame_count;
+
+   memset(&l_current, 0, sizeof(l_current));
+   l_toplevel_time = 0;
+   l_frame_start = curr_time;
+
+   l_input_presented = l_input_used;
+   l_input_used = 0;
 }
 
 void timed_sections_refresh()
 {
-   long long int curr_time = get_time();
+   long long int curr_time;
+
+   if (!l_enabled)
+      return;
+
+   curr_time = get_time();
+   profile_end_frame(curr_time);
+
+#if defined(PROFILE)
    if(time_to_nsec(curr_time - last_start[TIMED_SECTION_ALL]) >= 2000000000)
    {
       time_in_section[TIMED_SECTION_ALL] = curr_time - last_start[TIMED_SECTION_ALL];
@@ -96,4 +231,90 @@ void timed_sections_refresh()
       time_in_section[TIMED_SECTION_IDLE] = 0;
       last_start[TIMED_SECTION_ALL] = curr_time;
    }
+#endif
+}
+
+void profile_input_polled(void)
+{
+   if (!l_enabled)
+      return;
+
+   l_input_poll = get_time();
+}
+
+void profile_input_sampled(void)
+{
+   if (!l_enabled || l_input_used != 0)
+      return;
+
+   l_input_used = l_input_poll;
+}
+
+void profile_frame_presented(void)
+{
+   if (!l_enabled || l_frame_count == 0)
+      return;
+
+   if (l_input_presented != 0)
+      l_frames[(l_frame_count - 1) % PROFILE_FRAME_HISTORY].input_latency = time_to_nsec(get_time() - l_input_presented);
+   l_input_presented = 0;
+}
+
+int profile_get_frame_stats(unsigned int frames_back, struct profile_frame_stats* stats)
+{
+   uint32_t available = (l_frame_count < PROFILE_FRAME_HISTORY) ? l_frame_count : PROFILE_FRAME_HISTORY;
+
+   if (stats == NULL || frames_back >= available)
+      return 0;
+
+   *stats = l_frames[(l_frame_count - 1 - frames_back) % PROFILE_FRAME_HISTORY];
+   return 1;
+}
+
+int profile_write_chrome_trace(const char* filepath)
+{
+   FILE* f;
+   uint32_t i, first, count;
+   const char* separator = "";
+
+   f = fopen(filepath, "w");
+   if (f == NULL)
+   {
+      DebugMessage(M64MSG_ERROR, "Couldn't open profile trace file '%s' for writing.", filepath);
+      return 0;
+   }
+
+   fprintf(f, "{\"traceEvents\":[\n");
+
+   count = (l_frame_count < PROFILE_FRAME_HISTORY) ? l_frame_count : PROFILE_FRAME_HISTORY;
+   first = l_frame_count - count;
+   for (i = first; i < l_frame_count; ++i)
+   {
+      const struct profile_frame_stats* frame = &l_frames[i % PROFILE_FRAME_HISTORY];
+      fprintf(f, "%s{\"name\":\"frame\",\"cat\":\"core\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u,\"cpu_us\":%.3f,\"input_latency_us\":%.3f}}",
+              separator, frame->start / 1000.0, frame->duration / 1000.0,
+              frame->frame, frame->cpu / 1000.0,
+              (frame->input_latency >= 0) ? frame->input_latency / 1000.0 : -1.0);
+      separator = ",\n";
+   }
+
+   count = (l_event_count < PROFILE_EVENT_HISTORY) ? l_event_count : PROFILE_EVENT_HISTORY;
+   first = l_event_count - count;
+   for (i = first; i < l_event_count; ++i)
+   {
+      const struct profile_event* event = &l_events[i % PROFILE_EVENT_HISTORY];
+      fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"core\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+              separator, timed_section_name((enum timed_section)event->section),
+              time_to_nsec(event->start - l_epoch) / 1000.0,
+              time_to_nsec(event->end - event->start) / 1000.0,
+              event->frame);
+      separator = ",\n";
+   }
+
+   fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+   fclose(f);
+
+   return 1;
 }
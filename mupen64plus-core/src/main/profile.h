@@ -24,6 +24,8 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
+#include <stdint.h>
+
 enum timed_section
 {
     TIMED_SECTION_ALL,
@@ -31,11 +33,54 @@ enum timed_section
     TIMED_SECTION_AUDIO,
     TIMED_SECTION_COMPILER,
     TIMED_SECTION_IDLE,
+    TIMED_SECTION_RSP,
+    TIMED_SECTION_RDP,
+    TIMED_SECTION_VI,
+    TIMED_SECTION_AUDIO_RESAMPLE,
+    TIMED_SECTION_SAVESTATE,
+    TIMED_SECTION_INPUT,
     NUM_TIMED_SECTIONS
 };
 
+/* Number of frames kept in the per-frame history ring */
+#define PROFILE_FRAME_HISTORY 512
+/* Number of individual section events kept for trace export */
+#define PROFILE_EVENT_HISTORY 16384
+
+struct profile_frame_stats
+{
+    uint32_t frame;
+    /* all times are in nanoseconds */
+    int64_t start;
+    int64_t duration;
+    /* time spent in the R4300 core and everything not covered by a section */
+    int64_t cpu;
+    int64_t time_in_section[NUM_TIMED_SECTIONS];
+    uint32_t count_in_section[NUM_TIMED_SECTIONS];
+    /* from the frontend poll the frame's controller input comes from to
+     * presenting the frame, -1 if the game didn't read its controllers
+     * or the frame wasn't presented */
+    int64_t input_latency;
+};
+
+void profile_set_enabled(int enabled);
+int profile_is_enabled(void);
+void profile_reset(void);
+
+const char* timed_section_name(enum timed_section section);
+
 void timed_section_start(enum timed_section section);
 void timed_section_end(enum timed_section section);
 void timed_sections_refresh(void);
 
+/* Input latency: the frontend polled its input, the game got a snapshot
+ * of it, the frame which ended last got presented. */
+void profile_input_polled(void);
+void profile_input_sampled(void);
+void profile_frame_presented(void);
+
+/* frames_back == 0 is the last completed frame */
+int profile_get_frame_stats(unsigned int frames_back, struct profile_frame_stats* stats);
+int profile_write_chrome_trace(const char* filepath);
+
 #endif
@@ -55,6 +55,8 @@ enum { DEFAULT_DISABLE_EXTRA_MEM = 0 };
 enum { DEFAULT_SI_DMA_DURATION = 0x900 };
 /* Default AI DMA modifier */
 enum { DEFAULT_AI_DMA_MODIFIER = 100 };
+/* by default, polling loops are only skipped when the frontend asks for it */
+enum { DEFAULT_IDLE_LOOP_SKIP = IDLE_LOOP_SKIP_UNSET };
 
 static romdatabase_entry* ini_search_by_md5(md5_byte_t* md5);
 
@@ -63,6 +65,13 @@ static _romdatabase g_romdatabase;
 /* Global loaded rom size. */
 int g_rom_size = 0;
 
+/* Lazily loaded ROM image, see open_rom_file */
+uint8_t* g_rom_pages = NULL;
+static const unsigned char* l_rom_image = NULL;
+static size_t l_rom_image_size = 0;
+static unsigned char l_rom_imagetype;
+static unsigned int l_rom_pages_left;
+
 m64p_rom_header   ROM_HEADER;
 rom_params        ROM_PARAMS;
 m64p_rom_settings ROM_SETTINGS;
@@ -76,7 +85,7 @@ static const uint8_t V64_SIGNATURE[4] = { 0x37, 0x80, 0x40, 0x12 };
 static const uint8_t N64_SIGNATURE[4] = { 0x40, 0x12, 0x37, 0x80 };
 
 /* Tests if a file is a valid N64 rom by checking the first 4 bytes and size */
-static int is_valid_rom(const unsigned char *buffer, unsigned int size)
+int is_valid_rom(const unsigned char *buffer, unsigned int size)
 {
     if ((memcmp(buffer, Z64_SIGNATURE, sizeof(Z64_SIGNATURE)) == 0)
      || (memcmp(buffer, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0 && size % 2 == 0)
@@ -86,43 +95,47 @@ static int is_valid_rom(const unsigned char *buffer, unsigned int size)
         return 0;
 }
 
+static unsigned char rom_image_type(const void* src)
+{
+    if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
+        return V64IMAGE;
+    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+        return N64IMAGE;
+    else
+        return Z64IMAGE;
+}
+
 /* Copies the source block of memory to the destination block of memory while
  * switching the endianness of .v64 and .n64 images to the .z64 format, which
  * is native to the Nintendo 64. The data extraction routines and MD5 hashing
  * function may only act on the .z64 big-endian format.
  *
- * IN: src: The source block of memory. This must be a valid Nintendo 64 ROM
- *          image of 'len' bytes.
+ * IN: src: The source block of memory, 'len' bytes of a Nintendo 64 ROM image
+ *          of the given 'imagetype'.
  *     len: The length of the source and destination, in bytes.
  * OUT: dst: The destination block of memory. This must be a valid buffer for
  *           at least 'len' bytes.
- *      imagetype: A pointer to a byte that gets updated with the value of
- *                 V64IMAGE, N64IMAGE or Z64IMAGE according to the format of
- *                 the source block. The value is undefined if 'src' does not
- *                 represent a valid Nintendo 64 ROM image.
  */
-static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
+static void swap_copy_rom_chunk(void* dst, const void* src, size_t len, unsigned char imagetype)
 {
-    if (memcmp(src, V64_SIGNATURE, sizeof(V64_SIGNATURE)) == 0)
+    if (imagetype == V64IMAGE)
     {
         size_t i;
         const uint16_t* src16 = (const uint16_t*) src;
         uint16_t* dst16 = (uint16_t*) dst;
 
-        *imagetype = V64IMAGE;
         /* .v64 images have byte-swapped half-words (16-bit). */
         for (i = 0; i < len; i += 2)
         {
             *dst16++ = m64p_swap16(*src16++);
         }
     }
-    else if (memcmp(src, N64_SIGNATURE, sizeof(N64_SIGNATURE)) == 0)
+    else if (imagetype == N64IMAGE)
     {
         size_t i;
         const uint32_t* src32 = (const uint32_t*) src;
         uint32_t* dst32 = (uint32_t*) dst;
 
-        *imagetype = N64IMAGE;
         /* .n64 images have byte-swapped words (32-bit). */
         for (i = 0; i < len; i += 4)
         {
@@ -130,40 +143,25 @@ static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char*
         }
     }
     else {
-        *imagetype = Z64IMAGE;
         memcpy(dst, src, len);
     }
 }
 
-m64p_error open_rom(const unsigned char* romimage, unsigned int size)
+/* Same as swap_copy_rom_chunk for a whole ROM image, whose format is
+ * detected from its first bytes and returned in 'imagetype'. */
+static void swap_copy_rom(void* dst, const void* src, size_t len, unsigned char* imagetype)
+{
+    *imagetype = rom_image_type(src);
+    swap_copy_rom_chunk(dst, src, len, *imagetype);
+}
+
+/* Fills in ROM_SETTINGS and ROM_PARAMS once ROM_HEADER is set */
+static void load_rom_settings(md5_byte_t* digest, unsigned char imagetype)
 {
-    md5_state_t state;
-    md5_byte_t digest[16];
     romdatabase_entry* entry;
     char buffer[256];
-    unsigned char imagetype;
     int i;
 
-    /* check input requirements */
-    if (romimage == NULL || !is_valid_rom(romimage, size))
-    {
-        DebugMessage(M64MSG_ERROR, "open_rom(): not a valid ROM image");
-        return M64ERR_INPUT_INVALID;
-    }
-
-    /* Clear Byte-swapped flag, since ROM is now deleted. */
-    g_RomWordsLittleEndian = 0;
-    /* allocate new buffer for ROM and copy into this buffer */
-    g_rom_size = size;
-    swap_copy_rom((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), romimage, size, &imagetype);
-    /* ROM is now in N64 native (big endian) byte order */
-
-    memcpy(&ROM_HEADER, (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), sizeof(m64p_rom_header));
-
-    /* Calculate MD5 hash  */
-    md5_init(&state);
-    md5_append(&state, (const md5_byte_t*)((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM)), g_rom_size);
-    md5_finish(&state, digest);
     for ( i = 0; i < 16; ++i )
         sprintf(buffer+i*2, "%02X", digest[i]);
     buffer[32] = '\0';
@@ -194,6 +192,7 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
         ROM_SETTINGS.disableextramem = entry->disableextramem;
         ROM_SETTINGS.sidmaduration = entry->sidmaduration;
         ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
+        ROM_SETTINGS.idleloopskip = entry->idleloopskip;
         ROM_PARAMS.cheats = entry->cheats;
     }
     else
@@ -210,6 +209,7 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
         ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
         ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
         ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+        ROM_SETTINGS.idleloopskip = DEFAULT_IDLE_LOOP_SKIP;
         ROM_PARAMS.cheats = NULL;
 
         /* check if ROM has the Advanced Homebrew ROM Header (see https://n64brew.dev/wiki/ROM_Header) */
@@ -244,12 +244,182 @@ m64p_error open_rom(const unsigned char* romimage, unsigned int size)
     DebugMessage(M64MSG_INFO, "Country: %s", buffer);
     DebugMessage(M64MSG_VERBOSE, "PC = %" PRIX32, tohl(ROM_HEADER.PC));
     DebugMessage(M64MSG_VERBOSE, "Save type: %d", ROM_SETTINGS.savetype);
+}
+
+m64p_error open_rom(const unsigned char* romimage, unsigned int size)
+{
+    md5_state_t state;
+    md5_byte_t digest[16];
+    unsigned char imagetype;
+
+    /* check input requirements */
+    if (romimage == NULL || !is_valid_rom(romimage, size))
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom(): not a valid ROM image");
+        return M64ERR_INPUT_INVALID;
+    }
+
+    /* Clear Byte-swapped flag, since ROM is now deleted. */
+    g_RomWordsLittleEndian = 0;
+    /* allocate new buffer for ROM and copy into this buffer */
+    g_rom_size = size;
+    swap_copy_rom((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), romimage, size, &imagetype);
+    /* ROM is now in N64 native (big endian) byte order */
+
+    memcpy(&ROM_HEADER, (uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM), sizeof(m64p_rom_header));
+
+    /* Calculate MD5 hash  */
+    md5_init(&state);
+    md5_append(&state, (const md5_byte_t*)((uint8_t*)mem_base_u32(g_mem_base, MM_CART_ROM)), g_rom_size);
+    md5_finish(&state, digest);
+
+    load_rom_settings(digest, imagetype);
+
+    return M64ERR_SUCCESS;
+}
+
+/* Converts ROM words from the image straight to the byte order the rest of
+ * the emulator expects once main.c swapped the ROM, which is host order */
+static void load_rom_words(uint32_t* dst, const uint8_t* src, size_t count, unsigned char imagetype)
+{
+    size_t i;
+
+    switch (imagetype)
+    {
+    case V64IMAGE:
+        for (i = 0; i < count; ++i, src += 4)
+            dst[i] = ((uint32_t)src[1] << 24) | ((uint32_t)src[0] << 16) | ((uint32_t)src[3] << 8) | src[2];
+        break;
+    case N64IMAGE:
+        for (i = 0; i < count; ++i, src += 4)
+            dst[i] = ((uint32_t)src[3] << 24) | ((uint32_t)src[2] << 16) | ((uint32_t)src[1] << 8) | src[0];
+        break;
+    default:
+        for (i = 0; i < count; ++i, src += 4)
+            dst[i] = ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | src[3];
+        break;
+    }
+}
+
+void rom_pages_load(uint32_t offset, uint32_t length)
+{
+    uint32_t page, last;
+    uint32_t pages = ((uint32_t)g_rom_size + ROM_PAGE_SIZE - 1) >> ROM_PAGE_SHIFT;
+
+    if (length == 0 || offset >= (uint32_t)g_rom_size)
+        return;
+
+    page = offset >> ROM_PAGE_SHIFT;
+    last = (offset + length - 1) >> ROM_PAGE_SHIFT;
+    if (last >= pages)
+        last = pages - 1;
+
+    for (; page <= last; ++page)
+    {
+        uint32_t start = page << ROM_PAGE_SHIFT;
+        uint32_t size = ((uint32_t)g_rom_size - start < ROM_PAGE_SIZE) ? (uint32_t)g_rom_size - start : ROM_PAGE_SIZE;
+
+        if (g_rom_pages[page])
+            continue;
+
+        load_rom_words(mem_base_u32(g_mem_base, MM_CART_ROM + start), l_rom_image + start, size / 4, l_rom_imagetype);
+        g_rom_pages[page] = 1;
+
+        /* once the whole ROM is in, accesses don't need to check anymore */
+        if (--l_rom_pages_left == 0)
+        {
+            free(g_rom_pages);
+            g_rom_pages = NULL;
+            DebugMessage(M64MSG_VERBOSE, "All ROM pages loaded.");
+            return;
+        }
+    }
+}
+
+m64p_error open_rom_file(const char* filename)
+{
+    md5_state_t state;
+    md5_byte_t digest[16];
+    const void* image;
+    size_t size;
+    unsigned int pages;
+
+    if (map_file(filename, &image, &size) != file_ok)
+        return M64ERR_FILES;
+
+    /* ROM pages are converted a word at a time */
+    if (size < 4096 || size > CART_ROM_MAX_SIZE || size % 4 != 0 || !is_valid_rom(image, (unsigned int)size))
+    {
+        DebugMessage(M64MSG_ERROR, "open_rom_file(): not a valid ROM image");
+        unmap_file(image, size);
+        return M64ERR_INPUT_INVALID;
+    }
+
+    pages = (unsigned int)((size + ROM_PAGE_SIZE - 1) >> ROM_PAGE_SHIFT);
+    g_rom_pages = (uint8_t*)calloc(pages, 1);
+    if (g_rom_pages == NULL)
+    {
+        unmap_file(image, size);
+        return M64ERR_NO_MEMORY;
+    }
+
+    l_rom_image = (const unsigned char*)image;
+    l_rom_image_size = size;
+    l_rom_imagetype = rom_image_type(image);
+    l_rom_pages_left = pages;
+    g_rom_size = (int)size;
+
+    /* Pages are loaded in host byte order, don't let main.c swap them again */
+    g_RomWordsLittleEndian = 1;
+
+    /* The header and boot code are read directly, load them up front */
+    rom_pages_load(0, 1);
+
+    swap_copy_rom_chunk(&ROM_HEADER, l_rom_image, sizeof(m64p_rom_header), l_rom_imagetype);
+
+    /* The MD5 hash still needs the whole image */
+    md5_init(&state);
+    if (l_rom_imagetype == Z64IMAGE)
+    {
+        md5_append(&state, (const md5_byte_t*)l_rom_image, g_rom_size);
+    }
+    else
+    {
+        unsigned char* chunk = (unsigned char*)malloc(CHUNKSIZE);
+        size_t offset;
+
+        if (chunk == NULL)
+        {
+            close_rom();
+            return M64ERR_NO_MEMORY;
+        }
+
+        for (offset = 0; offset < size; offset += CHUNKSIZE)
+        {
+            size_t length = (size - offset < CHUNKSIZE) ? size - offset : CHUNKSIZE;
+            swap_copy_rom_chunk(chunk, l_rom_image + offset, length, l_rom_imagetype);
+            md5_append(&state, (const md5_byte_t*)chunk, length);
+        }
+        free(chunk);
+    }
+    md5_finish(&state, digest);
+
+    load_rom_settings(digest, l_rom_imagetype);
 
     return M64ERR_SUCCESS;
 }
 
 m64p_error close_rom(void)
 {
+    free(g_rom_pages);
+    g_rom_pages = NULL;
+    if (l_rom_image != NULL)
+    {
+        unmap_file(l_rom_image, l_rom_image_size);
+        l_rom_image = NULL;
+        l_rom_image_size = 0;
+    }
+
     /* Clear Byte-swapped flag, since ROM is now deleted. */
     g_RomWordsLittleEndian = 0;
     DebugMessage(M64MSG_STATUS, "Rom closed.");
@@ -331,6 +501,7 @@ m64p_error open_disk(void)
         ROM_SETTINGS.disableextramem = entry->disableextramem;
         ROM_SETTINGS.sidmaduration = entry->sidmaduration;
         ROM_SETTINGS.aidmamodifier = entry->aidmamodifier;
+        ROM_SETTINGS.idleloopskip = entry->idleloopskip;
         ROM_PARAMS.cheats = entry->cheats;
     }
     else
@@ -348,6 +519,7 @@ m64p_error open_disk(void)
         ROM_SETTINGS.disableextramem = DEFAULT_DISABLE_EXTRA_MEM;
         ROM_SETTINGS.sidmaduration = DEFAULT_SI_DMA_DURATION;
         ROM_SETTINGS.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+        ROM_SETTINGS.idleloopskip = DEFAULT_IDLE_LOOP_SKIP;
         ROM_PARAMS.cheats = NULL;
     }
 
@@ -552,6 +724,12 @@ static size_t romdatabase_resolve_round(void)
             entry->entry.set_flags |= ROMDATABASE_ENTRY_AIDMAMODIFIER;
         }
 
+        if (!isset_bitmask(entry->entry.set_flags, ROMDATABASE_ENTRY_IDLELOOPSKIP) &&
+            isset_bitmask(ref->set_flags, ROMDATABASE_ENTRY_IDLELOOPSKIP)) {
+            entry->entry.idleloopskip = ref->idleloopskip;
+            entry->entry.set_flags |= ROMDATABASE_ENTRY_IDLELOOPSKIP;
+        }
+
         free(entry->entry.refmd5);
         entry->entry.refmd5 = NULL;
     }
@@ -649,6 +827,7 @@ void romdatabase_open(void)
             search->entry.biopak = 0;
             search->entry.sidmaduration = DEFAULT_SI_DMA_DURATION;
             search->entry.aidmamodifier = DEFAULT_AI_DMA_MODIFIER;
+            search->entry.idleloopskip = DEFAULT_IDLE_LOOP_SKIP;
             search->entry.set_flags = ROMDATABASE_ENTRY_NONE;
 
             search->next_entry = NULL;
@@ -854,6 +1033,18 @@ void romdatabase_open(void)
                     DebugMessage(M64MSG_WARNING, "ROM Database: Invalid AiDmaModifier on line %i", lineno);
                 }
             }
+            else if(!strcmp(l.name, "IdleLoopSkip"))
+            {
+                if(!strcmp(l.value, "Yes")) {
+                    search->entry.idleloopskip = IDLE_LOOP_SKIP_YES;
+                    search->entry.set_flags |= ROMDATABASE_ENTRY_IDLELOOPSKIP;
+                } else if(!strcmp(l.value, "No")) {
+                    search->entry.idleloopskip = IDLE_LOOP_SKIP_NO;
+                    search->entry.set_flags |= ROMDATABASE_ENTRY_IDLELOOPSKIP;
+                } else {
+                    DebugMessage(M64MSG_WARNING, "ROM Database: Invalid IdleLoopSkip string on line %i", lineno);
+                }
+            }
             else
             {
                 DebugMessage(M64MSG_WARNING, "ROM Database: Unknown property on line %i", lineno);
@@ -27,6 +27,7 @@
 #include <stdint.h>
 
 #include "api/m64p_types.h"
+#include "osal/preproc.h"
 
 #define BIT(bitnr) (1ULL << (bitnr))
 #ifdef __GNUC__
@@ -39,13 +40,34 @@
 /* ROM Loading and Saving functions */
 
 m64p_error open_rom(const unsigned char* romimage, unsigned int size);
+/* Maps the ROM file instead of copying it, pages are converted as the
+ * emulator first touches them. */
+m64p_error open_rom_file(const char* filename);
 m64p_error close_rom(void);
+/* Tests if buffer holds the first bytes of an N64 ROM of size bytes */
+int is_valid_rom(const unsigned char *buffer, unsigned int size);
 
 m64p_error open_disk(void);
 m64p_error close_disk(void);
 
 extern int g_rom_size;
 
+/* Lazily loaded ROM pages, matching the memory handler granularity */
+enum { ROM_PAGE_SHIFT = 16 };
+enum { ROM_PAGE_SIZE = 1 << ROM_PAGE_SHIFT };
+
+/* Per page loaded flags while a mapped ROM isn't fully loaded, NULL otherwise */
+extern uint8_t* g_rom_pages;
+
+void rom_pages_load(uint32_t offset, uint32_t length);
+
+/* Must be called before reading the ROM in g_mem_base outside of page 0 */
+static osal_inline void rom_pages_touch(uint32_t offset, uint32_t length)
+{
+    if (g_rom_pages != NULL)
+        rom_pages_load(offset, length);
+}
+
 typedef struct _rom_params
 {
    char *cheats;
@@ -86,6 +108,15 @@ enum
     CIC_NUS_6106
 };
 
+/* IdleLoopSkip values. UNSET leaves the choice to the frontend option,
+ * an explicit No in the database overrides it. */
+enum
+{
+    IDLE_LOOP_SKIP_NO,
+    IDLE_LOOP_SKIP_YES,
+    IDLE_LOOP_SKIP_UNSET
+};
+
 /* Rom INI database structures and functions */
 
 /* The romdatabase contains the items mupen64plus indexes for each rom. These
@@ -117,6 +148,7 @@ typedef struct
    unsigned char biopak; /* 0 - No, 1 - Yes boolean for biopak support. */
    unsigned int sidmaduration;
    unsigned int aidmamodifier;
+   unsigned char idleloopskip; /* 0 - No, 1 - Yes, 2 - Unset, skipping polling loops in the dynarec. */
    uint32_t set_flags;
 } romdatabase_entry;
 
@@ -135,6 +167,7 @@ typedef struct
 #define ROMDATABASE_ENTRY_BIOPAK        BIT(11)
 #define ROMDATABASE_ENTRY_SIDMADURATION BIT(12)
 #define ROMDATABASE_ENTRY_AIDMAMODIFIER BIT(13)
+#define ROMDATABASE_ENTRY_IDLELOOPSKIP  BIT(14)
 
 typedef struct _romdatabase_search
 {
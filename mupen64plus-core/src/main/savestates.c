@@ -48,12 +48,13 @@
 #include "osal/preproc.h"
 #include "osd/osd.h"
 #include "plugin/plugin.h"
+#include "profile.h"
 #include "rom.h"
 #include "savestates.h"
 #include "util.h"
 #include "workqueue.h"
+#include "zip_stream.h"
 
-#include <unzip.h>
 #include <zip.h>
 
 enum { GB_CART_FINGERPRINT_SIZE = 0x1c };
@@ -206,6 +207,41 @@ static void savestates_clear_job(void)
 #define PUTDATA(buff, type, value) \
     do { type x = value; PUTARRAY(&x, buff, type, 1); } while(0)
 
+/* TLB lookup tables are stored as the flat arrays they used to be */
+static unsigned char* load_tlb_lut(struct tlb_lut* lut, unsigned char* curr)
+{
+    size_t i, j;
+    int failed = 0;
+
+    tlb_lut_clear(lut);
+    for (i = 0; i < TLB_LUT_DIR_SIZE; ++i) {
+        const uint32_t* leaf = GETARRAY(curr, uint32_t, TLB_LUT_LEAF_SIZE);
+
+        for (j = 0; j < TLB_LUT_LEAF_SIZE; ++j) {
+            if (leaf[j] != 0 && !tlb_lut_set(lut, (uint32_t)((i << TLB_LUT_LEAF_BITS) | j), leaf[j])) {
+                failed = 1;
+            }
+        }
+    }
+
+    if (failed) {
+        DebugMessage(M64MSG_ERROR, "Failed to allocate TLB lookup table");
+    }
+
+    return curr;
+}
+
+static char* save_tlb_lut(const struct tlb_lut* lut, char* curr)
+{
+    size_t i;
+
+    for (i = 0; i < TLB_LUT_DIR_SIZE; ++i) {
+        PUTARRAY(lut->dir[i], curr, uint32_t, TLB_LUT_LEAF_SIZE);
+    }
+
+    return curr;
+}
+
 #ifndef __LIBRETRO__
 int savestates_load_m64p(struct device* dev, char *filepath)
 #else
@@ -522,8 +558,8 @@ int savestates_load_m64p(struct device* dev, const void *data)
     /* by default, reset flashram state here and load it later if available */
     poweron_flashram(&dev->cart.flashram);
 
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    COPYARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    curr = load_tlb_lut(&dev->r4300.cp0.tlb.LUT_r, curr);
+    curr = load_tlb_lut(&dev->r4300.cp0.tlb.LUT_w, curr);
 
     *r4300_llbit(&dev->r4300) = GETDATA(curr, uint32_t);
     COPYARRAY(r4300_regs(&dev->r4300), curr, int64_t, 32);
@@ -1278,8 +1314,8 @@ static int savestates_load_pj64(struct device* dev,
     dev->si.regs[SI_STATUS_REG]         = GETDATA(curr, uint32_t);
 
     // tlb
-    memset(dev->r4300.cp0.tlb.LUT_r, 0, 0x400000);
-    memset(dev->r4300.cp0.tlb.LUT_w, 0, 0x400000);
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_r);
+    tlb_lut_clear(&dev->r4300.cp0.tlb.LUT_w);
     for (i=0; i < 32; i++)
     {
         unsigned int MyPageMask, MyEntryHi, MyEntryLo0, MyEntryLo1;
@@ -1401,38 +1437,30 @@ static int savestates_load_pj64(struct device* dev,
 
 static int read_data_from_zip(void *zip, void *buffer, size_t length)
 {
-    int err = unzReadCurrentFile((unzFile)zip, buffer, (unsigned)length);
-    return (err >= 0) && ((size_t)err == length);
+    return zip_stream_read((struct zip_stream*)zip, buffer, length);
 }
 
 static int savestates_load_pj64_zip(struct device* dev, char *filepath)
 {
-    char szFileName[256], szExtraField[256], szComment[256];
-    unzFile zipstatefile = NULL;
-    unz_file_info fileinfo;
+    struct zip_stream* zipstatefile;
     int ret = 0;
 
     /* Open the .zip file. */
-    zipstatefile = unzOpen(filepath);
-    if (zipstatefile == NULL ||
-        unzGoToFirstFile(zipstatefile) != UNZ_OK ||
-        unzGetCurrentFileInfo(zipstatefile, &fileinfo, szFileName, 255, szExtraField, 255, szComment, 255) != UNZ_OK ||
-        unzOpenCurrentFile(zipstatefile) != UNZ_OK)
+    zipstatefile = zip_stream_open(filepath, NULL, NULL, 0);
+    if (zipstatefile == NULL)
     {
         main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "Zip error. Could not open state file: %s", filepath);
-        goto clean_and_exit;
+        return 0;
     }
 
-    if (!savestates_load_pj64(dev, filepath, zipstatefile, read_data_from_zip))
-        goto clean_and_exit;
-
-    main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
-    ret = 1;
+    if (savestates_load_pj64(dev, filepath, zipstatefile, read_data_from_zip))
+    {
+        main_message(M64MSG_STATUS, OSD_BOTTOM_LEFT, "State loaded from: %s", namefrompath(filepath));
+        ret = 1;
+    }
 
-    clean_and_exit:
-        if (zipstatefile != NULL)
-            unzClose(zipstatefile);
-        return ret;
+    zip_stream_close(zipstatefile);
+    return ret;
 }
 
 static int read_data_from_file(void *file, void *buffer, size_t length)
@@ -1500,6 +1528,11 @@ int savestates_load(void)
     int ret = 0;
     struct device* dev = &g_dev;
 
+    timed_section_start(TIMED_SECTION_SAVESTATE);
+
+    /* an async audio task would write over the loaded state */
+    rsp_wait_task(&g_dev.sp);
+
 #ifndef __LIBRETRO__
     FILE *fPtr = NULL;
     char *filepath = NULL;
@@ -1577,6 +1610,8 @@ int savestates_load(void)
     }
 #endif // __LIBRETRO__
 
+    timed_section_end(TIMED_SECTION_SAVESTATE);
+
     // deliver callback to indicate completion of state loading operation
     StateChanged(M64CORE_STATE_LOADCOMPLETE, ret);
 
@@ -1845,8 +1880,8 @@ int savestates_save_m64p(const struct device* dev, void *data)
     PUTDATA(curr, int32_t, dev->cart.use_flashram);
     curr += 4+8+4+4; // Here used to be flashram state
 
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_r, curr, uint32_t, 0x100000);
-    PUTARRAY(dev->r4300.cp0.tlb.LUT_w, curr, uint32_t, 0x100000);
+    curr = save_tlb_lut(&dev->r4300.cp0.tlb.LUT_r, curr);
+    curr = save_tlb_lut(&dev->r4300.cp0.tlb.LUT_w, curr);
 
     /* OK to cast away const qualifier */
     PUTDATA(curr, uint32_t, *r4300_llbit((struct r4300_core*)&dev->r4300));
@@ -2294,6 +2329,10 @@ int savestates_save(void)
     int ret = 0;
     const struct device* dev = &g_dev;
 
+    timed_section_start(TIMED_SECTION_SAVESTATE);
+
+    rsp_wait_task(&g_dev.sp);
+
 #ifndef __LIBRETRO__
     char *filepath;
 
@@ -2302,7 +2341,10 @@ int savestates_save(void)
     if ((type == savestates_type_pj64_zip ||
          type == savestates_type_pj64_unc) &&
         get_next_event_type(&dev->r4300.cp0.q) > COMPARE_INT)
+    {
+        timed_section_end(TIMED_SECTION_SAVESTATE);
         return 0;
+    }
 
     if (fname != NULL && type == savestates_type_unknown)
         type = savestates_type_m64p;
@@ -2338,6 +2380,8 @@ int savestates_save(void)
     StateChanged(M64CORE_STATE_SAVECOMPLETE, ret);
 #endif // __LIBRETRO__
 
+    timed_section_end(TIMED_SECTION_SAVESTATE);
+
     savestates_clear_job();
 
     return ret;
@@ -43,6 +43,17 @@
 #include "rom.h"
 #include "util.h"
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(HAVE_LIBNX) && !defined(EMSCRIPTEN)
+#define HAVE_MAP_FILE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 /**********************
      File utilities
  **********************/
@@ -217,6 +228,92 @@ close_file:
     return ret;
 }
 
+file_status_t map_file(const char* filename, const void** data, size_t* size)
+{
+#if defined(_WIN32)
+    HANDLE file, mapping;
+    LARGE_INTEGER l_size;
+    void* view;
+
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return file_open_error;
+    }
+
+    if (!GetFileSizeEx(file, &l_size) || l_size.QuadPart <= 0 || (unsigned long long)l_size.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return file_size_error;
+    }
+
+    /* the view keeps the file open */
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return file_read_error;
+    }
+
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL)
+    {
+        return file_read_error;
+    }
+
+    *data = view;
+    *size = (size_t)l_size.QuadPart;
+    return file_ok;
+#elif defined(HAVE_MAP_FILE_POSIX)
+    struct stat st;
+    void* view;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd == -1)
+    {
+        return file_open_error;
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        close(fd);
+        return file_size_error;
+    }
+
+    /* the mapping keeps the file open */
+    view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+    {
+        return file_read_error;
+    }
+
+    *data = view;
+    *size = (size_t)st.st_size;
+    return file_ok;
+#else
+    (void)filename;
+    (void)data;
+    (void)size;
+    return file_open_error;
+#endif
+}
+
+void unmap_file(const void* data, size_t size)
+{
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(data);
+#elif defined(HAVE_MAP_FILE_POSIX)
+    munmap((void*)data, size);
+#else
+    (void)data;
+    (void)size;
+#endif
+}
+
 /**********************
    Byte swap utilities
  **********************/
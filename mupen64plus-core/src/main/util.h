@@ -79,6 +79,17 @@ file_status_t load_file(const char* filename, void** buffer, size_t* size);
  */
 file_status_t get_file_size(const char* filename, size_t* size);
 
+/** map_file
+ *    maps the file content read-only, pages are read in as they are touched.
+ *    returns zero on success, nonzero on failure or where mapping isn't supported
+ */
+file_status_t map_file(const char* filename, const void** data, size_t* size);
+
+/** unmap_file
+ *    releases a mapping made by map_file.
+ */
+void unmap_file(const void* data, size_t size);
+
 /**********************
    Byte swap utilities
  **********************/
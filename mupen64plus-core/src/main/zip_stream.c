@@ -0,0 +1,597 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - zip_stream.c                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "zip_stream.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <ioapi.h>
+#include <unzip.h>
+
+/* largest single read handed to minizip and the cache files */
+#define ZIP_STREAM_CHUNK 0x100000
+
+#define ZIP_CACHE_INDEX "index"
+#define ZIP_CACHE_KEY_LENGTH 24
+
+/* archive held in memory, read through minizip's file functions */
+struct zip_memory
+{
+    const unsigned char* data;
+    size_t size;
+    size_t pos;
+};
+
+struct zip_stream
+{
+    unzFile zip;
+    int file_open;
+    struct zip_memory memory;
+
+    uint32_t crc;
+    size_t size;
+    size_t compressed_size;
+
+    /* first bytes of the file, read to match it */
+    unsigned char header[ZIP_STREAM_HEADER_SIZE];
+    size_t header_length;
+    size_t pos;
+
+    char* cache_dir;
+    size_t cache_size;
+
+    /* image read instead of inflating, or being written while inflating */
+    FILE* cache_image;
+    int cached;
+    int failed;
+};
+
+struct zip_cache_entry
+{
+    char key[ZIP_CACHE_KEY_LENGTH + 1];
+    unsigned long size;
+    unsigned long stamp;
+};
+
+static void zip_cache_key(const struct zip_stream* stream, char* key)
+{
+    snprintf(key, ZIP_CACHE_KEY_LENGTH + 1, "%08x%08lx%08lx", (unsigned int)stream->crc,
+             (unsigned long)stream->size & 0xffffffffUL, (unsigned long)stream->compressed_size & 0xffffffffUL);
+}
+
+static char* zip_cache_path(const char* dir, const char* name)
+{
+    size_t length = strlen(dir);
+    int separator = length > 0 && dir[length - 1] != '/' && dir[length - 1] != '\\';
+    char* path = (char*)malloc(length + separator + strlen(name) + 1);
+
+    if (path != NULL) {
+        sprintf(path, "%s%s%s", dir, separator ? "/" : "", name);
+    }
+    return path;
+}
+
+static size_t zip_cache_load_index(const char* dir, struct zip_cache_entry** entries)
+{
+    struct zip_cache_entry entry;
+    struct zip_cache_entry* list = NULL;
+    size_t count = 0, capacity = 0;
+    char* path = zip_cache_path(dir, ZIP_CACHE_INDEX);
+    FILE* f = (path != NULL) ? fopen(path, "r") : NULL;
+
+    free(path);
+    if (f != NULL) {
+        while (fscanf(f, "%24s %lu %lu", entry.key, &entry.size, &entry.stamp) == 3) {
+            if (count == capacity) {
+                struct zip_cache_entry* grown;
+                capacity = capacity ? capacity * 2 : 16;
+                grown = (struct zip_cache_entry*)realloc(list, capacity * sizeof(*list));
+                if (grown == NULL) {
+                    break;
+                }
+                list = grown;
+            }
+            list[count++] = entry;
+        }
+        fclose(f);
+    }
+
+    *entries = list;
+    return count;
+}
+
+static void zip_cache_save_index(const char* dir, const struct zip_cache_entry* entries, size_t count)
+{
+    char* path = zip_cache_path(dir, ZIP_CACHE_INDEX);
+    char* tmp = zip_cache_path(dir, ZIP_CACHE_INDEX ".tmp");
+    FILE* f = (tmp != NULL) ? fopen(tmp, "w") : NULL;
+    size_t i;
+    int ok;
+
+    if (f != NULL && path != NULL) {
+        for (i = 0; i < count; ++i) {
+            fprintf(f, "%s %lu %lu\n", entries[i].key, entries[i].size, entries[i].stamp);
+        }
+        ok = (fclose(f) == 0);
+
+        /* rename doesn't replace an existing file on Windows */
+        if (ok && rename(tmp, path) != 0) {
+            remove(path);
+            rename(tmp, path);
+        }
+    }
+    else if (f != NULL) {
+        fclose(f);
+    }
+
+    free(tmp);
+    free(path);
+}
+
+/* Marks key as the most recently used image, then drops the least recently
+ * used ones until the cache fits */
+static void zip_cache_use(const struct zip_stream* stream, const char* key)
+{
+    struct zip_cache_entry* entries;
+    size_t count = zip_cache_load_index(stream->cache_dir, &entries);
+    unsigned long stamp = 0;
+    size_t total = 0;
+    size_t i, found = count;
+
+    for (i = 0; i < count; ++i) {
+        if (entries[i].stamp > stamp) {
+            stamp = entries[i].stamp;
+        }
+        if (strcmp(entries[i].key, key) == 0) {
+            found = i;
+        }
+    }
+
+    if (found == count) {
+        struct zip_cache_entry* grown = (struct zip_cache_entry*)realloc(entries, (count + 1) * sizeof(*entries));
+        if (grown == NULL) {
+            free(entries);
+            return;
+        }
+        entries = grown;
+        strcpy(entries[count].key, key);
+        entries[count].size = (unsigned long)stream->size;
+        ++count;
+    }
+    entries[found].stamp = stamp + 1;
+
+    for (i = 0; i < count; ++i) {
+        total += entries[i].size;
+    }
+
+    while (total > stream->cache_size) {
+        size_t oldest = count;
+        char* path;
+
+        for (i = 0; i < count; ++i) {
+            if (i != found && (oldest == count || entries[i].stamp < entries[oldest].stamp)) {
+                oldest = i;
+            }
+        }
+        if (oldest == count) {
+            break;
+        }
+
+        path = zip_cache_path(stream->cache_dir, entries[oldest].key);
+        if (path != NULL) {
+            remove(path);
+            free(path);
+        }
+
+        total -= entries[oldest].size;
+        entries[oldest] = entries[--count];
+        if (found == count) {
+            found = oldest;
+        }
+    }
+
+    zip_cache_save_index(stream->cache_dir, entries, count);
+    free(entries);
+}
+
+/* Opens the cached image of the file if there is one and it checks out */
+static FILE* zip_cache_open(const struct zip_stream* stream, const char* key)
+{
+    unsigned char* chunk;
+    char* path = zip_cache_path(stream->cache_dir, key);
+    FILE* f = (path != NULL) ? fopen(path, "rb") : NULL;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    size_t total = 0, n;
+
+    free(path);
+    if (f == NULL) {
+        return NULL;
+    }
+
+    /* the key only says what the file should be, check what it is */
+    chunk = (unsigned char*)malloc(ZIP_STREAM_CHUNK);
+    while (chunk != NULL && (n = fread(chunk, 1, ZIP_STREAM_CHUNK, f)) > 0) {
+        crc = crc32(crc, chunk, (uInt)n);
+        total += n;
+    }
+    free(chunk);
+
+    if (total != stream->size || (uint32_t)crc != stream->crc || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+/* Starts writing the image of the file, it only gets its name once the
+ * whole file was inflated and its CRC checked out */
+static FILE* zip_cache_create(const struct zip_stream* stream)
+{
+    char* tmp;
+    FILE* f;
+
+    if (stream->size > stream->cache_size) {
+        return NULL;
+    }
+
+    tmp = zip_cache_path(stream->cache_dir, "image.tmp");
+    f = (tmp != NULL) ? fopen(tmp, "wb") : NULL;
+    free(tmp);
+    return f;
+}
+
+static void zip_cache_store(struct zip_stream* stream)
+{
+    char key[ZIP_CACHE_KEY_LENGTH + 1];
+    char* path;
+    char* tmp;
+    int ok;
+
+    ok = !ferror(stream->cache_image);
+    ok = (fclose(stream->cache_image) == 0) && ok;
+    stream->cache_image = NULL;
+
+    zip_cache_key(stream, key);
+    path = zip_cache_path(stream->cache_dir, key);
+    tmp = zip_cache_path(stream->cache_dir, "image.tmp");
+    if (path != NULL && tmp != NULL) {
+        if (ok) {
+            remove(path);
+            ok = (rename(tmp, path) == 0);
+        }
+        if (!ok) {
+            remove(tmp);
+        }
+        if (ok) {
+            zip_cache_use(stream, key);
+        }
+    }
+
+    free(tmp);
+    free(path);
+}
+
+static void zip_cache_discard(struct zip_stream* stream)
+{
+    char* tmp;
+
+    fclose(stream->cache_image);
+    stream->cache_image = NULL;
+
+    tmp = zip_cache_path(stream->cache_dir, "image.tmp");
+    if (tmp != NULL) {
+        remove(tmp);
+        free(tmp);
+    }
+}
+
+static voidpf ZCALLBACK zip_memory_open(voidpf opaque, const char* filename, int mode)
+{
+    struct zip_memory* memory = (struct zip_memory*)opaque;
+
+    if ((mode & ZLIB_FILEFUNC_MODE_READWRITEFILTER) != ZLIB_FILEFUNC_MODE_READ) {
+        return NULL;
+    }
+    memory->pos = 0;
+    return memory;
+}
+
+static uLong ZCALLBACK zip_memory_read(voidpf opaque, voidpf file, void* buf, uLong size)
+{
+    struct zip_memory* memory = (struct zip_memory*)file;
+    size_t n = memory->size - memory->pos;
+
+    if (n > size) {
+        n = size;
+    }
+    memcpy(buf, memory->data + memory->pos, n);
+    memory->pos += n;
+    return (uLong)n;
+}
+
+static uLong ZCALLBACK zip_memory_write(voidpf opaque, voidpf file, const void* buf, uLong size)
+{
+    return 0;
+}
+
+static long ZCALLBACK zip_memory_tell(voidpf opaque, voidpf file)
+{
+    return (long)((struct zip_memory*)file)->pos;
+}
+
+static long ZCALLBACK zip_memory_seek(voidpf opaque, voidpf file, uLong offset, int origin)
+{
+    struct zip_memory* memory = (struct zip_memory*)file;
+    size_t base;
+
+    switch (origin)
+    {
+    case ZLIB_FILEFUNC_SEEK_SET: base = 0; break;
+    case ZLIB_FILEFUNC_SEEK_CUR: base = memory->pos; break;
+    case ZLIB_FILEFUNC_SEEK_END: base = memory->size; break;
+    default: return -1;
+    }
+
+    if (offset > memory->size - base) {
+        return -1;
+    }
+    memory->pos = base + offset;
+    return 0;
+}
+
+static int ZCALLBACK zip_memory_close(voidpf opaque, voidpf file)
+{
+    return 0;
+}
+
+static int ZCALLBACK zip_memory_error(voidpf opaque, voidpf file)
+{
+    return 0;
+}
+
+/* Opens the file to read, leaving its first bytes in the header when they
+ * were needed to match it */
+static int zip_stream_select(struct zip_stream* stream, zip_stream_match_func match)
+{
+    unz_file_info info;
+    int err;
+
+    for (err = unzGoToFirstFile(stream->zip); err == UNZ_OK; err = unzGoToNextFile(stream->zip)) {
+        if (unzGetCurrentFileInfo(stream->zip, &info, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK) {
+            return 0;
+        }
+        if (info.uncompressed_size == 0
+            || (match != NULL && info.uncompressed_size < ZIP_STREAM_HEADER_SIZE)) {
+            continue;
+        }
+        if (unzOpenCurrentFile(stream->zip) != UNZ_OK) {
+            return 0;
+        }
+        stream->file_open = 1;
+
+        stream->crc = (uint32_t)info.crc;
+        stream->size = (size_t)info.uncompressed_size;
+        stream->compressed_size = (size_t)info.compressed_size;
+        stream->header_length = 0;
+
+        if (match == NULL) {
+            return 1;
+        }
+
+        if (unzReadCurrentFile(stream->zip, stream->header, ZIP_STREAM_HEADER_SIZE) == ZIP_STREAM_HEADER_SIZE
+            && match(stream->header, (unsigned int)stream->size)) {
+            stream->header_length = ZIP_STREAM_HEADER_SIZE;
+            return 1;
+        }
+
+        unzCloseCurrentFile(stream->zip);
+        stream->file_open = 0;
+    }
+
+    return 0;
+}
+
+static struct zip_stream* zip_stream_start(struct zip_stream* stream, zip_stream_match_func match,
+                                           const char* cache_dir, size_t cache_size)
+{
+    char key[ZIP_CACHE_KEY_LENGTH + 1];
+
+    if (stream->zip == NULL || !zip_stream_select(stream, match)) {
+        zip_stream_close(stream);
+        return NULL;
+    }
+
+    if (cache_dir == NULL || cache_size == 0) {
+        return stream;
+    }
+
+    stream->cache_dir = strdup(cache_dir);
+    stream->cache_size = cache_size;
+    if (stream->cache_dir == NULL) {
+        return stream;
+    }
+
+    zip_cache_key(stream, key);
+    stream->cache_image = zip_cache_open(stream, key);
+    if (stream->cache_image != NULL) {
+        /* the header was inflated already, the rest comes from the image */
+        if (fseek(stream->cache_image, (long)stream->header_length, SEEK_SET) == 0) {
+            stream->cached = 1;
+            unzCloseCurrentFile(stream->zip);
+            stream->file_open = 0;
+            zip_cache_use(stream, key);
+            return stream;
+        }
+        fclose(stream->cache_image);
+    }
+
+    stream->cache_image = zip_cache_create(stream);
+    if (stream->cache_image != NULL && stream->header_length > 0
+        && fwrite(stream->header, 1, stream->header_length, stream->cache_image) != stream->header_length) {
+        zip_cache_discard(stream);
+    }
+
+    return stream;
+}
+
+struct zip_stream* zip_stream_open(const char* filepath, zip_stream_match_func match,
+                                   const char* cache_dir, size_t cache_size)
+{
+    struct zip_stream* stream = (struct zip_stream*)calloc(1, sizeof(*stream));
+
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    stream->zip = unzOpen(filepath);
+    return zip_stream_start(stream, match, cache_dir, cache_size);
+}
+
+struct zip_stream* zip_stream_open_memory(const void* data, size_t size, zip_stream_match_func match,
+                                          const char* cache_dir, size_t cache_size)
+{
+    struct zip_stream* stream = (struct zip_stream*)calloc(1, sizeof(*stream));
+    zlib_filefunc_def funcs;
+
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    stream->memory.data = (const unsigned char*)data;
+    stream->memory.size = size;
+
+    funcs.zopen_file = zip_memory_open;
+    funcs.zread_file = zip_memory_read;
+    funcs.zwrite_file = zip_memory_write;
+    funcs.ztell_file = zip_memory_tell;
+    funcs.zseek_file = zip_memory_seek;
+    funcs.zclose_file = zip_memory_close;
+    funcs.zerror_file = zip_memory_error;
+    funcs.opaque = &stream->memory;
+
+    /* the name is only handed to zip_memory_open */
+    stream->zip = unzOpen2("memory", &funcs);
+    return zip_stream_start(stream, match, cache_dir, cache_size);
+}
+
+/* Reads the next length bytes of the file that come after the header */
+static int zip_stream_fill(struct zip_stream* stream, unsigned char* dst, size_t length)
+{
+    while (length > 0) {
+        size_t n = (length < ZIP_STREAM_CHUNK) ? length : ZIP_STREAM_CHUNK;
+
+        if (stream->cached) {
+            if (fread(dst, 1, n, stream->cache_image) != n) {
+                return 0;
+            }
+        }
+        else {
+            if (unzReadCurrentFile(stream->zip, dst, (unsigned)n) != (int)n) {
+                return 0;
+            }
+            if (stream->cache_image != NULL && fwrite(dst, 1, n, stream->cache_image) != n) {
+                zip_cache_discard(stream);
+            }
+        }
+
+        stream->pos += n;
+        dst += n;
+        length -= n;
+    }
+
+    /* closing the file after reading it all is what checks the CRC */
+    if (stream->pos == stream->size && stream->file_open) {
+        stream->file_open = 0;
+        if (unzCloseCurrentFile(stream->zip) != UNZ_OK) {
+            return 0;
+        }
+        if (stream->cache_image != NULL) {
+            zip_cache_store(stream);
+        }
+    }
+
+    return 1;
+}
+
+int zip_stream_read(struct zip_stream* stream, void* buffer, size_t length)
+{
+    unsigned char* dst = (unsigned char*)buffer;
+
+    if (stream->failed || length > stream->size - stream->pos) {
+        return 0;
+    }
+
+    if (stream->pos < stream->header_length) {
+        size_t n = stream->header_length - stream->pos;
+        if (n > length) {
+            n = length;
+        }
+        memcpy(dst, stream->header + stream->pos, n);
+        stream->pos += n;
+        dst += n;
+        length -= n;
+    }
+
+    if (!zip_stream_fill(stream, dst, length)) {
+        stream->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+size_t zip_stream_size(const struct zip_stream* stream)
+{
+    return stream->size;
+}
+
+int zip_stream_cached(const struct zip_stream* stream)
+{
+    return stream->cached;
+}
+
+void zip_stream_close(struct zip_stream* stream)
+{
+    if (stream == NULL) {
+        return;
+    }
+
+    if (stream->cache_image != NULL) {
+        if (stream->cached) {
+            fclose(stream->cache_image);
+        }
+        else {
+            zip_cache_discard(stream);
+        }
+    }
+
+    if (stream->zip != NULL) {
+        if (stream->file_open) {
+            unzCloseCurrentFile(stream->zip);
+        }
+        unzClose(stream->zip);
+    }
+
+    free(stream->cache_dir);
+    free(stream);
+}
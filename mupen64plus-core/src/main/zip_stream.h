@@ -0,0 +1,67 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *   Mupen64plus - zip_stream.h                                            *
+ *   Mupen64Plus homepage: https://mupen64plus.org/                        *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.          *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef M64P_MAIN_ZIP_STREAM_H
+#define M64P_MAIN_ZIP_STREAM_H
+
+#include <stddef.h>
+
+/* Sequential reader over one file of a zip archive, read from disk or from
+ * memory. Reads inflate straight into the caller's buffer.
+ *
+ * With a cache directory, inflated images are also kept on disk, keyed by
+ * the CRC and sizes the archive records for the file, and opening the same
+ * content again reads them back instead of inflating. The cache is trimmed
+ * to cache_size bytes, least recently used images first. */
+
+struct zip_stream;
+
+/* Bytes of each file given to a match function */
+#define ZIP_STREAM_HEADER_SIZE 64
+
+/* Returns non zero if the file starting with header, which holds the first
+ * ZIP_STREAM_HEADER_SIZE bytes of a file of size bytes, is the one to read */
+typedef int (*zip_stream_match_func)(const unsigned char* header, unsigned int size);
+
+/* Opens the first file for which match returns non zero, files smaller than
+ * ZIP_STREAM_HEADER_SIZE are skipped. A NULL match takes the first file.
+ * Returns NULL if the archive can't be opened or has no such file.
+ * cache_dir must exist; pass NULL to disable the cache. */
+struct zip_stream* zip_stream_open(const char* filepath, zip_stream_match_func match,
+                                   const char* cache_dir, size_t cache_size);
+
+/* Same for an archive in memory, which must stay valid until the stream is
+ * closed */
+struct zip_stream* zip_stream_open_memory(const void* data, size_t size, zip_stream_match_func match,
+                                          const char* cache_dir, size_t cache_size);
+
+/* Reads exactly length bytes, returns 0 on a short or corrupted file.
+ * The read that reaches the end of the file fails if its CRC doesn't match. */
+int zip_stream_read(struct zip_stream* stream, void* buffer, size_t length);
+
+/* Uncompressed size of the file */
+size_t zip_stream_size(const struct zip_stream* stream);
+
+/* Non zero if the data comes from the cache */
+int zip_stream_cached(const struct zip_stream* stream);
+
+void zip_stream_close(struct zip_stream* stream);
+
+#endif /* M64P_MAIN_ZIP_STREAM_H */
@@ -36,6 +36,7 @@
 #include "device/rcp/vi/vi_controller.h"
 #include "dummy_audio.h"
 #include "dummy_input.h"
+#include "dummy_video.h"
 #include "main/main.h"
 #include "main/rom.h"
 #include "main/version.h"
@@ -101,6 +102,27 @@ DEFINE_GFX(angrylion);
 DEFINE_GFX(parallel);
 #endif
 
+const gfx_plugin_functions dummy_video = {
+    dummyvideo_PluginGetVersion,
+    dummyvideo_ChangeWindow,
+    dummyvideo_InitiateGFX,
+    dummyvideo_MoveScreen,
+    dummyvideo_ProcessDList,
+    dummyvideo_ProcessRDPList,
+    dummyvideo_RomClosed,
+    dummyvideo_RomOpen,
+    dummyvideo_ShowCFB,
+    dummyvideo_UpdateScreen,
+    dummyvideo_ViStatusChanged,
+    dummyvideo_ViWidthChanged,
+    dummyvideo_ReadScreen2,
+    dummyvideo_SetRenderingCallback,
+    dummyvideo_ResizeVideoOutput,
+    dummyvideo_FBRead,
+    dummyvideo_FBWrite,
+    dummyvideo_FBGetFrameBufferInfo
+};
+
 gfx_plugin_functions gfx;
 GFX_INFO gfx_info;
 audio_plugin_functions audio;
@@ -403,9 +425,9 @@ void plugin_connect_rdp_api(enum rdp_plugin_type type)
       case RDP_PLUGIN_GLIDEN64:
       case RDP_PLUGIN_ANGRYLION:
       case RDP_PLUGIN_PARALLEL:
+      case RDP_PLUGIN_NONE:
          current_rdp_type = type;
          break;
-      case RSP_PLUGIN_NONE:
       default:
          break;
    }
@@ -445,6 +467,9 @@ void plugin_connect_all()
           gfx = gfx_gln64;
           break;
       case RDP_PLUGIN_NONE:
+          /* Headless, e.g. for the benchmark harness */
+          gfx = dummy_video;
+          break;
       default:
          break;
     }
@@ -207,6 +207,45 @@ MT_CMD_START       ,MT_CMD_END         ,MT_READ_ONLY       ,MT_CMD_STATUS,
 MT_CMD_CLOCK       ,MT_READ_ONLY       ,MT_READ_ONLY       ,MT_READ_ONLY
 };
 
+/*
+ * Decoded-instruction cache over IMEM
+ *
+ * Every IMEM word is decoded once, into a direct pointer to the handler of
+ * its operation and its operands extracted ahead of time, and then executed
+ * from here instead of being fetched and decoded again on every step.
+ * Words not decoded yet, or overwritten since, point to su_decode instead.
+ *
+ * Handlers return 0 to step to the next op, +1 when they set temp_PC for a
+ * jump or taken branch, and -1 when the RSP halted.
+ */
+typedef struct su_op su_op;
+typedef int (*su_handler)(su_op * op, u32 PC);
+
+struct su_op {
+    su_handler handler;
+    union {
+        mwc2_func lsw;
+        p_vector_func vector;
+    } func;
+    u32 target; /* 4 * instruction word, for jumps and branches */
+    u16 imm; /* immediate, or the LWC2/SWC2 offset */
+    u8 rs, rt, rd, sa;
+};
+
+static su_op su_ops[0x1000 / 4];
+static u32 su_ops_inst[0x1000 / 4]; /* the IMEM words the ops came from */
+static int su_ops_ready;
+
+static int su_decode(su_op * op, u32 PC);
+
+/*
+ * The RSP itself can only change IMEM through DMA.
+ */
+static INLINE void su_invalidate_imem(unsigned int offset)
+{
+    su_ops[FIT_IMEM(offset) / 4].handler = su_decode;
+}
+
 void SP_DMA_READ(void)
 {
     unsigned int offC, offD; /* SP cache and dynamic DMA pointers */
@@ -235,6 +274,10 @@ void SP_DMA_READ(void)
                 *(pi64)(DRAM + offD)
               & (offD & ~MAX_DRAM_DMA_ADDR ? 0 : ~0) /* 0 if (addr > limit) */
             ;
+            if (offC & 0x1000) {
+                su_invalidate_imem(offC + 0);
+                su_invalidate_imem(offC + 4);
+            }
             i += 0x008;
         } while (i < length);
     } while (count);
@@ -284,226 +327,179 @@ void SP_DMA_WRITE(void)
 
 /*** scalar, R4000 control flow manipulation ***/
 
-static INLINE void J(u32 inst)
+static int J(su_op * op, u32 PC)
 {
-    set_PC(4 * inst);
+    set_PC(op->target);
+    return 1;
 }
 
-static INLINE void JAL(u32 inst, u32 PC)
+static int JAL(su_op * op, u32 PC)
 {
     SR[ra] = FIT_IMEM(PC + LINK_OFF);
-    set_PC(4 * inst);
+    set_PC(op->target);
+    return 1;
 }
 
-static INLINE int BEQ(u32 inst, u32 PC)
+static int BEQ(su_op * op, u32 PC)
 {
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    if (!(SR[rs] == SR[rt]))
+    if (!(SR[op->rs] == SR[op->rt]))
         return 0;
-    set_PC(PC + 4*inst + SLOT_OFF);
+    set_PC(PC + op->target + SLOT_OFF);
     return 1;
 }
-static INLINE int BNE(u32 inst, u32 PC)
+static int BNE(su_op * op, u32 PC)
 {
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    if (!(SR[rs] != SR[rt]))
+    if (!(SR[op->rs] != SR[op->rt]))
         return 0;
-    set_PC(PC + 4*inst + SLOT_OFF);
+    set_PC(PC + op->target + SLOT_OFF);
     return 1;
 }
-static INLINE int BLEZ(u32 inst, u32 PC)
+static int BLEZ(su_op * op, u32 PC)
 {
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-
-    if (!((s32)SR[rs] <= 0))
+    if (!((s32)SR[op->rs] <= 0))
         return 0;
-    set_PC(PC + 4*inst + SLOT_OFF);
+    set_PC(PC + op->target + SLOT_OFF);
     return 1;
 }
-static INLINE int BGTZ(u32 inst, u32 PC)
+static int BGTZ(su_op * op, u32 PC)
 {
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-
-    if (!((s32)SR[rs] >  0))
+    if (!((s32)SR[op->rs] >  0))
         return 0;
-    set_PC(PC + 4*inst + SLOT_OFF);
+    set_PC(PC + op->target + SLOT_OFF);
     return 1;
 }
 
 /*** scalar, R4000 bit-wise logical operations ***/
 
-static INLINE void ANDI(u32 inst)
+static int ANDI(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = SR[rs] & immediate;
+    SR[op->rt] = SR[op->rs] & op->imm;
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void ORI(u32 inst)
+static int ORI(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = SR[rs] | immediate;
+    SR[op->rt] = SR[op->rs] | op->imm;
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void XORI(u32 inst)
+static int XORI(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = SR[rs] ^ immediate;
+    SR[op->rt] = SR[op->rs] ^ op->imm;
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void LUI(u32 inst)
+static int LUI(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = (u32)immediate << 16; /* or:  SR[rt] = 0; SR[rt]31..16 = imm; */
+    SR[op->rt] = (u32)op->imm << 16; /* or:  SR[rt] = 0; SR[rt]31..16 = imm; */
     SR[zero] = 0x00000000;
+    return 0;
 }
 
 /*** scalar, R4000 arithmetic operations ***/
 
-static INLINE void ADDIU(u32 inst)
+static int ADDIU(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = SR[rs] + (s16)(immediate);
+    SR[op->rt] = SR[op->rs] + (s16)(op->imm);
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void SLTI(u32 inst)
+static int SLTI(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = ((s32)(SR[rs]) < (s16)(immediate)) ? 1 : 0;
+    SR[op->rt] = ((s32)(SR[op->rs]) < (s16)(op->imm)) ? 1 : 0;
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void SLTIU(u32 inst)
+static int SLTIU(su_op * op, u32 PC)
 {
-    const u16 immediate = (u16)(inst & 0x0000FFFFu);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
-
-    SR[rt] = ((u32)(SR[rs]) < (u16)(immediate)) ? 1 : 0;
+    SR[op->rt] = ((u32)(SR[op->rs]) < (u16)(op->imm)) ? 1 : 0;
     SR[zero] = 0x00000000;
+    return 0;
 }
 
 /*** scalar, R4000 memory loads and stores ***/
 
-static INLINE void LB(u32 inst)
+static int LB(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
+    const unsigned int rt = op->rt;
 
-    addr = SR[base] + offset;
     SR[rt] = DMEM[BES(addr) & 0x00000FFFul];
     SR[rt] = (s8)SR[rt];
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void LH(u32 inst)
+static int LH(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
+    const unsigned int rt = op->rt;
 
-    addr = SR[base] + offset;
     SR[rt] = 0x00000000
       | DMEM[BES(addr + 0) & 0x00000FFFul] <<  8
       | DMEM[BES(addr + 1) & 0x00000FFFul] <<  0
     ;
     SR[rt] = (s16)SR[rt];
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void LW(u32 inst)
+static int LW(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
+    const unsigned int rt = op->rt;
 
-    addr = SR[base] + offset;
     SR_B(rt, 0) = DMEM[BES(addr + 0) & 0x00000FFFul];
     SR_B(rt, 1) = DMEM[BES(addr + 1) & 0x00000FFFul];
     SR_B(rt, 2) = DMEM[BES(addr + 2) & 0x00000FFFul];
     SR_B(rt, 3) = DMEM[BES(addr + 3) & 0x00000FFFul];
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void LBU(u32 inst)
+static int LBU(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
 
-    addr = SR[base] + offset;
-    SR[rt] = DMEM[BES(addr) & 0x00000FFFul];
+    SR[op->rt] = DMEM[BES(addr) & 0x00000FFFul];
     SR[zero] = 0x00000000;
+    return 0;
 }
-static INLINE void LHU(u32 inst)
+static int LHU(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
 
-    addr = SR[base] + offset;
-    SR[rt] = 0x00000000
+    SR[op->rt] = 0x00000000
       | DMEM[BES(addr + 0) & 0x00000FFFul] <<  8
       | DMEM[BES(addr + 1) & 0x00000FFFul] <<  0
     ;
     SR[zero] = 0x00000000;
+    return 0;
 }
 
-static INLINE void SB(u32 inst)
+static int SB(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
 
-    addr = SR[base] + offset;
-    DMEM[BES(addr) & 0x00000FFFul] = (u8)(SR[rt] & 0xFFu);
+    DMEM[BES(addr) & 0x00000FFFul] = (u8)(SR[op->rt] & 0xFFu);
+    return 0;
 }
-static INLINE void SH(u32 inst)
+static int SH(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
+    const unsigned int rt = op->rt;
 
-    addr = SR[base] + offset;
     DMEM[BES(addr + 0) & 0x00000FFFul] = SR_B(rt, 2);
     DMEM[BES(addr + 1) & 0x00000FFFul] = SR_B(rt, 3);
+    return 0;
 }
-static INLINE void SW(u32 inst)
+static int SW(su_op * op, u32 PC)
 {
-    u32 addr;
-    const s16 offset = (s16)(inst & 0x0000FFFFul);
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    const u32 addr = SR[op->rs] + (s16)op->imm;
+    const unsigned int rt = op->rt;
 
-    addr = SR[base] + offset;
     DMEM[BES(addr + 0) & 0x00000FFFul] = SR_B(rt, 0);
     DMEM[BES(addr + 1) & 0x00000FFFul] = SR_B(rt, 1);
     DMEM[BES(addr + 2) & 0x00000FFFul] = SR_B(rt, 2);
     DMEM[BES(addr + 3) & 0x00000FFFul] = SR_B(rt, 3);
+    return 0;
 }
 
 /*** scalar, coprocessor operations (vector unit) ***/
@@ -1697,412 +1693,463 @@ static const unsigned char ei[1 << 4][N] = {
 };
 #endif
 
-static INLINE int SPECIAL(u32 inst, u32 PC)
-{
-    unsigned int rd, rs, rt;
+/*** scalar, SPECIAL and REGIMM ***/
 
-    rd = IW_RD(inst);
-    rt = (inst >> 16) % (1 << 5);
-
-    switch (inst % 64) {
-    case 000: /* SLL */
-        SR[rd] = SR[rt] << MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 002: /* SRL */
-        SR[rd] = (u32)(SR[rt]) >> MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 003: /* SRA */
-        SR[rd] = (s32)(SR[rt]) >> MASK_SA(inst >> 6);
-        SR[zero] = 0x00000000;
-        break;
-    case 004: /* SLLV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rt] << MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 006: /* SRLV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = (u32)(SR[rt]) >> MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 007: /* SRAV */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = (s32)(SR[rt]) >> MASK_SA(SR[rs]);
-        SR[zero] = 0x00000000;
-        break;
-    case 011: /* JALR */
-        SR[rd] = FIT_IMEM(PC + LINK_OFF);
-        SR[zero] = 0x00000000;
-     /* Fall through. */
-    case 010: /* JR */
-        rs = SPECIAL_DECODE_RS(inst);
-        set_PC(SR[rs]);
-        return 1;
-    case 015: /* BREAK */
-        *CR[0x4] |= SP_STATUS_BROKE | SP_STATUS_HALT;
-        if (*CR[0x4] & SP_STATUS_INTR_BREAK) {
-            GET_RCP_REG(MI_INTR_REG) |= 0x00000001;
-            GET_RSP_INFO(CheckInterrupts)();
-        }
-        return -1;
-    case 040: /* ADD */
-    case 041: /* ADDU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] + SR[rt];
-        SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
-        break;
-    case 042: /* SUB */
-    case 043: /* SUBU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] - SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 044: /* AND */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] & SR[rt];
-        SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
-        break;
-    case 045: /* OR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] | SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 046: /* XOR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = SR[rs] ^ SR[rt];
-        SR[zero] = 0x00000000;
-        break;
-    case 047: /* NOR */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ~(SR[rs] | SR[rt]);
-        SR[zero] = 0x00000000;
-        break;
-    case 052: /* SLT */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ((s32)(SR[rs]) < (s32)(SR[rt]));
-        SR[zero] = 0x00000000;
-        break;
-    case 053: /* SLTU */
-        rs = SPECIAL_DECODE_RS(inst);
-        SR[rd] = ((u32)(SR[rs]) < (u32)(SR[rt]));
-        SR[zero] = 0x00000000;
-        break;
-    default:
-        res_S();
+static int SLL(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rt] << MASK_SA(op->sa);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SRL(su_op * op, u32 PC)
+{
+    SR[op->rd] = (u32)(SR[op->rt]) >> MASK_SA(op->sa);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SRA(su_op * op, u32 PC)
+{
+    SR[op->rd] = (s32)(SR[op->rt]) >> MASK_SA(op->sa);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SLLV(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rt] << MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SRLV(su_op * op, u32 PC)
+{
+    SR[op->rd] = (u32)(SR[op->rt]) >> MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SRAV(su_op * op, u32 PC)
+{
+    SR[op->rd] = (s32)(SR[op->rt]) >> MASK_SA(SR[op->rs]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int JR(su_op * op, u32 PC)
+{
+    set_PC(SR[op->rs]);
+    return 1;
+}
+static int JALR(su_op * op, u32 PC)
+{
+    SR[op->rd] = FIT_IMEM(PC + LINK_OFF);
+    SR[zero] = 0x00000000;
+    set_PC(SR[op->rs]);
+    return 1;
+}
+static int BREAK(su_op * op, u32 PC)
+{
+    *CR[0x4] |= SP_STATUS_BROKE | SP_STATUS_HALT;
+    if (*CR[0x4] & SP_STATUS_INTR_BREAK) {
+        GET_RCP_REG(MI_INTR_REG) |= 0x00000001;
+        GET_RSP_INFO(CheckInterrupts)();
     }
+    return -1;
+}
+static int ADDU(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] + SR[op->rt];
+    SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
     return 0;
 }
-
-static INLINE int REGIMM(u32 inst, u32 PC)
+static int SUBU(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] - SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int AND(su_op * op, u32 PC)
 {
-    const unsigned int base = (inst >> 21) % (1 << 5);
-    const unsigned int rt   = (inst >> 16) % (1 << 5);
+    SR[op->rd] = SR[op->rs] & SR[op->rt];
+    SR[zero] = 0x00000000; /* needed for Rareware micro-codes */
+    return 0;
+}
+static int OR(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] | SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int XOR(su_op * op, u32 PC)
+{
+    SR[op->rd] = SR[op->rs] ^ SR[op->rt];
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int NOR(su_op * op, u32 PC)
+{
+    SR[op->rd] = ~(SR[op->rs] | SR[op->rt]);
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SLT(su_op * op, u32 PC)
+{
+    SR[op->rd] = ((s32)(SR[op->rs]) < (s32)(SR[op->rt]));
+    SR[zero] = 0x00000000;
+    return 0;
+}
+static int SLTU(su_op * op, u32 PC)
+{
+    SR[op->rd] = ((u32)(SR[op->rs]) < (u32)(SR[op->rt]));
+    SR[zero] = 0x00000000;
+    return 0;
+}
 
-    switch (rt) {
-    case 020: /* BLTZAL */
-        SR[ra] = FIT_IMEM(PC + LINK_OFF);
-     /* Fall through. */
-    case 000: /* BLTZ */
-        if (!((s32)SR[base] < 0))
-            return 0;
-        set_PC(PC + 4*inst + SLOT_OFF);
-        break;
-    case 021: /* BGEZAL */
-        SR[ra] = FIT_IMEM(PC + LINK_OFF);
-     /* Fall through. */
-    case 001: /* BGEZ */
-        if (!((s32)SR[base] >= 0))
-            return 0;
-        set_PC(PC + 4*inst + SLOT_OFF);
-        break;
-    default:
-        res_S();
-    }
+static int BLTZ(su_op * op, u32 PC)
+{
+    if (!((s32)SR[op->rs] < 0))
+        return 0;
+    set_PC(PC + op->target + SLOT_OFF);
     return 1;
 }
-
-static INLINE void MWC2_load(u32 inst)
+static int BGEZ(su_op * op, u32 PC)
 {
-    s16 offset;
-    const unsigned int base    = (inst >> 21) % (1 << 5);
-    const unsigned int vt      = (inst >> 16) % (1 << 5);
-    const unsigned int element = (inst >>  7) % (1 << 4);
-
-#if defined(ARCH_MIN_SSE2) && !defined(SSE2NEON)
-    offset   = (s16)inst;
-    offset <<= 5 + 4; /* safe on x86, skips 5-bit rd, 4-bit element */
-    offset >>= 5 + 4;
-#else
-    offset = (inst & 64) ? -(s16)(~inst%64 + 1) : inst % 64;
-#endif
-    LWC2[IW_RD(inst)](vt, element, offset, base);
+    if (!((s32)SR[op->rs] >= 0))
+        return 0;
+    set_PC(PC + op->target + SLOT_OFF);
+    return 1;
+}
+static int BLTZAL(su_op * op, u32 PC)
+{
+    SR[ra] = FIT_IMEM(PC + LINK_OFF);
+    return BLTZ(op, PC);
 }
-static INLINE void MWC2_store(u32 inst)
+static int BGEZAL(su_op * op, u32 PC)
 {
-    s16 offset;
-    const unsigned int base    = (inst >> 21) % (1 << 5);
-    const unsigned int vt      = (inst >> 16) % (1 << 5);
-    const unsigned int element = (inst >>  7) % (1 << 4);
+    SR[ra] = FIT_IMEM(PC + LINK_OFF);
+    return BGEZ(op, PC);
+}
 
-#if defined(ARCH_MIN_SSE2) && !defined(SSE2NEON)
-    offset = (s16)inst;
-    offset <<= 5 + 4; /* safe on x86, skips 5-bit rd, 4-bit element */
-    offset >>= 5 + 4;
-#else
-    offset = (inst & 64) ? -(s16)(~inst%64 + 1) : inst % 64;
-#endif
-    SWC2[IW_RD(inst)](vt, element, offset, base);
+static int res_op(su_op * op, u32 PC)
+{
+    res_S();
+    return 0;
 }
+static int res_REGIMM(su_op * op, u32 PC)
+{
+    res_S();
+    return 1; /* as if taken, to wherever temp_PC was left */
+}
+
+/*** scalar, coprocessor operations ***/
 
-static INLINE void COP0(u32 inst)
+static int MWC2(su_op * op, u32 PC)
 {
-    const unsigned int rd = IW_RD(inst);
-    const unsigned int rs = (inst >> 21) % (1 << 5);
-    const unsigned int rt = (inst >> 16) % (1 << 5);
+    op->func.lsw(op->rt, op->sa, (s16)op->imm, op->rs);
+    return 0;
+}
 
-    switch (rs) {
-    case 000:
-        SP_CP0_MF(rt, rd);
-        break;
-    case 004:
-        SP_CP0_MT[rd % NUMBER_OF_CP0_REGISTERS](rt);
-        break;
-    default:
-        res_S();
-    }
+static int COP0_MF(su_op * op, u32 PC)
+{
+    SP_CP0_MF(op->rt, op->rd);
+    return (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT) ? -1 : 0;
+}
+static int COP0_MT(su_op * op, u32 PC)
+{
+    SP_CP0_MT[op->rd % NUMBER_OF_CP0_REGISTERS](op->rt);
+    return (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT) ? -1 : 0;
+}
+static int COP0_res(su_op * op, u32 PC)
+{
+    res_S();
+    return (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT) ? -1 : 0;
 }
 
-static INLINE void COP2(u32 inst)
+/*
+ * For COP2, rt is vt, rd is vs, sa is vd and rs is the element selector.
+ */
+static int COP2_MF(su_op * op, u32 PC)
 {
-    const unsigned int op = (inst >> 21) % (1 << 5); /* inst.R.rs */
-    const unsigned int vt = (inst >> 16) % (1 << 5); /* inst.R.rt */
-    const unsigned int vs = IW_RD(inst);
-    const unsigned int vd = (inst >>  6) % (1 << 5); /* inst.R.sa */
-    const unsigned int func = inst % (1 << 6);
-#ifndef ARCH_MIN_SSE2
-    const unsigned int e  = op & 0xF; /* With Intel, LEA offsets beat ANDing. */
-#endif
+    MFC2(op->rt, op->rd, op->sa >> 1);
+    return 0;
+}
+static int COP2_CF(su_op * op, u32 PC)
+{
+    CFC2(op->rt, op->rd);
+    return 0;
+}
+static int COP2_MT(su_op * op, u32 PC)
+{
+    MTC2(op->rt, op->rd, op->sa >> 1);
+    return 0;
+}
+static int COP2_CT(su_op * op, u32 PC)
+{
+    CTC2(op->rt, op->rd);
+    return 0;
+}
 
-    switch (op) {
-#ifdef ARCH_MIN_SSE2
-        v16 target;
-#else
-        register unsigned int i;
-#endif
+static int COP2_V(su_op * op, u32 PC)
+{
+    const unsigned int vt = op->rt;
+    const unsigned int vs = op->rd;
+    const unsigned int vd = op->sa;
 
-    case 000:
-        MFC2(vt, vs, vd >> 1);
-        break;
-    case 002:
-        CFC2(vt, vs);
-        break;
-    case 004:
-        MTC2(vt, vs, vd >> 1);
-        break;
-    case 006:
-        CTC2(vt, vs);
-        break;
-    case 020:
-    case 021:
+    inst_word = su_ops_inst[op - su_ops]; /* VSAW and the divides decode it again */
 #ifdef ARCH_MIN_SSE2
-        *(v16 *)(VR[vd]) = COP2_C2[func](*(v16 *)VR[vs], *(v16 *)VR[vt]);
+    *(v16 *)(VR[vd]) = op->func.vector(*(v16 *)VR[vs], *(v16 *)VR[vt]);
 #else
-        COP2_C2[func](&VR[vs][0], &VR[vt][0]);
-        vector_copy(&VR[vd][0], &V_result[0]);
+    op->func.vector(&VR[vs][0], &VR[vt][0]);
+    vector_copy(&VR[vd][0], &V_result[0]);
 #endif
-        break;
-    case 022:
-    case 023:
+    return 0;
+}
+static int COP2_VQ(su_op * op, u32 PC)
+{
+    const unsigned int vt = op->rt;
+    const unsigned int vs = op->rd;
+    const unsigned int vd = op->sa;
 #ifdef ARCH_MIN_SSE2
+    const unsigned int e = op->rs - 0x12;
+    v16 target;
+
 #ifdef __ARM_NEON__
-        target = (v16)vld1q_u16(&VR[vt][0 + op - 0x12]);
-        target = (v16)vshlq_n_u32((uint32x4_t)target, 16);
-        target = (v16)vorrq_u16((uint16x8_t)target,
-                                (uint16x8_t)vshrq_n_u32((uint32x4_t)target, 16));
+    target = (v16)vld1q_u16(&VR[vt][0 + e]);
+    target = (v16)vshlq_n_u32((uint32x4_t)target, 16);
+    target = (v16)vorrq_u16((uint16x8_t)target,
+                            (uint16x8_t)vshrq_n_u32((uint32x4_t)target, 16));
 #else
-        shuffle_temporary[0] = VR[vt][0 + op - 0x12];
-        shuffle_temporary[2] = VR[vt][2 + op - 0x12];
-        shuffle_temporary[4] = VR[vt][4 + op - 0x12];
-        shuffle_temporary[6] = VR[vt][6 + op - 0x12];
-        target = *(v16 *)(&shuffle_temporary[0]);
-        target = _mm_shufflehi_epi16(target, _MM_SHUFFLE(2, 2, 0, 0));
-        target = _mm_shufflelo_epi16(target, _MM_SHUFFLE(2, 2, 0, 0));
+    shuffle_temporary[0] = VR[vt][0 + e];
+    shuffle_temporary[2] = VR[vt][2 + e];
+    shuffle_temporary[4] = VR[vt][4 + e];
+    shuffle_temporary[6] = VR[vt][6 + e];
+    target = *(v16 *)(&shuffle_temporary[0]);
+    target = _mm_shufflehi_epi16(target, _MM_SHUFFLE(2, 2, 0, 0));
+    target = _mm_shufflelo_epi16(target, _MM_SHUFFLE(2, 2, 0, 0));
 #endif
-        *(v16 *)(VR[vd]) = COP2_C2[func](*(v16 *)VR[vs], target);
+    inst_word = su_ops_inst[op - su_ops];
+    *(v16 *)(VR[vd]) = op->func.vector(*(v16 *)VR[vs], target);
 #else
-        for (i = 0; i < N; i++)
-            shuffle_temporary[i] = VR[vt][(i & 0xE) + (e & 0x1)];
-        COP2_C2[func](&VR[vs][0], &shuffle_temporary[0]);
-        vector_copy(&VR[vd][0], &V_result[0]);
+    const unsigned int e = op->rs & 0xF;
+    register unsigned int i;
+
+    for (i = 0; i < N; i++)
+        shuffle_temporary[i] = VR[vt][(i & 0xE) + (e & 0x1)];
+    inst_word = su_ops_inst[op - su_ops];
+    op->func.vector(&VR[vs][0], &shuffle_temporary[0]);
+    vector_copy(&VR[vd][0], &V_result[0]);
 #endif
-        break;
-    case 024:
-    case 025:
-    case 026:
-    case 027:
+    return 0;
+}
+static int COP2_VH(su_op * op, u32 PC)
+{
+    const unsigned int vt = op->rt;
+    const unsigned int vs = op->rd;
+    const unsigned int vd = op->sa;
 #ifdef ARCH_MIN_SSE2
+    const unsigned int e = op->rs - 0x14;
+    v16 target;
+
 #ifdef __ARM_NEON__
-        target = (v16)vcombine_s16(vdup_n_s16(VR[vt][0 + op - 0x14]),
-                                   vdup_n_s16(VR[vt][4 + op - 0x14]));
+    target = (v16)vcombine_s16(vdup_n_s16(VR[vt][0 + e]),
+                               vdup_n_s16(VR[vt][4 + e]));
 #else
-        target = _mm_setzero_si128();
-        target = _mm_insert_epi16(target, VR[vt][0 + op - 0x14], 0);
-        target = _mm_insert_epi16(target, VR[vt][4 + op - 0x14], 4);
-        target = _mm_shufflehi_epi16(target, _MM_SHUFFLE(0, 0, 0, 0));
-        target = _mm_shufflelo_epi16(target, _MM_SHUFFLE(0, 0, 0, 0));
+    target = _mm_setzero_si128();
+    target = _mm_insert_epi16(target, VR[vt][0 + e], 0);
+    target = _mm_insert_epi16(target, VR[vt][4 + e], 4);
+    target = _mm_shufflehi_epi16(target, _MM_SHUFFLE(0, 0, 0, 0));
+    target = _mm_shufflelo_epi16(target, _MM_SHUFFLE(0, 0, 0, 0));
 #endif
-        *(v16 *)(VR[vd]) = COP2_C2[func](*(v16 *)VR[vs], target);
+    inst_word = su_ops_inst[op - su_ops];
+    *(v16 *)(VR[vd]) = op->func.vector(*(v16 *)VR[vs], target);
 #else
-        for (i = 0; i < N; i++)
-            shuffle_temporary[i] = VR[vt][(i & 0xC) + (e & 0x3)];
-        COP2_C2[func](&VR[vs][0], &shuffle_temporary[0]);
-        vector_copy(&VR[vd][0], &V_result[0]);
+    const unsigned int e = op->rs & 0xF;
+    register unsigned int i;
+
+    for (i = 0; i < N; i++)
+        shuffle_temporary[i] = VR[vt][(i & 0xC) + (e & 0x3)];
+    inst_word = su_ops_inst[op - su_ops];
+    op->func.vector(&VR[vs][0], &shuffle_temporary[0]);
+    vector_copy(&VR[vd][0], &V_result[0]);
 #endif
-        break;
-    case 030:
-    case 031:
-    case 032:
-    case 033:
-    case 034:
-    case 035:
-    case 036:
-    case 037:
+    return 0;
+}
+static int COP2_VW(su_op * op, u32 PC)
+{
+    const unsigned int vt = op->rt;
+    const unsigned int vs = op->rd;
+    const unsigned int vd = op->sa;
 #ifdef ARCH_MIN_SSE2
-        *(v16 *)(VR[vd]) = COP2_C2[func](
-            *(v16 *)VR[vs],
-            _mm_set1_epi16(VR[vt][op - 0x18])
-        );
+    inst_word = su_ops_inst[op - su_ops];
+    *(v16 *)(VR[vd]) = op->func.vector(
+        *(v16 *)VR[vs],
+        _mm_set1_epi16(VR[vt][op->rs - 0x18])
+    );
 #else
-        for (i = 0; i < N; i++)
-            shuffle_temporary[i] = VR[vt][e % N];
-        COP2_C2[func](&VR[vs][0], &shuffle_temporary[0]);
-        vector_copy(&VR[vd][0], &V_result[0]);
+    const unsigned int e = op->rs & 0xF;
+    register unsigned int i;
+
+    for (i = 0; i < N; i++)
+        shuffle_temporary[i] = VR[vt][e % N];
+    inst_word = su_ops_inst[op - su_ops];
+    op->func.vector(&VR[vs][0], &shuffle_temporary[0]);
+    vector_copy(&VR[vd][0], &V_result[0]);
 #endif
-        break;
-    default:
-        res_S();
+    return 0;
+}
+
+/*** decoder and interpreter loop ***/
+
+static su_handler const SPECIAL[64] = {
+    SLL    ,res_op ,SRL    ,SRA    ,SLLV   ,res_op ,SRLV   ,SRAV   ,
+    JR     ,JALR   ,res_op ,res_op ,res_op ,BREAK  ,res_op ,res_op ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    ADDU   ,ADDU   ,SUBU   ,SUBU   ,AND    ,OR     ,XOR    ,NOR    ,
+    res_op ,res_op ,SLT    ,SLTU   ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+};
+
+static su_handler const OPCODE[64] = {
+    res_op ,res_op ,J      ,JAL    ,BEQ    ,BNE    ,BLEZ   ,BGTZ   ,
+    ADDIU  ,ADDIU  ,SLTI   ,SLTIU  ,ANDI   ,ORI    ,XORI   ,LUI    ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    LB     ,LH     ,res_op ,LW     ,LBU    ,LHU    ,res_op ,res_op ,
+    SB     ,SH     ,res_op ,SW     ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,MWC2   ,res_op ,res_op ,res_op ,res_op ,res_op ,
+    res_op ,res_op ,MWC2   ,res_op ,res_op ,res_op ,res_op ,res_op ,
+};
+
+/*
+ * Fills in one op from its instruction word.
+ * Returns non-zero for jumps and branches, which end a basic block.
+ */
+static int su_decode_op(su_op * op, u32 inst)
+{
+    op->rs  = (inst >> 21) % (1 << 5);
+    op->rt  = (inst >> 16) % (1 << 5);
+    op->rd  = (inst >> 11) % (1 << 5);
+    op->sa  = (inst >>  6) % (1 << 5);
+    op->imm = (u16)(inst & 0x0000FFFFu);
+    op->target = 4 * inst;
+    op->handler = OPCODE[inst >> 26];
+
+    switch (inst >> 26) {
+    case 000: /* SPECIAL */
+        op->handler = SPECIAL[inst % 64];
+        return (op->handler == JR || op->handler == JALR);
+    case 001: /* REGIMM */
+        switch (op->rt) {
+        case 000: op->handler = BLTZ;   break;
+        case 001: op->handler = BGEZ;   break;
+        case 020: op->handler = BLTZAL; break;
+        case 021: op->handler = BGEZAL; break;
+        default:  op->handler = res_REGIMM;
+        }
+        return 1;
+    case 002: case 003: case 004: case 005: case 006: case 007:
+        return 1;
+    case 020: /* COP0 */
+        switch (op->rs) {
+        case 000: op->handler = COP0_MF;  break;
+        case 004: op->handler = COP0_MT;  break;
+        default:  op->handler = COP0_res;
+        }
+        return 0;
+    case 022: /* COP2 */
+        op->func.vector = COP2_C2[inst % 64];
+        switch (op->rs) {
+        case 000: op->handler = COP2_MF; break;
+        case 002: op->handler = COP2_CF; break;
+        case 004: op->handler = COP2_MT; break;
+        case 006: op->handler = COP2_CT; break;
+        case 020: case 021:
+            op->handler = COP2_V;
+            break;
+        case 022: case 023:
+            op->handler = COP2_VQ;
+            break;
+        case 024: case 025: case 026: case 027:
+            op->handler = COP2_VH;
+            break;
+        case 030: case 031: case 032: case 033:
+        case 034: case 035: case 036: case 037:
+            op->handler = COP2_VW;
+            break;
+        default:
+            op->handler = res_op;
+        }
+        return 0;
+    case 062: /* LWC2 */
+    case 072: /* SWC2 */
+        op->func.lsw = ((inst >> 26) == 062 ? LWC2 : SWC2)[IW_RD(inst)];
+        op->sa  = (inst >> 7) % (1 << 4); /* element */
+        op->imm = (u16)((inst & 64) ? -(s16)(~inst%64 + 1) : inst % 64);
+        return 0;
+    }
+    return 0;
+}
+
+/*
+ * The handler of every op not decoded yet.  Decodes the rest of the basic
+ * block from here, through the delay slot of the branch ending it.
+ */
+static int su_decode(su_op * op, u32 PC)
+{
+    const unsigned int first = (unsigned int)(op - su_ops);
+    unsigned int last = 0x1000 / 4;
+    register unsigned int i;
+
+    for (i = first; i < last; i++) {
+        if (i != first && su_ops[i].handler != su_decode)
+            break;
+        su_ops_inst[i] = *(pu32)(IMEM + 4*i);
+        if (su_decode_op(&su_ops[i], su_ops_inst[i]) && last > i + 2)
+            last = i + 2;
+    }
+    return op->handler(op, PC);
+}
+
+/*
+ * Drops the ops of every IMEM word changed since it was decoded, which only
+ * the CPU can have done between two tasks.
+ */
+static void su_sync_imem(void)
+{
+    register unsigned int i;
+
+    if (su_ops_ready == 0) {
+        for (i = 0; i < 0x1000 / 4; i++)
+            su_ops[i].handler = su_decode;
+        su_ops_ready = 1;
+        return;
     }
+    for (i = 0; i < 0x1000 / 4; i++)
+        if (su_ops_inst[i] != *(pu32)(IMEM + 4*i))
+            su_ops[i].handler = su_decode;
 }
 
 NOINLINE void run_task(void)
 {
     register u32 PC;
+    su_op * op;
 
+    su_sync_imem();
     PC = FIT_IMEM(GET_RCP_REG(SP_PC_REG));
     for (;;) {
-        inst_word = *(pi32)(IMEM + FIT_IMEM(PC));
+        op = &su_ops[FIT_IMEM(PC) / 4];
 #ifdef EMULATE_STATIC_PC
         PC = (PC + 0x004);
 EX:
 #endif
 #ifdef SP_EXECUTE_LOG
+        inst_word = *(pi32)(IMEM + 4*(op - su_ops));
         step_SP_commands(inst_word);
 #endif
 
-#if (0 != 0)
-        if (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT)
-            goto RSP_halted_CPU_exit_point; /* Only BREAK and COP0 set this. */
-        SR[zero] = 0x00000000; /* already handled on per-instruction basis */
-#endif
-        switch (inst_word >> 26) {
-        case 000: /* SPECIAL */
-            switch (SPECIAL(inst_word, PC)) {
-            case -1: /* BREAK */
-                goto RSP_halted_CPU_exit_point;
-            case +1: /* JR and JALR */
-                JUMP;
-            }
-            break;
-        case 001: /* REGIMM */
-            if (REGIMM(inst_word, PC) != 0)
-                JUMP;
-            break;
-        case 002:
-            J(inst_word);
-            JUMP;
-        case 003:
-            JAL(inst_word, PC);
+        switch (op->handler(op, PC)) {
+        case -1: /* BREAK, or COP0 halted the RSP */
+            goto RSP_halted_CPU_exit_point;
+        case +1: /* jumps and taken branches */
             JUMP;
-        case 004:
-            if (BEQ(inst_word, PC) != 0)
-                JUMP;
-            break;
-        case 005:
-            if (BNE(inst_word, PC) != 0)
-                JUMP;
-            break;
-        case 006:
-            if (BLEZ(inst_word, PC) != 0)
-                JUMP;
-            break;
-        case 007:
-            if (BGTZ(inst_word, PC) != 0)
-                JUMP;
-            break;
-        case 010: /* ADDI:  Traps don't exist on the RCP. */
-        case 011:
-            ADDIU(inst_word);
-            break;
-        case 012:
-            SLTI(inst_word);
-            break;
-        case 013:
-            SLTIU(inst_word);
-            break;
-        case 014:
-            ANDI(inst_word);
-            break;
-        case 015:
-            ORI(inst_word);
-            break;
-        case 016:
-            XORI(inst_word);
-            break;
-        case 017:
-            LUI(inst_word);
-            break;
-        case 020:
-            COP0(inst_word);
-            if (GET_RCP_REG(SP_STATUS_REG) & SP_STATUS_HALT)
-                goto RSP_halted_CPU_exit_point;
-            break;
-        case 022:
-            COP2(inst_word);
-            break;
-        case 040:
-            LB(inst_word);
-            break;
-        case 041:
-            LH(inst_word);
-            break;
-        case 043:
-            LW(inst_word);
-            break;
-        case 044:
-            LBU(inst_word);
-            break;
-        case 045:
-            LHU(inst_word);
-            break;
-        case 050:
-            SB(inst_word);
-            break;
-        case 051:
-            SH(inst_word);
-            break;
-        case 053:
-            SW(inst_word);
-            break;
-        case 062: /* LWC2 */
-            MWC2_load(inst_word);
-            break;
-        case 072: /* SWC2 */
-            MWC2_store(inst_word);
-            break;
-        default:
-            res_S();
         }
 
 #ifndef EMULATE_STATIC_PC
@@ -2118,7 +2165,7 @@ EX:
 #else
         continue;
 set_branch_delay:
-        inst_word = *(pi32)(IMEM + FIT_IMEM(PC));
+        op = &su_ops[FIT_IMEM(PC) / 4];
         PC = FIT_IMEM(temp_PC);
         goto EX;
 #endif
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #endif
 
+#include "hle.h"
 #include "hle_external.h"
 #include "hle_internal.h"
 #include "memory.h"
@@ -35,6 +36,12 @@
 
 #define min(a,b) (((a) < (b)) ? (a) : (b))
 
+/* no alist command moves more than a DMEM worth of data */
+#define ALIST_MAX_TRANSFER          0x1000
+
+/* ABI1 command setting a segment base */
+#define ABI1_SEGMENT                0x07
+
 /* some rdp status flags */
 #define DP_STATUS_FREEZE            0x2
 
@@ -142,6 +149,62 @@ void hle_execute(struct hle_t* hle)
     info->uc_pfunc(hle);
 }
 
+/* Reports the RDRAM ranges the pending audio task may access, by looking at
+ * the address operands of every command of its alist. It is conservative:
+ * every operand that could be an address is reported. Returns false when the
+ * task isn't an alist one (MusyX walks RDRAM structures on its own). */
+bool hle_alist_footprint(struct hle_t* hle, hle_range_callback_t add_range, void* opaque)
+{
+    ucode_func_t uc_pfunc;
+    bool abi1, naudio;
+    uint32_t segments[0x40] = { 0 };
+    const uint32_t *alist, *alist_end;
+    uint32_t w1, w2;
+
+    if (!is_task(hle) || *dmem_u32(hle, TASK_TYPE) != 2 || hle->hle_aud)
+        return false;
+
+    uc_pfunc = try_audio_task_detection(hle);
+    if (uc_pfunc == NULL || uc_pfunc == &musyx_v1_task || uc_pfunc == &musyx_v2_task)
+        return false;
+
+    abi1 = (uc_pfunc == &alist_process_audio
+         || uc_pfunc == &alist_process_audio_ge
+         || uc_pfunc == &alist_process_audio_bc);
+
+    /* naudio passes the ADPCM and RESAMPLE state addresses in w1 */
+    naudio = (uc_pfunc == &alist_process_naudio
+           || uc_pfunc == &alist_process_naudio_bk
+           || uc_pfunc == &alist_process_naudio_dk
+           || uc_pfunc == &alist_process_naudio_mp3
+           || uc_pfunc == &alist_process_naudio_cbfd);
+
+    add_range(opaque, *dmem_u32(hle, TASK_UCODE_DATA), *dmem_u32(hle, TASK_UCODE_DATA_SIZE));
+    add_range(opaque, *dmem_u32(hle, TASK_DATA_PTR), *dmem_u32(hle, TASK_DATA_SIZE));
+
+    alist = dram_u32(hle, *dmem_u32(hle, TASK_DATA_PTR));
+    alist_end = alist + ((*dmem_u32(hle, TASK_DATA_SIZE) >> 3) << 1);
+
+    while (alist != alist_end) {
+        w1 = *(alist++);
+        w2 = *(alist++);
+
+        if (abi1) {
+            if (((w1 >> 24) & 0x7f) == ABI1_SEGMENT)
+                segments[(w2 >> 24) & 0x3f] = w2 & 0xffffff;
+
+            add_range(opaque, segments[(w2 >> 24) & 0x3f] + (w2 & 0xffffff), ALIST_MAX_TRANSFER);
+        }
+
+        if (naudio)
+            add_range(opaque, w1 & 0xffffff, ALIST_MAX_TRANSFER);
+
+        add_range(opaque, w2 & 0xffffff, ALIST_MAX_TRANSFER);
+    }
+
+    return true;
+}
+
 /* local functions */
 static unsigned int sum_bytes(const unsigned char *bytes, unsigned int size)
 {
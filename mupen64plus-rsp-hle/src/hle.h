@@ -22,6 +22,9 @@
 #ifndef HLE_H
 #define HLE_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "hle_internal.h"
 
 void hle_init(struct hle_t* hle,
@@ -50,5 +53,9 @@ void hle_init(struct hle_t* hle,
 
 void hle_execute(struct hle_t* hle);
 
+typedef void (*hle_range_callback_t)(void* opaque, uint32_t address, uint32_t length);
+
+bool hle_alist_footprint(struct hle_t* hle, hle_range_callback_t add_range, void* opaque);
+
 #endif
 
@@ -23,6 +23,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "common.h"
@@ -44,13 +45,22 @@
 #define RSP_HLE_VERSION        0x020509
 #define RSP_PLUGIN_API_VERSION 0x020000
 
+/* RSP instance and the core callbacks it reports to, handed to the HLE
+ * core as its user_defined pointer */
+struct hle_plugin
+{
+    struct hle_t hle;
+    void (*CheckInterrupts)(void);
+    void (*ProcessDlistList)(void);
+    void (*ProcessAlistList)(void);
+    void (*ProcessRdpList)(void);
+    void (*ShowCFB)(void);
+    unsigned int* MiIntrReg;
+    unsigned int* SpStatusReg;
+};
+
 /* local variables */
-static struct hle_t g_hle;
-static void (*l_CheckInterrupts)(void) = NULL;
-static void (*l_ProcessDlistList)(void) = NULL;
-static void (*l_ProcessAlistList)(void) = NULL;
-static void (*l_ProcessRdpList)(void) = NULL;
-static void (*l_ShowCFB)(void) = NULL;
+static struct hle_plugin l_Plugin;
 static void (*l_DebugCallback)(void *, int, const char *) = NULL;
 static void *l_DebugCallContext = NULL;
 static int l_PluginInit = 0;
@@ -102,44 +112,54 @@ void HleWarnMessage(void* UNUSED(user_defined), const char *message, ...)
 {
 }
 
-void HleCheckInterrupts(void* UNUSED(user_defined))
+void HleCheckInterrupts(void* user_defined)
 {
-    if (l_CheckInterrupts == NULL)
+    struct hle_plugin* plugin = (struct hle_plugin*)user_defined;
+
+    if (plugin->CheckInterrupts == NULL)
         return;
 
-    (*l_CheckInterrupts)();
+    (*plugin->CheckInterrupts)();
 }
 
-void HleProcessDlistList(void* UNUSED(user_defined))
+void HleProcessDlistList(void* user_defined)
 {
-    if (l_ProcessDlistList == NULL)
+    struct hle_plugin* plugin = (struct hle_plugin*)user_defined;
+
+    if (plugin->ProcessDlistList == NULL)
         return;
 
-    (*l_ProcessDlistList)();
+    (*plugin->ProcessDlistList)();
 }
 
-void HleProcessAlistList(void* UNUSED(user_defined))
+void HleProcessAlistList(void* user_defined)
 {
-    if (l_ProcessAlistList == NULL)
+    struct hle_plugin* plugin = (struct hle_plugin*)user_defined;
+
+    if (plugin->ProcessAlistList == NULL)
         return;
 
-    (*l_ProcessAlistList)();
+    (*plugin->ProcessAlistList)();
 }
 
-void HleProcessRdpList(void* UNUSED(user_defined))
+void HleProcessRdpList(void* user_defined)
 {
-    if (l_ProcessRdpList == NULL)
+    struct hle_plugin* plugin = (struct hle_plugin*)user_defined;
+
+    if (plugin->ProcessRdpList == NULL)
         return;
 
-    (*l_ProcessRdpList)();
+    (*plugin->ProcessRdpList)();
 }
 
-void HleShowCFB(void* UNUSED(user_defined))
+void HleShowCFB(void* user_defined)
 {
-    if (l_ShowCFB == NULL)
+    struct hle_plugin* plugin = (struct hle_plugin*)user_defined;
+
+    if (plugin->ShowCFB == NULL)
         return;
 
-    (*l_ShowCFB)();
+    (*plugin->ShowCFB)();
 }
 
 int HleForwardTask(void* user_defined)
@@ -177,61 +197,113 @@ EXPORT m64p_error CALL hlePluginShutdown(void)
     return M64ERR_SUCCESS;
 }
 
-EXPORT unsigned int CALL hleDoRspCycles(unsigned int Cycles)
+static void plugin_init(struct hle_plugin* plugin, RSP_INFO* Rsp_Info)
 {
-    hle_execute(&g_hle);
+    hle_init(&plugin->hle,
+             Rsp_Info->RDRAM,
+             Rsp_Info->DMEM,
+             Rsp_Info->IMEM,
+             Rsp_Info->MI_INTR_REG,
+             Rsp_Info->SP_MEM_ADDR_REG,
+             Rsp_Info->SP_DRAM_ADDR_REG,
+             Rsp_Info->SP_RD_LEN_REG,
+             Rsp_Info->SP_WR_LEN_REG,
+             Rsp_Info->SP_STATUS_REG,
+             Rsp_Info->SP_DMA_FULL_REG,
+             Rsp_Info->SP_DMA_BUSY_REG,
+             Rsp_Info->SP_PC_REG,
+             Rsp_Info->SP_SEMAPHORE_REG,
+             Rsp_Info->DPC_START_REG,
+             Rsp_Info->DPC_END_REG,
+             Rsp_Info->DPC_CURRENT_REG,
+             Rsp_Info->DPC_STATUS_REG,
+             Rsp_Info->DPC_CLOCK_REG,
+             Rsp_Info->DPC_BUFBUSY_REG,
+             Rsp_Info->DPC_PIPEBUSY_REG,
+             Rsp_Info->DPC_TMEM_REG,
+             plugin);
+
+    plugin->MiIntrReg = Rsp_Info->MI_INTR_REG;
+    plugin->SpStatusReg = Rsp_Info->SP_STATUS_REG;
+
+    plugin->CheckInterrupts = Rsp_Info->CheckInterrupts;
+    plugin->ProcessDlistList = Rsp_Info->ProcessDlistList;
+    plugin->ProcessAlistList = Rsp_Info->ProcessAlistList;
+    plugin->ProcessRdpList = Rsp_Info->ProcessRdpList;
+    plugin->ShowCFB = Rsp_Info->ShowCFB;
+
+    plugin->hle.hle_gfx = 1;
+    plugin->hle.hle_aud = 0;
+}
+
+/* Instances besides the plugin's own one, for running several emulators in
+ * one process. Each keeps its own task state and reports to the core
+ * callbacks of its RSP_INFO. */
+EXPORT struct hle_plugin* CALL hleCreateInstance(RSP_INFO Rsp_Info)
+{
+    struct hle_plugin* plugin = calloc(1, sizeof(*plugin));
+
+    if (plugin != NULL)
+        plugin_init(plugin, &Rsp_Info);
+
+    return plugin;
+}
+
+EXPORT void CALL hleDestroyInstance(struct hle_plugin* plugin)
+{
+    free(plugin);
+}
+
+EXPORT unsigned int CALL hleInstanceDoRspCycles(struct hle_plugin* plugin, unsigned int Cycles)
+{
+    hle_execute(&plugin->hle);
     return Cycles;
 }
 
+EXPORT void CALL hleInstanceRomClosed(struct hle_plugin* plugin)
+{
+    plugin->hle.cached_ucodes.count = 0;
+}
+
+EXPORT unsigned int CALL hleDoRspCycles(unsigned int Cycles)
+{
+    return hleInstanceDoRspCycles(&l_Plugin, Cycles);
+}
+
 EXPORT void CALL hleInitiateRSP(RSP_INFO Rsp_Info, unsigned int* CycleCount)
 {
-    hle_init(&g_hle,
-             Rsp_Info.RDRAM,
-             Rsp_Info.DMEM,
-             Rsp_Info.IMEM,
-             Rsp_Info.MI_INTR_REG,
-             Rsp_Info.SP_MEM_ADDR_REG,
-             Rsp_Info.SP_DRAM_ADDR_REG,
-             Rsp_Info.SP_RD_LEN_REG,
-             Rsp_Info.SP_WR_LEN_REG,
-             Rsp_Info.SP_STATUS_REG,
-             Rsp_Info.SP_DMA_FULL_REG,
-             Rsp_Info.SP_DMA_BUSY_REG,
-             Rsp_Info.SP_PC_REG,
-             Rsp_Info.SP_SEMAPHORE_REG,
-             Rsp_Info.DPC_START_REG,
-             Rsp_Info.DPC_END_REG,
-             Rsp_Info.DPC_CURRENT_REG,
-             Rsp_Info.DPC_STATUS_REG,
-             Rsp_Info.DPC_CLOCK_REG,
-             Rsp_Info.DPC_BUFBUSY_REG,
-             Rsp_Info.DPC_PIPEBUSY_REG,
-             Rsp_Info.DPC_TMEM_REG,
-             NULL);
-
-    l_CheckInterrupts = Rsp_Info.CheckInterrupts;
-    l_ProcessDlistList = Rsp_Info.ProcessDlistList;
-    l_ProcessAlistList = Rsp_Info.ProcessAlistList;
-    l_ProcessRdpList = Rsp_Info.ProcessRdpList;
-    l_ShowCFB = Rsp_Info.ShowCFB;
+    plugin_init(&l_Plugin, &Rsp_Info);
 
     // Is the DoCommand really needed? It's upstream
     m64p_rom_header rom_header;
     CoreDoCommand(M64CMD_ROM_GET_HEADER, sizeof(rom_header), &rom_header);
 
-    g_hle.hle_gfx = 1;
-    g_hle.hle_aud = 0;
-    
     /* notify fallback plugin */
     /*if (l_InitiateRSP) {
         l_InitiateRSP(Rsp_Info, CycleCount);
     }*/
 }
 
+/* Redirects the MI_INTR and SP_STATUS writes of the following tasks, so that
+ * a task run off the emulation thread doesn't modify the live registers.
+ * NULL restores the registers given to InitiateRSP. */
+EXPORT void CALL hleSetTaskRegisters(unsigned int* mi_intr, unsigned int* sp_status)
+{
+    l_Plugin.hle.mi_intr = (mi_intr != NULL) ? mi_intr : l_Plugin.MiIntrReg;
+    l_Plugin.hle.sp_status = (sp_status != NULL) ? sp_status : l_Plugin.SpStatusReg;
+}
+
+/* Reports the RDRAM ranges of the pending audio task, see hle_alist_footprint.
+ * Returns 0 when they can't be bounded. */
+EXPORT int CALL hleAudioTaskFootprint(void (*add_range)(void*, uint32_t, uint32_t), void* opaque)
+{
+    return hle_alist_footprint(&l_Plugin.hle, add_range, opaque) ? 1 : 0;
+}
+
 EXPORT void CALL hleRomClosed(void)
 {
-     g_hle.cached_ucodes.count = 0;
-     
+    hleInstanceRomClosed(&l_Plugin);
+
     /* notify fallback plugin */
     /*if (l_RomClosed) {
         l_RomClosed();
@@ -37,6 +37,8 @@ extern uint32_t screen_pitch;
 
 struct n64video_config config;
 
+static struct n64video* video;
+
 void plugin_init(void)
 {
 }
@@ -161,8 +163,8 @@ void angrylion_set_vi(unsigned value)
       config.vi.mode = (enum vi_mode)value;
       if (angrylion_init)
       {
-          n64video_close();
-          n64video_init(&config);
+          n64video_close(video);
+          n64video_init(video, &config);
       }
    }
 }
@@ -175,8 +177,8 @@ void angrylion_set_threads(unsigned value)
      config.num_workers = value;
      if (angrylion_init)
      {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
      }
     }
     
@@ -189,8 +191,8 @@ void angrylion_set_overscan(unsigned value)
       config.vi.hide_overscan = (bool)value;
       if (angrylion_init)
       {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
       }
    }
     
@@ -203,8 +205,8 @@ void angrylion_set_vi_dedither(unsigned value)
       config.vi.vi_dedither = (bool)value;
       if (angrylion_init)
       {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
       }
    }
     
@@ -217,13 +219,31 @@ void angrylion_set_vi_blur(unsigned value)
       config.vi.vi_blur = (bool)value;
       if (angrylion_init)
       {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
       }
    }
     
 }
 
+void angrylion_set_vi_pipeline(unsigned value)
+{
+   if(config.vi.pipeline != (bool)value)
+   {
+      config.vi.pipeline = (bool)value;
+      if (angrylion_init)
+      {
+         n64video_close(video);
+         n64video_init(video, &config);
+      }
+   }
+}
+
+void *angrylion_present_screen(void)
+{
+   return n64video_present_screen(video);
+}
+
 void angrylion_set_synclevel(unsigned value)
 {
    if(config.dp.compat != (enum dp_compat_profile)value)
@@ -231,8 +251,8 @@ void angrylion_set_synclevel(unsigned value)
       config.dp.compat= (enum dp_compat_profile)value;
       if (angrylion_init)
       {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
       }
    }
 }
@@ -265,8 +285,8 @@ void angrylion_set_filtering(unsigned filter_type)
       config.vi.interp = (enum vi_interp)filter_type;
       if (angrylion_init)
       {
-         n64video_close();
-         n64video_init(&config);
+         n64video_close(video);
+         n64video_init(video, &config);
       }
    }
 }
@@ -302,6 +322,11 @@ void angrylionSetRenderingCallback(void (*callback)(int)) { }
 
 int angrylionInitiateGFX (GFX_INFO Gfx_Info)
 {
+   if (!video)
+      video = n64video_create();
+   if (!video)
+      return 0;
+
    n64video_config_init(&config);
    return 1;
 }
@@ -316,12 +341,12 @@ void angrylionProcessDList(void)
 
 void angrylionProcessRDPList(void)
 {
-  n64video_process_list();
+  n64video_process_list(video);
 }
 
 void angrylionRomClosed (void)
 {
-  n64video_close();
+  n64video_close(video);
 }
 
 int angrylionRomOpen(void)
@@ -355,7 +380,7 @@ int angrylionRomOpen(void)
   config.gfx.vi_reg      = plugin_get_vi_registers();
   config.gfx.dp_reg      = plugin_get_dp_registers();
 
-   n64video_init(&config);
+   n64video_init(video, &config);
    angrylion_init        = true;
    return 1;
 }
@@ -368,7 +393,7 @@ void angrylionUpdateScreen(void)
         return;
     counter = 0;
 #endif
-    n64video_update_screen();
+    n64video_update_screen(video);
     
 }
 
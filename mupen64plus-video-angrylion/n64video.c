@@ -88,15 +88,52 @@ void angrylion_set_vi(unsigned value);
 #define CMD_ID_SET_MASK_IMAGE                  0x3e
 #define CMD_ID_SET_COLOR_IMAGE                 0x3f
 
-#define config al_config
-static struct n64video_config config;
+struct rdp_state;
+struct vi_state;
 
-static struct
+// everything a renderer instance keeps, see n64video_create()
+struct n64video
 {
-    bool fillmbitcrashes, vbusclock, nolerp;
-} onetimewarnings;
+    struct n64video_config config;
 
-static int rdp_pipeline_crashed = 0;
+    struct
+    {
+        bool fillmbitcrashes, vbusclock, nolerp;
+    } onetimewarnings;
+
+    int rdp_pipeline_crashed;
+
+    // true while the instance holds a reference to the shared worker pool
+    bool parallel;
+
+    // commands buffered for parallel processing and the one being read
+    uint32_t cmd_buf[CMD_BUFFER_SIZE][CMD_MAX_INTS];
+    uint32_t cmd_buf_pos;
+
+    uint32_t cmd_pos;
+    uint32_t cmd_id;
+    uint32_t cmd_len;
+
+    // table of commands that require thread synchronization in
+    // multithreaded mode
+    bool cmd_sync[64];
+
+    // per-worker RDP state, VI state and the hidden RDRAM bits, reached by
+    // the RDP and VI code through the file-scope pointers of the same name
+    // that n64video_bind() points at the instance
+    struct rdp_state* state;
+    struct vi_state* vi;
+    uint8_t* rdram_hidden;
+};
+
+// instance the entry points were last called with
+static struct n64video* video;
+
+static void n64video_bind(struct n64video* handle);
+
+// number of instances using the worker pool, which is shared by all of them
+// and sized by the first one
+static uint32_t parallel_users;
 
 static STRICTINLINE int32_t clamp(int32_t value, int32_t min, int32_t max)
 {
@@ -116,40 +153,46 @@ static STRICTINLINE uint32_t irand(uint32_t* state)
 #include "n64video/rdp.c"
 #include "n64video/vi.c"
 
-static uint32_t rdp_cmd_buf[CMD_BUFFER_SIZE][CMD_MAX_INTS];
-static uint32_t rdp_cmd_buf_pos;
+static void n64video_bind(struct n64video* handle)
+{
+    if (video == handle) {
+        return;
+    }
 
-static uint32_t rdp_cmd_pos;
-static uint32_t rdp_cmd_id;
-static uint32_t rdp_cmd_len;
+    // a pipelined filter pass of the previous instance still reads its state
+    if (video) {
+        vi_sync();
+    }
 
-// table of commands that require thread synchronization in
-// multithreaded mode
-static bool rdp_cmd_sync[64];
+    video = handle;
+    state = handle->state;
+    vi = handle->vi;
+    rdram_bind();
+}
 
 static void cmd_run_buffered(uint32_t worker_id)
 {
     uint32_t pos;
-    for (pos = 0; pos < rdp_cmd_buf_pos; pos++)
-        rdp_cmd(worker_id, rdp_cmd_buf[pos]);
+    for (pos = 0; pos < video->cmd_buf_pos; pos++)
+        rdp_cmd(worker_id, video->cmd_buf[pos]);
 }
 
 static void cmd_flush(void)
 {
     // only run if there's something buffered
-    if (rdp_cmd_buf_pos) {
+    if (video->cmd_buf_pos) {
         // let workers run all buffered commands in parallel
         parallel_run(cmd_run_buffered);
         // reset buffer by starting from the beginning
-        rdp_cmd_buf_pos = 0;
+        video->cmd_buf_pos = 0;
     }
 }
 
 static void cmd_init(void)
 {
-    rdp_cmd_pos = 0;
-    rdp_cmd_id = 0;
-    rdp_cmd_len = CMD_MAX_INTS;
+    video->cmd_pos = 0;
+    video->cmd_id = 0;
+    video->cmd_len = CMD_MAX_INTS;
 }
 
 void n64video_config_init(struct n64video_config* config)
@@ -167,12 +210,24 @@ void rdp_init_worker(uint32_t worker_id)
     rdp_init(worker_id, parallel_num_workers());
 }
 
-void n64video_init(struct n64video_config* xconfig)
+struct n64video* n64video_create(void)
 {
-    if (xconfig)
-        config = *xconfig;
+    struct n64video* handle = calloc(1, sizeof(*handle));
+    if (!handle) {
+        return NULL;
+    }
+
+    handle->state = calloc(PARALLEL_MAX_WORKERS, sizeof(*handle->state));
+    handle->vi = calloc(1, sizeof(*handle->vi));
+    handle->rdram_hidden = malloc(RDRAM_MAX_SIZE / 2);
+    if (!handle->state || !handle->vi || !handle->rdram_hidden) {
+        n64video_destroy(handle);
+        return NULL;
+    }
+
+    n64video_config_init(&handle->config);
 
-    // initialize static lookup tables and RDP state, once is enough
+    // initialize static lookup tables, once is enough
     static bool static_init;
     if (!static_init)
     {
@@ -182,24 +237,53 @@ void n64video_init(struct n64video_config* xconfig)
         tex_init_lut();
         z_init_lut();
 
-        fb_init(0);
-        combiner_init(0);
-        tex_init(0);
-        rasterizer_init(0);
-
         static_init = true;
     }
 
+    // initialize the RDP state, it's kept when the instance is reinitialized
+    n64video_bind(handle);
+    fb_init(0);
+    combiner_init(0);
+    tex_init(0);
+    rasterizer_init(0);
+
+    return handle;
+}
+
+void n64video_destroy(struct n64video* handle)
+{
+    if (!handle) {
+        return;
+    }
+
+    if (video == handle) {
+        vi_sync();
+        video = NULL;
+    }
+
+    free(handle->state);
+    free(handle->vi);
+    free(handle->rdram_hidden);
+    free(handle);
+}
+
+void n64video_init(struct n64video* handle, struct n64video_config* xconfig)
+{
+    n64video_bind(handle);
+
+    if (xconfig)
+        video->config = *xconfig;
+
     // enable sync switches depending on compatibility mode
-    memset(rdp_cmd_sync, 0, sizeof(rdp_cmd_sync));
-    switch (config.dp.compat) {
+    memset(video->cmd_sync, 0, sizeof(video->cmd_sync));
+    switch (video->config.dp.compat) {
         case DP_COMPAT_HIGH:
-            rdp_cmd_sync[CMD_ID_SET_TEXTURE_IMAGE] = true;
+            video->cmd_sync[CMD_ID_SET_TEXTURE_IMAGE] = true;
         case DP_COMPAT_MEDIUM:
-            rdp_cmd_sync[CMD_ID_SET_MASK_IMAGE] = true;
-            rdp_cmd_sync[CMD_ID_SET_COLOR_IMAGE] = true;
+            video->cmd_sync[CMD_ID_SET_MASK_IMAGE] = true;
+            video->cmd_sync[CMD_ID_SET_COLOR_IMAGE] = true;
         case DP_COMPAT_LOW:
-            rdp_cmd_sync[CMD_ID_SYNC_FULL] = true;
+            video->cmd_sync[CMD_ID_SYNC_FULL] = true;
     }
 
     // init internals
@@ -207,14 +291,16 @@ void n64video_init(struct n64video_config* xconfig)
     vi_init();
     cmd_init();
 
-    rdp_pipeline_crashed = 0;
-    memset(&onetimewarnings, 0, sizeof(onetimewarnings));
+    video->rdp_pipeline_crashed = 0;
+    memset(&video->onetimewarnings, 0, sizeof(video->onetimewarnings));
 
-    if (config.parallel)
+    if (video->config.parallel)
     {
        uint32_t i;
-       // init worker system
-       parallel_alinit(config.num_workers);
+       // init worker system, unless another instance started it already
+       if (!video->parallel && !parallel_users++)
+          parallel_alinit(video->config.num_workers);
+       video->parallel = true;
 
        // sync states from main worker
        for (i = 1; i < parallel_num_workers(); i++)
@@ -227,14 +313,16 @@ void n64video_init(struct n64video_config* xconfig)
         rdp_init(0, 1);
 }
 
-void n64video_process_list(void)
+void n64video_process_list(struct n64video* handle)
 {
-    uint32_t** dp_reg = config.gfx.dp_reg;
+    n64video_bind(handle);
+
+    uint32_t** dp_reg = video->config.gfx.dp_reg;
     uint32_t dp_current_al = (*dp_reg[DP_CURRENT] & ~7) >> 2;
     uint32_t dp_end_al = (*dp_reg[DP_END] & ~7) >> 2;
 
     // don't do anything if the RDP has crashed or the registers are not set up correctly
-    if (rdp_pipeline_crashed || dp_end_al <= dp_current_al) {
+    if (video->rdp_pipeline_crashed || dp_end_al <= dp_current_al) {
         return;
     }
 
@@ -242,40 +330,40 @@ void n64video_process_list(void)
     while (dp_end_al - dp_current_al > 0) {
         uint32_t i, toload;
         bool xbus_dma = (*dp_reg[DP_STATUS] & DP_STATUS_XBUS_DMA) != 0;
-        uint32_t* dmem = (uint32_t*)config.gfx.dmem;
-        uint32_t* cmd_buf = rdp_cmd_buf[rdp_cmd_buf_pos];
+        uint32_t* dmem = (uint32_t*)video->config.gfx.dmem;
+        uint32_t* cmd_buf = video->cmd_buf[video->cmd_buf_pos];
 
         // when reading the first int, extract the command ID and update the buffer length
-        if (rdp_cmd_pos == 0) {
+        if (video->cmd_pos == 0) {
             if (xbus_dma) {
-                cmd_buf[rdp_cmd_pos++] = dmem[dp_current_al++ & 0x3ff];
+                cmd_buf[video->cmd_pos++] = dmem[dp_current_al++ & 0x3ff];
             } else {
-                cmd_buf[rdp_cmd_pos++] = rdram_read_idx32(dp_current_al++);
+                cmd_buf[video->cmd_pos++] = rdram_read_idx32(dp_current_al++);
             }
 
-            rdp_cmd_id = CMD_ID(cmd_buf);
-            rdp_cmd_len = rdp_commands[rdp_cmd_id].length >> 2;
+            video->cmd_id = CMD_ID(cmd_buf);
+            video->cmd_len = rdp_commands[video->cmd_id].length >> 2;
         }
 
         // copy more data from the N64 to the local command buffer
-        toload = MIN(dp_end_al - dp_current_al, rdp_cmd_len - 1);
+        toload = MIN(dp_end_al - dp_current_al, video->cmd_len - 1);
 
         if (xbus_dma) {
             for (i = 0; i < toload; i++) {
-                cmd_buf[rdp_cmd_pos++] = dmem[dp_current_al++ & 0x3ff];
+                cmd_buf[video->cmd_pos++] = dmem[dp_current_al++ & 0x3ff];
             }
         } else {
             for (i = 0; i < toload; i++) {
-                cmd_buf[rdp_cmd_pos++] = rdram_read_idx32(dp_current_al++);
+                cmd_buf[video->cmd_pos++] = rdram_read_idx32(dp_current_al++);
             }
         }
 
         // if there's enough data for the current command...
-        if (rdp_cmd_pos == rdp_cmd_len) {
+        if (video->cmd_pos == video->cmd_len) {
             // check if parallel processing is enabled
-            if (config.parallel) {
+            if (video->config.parallel) {
                 // special case: sync_full always needs to be run in main thread
-                if (rdp_cmd_id == CMD_ID_SYNC_FULL) {
+                if (video->cmd_id == CMD_ID_SYNC_FULL) {
                     // first, run all pending commands
                     cmd_flush();
 
@@ -283,10 +371,10 @@ void n64video_process_list(void)
                     rdp_sync_full(0, NULL);
                 } else {
                     // increment buffer position
-                    rdp_cmd_buf_pos++;
+                    video->cmd_buf_pos++;
 
                     // flush buffer when it is full or when the current command requires a sync
-                    if (rdp_cmd_buf_pos >= CMD_BUFFER_SIZE || rdp_cmd_sync[rdp_cmd_id]) {
+                    if (video->cmd_buf_pos >= CMD_BUFFER_SIZE || video->cmd_sync[video->cmd_id]) {
                         cmd_flush();
                     }
                 }
@@ -296,7 +384,7 @@ void n64video_process_list(void)
             }
 
             // send Z-buffer address to VI for "depth" output mode
-            if (rdp_cmd_id == CMD_ID_SET_MASK_IMAGE) {
+            if (video->cmd_id == CMD_ID_SET_MASK_IMAGE) {
                 vi_set_zbuffer_address(cmd_buf[1] & 0x0ffffff);
             }
 
@@ -309,8 +397,16 @@ void n64video_process_list(void)
     *dp_reg[DP_START] = *dp_reg[DP_CURRENT] = *dp_reg[DP_END];
 }
 
-void n64video_close(void)
+void n64video_close(struct n64video* handle)
 {
+    n64video_bind(handle);
+
     vi_close();
-    parallel_close();
+
+    // the last instance using the worker pool shuts it down
+    if (video->parallel) {
+        video->parallel = false;
+        if (!--parallel_users)
+            parallel_close();
+    }
 }
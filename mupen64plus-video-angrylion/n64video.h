@@ -83,6 +83,7 @@ struct n64video_config
         bool exclusive;             // run in exclusive mode when in fullscreen if true
         bool vi_dedither;           // enable dedithering if true
         bool vi_blur;               // enable bilateral blur if true
+        bool pipeline;              // filter on the workers while the next frame is emulated if true
     } vi;
     struct {
         enum dp_compat_profile compat;  // multithreading compatibility mode
@@ -92,8 +93,17 @@ struct n64video_config
     uint32_t num_workers;           // number of rendering workers
 };
 
+// renderer instance, each one keeps its own RDP, VI and command state. The
+// instances share the worker pool and are meant to be driven from one thread
+// at a time, a pipelined VI pass is waited for when switching between them.
+struct n64video;
+
+struct n64video* n64video_create(void);
+void n64video_destroy(struct n64video* video);
+
 void n64video_config_init(struct n64video_config* config);
-void n64video_init(struct n64video_config* config);
-void n64video_update_screen(void);
-void n64video_process_list(void);
-void n64video_close(void);
+void n64video_init(struct n64video* video, struct n64video_config* config);
+void n64video_update_screen(struct n64video* video);
+void* n64video_present_screen(struct n64video* video);
+void n64video_process_list(struct n64video* video);
+void n64video_close(struct n64video* video);
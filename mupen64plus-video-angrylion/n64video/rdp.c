@@ -338,7 +338,8 @@ struct rdp_state
     int32_t pastrawdzmem;
 };
 
-struct rdp_state state[PARALLEL_MAX_WORKERS];
+// per-worker state of the bound instance
+static struct rdp_state* state;
 
 static int32_t one_color = 0x100;
 static int32_t zero_color = 0x00;
@@ -592,8 +593,8 @@ void rdp_sync_tile(uint32_t wid, const uint32_t* args)
 void rdp_sync_full(uint32_t wid, const uint32_t* args)
 {
     // signal DP interrupt
-    *config.gfx.mi_intr_reg |= DP_INTERRUPT;
-    config.gfx.mi_intr_cb();
+    *video->config.gfx.mi_intr_reg |= DP_INTERRUPT;
+    video->config.gfx.mi_intr_cb();
 }
 
 void rdp_set_other_modes(uint32_t wid, const uint32_t* args)
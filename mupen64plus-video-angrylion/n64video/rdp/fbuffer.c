@@ -85,7 +85,7 @@ static void fbwrite_32(uint32_t wid, uint32_t curpixel, uint32_t r, uint32_t g,
 
 static void fbfill_4(uint32_t wid, uint32_t curpixel)
 {
-    rdp_pipeline_crashed = 1;
+    video->rdp_pipeline_crashed = 1;
 }
 
 static void fbfill_8(uint32_t wid, uint32_t curpixel)
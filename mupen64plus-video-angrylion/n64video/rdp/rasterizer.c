@@ -1586,7 +1586,7 @@ static void render_spans_fill(uint32_t wid, int start, int end, int flip)
 {
     if (state[wid].fb_size == PIXEL_SIZE_4BIT)
     {
-        rdp_pipeline_crashed = 1;
+        video->rdp_pipeline_crashed = 1;
         return;
     }
 
@@ -1616,11 +1616,11 @@ static void render_spans_fill(uint32_t wid, int start, int end, int flip)
         {
             if (fastkillbits && length >= 0)
             {
-                if (!onetimewarnings.fillmbitcrashes)
+                if (!video->onetimewarnings.fillmbitcrashes)
                     msg_warning("render_spans_fill: image_read_en %x z_update_en %x z_compare_en %x. RDP crashed",
                     state[wid].other_modes.image_read_en, state[wid].other_modes.z_update_en, state[wid].other_modes.z_compare_en);
-                onetimewarnings.fillmbitcrashes = true;
-                rdp_pipeline_crashed = 1;
+                video->onetimewarnings.fillmbitcrashes = true;
+                video->rdp_pipeline_crashed = 1;
                 return;
             }
 
@@ -1656,11 +1656,11 @@ static void render_spans_fill(uint32_t wid, int start, int end, int flip)
 
             if (slowkillbits && length >= 0)
             {
-                if (!onetimewarnings.fillmbitcrashes)
+                if (!video->onetimewarnings.fillmbitcrashes)
                     msg_warning("render_spans_fill: image_read_en %x z_update_en %x z_compare_en %x z_source_sel %x. RDP crashed",
                     state[wid].other_modes.image_read_en, state[wid].other_modes.z_update_en, state[wid].other_modes.z_compare_en, state[wid].other_modes.z_source_sel);
-                onetimewarnings.fillmbitcrashes = 1;
-                rdp_pipeline_crashed = 1;
+                video->onetimewarnings.fillmbitcrashes = 1;
+                video->rdp_pipeline_crashed = 1;
                 return;
             }
         }
@@ -1673,7 +1673,7 @@ static void render_spans_copy(uint32_t wid, int start, int end, int tilenum, int
 
     if (state[wid].fb_size == PIXEL_SIZE_32BIT)
     {
-        rdp_pipeline_crashed = 1;
+        video->rdp_pipeline_crashed = 1;
         return;
     }
 
@@ -21,7 +21,8 @@
 
 #define PAIRWRITE8(in, rval, hval) rdram_write_pair8((in), (rval), (hval))
 
-// pointer indexing limits for aliasing RDRAM reads and writes
+// RDRAM of the bound instance and its pointer indexing limits for aliasing
+// RDRAM reads and writes
 static uint32_t idxlim8;
 static uint32_t idxlim16;
 static uint32_t idxlim32;
@@ -29,19 +30,24 @@ static uint32_t idxlim32;
 static uint32_t* rdram32;
 static uint16_t* rdram16;
 static uint8_t* rdram8;
-static uint8_t rdram_hidden[RDRAM_MAX_SIZE / 2];
+static uint8_t* rdram_hidden;
 
-static void rdram_init(void)
+static void rdram_bind(void)
 {
-    idxlim8 = config.gfx.rdram_size - 1;
+    idxlim8 = video->config.gfx.rdram_size - 1;
     idxlim16 = (idxlim8 >> 1) & 0xffffffu;
     idxlim32 = (idxlim8 >> 2) & 0xffffffu;
 
-    rdram32 = (uint32_t*)config.gfx.rdram;
-    rdram16 = (uint16_t*)config.gfx.rdram;
-    rdram8 = config.gfx.rdram;
+    rdram32 = (uint32_t*)video->config.gfx.rdram;
+    rdram16 = (uint16_t*)video->config.gfx.rdram;
+    rdram8 = video->config.gfx.rdram;
+    rdram_hidden = video->rdram_hidden;
+}
 
-    memset(rdram_hidden, 3, sizeof(rdram_hidden));
+static void rdram_init(void)
+{
+    rdram_bind();
+    memset(rdram_hidden, 3, RDRAM_MAX_SIZE / 2);
 }
 
 static STRICTINLINE bool rdram_valid_idx8(uint32_t in)
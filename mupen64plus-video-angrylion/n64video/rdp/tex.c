@@ -510,7 +510,7 @@ static void loading_pipeline(uint32_t wid, int start, int end, int tilenum, int
 
     if (end > start && ltlut)
     {
-        rdp_pipeline_crashed = 1;
+        video->rdp_pipeline_crashed = 1;
         return;
     }
 
@@ -526,7 +526,7 @@ static void loading_pipeline(uint32_t wid, int start, int end, int tilenum, int
     switch (state[wid].ti_size)
     {
     case PIXEL_SIZE_4BIT:
-        rdp_pipeline_crashed = 1;
+        video->rdp_pipeline_crashed = 1;
         return;
         break;
     case PIXEL_SIZE_8BIT:
@@ -46,6 +46,110 @@ struct vi_reg_ctrl
     bool dither_filter_enable;
 };
 
+// Make sure each thread gets its own cache line.
+#define VI_CACHE_LINE_SIZE 64
+
+// prescale buffers, only the first one is used unless the VI is pipelined
+#define PRESCALE_BUFFERS 2
+
+// everything the VI keeps between frames, the gamma and restore tables are
+// constant once initialized and shared
+struct vi_state
+{
+    // RDRAM as seen by the VI filters. While a filter pass runs on the
+    // workers, this is a snapshot of the rows being scanned out, so the CPU
+    // and RDP can keep writing to the live frame buffer.
+    uint8_t rdram_snapshot[RDRAM_MAX_SIZE];
+    uint8_t rdram_hidden_snapshot[RDRAM_MAX_SIZE / 2];
+    uint32_t* rdram32;
+    uint16_t* rdram16;
+    uint8_t* rdram_hidden;
+
+    // states
+    uint32_t prevvicurrent;
+    int32_t emucontrolsvicurrent;
+    bool prevserrate;
+    bool lowerfield;
+    int32_t oldvstart;
+    bool prevwasblank;
+    int32_t vactivelines;
+    bool ispal;
+    int32_t minhpass;
+    int32_t maxhpass;
+    uint32_t x_add;
+    uint32_t x_start;
+    uint32_t y_add;
+    uint32_t y_start;
+    int32_t v_sync;
+    int32_t width_low;
+    uint32_t frame_buffer;
+    uint32_t tvfadeoutstate[PRESCALE_HEIGHT];
+    uint32_t rseed[PARALLEL_MAX_WORKERS * (VI_CACHE_LINE_SIZE / 4)];
+    uint32_t zb_address;
+
+    struct rgba prescale_buffers[PRESCALE_BUFFERS][PRESCALE_WIDTH * PRESCALE_HEIGHT];
+    struct rgba* prescale;
+    uint32_t prescale_index;
+    uint32_t prescale_ptr;
+
+    // output of each prescale buffer, kept back until the filter pass finished
+    struct
+    {
+        struct frame_buffer fb;
+        bool written;
+        bool valid;
+    } output[PRESCALE_BUFFERS];
+
+    bool pipelined;
+    bool busy;
+    uint32_t worker_base;
+    int32_t linecount;
+
+    // parsed VI registers
+    uint32_t** reg_ptr;
+    struct vi_reg_ctrl ctrl;
+    int32_t hres, vres;
+    int32_t hres_raw, vres_raw;
+    int32_t v_start;
+    int32_t h_start;
+    int32_t v_current_line;
+};
+
+static struct vi_state* vi;
+
+static STRICTINLINE uint16_t vi_rdram_read_idx16(uint32_t in)
+{
+    in &= RDRAM_MASK >> 1;
+    return rdram_valid_idx16(in) ? vi->rdram16[in ^ WORD_ADDR_XOR] : 0;
+}
+
+static STRICTINLINE uint16_t vi_rdram_read_idx16_fast(uint32_t in)
+{
+    return vi->rdram16[in ^ WORD_ADDR_XOR];
+}
+
+static STRICTINLINE uint32_t vi_rdram_read_idx32(uint32_t in)
+{
+    in &= RDRAM_MASK >> 2;
+    return rdram_valid_idx32(in) ? vi->rdram32[in] : 0;
+}
+
+static STRICTINLINE uint32_t vi_rdram_read_idx32_fast(uint32_t in)
+{
+    return vi->rdram32[in];
+}
+
+static STRICTINLINE void vi_rdram_read_pair16(uint16_t* rdst, uint8_t* hdst, uint32_t in)
+{
+    in &= RDRAM_MASK >> 1;
+    if (rdram_valid_idx16(in)) {
+        *rdst = vi->rdram16[in ^ WORD_ADDR_XOR];
+        *hdst = vi->rdram_hidden[in];
+    } else {
+        *rdst = *hdst = 0;
+    }
+}
+
 typedef void(*vi_fetch_filter_func)(struct rgba*, uint32_t, uint32_t, struct vi_reg_ctrl, uint32_t, uint32_t);
 
 #include "vi/gamma.c"
@@ -55,62 +159,37 @@ typedef void(*vi_fetch_filter_func)(struct rgba*, uint32_t, uint32_t, struct vi_
 #include "vi/restore.c"
 #include "vi/fetch.c"
 
-// states
-static uint32_t prevvicurrent;
-static int32_t emucontrolsvicurrent;
-static bool prevserrate;
-static bool lowerfield;
-static int32_t oldvstart;
-static bool prevwasblank;
-static int32_t vactivelines;
-static bool ispal;
-static int32_t minhpass;
-static int32_t maxhpass;
-static uint32_t x_add;
-static uint32_t x_start;
-static uint32_t y_add;
-static uint32_t y_start;
-static int32_t v_sync;
-static int32_t vi_width_low;
-static uint32_t frame_buffer;
-static uint32_t tvfadeoutstate[PRESCALE_HEIGHT];
+#if defined(__SSE2__)
+#include "vi/simd.c"
+#endif
 
-// Make sure each thread gets its own cache line.
-#define VI_CACHE_LINE_SIZE 64
-static uint32_t rseed[PARALLEL_MAX_WORKERS * (VI_CACHE_LINE_SIZE / 4)];
-static uint32_t zb_address;
-
-// prescale buffer
-struct rgba prescale[PRESCALE_WIDTH * PRESCALE_HEIGHT];
-static uint32_t prescale_ptr;
-static int32_t linecount;
-
-// parsed VI registers
-static uint32_t** vi_reg_ptr;
-static struct vi_reg_ctrl ctrl;
-static int32_t hres, vres;
-static int32_t hres_raw, vres_raw;
-static int32_t v_start;
-static int32_t h_start;
-static int32_t v_current_line;
 
 static void vi_init(void)
 {
-    vdac_init(&config);
+    vdac_init(&video->config);
 
     vi_gamma_init();
     vi_restore_init();
 
-    memset(prescale, 0, sizeof(prescale));
-
-    prevvicurrent = 0;
-    emucontrolsvicurrent = -1;
-    prevserrate = false;
-    oldvstart = 1337;
-    prevwasblank = false;
-    zb_address = 0;
-
-    memset(rseed, 3, sizeof(rseed));
+    memset(vi->prescale_buffers, 0, sizeof(vi->prescale_buffers));
+    memset(vi->output, 0, sizeof(vi->output));
+    vi->prescale_index = 0;
+    vi->prescale = vi->prescale_buffers[0];
+
+    vi->rdram32 = rdram32;
+    vi->rdram16 = rdram16;
+    vi->rdram_hidden = rdram_hidden;
+    vi->busy = false;
+    vi->worker_base = 0;
+
+    vi->prevvicurrent = 0;
+    vi->emucontrolsvicurrent = -1;
+    vi->prevserrate = false;
+    vi->oldvstart = 1337;
+    vi->prevwasblank = false;
+    vi->zb_address = 0;
+
+    memset(vi->rseed, 3, sizeof(vi->rseed));
 }
 
 static void vi_process_full_parallel(uint32_t worker_id)
@@ -120,7 +199,7 @@ static void vi_process_full_parallel(uint32_t worker_id)
     struct rgba divot_array[0xa10 << 1];
 
     int32_t cache_marker = 0, cache_next_marker = 0, divot_cache_marker = 0, divot_cache_next_marker = 0;
-    int32_t cache_marker_init = (x_start >> 10) - 1;
+    int32_t cache_marker_init = (vi->x_start >> 10) - 1;
 
     struct rgba *viaa_cache = &viaa_array[0];
     struct rgba *viaa_cache_next = &viaa_array[0xa10];
@@ -129,7 +208,7 @@ static void vi_process_full_parallel(uint32_t worker_id)
 
     struct rgba color, nextcolor, scancolor, scannextcolor;
 
-    vi_fetch_filter_func vi_fetch_filter_ptr = ctrl.type & 1 ? vi_fetch_filter32 : vi_fetch_filter16;
+    vi_fetch_filter_func vi_fetch_filter_ptr = vi->ctrl.type & 1 ? vi_fetch_filter32 : vi_fetch_filter16;
 
     uint32_t pixels = 0, nextpixels = 0, fetchbugstate = 0;
 
@@ -143,31 +222,31 @@ static void vi_process_full_parallel(uint32_t worker_id)
     pixels = 0;
 
     int32_t y_begin = 0;
-    int32_t y_end = vres;
+    int32_t y_end = vi->vres;
     int32_t y_inc = 1;
 
-    if (config.parallel) {
-        y_begin = worker_id;
-        y_inc = parallel_num_workers();
+    if (video->config.parallel) {
+        y_begin = worker_id - vi->worker_base;
+        y_inc = parallel_num_workers() - vi->worker_base;
     }
 
     for (y = y_begin; y < y_end; y += y_inc) {
         int32_t x;
-        uint32_t x_offs = x_start;
-        uint32_t curry = y_start + y * y_add;
-        uint32_t nexty = y_start + (y + 1) * y_add;
+        uint32_t x_offs = vi->x_start;
+        uint32_t curry = vi->y_start + y * vi->y_add;
+        uint32_t nexty = vi->y_start + (y + 1) * vi->y_add;
         uint32_t prevy = curry >> 10;
 
         cache_marker = cache_next_marker = cache_marker_init;
-        if (ctrl.divot_enable) {
+        if (vi->ctrl.divot_enable) {
             divot_cache_marker = divot_cache_next_marker = cache_marker_init;
         }
 
-        struct rgba* pixel_row = &prescale[prescale_ptr + linecount * y];
+        struct rgba* pixel_row = &vi->prescale[vi->prescale_ptr + vi->linecount * y];
 
         yfrac = (curry >> 5) & 0x1f;
-        pixels = vi_width_low * prevy;
-        nextpixels = vi_width_low + pixels;
+        pixels = vi->width_low * prevy;
+        nextpixels = vi->width_low + pixels;
 
         if (prevy == (nexty >> 10)) {
             fetchbugstate = 2;
@@ -175,7 +254,7 @@ static void vi_process_full_parallel(uint32_t worker_id)
             fetchbugstate >>= 1;
         }
 
-        for (x = 0; x < hres; x++, x_offs += x_add) {
+        for (x = 0; x < vi->hres; x++, x_offs += vi->x_add) {
             line_x = x_offs >> 10;
             prev_line_x = line_x - 1;
             next_line_x = line_x + 1;
@@ -199,41 +278,41 @@ static void vi_process_full_parallel(uint32_t worker_id)
             xfrac = (x_offs >> 5) & 0x1f;
 
             if (prev_line_x > cache_marker) {
-                vi_fetch_filter_ptr(&viaa_cache[prev_line_x], frame_buffer, prev_x, ctrl, vi_width_low, 0);
-                vi_fetch_filter_ptr(&viaa_cache[line_x], frame_buffer, cur_x, ctrl, vi_width_low, 0);
-                vi_fetch_filter_ptr(&viaa_cache[next_line_x], frame_buffer, next_x, ctrl, vi_width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[prev_line_x], vi->frame_buffer, prev_x, vi->ctrl, vi->width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[line_x], vi->frame_buffer, cur_x, vi->ctrl, vi->width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[next_line_x], vi->frame_buffer, next_x, vi->ctrl, vi->width_low, 0);
                 cache_marker = next_line_x;
             } else if (line_x > cache_marker) {
-                vi_fetch_filter_ptr(&viaa_cache[line_x], frame_buffer, cur_x, ctrl, vi_width_low, 0);
-                vi_fetch_filter_ptr(&viaa_cache[next_line_x], frame_buffer, next_x, ctrl, vi_width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[line_x], vi->frame_buffer, cur_x, vi->ctrl, vi->width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[next_line_x], vi->frame_buffer, next_x, vi->ctrl, vi->width_low, 0);
                 cache_marker = next_line_x;
             } else if (next_line_x > cache_marker) {
-                vi_fetch_filter_ptr(&viaa_cache[next_line_x], frame_buffer, next_x, ctrl, vi_width_low, 0);
+                vi_fetch_filter_ptr(&viaa_cache[next_line_x], vi->frame_buffer, next_x, vi->ctrl, vi->width_low, 0);
                 cache_marker = next_line_x;
             }
 
             if (prev_line_x > cache_next_marker) {
-                vi_fetch_filter_ptr(&viaa_cache_next[prev_line_x], frame_buffer, prev_scan_x, ctrl, vi_width_low, fetchbugstate);
-                vi_fetch_filter_ptr(&viaa_cache_next[line_x], frame_buffer, scan_x, ctrl, vi_width_low, fetchbugstate);
-                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], frame_buffer, next_scan_x, ctrl, vi_width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[prev_line_x], vi->frame_buffer, prev_scan_x, vi->ctrl, vi->width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[line_x], vi->frame_buffer, scan_x, vi->ctrl, vi->width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], vi->frame_buffer, next_scan_x, vi->ctrl, vi->width_low, fetchbugstate);
                 cache_next_marker = next_line_x;
             } else if (line_x > cache_next_marker) {
-                vi_fetch_filter_ptr(&viaa_cache_next[line_x], frame_buffer, scan_x, ctrl, vi_width_low, fetchbugstate);
-                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], frame_buffer, next_scan_x, ctrl, vi_width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[line_x], vi->frame_buffer, scan_x, vi->ctrl, vi->width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], vi->frame_buffer, next_scan_x, vi->ctrl, vi->width_low, fetchbugstate);
                 cache_next_marker = next_line_x;
             } else if (next_line_x > cache_next_marker) {
-                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], frame_buffer, next_scan_x, ctrl, vi_width_low, fetchbugstate);
+                vi_fetch_filter_ptr(&viaa_cache_next[next_line_x], vi->frame_buffer, next_scan_x, vi->ctrl, vi->width_low, fetchbugstate);
                 cache_next_marker = next_line_x;
             }
 
-            if (ctrl.divot_enable) {
+            if (vi->ctrl.divot_enable) {
                 if (far_line_x > cache_marker) {
-                    vi_fetch_filter_ptr(&viaa_cache[far_line_x], frame_buffer, far_x, ctrl, vi_width_low, 0);
+                    vi_fetch_filter_ptr(&viaa_cache[far_line_x], vi->frame_buffer, far_x, vi->ctrl, vi->width_low, 0);
                     cache_marker = far_line_x;
                 }
 
                 if (far_line_x > cache_next_marker) {
-                    vi_fetch_filter_ptr(&viaa_cache_next[far_line_x], frame_buffer, far_scan_x, ctrl, vi_width_low, fetchbugstate);
+                    vi_fetch_filter_ptr(&viaa_cache_next[far_line_x], vi->frame_buffer, far_scan_x, vi->ctrl, vi->width_low, fetchbugstate);
                     cache_next_marker = far_line_x;
                 }
 
@@ -260,10 +339,10 @@ static void vi_process_full_parallel(uint32_t worker_id)
                 color = viaa_cache[line_x];
             }
 
-            bool lerping = ctrl.aa_mode != VI_AA_REPLICATE && (xfrac || yfrac);
+            bool lerping = vi->ctrl.aa_mode != VI_AA_REPLICATE && (xfrac || yfrac);
 
             if (lerping) {
-                if (ctrl.divot_enable) {
+                if (vi->ctrl.divot_enable) {
                     nextcolor = divot_cache[next_line_x];
                     scancolor = divot_cache_next[line_x];
                     scannextcolor = divot_cache_next[next_line_x];
@@ -280,23 +359,23 @@ static void vi_process_full_parallel(uint32_t worker_id)
 
             struct rgba* pixel = &pixel_row[x];
 
-            if (x >= minhpass && x < maxhpass) {
+            if (x >= vi->minhpass && x < vi->maxhpass) {
                 *pixel = color;
                 // Make sure each thread owns its own cache line. Stride the seed.
-                gamma_filters(pixel, ctrl.gamma_enable, ctrl.gamma_dither_enable, &rseed[worker_id * (VI_CACHE_LINE_SIZE / 4)]);
+                gamma_filters(pixel, vi->ctrl.gamma_enable, vi->ctrl.gamma_dither_enable, &vi->rseed[worker_id * (VI_CACHE_LINE_SIZE / 4)]);
             } else {
                 pixel->r = pixel->g = pixel->b = 0;
             }
         }
 
-        if (!cache_init && y_add == 0x400) {
+        if (!cache_init && vi->y_add == 0x400) {
             cache_marker = cache_next_marker;
             cache_next_marker = cache_marker_init;
 
             struct rgba* tempccvgptr = viaa_cache;
             viaa_cache = viaa_cache_next;
             viaa_cache_next = tempccvgptr;
-            if (ctrl.divot_enable) {
+            if (vi->ctrl.divot_enable) {
                 divot_cache_marker = divot_cache_next_marker;
                 divot_cache_next_marker = cache_marker_init;
                 tempccvgptr = divot_cache;
@@ -309,111 +388,269 @@ static void vi_process_full_parallel(uint32_t worker_id)
     }
 }
 
+#if defined(__SSE2__)
+// same as vi_process_full_parallel, but fetches and filters whole rows at once
+static void vi_process_full_rows(uint32_t worker_id)
+{
+    int32_t x, y;
+    struct rgba viaa_cache[VI_ROW_MAX + VI_ROW_PAD];
+    struct rgba viaa_cache_next[VI_ROW_MAX + VI_ROW_PAD];
+    struct rgba divot_cache[VI_ROW_MAX + VI_ROW_PAD];
+    struct rgba divot_cache_next[VI_ROW_MAX + VI_ROW_PAD];
+    struct rgba line[PRESCALE_WIDTH + 4];
+    uint16_t line_x[PRESCALE_WIDTH + 4];
+    uint16_t line_xfrac[PRESCALE_WIDTH + 4];
+
+    vi_fetch_row_func vi_fetch_row_ptr = vi_select_fetch_row(vi->ctrl);
+    bool lerp = vi->ctrl.aa_mode != VI_AA_REPLICATE;
+    bool gamma = vi->ctrl.gamma_enable || vi->ctrl.gamma_dither_enable;
+
+    // cache entry c holds the pixel at line_x c - 1, the first one is only
+    // needed as left neighbour and the last one only for divot
+    uint32_t x_offs = vi->x_start;
+    for (x = 0; x < vi->hres; x++, x_offs += vi->x_add) {
+        line_x[x] = (x_offs >> 10) + 1;
+        line_xfrac[x] = (x_offs >> 5) & 0x1f;
+    }
+    for (; x < PRESCALE_WIDTH + 4; x++) {
+        line_x[x] = line_x[0];
+        line_xfrac[x] = 0;
+    }
+
+    uint32_t c_begin = vi->x_start >> 10;
+    uint32_t c_last = line_x[vi->hres - 1] - 1;
+    uint32_t c_end = c_last + (vi->ctrl.divot_enable ? 4 : 3);
+
+    uint32_t pixels = 0, nextpixels = 0, fetchbugstate = 0;
+
+    int32_t y_begin = 0;
+    int32_t y_end = vi->vres;
+    int32_t y_inc = 1;
+
+    if (video->config.parallel) {
+        y_begin = worker_id - vi->worker_base;
+        y_inc = parallel_num_workers() - vi->worker_base;
+    }
+
+    for (y = y_begin; y < y_end; y += y_inc) {
+        uint32_t curry = vi->y_start + y * vi->y_add;
+        uint32_t nexty = vi->y_start + (y + 1) * vi->y_add;
+        uint32_t prevy = curry >> 10;
+
+        struct rgba* pixel_row = &vi->prescale[vi->prescale_ptr + vi->linecount * y];
+
+        uint32_t yfrac = (curry >> 5) & 0x1f;
+        pixels = vi->width_low * prevy;
+        nextpixels = vi->width_low + pixels;
+
+        if (prevy == (nexty >> 10)) {
+            fetchbugstate = 2;
+        } else {
+            fetchbugstate >>= 1;
+        }
+
+        struct rgba* cur = viaa_cache;
+        struct rgba* next = viaa_cache_next;
+
+        vi_fetch_row_ptr(viaa_cache, c_begin, c_end, pixels, vi->frame_buffer, vi->ctrl, vi->width_low, 0);
+        if (lerp) {
+            vi_fetch_row_ptr(viaa_cache_next, c_begin, c_end, nextpixels, vi->frame_buffer, vi->ctrl, vi->width_low, fetchbugstate);
+        }
+
+        if (vi->ctrl.divot_enable) {
+            vi_divot_row(divot_cache, viaa_cache, c_begin + 1, c_end - 1);
+            cur = divot_cache;
+            if (lerp) {
+                vi_divot_row(divot_cache_next, viaa_cache_next, c_begin + 1, c_end - 1);
+                next = divot_cache_next;
+            }
+        }
+
+        vi_lerp_row(line, cur, next, line_x, line_xfrac, yfrac, vi->hres, lerp);
+
+        for (x = 0; x < vi->hres; x++) {
+            struct rgba* pixel = &pixel_row[x];
+
+            if (x >= vi->minhpass && x < vi->maxhpass) {
+                if (!gamma) {
+                    int32_t pass_end = vi->maxhpass < vi->hres ? vi->maxhpass : vi->hres;
+                    memcpy(pixel, &line[x], (pass_end - x) * sizeof(*pixel));
+                    x = pass_end - 1;
+                    continue;
+                }
+                *pixel = line[x];
+                gamma_filters(pixel, vi->ctrl.gamma_enable, vi->ctrl.gamma_dither_enable, &vi->rseed[worker_id * (VI_CACHE_LINE_SIZE / 4)]);
+            } else {
+                pixel->r = pixel->g = pixel->b = 0;
+            }
+        }
+    }
+}
+#endif
+
+static void vi_sync(void)
+{
+    if (vi->busy) {
+        parallel_sync();
+        vi->busy = false;
+    }
+}
+
+static void vi_output_write(struct frame_buffer* fb)
+{
+    if (vi->pipelined) {
+        vi->output[vi->prescale_index].fb = *fb;
+        vi->output[vi->prescale_index].written = true;
+    } else {
+        vdac_write(fb);
+    }
+}
+
+static void vi_output_sync(bool valid)
+{
+    if (vi->pipelined) {
+        vi->output[vi->prescale_index].valid = valid;
+    } else {
+        vdac_sync(!valid);
+    }
+}
+
+static void vi_snapshot_rdram(void)
+{
+    if (vi->vres <= 0) {
+        return;
+    }
+
+    // rows fetched for the frame plus the neighbours read by the restore and
+    // AA filters, with some slack for the horizontal fetch overrun
+    uint32_t pix_shift = (vi->ctrl.type & 1) ? 2 : 1;
+    int64_t first_row = (int64_t)(vi->y_start >> 10) - 1;
+    int64_t last_row = (int64_t)((vi->y_start + (uint32_t)vi->vres * vi->y_add) >> 10) + 3;
+    int64_t begin = ((int64_t)(vi->frame_buffer >> pix_shift) + first_row * vi->width_low - 4) << pix_shift;
+    int64_t end = ((int64_t)(vi->frame_buffer >> pix_shift) + last_row * vi->width_low + 4) << pix_shift;
+
+    begin = CLAMP(begin, 0, (int64_t)idxlim8 + 1) & ~3;
+    end = CLAMP(end, 0, (int64_t)idxlim8 + 1);
+
+    if (end > begin) {
+        memcpy(&vi->rdram_snapshot[begin], &rdram8[begin], end - begin);
+
+        // only the 16 bit filters look at the hidden bits
+        if (pix_shift == 1) {
+            memcpy(&vi->rdram_hidden_snapshot[begin >> 1], &rdram_hidden[begin >> 1], (end - begin) >> 1);
+        }
+    }
+
+    vi->rdram32 = (uint32_t*)vi->rdram_snapshot;
+    vi->rdram16 = (uint16_t*)vi->rdram_snapshot;
+    vi->rdram_hidden = vi->rdram_hidden_snapshot;
+}
+
 static bool vi_process_full(void)
 {
-    bool isblank = (ctrl.type & 2) == 0;
-    bool validinterlace = !isblank && ctrl.serrate;
+    bool isblank = (vi->ctrl.type & 2) == 0;
+    bool validinterlace = !isblank && vi->ctrl.serrate;
 
     if (validinterlace) {
-        if (prevserrate && emucontrolsvicurrent < 0) {
-            emucontrolsvicurrent = v_current_line != prevvicurrent;
+        if (vi->prevserrate && vi->emucontrolsvicurrent < 0) {
+            vi->emucontrolsvicurrent = vi->v_current_line != vi->prevvicurrent;
         }
 
-        if (emucontrolsvicurrent == 1) {
-            lowerfield = v_current_line ^ 1;
-        } else if (!emucontrolsvicurrent) {
-            if (v_start == oldvstart) {
-                lowerfield ^= true;
+        if (vi->emucontrolsvicurrent == 1) {
+            vi->lowerfield = vi->v_current_line ^ 1;
+        } else if (!vi->emucontrolsvicurrent) {
+            if (vi->v_start == vi->oldvstart) {
+                vi->lowerfield ^= true;
             } else {
-                lowerfield = v_start < oldvstart;
+                vi->lowerfield = vi->v_start < vi->oldvstart;
             }
         }
 
-        prevvicurrent = v_current_line;
-        oldvstart = v_start;
+        vi->prevvicurrent = vi->v_current_line;
+        vi->oldvstart = vi->v_start;
     }
 
-    prevserrate = validinterlace;
+    vi->prevserrate = validinterlace;
 
-    bool validh = hres > 0 && h_start < PRESCALE_WIDTH;
-    int32_t h_end = hres + h_start; // note: the result appears to be different to VI_H_END
+    bool validh = vi->hres > 0 && vi->h_start < PRESCALE_WIDTH;
+    int32_t h_end = vi->hres + vi->h_start; // note: the result appears to be different to VI_H_END
     int32_t hrightblank = PRESCALE_WIDTH - h_end;
 
-    if (isblank && prevwasblank) {
+    if (isblank && vi->prevwasblank) {
         return false;
     }
 
-    prevwasblank = isblank;
+    vi->prevwasblank = isblank;
 
-    linecount = PRESCALE_WIDTH << ctrl.serrate;
-    prescale_ptr = v_start * linecount + h_start + (lowerfield ? PRESCALE_WIDTH : 0);
+    vi->linecount = PRESCALE_WIDTH << vi->ctrl.serrate;
+    vi->prescale_ptr = vi->v_start * vi->linecount + vi->h_start + (vi->lowerfield ? PRESCALE_WIDTH : 0);
 
     int32_t i;
     if (isblank) {
         // blank signal, clear entire screen buffer
-        memset(tvfadeoutstate, 0, PRESCALE_HEIGHT * sizeof(uint32_t));
-        memset(prescale, 0, sizeof(prescale));
+        memset(vi->tvfadeoutstate, 0, PRESCALE_HEIGHT * sizeof(uint32_t));
+        memset(vi->prescale, 0, sizeof(vi->prescale_buffers[0]));
     } else {
         // clear left border
         int32_t j;
-        if (h_start > 0 && h_start < PRESCALE_WIDTH) {
-            for (i = 0; i < vactivelines; i++) {
-                memset(&prescale[i * PRESCALE_WIDTH], 0, h_start * sizeof(uint32_t));
+        if (vi->h_start > 0 && vi->h_start < PRESCALE_WIDTH) {
+            for (i = 0; i < vi->vactivelines; i++) {
+                memset(&vi->prescale[i * PRESCALE_WIDTH], 0, vi->h_start * sizeof(uint32_t));
             }
         }
 
         // clear right border
         if (h_end >= 0 && h_end < PRESCALE_WIDTH) {
-            for (i = 0; i < vactivelines; i++) {
-                memset(&prescale[i * PRESCALE_WIDTH + h_end], 0, hrightblank * sizeof(uint32_t));
+            for (i = 0; i < vi->vactivelines; i++) {
+                memset(&vi->prescale[i * PRESCALE_WIDTH + h_end], 0, hrightblank * sizeof(uint32_t));
             }
         }
 
         // clear top border
-        for (i = 0; i < ((v_start << ctrl.serrate) + lowerfield); i++) {
-            if (tvfadeoutstate[i]) {
-                tvfadeoutstate[i]--;
-                if (!tvfadeoutstate[i]) {
+        for (i = 0; i < ((vi->v_start << vi->ctrl.serrate) + vi->lowerfield); i++) {
+            if (vi->tvfadeoutstate[i]) {
+                vi->tvfadeoutstate[i]--;
+                if (!vi->tvfadeoutstate[i]) {
                     if (validh) {
-                        memset(&prescale[i * PRESCALE_WIDTH + h_start], 0, hres * sizeof(uint32_t));
+                        memset(&vi->prescale[i * PRESCALE_WIDTH + vi->h_start], 0, vi->hres * sizeof(uint32_t));
                     } else {
-                        memset(&prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
+                        memset(&vi->prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
                     }
                 }
             }
         }
 
-        if (!ctrl.serrate) {
-            for(j = 0; j < vres; j++) {
+        if (!vi->ctrl.serrate) {
+            for(j = 0; j < vi->vres; j++) {
                 if (validh) {
-                    tvfadeoutstate[i] = 2;
-                } else if (tvfadeoutstate[i]) {
-                    tvfadeoutstate[i]--;
-                    if (!tvfadeoutstate[i]) {
-                        memset(&prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
+                    vi->tvfadeoutstate[i] = 2;
+                } else if (vi->tvfadeoutstate[i]) {
+                    vi->tvfadeoutstate[i]--;
+                    if (!vi->tvfadeoutstate[i]) {
+                        memset(&vi->prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
                     }
                 }
 
                 i++;
             }
         } else {
-            for(j = 0; j < vres; j++) {
+            for(j = 0; j < vi->vres; j++) {
                 if (validh) {
-                    tvfadeoutstate[i] = 2;
-                } else if (tvfadeoutstate[i]) {
-                    tvfadeoutstate[i]--;
-                    if (!tvfadeoutstate[i]) {
-                        memset(&prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
+                    vi->tvfadeoutstate[i] = 2;
+                } else if (vi->tvfadeoutstate[i]) {
+                    vi->tvfadeoutstate[i]--;
+                    if (!vi->tvfadeoutstate[i]) {
+                        memset(&vi->prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
                     }
                 }
 
-                if (tvfadeoutstate[i + 1]) {
-                    tvfadeoutstate[i + 1]--;
-                    if (!tvfadeoutstate[i + 1]) {
+                if (vi->tvfadeoutstate[i + 1]) {
+                    vi->tvfadeoutstate[i + 1]--;
+                    if (!vi->tvfadeoutstate[i + 1]) {
                         if (validh) {
-                            memset(&prescale[(i + 1) * PRESCALE_WIDTH + h_start], 0, hres * sizeof(uint32_t));
+                            memset(&vi->prescale[(i + 1) * PRESCALE_WIDTH + vi->h_start], 0, vi->hres * sizeof(uint32_t));
                         } else {
-                            memset(&prescale[(i + 1) * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
+                            memset(&vi->prescale[(i + 1) * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
                         }
                     }
                 }
@@ -423,15 +660,15 @@ static bool vi_process_full(void)
         }
 
         // clear bottom border
-        for (; i < vactivelines; i++) {
-            if (tvfadeoutstate[i]) {
-                tvfadeoutstate[i]--;
+        for (; i < vi->vactivelines; i++) {
+            if (vi->tvfadeoutstate[i]) {
+                vi->tvfadeoutstate[i]--;
             }
-            if (!tvfadeoutstate[i]) {
+            if (!vi->tvfadeoutstate[i]) {
                 if (validh) {
-                    memset(&prescale[i * PRESCALE_WIDTH + h_start], 0, hres * sizeof(uint32_t));
+                    memset(&vi->prescale[i * PRESCALE_WIDTH + vi->h_start], 0, vi->hres * sizeof(uint32_t));
                 } else {
-                    memset(&prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
+                    memset(&vi->prescale[i * PRESCALE_WIDTH], 0, PRESCALE_WIDTH * sizeof(uint32_t));
                 }
             }
         }
@@ -441,39 +678,58 @@ static bool vi_process_full(void)
         return false;
     }
 
-    // run filter update in parallel if enabled
-    if (config.parallel) {
-        parallel_run(vi_process_full_parallel);
+#if defined(__SSE2__)
+    void (*vi_process_full_worker)(uint32_t) = vi_process_full_rows;
+#else
+    void (*vi_process_full_worker)(uint32_t) = vi_process_full_parallel;
+#endif
+
+    // run filter update in parallel if enabled, when pipelined the workers
+    // keep going while the next frame is emulated
+    if (vi->pipelined) {
+        vi_snapshot_rdram();
+        vi->worker_base = 1;
+        vi->busy = true;
+        parallel_run_async(vi_process_full_worker);
     } else {
-        vi_process_full_parallel(0);
+        vi->rdram32 = rdram32;
+        vi->rdram16 = rdram16;
+        vi->rdram_hidden = rdram_hidden;
+        vi->worker_base = 0;
+
+        if (video->config.parallel) {
+            parallel_run(vi_process_full_worker);
+        } else {
+            vi_process_full_worker(0);
+        }
     }
 
     // finish and send buffer to screen
     struct frame_buffer fb;
-    fb.pixels = prescale;
+    fb.pixels = vi->prescale;
     fb.pitch = PRESCALE_WIDTH;
 
-    if (config.vi.hide_overscan) {
-        // crop away overscan area from prescale
-        fb.width = maxhpass - minhpass;
-        fb.height = vres << ctrl.serrate;
-        fb.height_out = (vres << 1) * V_SYNC_NTSC / v_sync;
-        int32_t x = h_start + minhpass;
-        int32_t y = (v_start + (emucontrolsvicurrent ? lowerfield : 0)) << ctrl.serrate;
+    if (video->config.vi.hide_overscan) {
+        // crop away overscan area from vi->prescale
+        fb.width = vi->maxhpass - vi->minhpass;
+        fb.height = vi->vres << vi->ctrl.serrate;
+        fb.height_out = (vi->vres << 1) * V_SYNC_NTSC / vi->v_sync;
+        int32_t x = vi->h_start + vi->minhpass;
+        int32_t y = (vi->v_start + (vi->emucontrolsvicurrent ? vi->lowerfield : 0)) << vi->ctrl.serrate;
         fb.pixels += x + y * fb.pitch;
     } else {
-        // use entire prescale buffer
+        // use entire vi->prescale buffer
         fb.width = PRESCALE_WIDTH;
-        fb.height = (ispal ? V_RES_PAL : V_RES_NTSC) >> !ctrl.serrate;
+        fb.height = (vi->ispal ? V_RES_PAL : V_RES_NTSC) >> !vi->ctrl.serrate;
         fb.height_out = V_RES_NTSC;
     }
 
     // convert to 16:9 if enabled
-    if (config.vi.widescreen) {
+    if (video->config.vi.widescreen) {
         fb.height_out = fb.height_out * 3 / 4;
     }
 
-    vdac_write(&fb);
+    vi_output_write(&fb);
 
     return fb.width > 0 && fb.height > 0;
 }
@@ -482,36 +738,36 @@ static void vi_process_fast_parallel(uint32_t worker_id)
 {
     int32_t y;
     int32_t y_begin = 0;
-    int32_t y_end = vres_raw;
+    int32_t y_end = vi->vres_raw;
     int32_t y_inc = 1;
 
     // drop every other interlaced frame to avoid "wobbly" output due to the
     // vertical offset
     // TODO: completely skip rendering these frames in unfiltered to improve
     // performance?
-    if (ctrl.serrate && v_current_line) {
+    if (vi->ctrl.serrate && vi->v_current_line) {
         return;
     }
 
-    if (config.parallel) {
+    if (video->config.parallel) {
         y_begin = worker_id;
         y_inc = parallel_num_workers();
     }
 
     for (y = y_begin; y < y_end; y += y_inc) {
         int32_t x;
-        int32_t line = y * vi_width_low;
+        int32_t line = y * vi->width_low;
 
-        struct rgba* pixel_row = &prescale[y * hres_raw];
+        struct rgba* pixel_row = &vi->prescale[y * vi->hres_raw];
 
-        for (x = 0; x < hres_raw; x++) {
+        for (x = 0; x < vi->hres_raw; x++) {
             struct rgba* pixel = &pixel_row[x];
 
-            switch (config.vi.mode) {
+            switch (video->config.vi.mode) {
                 case VI_MODE_COLOR:
-                    switch (ctrl.type) {
+                    switch (vi->ctrl.type) {
                         case VI_TYPE_RGBA5551: {
-                            uint16_t pix = rdram_read_idx16((frame_buffer >> 1) + line + x);
+                            uint16_t pix = rdram_read_idx16((vi->frame_buffer >> 1) + line + x);
                             pixel->r = RGBA16_R(pix);
                             pixel->g = RGBA16_G(pix);
                             pixel->b = RGBA16_B(pix);
@@ -519,7 +775,7 @@ static void vi_process_fast_parallel(uint32_t worker_id)
                         }
 
                         case VI_TYPE_RGBA8888: {
-                            uint32_t pix = rdram_read_idx32((frame_buffer >> 2) + line + x);
+                            uint32_t pix = rdram_read_idx32((vi->frame_buffer >> 2) + line + x);
                             pixel->r = RGBA32_R(pix);
                             pixel->g = RGBA32_G(pix);
                             pixel->b = RGBA32_B(pix);
@@ -530,12 +786,12 @@ static void vi_process_fast_parallel(uint32_t worker_id)
                             return;
                     }
 
-                    gamma_filters(pixel, ctrl.gamma_enable, false, &rseed[worker_id * (VI_CACHE_LINE_SIZE / 4)]);
+                    gamma_filters(pixel, vi->ctrl.gamma_enable, false, &vi->rseed[worker_id * (VI_CACHE_LINE_SIZE / 4)]);
                     break;
 
                 case VI_MODE_DEPTH: {
-                    if (zb_address) {
-                        pixel->r = pixel->g = pixel->b = rdram_read_idx16((zb_address >> 1) + line + x) >> 8;
+                    if (vi->zb_address) {
+                        pixel->r = pixel->g = pixel->b = rdram_read_idx16((vi->zb_address >> 1) + line + x) >> 8;
                     }
                     break;
                 }
@@ -544,7 +800,7 @@ static void vi_process_fast_parallel(uint32_t worker_id)
                     // TODO: incorrect for RGBA8888?
                     uint8_t hval;
                     uint16_t pix;
-                    rdram_read_pair16(&pix, &hval, (frame_buffer >> 1) + line + x);
+                    rdram_read_pair16(&pix, &hval, (vi->frame_buffer >> 1) + line + x);
                     pixel->r = pixel->g = pixel->b = (((pix & 1) << 2) | hval) << 5;
                     break;
                 }
@@ -560,21 +816,21 @@ static bool vi_process_fast(void)
 {
     // note: this is probably a very, very crude method to get the frame size,
     // but should hopefully work most of the time
-    hres_raw = (int32_t)x_add * hres / 1024;
-    vres_raw = (int32_t)y_add * vres / 1024;
+    vi->hres_raw = (int32_t)vi->x_add * vi->hres / 1024;
+    vi->vres_raw = (int32_t)vi->y_add * vi->vres / 1024;
 
     // skip invalid frame sizes
-    if (hres_raw <= 0 || vres_raw <= 0) {
+    if (vi->hres_raw <= 0 || vi->vres_raw <= 0) {
         return false;
     }
 
     // skip blank/invalid modes
-    if (!(ctrl.type & 2)) {
+    if (!(vi->ctrl.type & 2)) {
         return false;
     }
 
     // run filter update in parallel if enabled
-    if (config.parallel) {
+    if (video->config.parallel) {
         parallel_run(vi_process_fast_parallel);
     } else {
         vi_process_fast_parallel(0);
@@ -582,18 +838,18 @@ static bool vi_process_fast(void)
 
     // finish and send buffer to screen
     struct frame_buffer fb;
-    fb.pixels = prescale;
-    fb.width = hres_raw;
-    fb.height = vres_raw;
-    fb.pitch = hres_raw;
+    fb.pixels = vi->prescale;
+    fb.width = vi->hres_raw;
+    fb.height = vi->vres_raw;
+    fb.pitch = vi->hres_raw;
 
     // get display size of filtered mode
-    int32_t filtered_width = maxhpass - minhpass;
-    int32_t filtered_height = (vres << 1) * V_SYNC_NTSC / v_sync;
+    int32_t filtered_width = vi->maxhpass - vi->minhpass;
+    int32_t filtered_height = (vi->vres << 1) * V_SYNC_NTSC / vi->v_sync;
 
 /*  TOFIX it's cropping the right side atm, bypass to show the full width instead
     // re-calculate cropped 8 pixel area on the left and right from filtered mode
-    int32_t border_width = (hres - filtered_width) * hres_raw / hres;
+    int32_t border_width = (vi->hres - filtered_width) * vi->hres_raw / vi->hres;
     fb.pixels += (border_width / 2) + 1;
     fb.width -= border_width;
 */
@@ -602,148 +858,164 @@ static bool vi_process_fast(void)
     fb.height_out = fb.width * filtered_height / filtered_width;
 
     // convert to 16:9 if enabled
-    if (config.vi.widescreen) {
+    if (video->config.vi.widescreen) {
         fb.height_out = fb.height_out * 3 / 4;
     }
 
-    vdac_write(&fb);
+    vi_output_write(&fb);
 
     return fb.width > 0 && fb.height > 0;
 }
 
 void vi_set_zbuffer_address(uint32_t address)
 {
-    zb_address = address;
+    vi->zb_address = address;
 }
 
-void n64video_update_screen(void)
+void n64video_update_screen(struct n64video* handle)
 {
+    n64video_bind(handle);
+
+    // the previous filter pass still uses the parsed registers below
+    vi_sync();
+
+    vi->pipelined = video->config.vi.pipeline && video->config.parallel && parallel_num_workers() > 1;
+    if (vi->pipelined) {
+        // start from the previous frame, the borders and the other field of
+        // interlaced frames are only updated partially
+        struct rgba* prev = vi->prescale;
+        vi->prescale_index = (vi->prescale_index + 1) % PRESCALE_BUFFERS;
+        vi->prescale = vi->prescale_buffers[vi->prescale_index];
+        memcpy(vi->prescale, prev, sizeof(vi->prescale_buffers[0]));
+        vi->output[vi->prescale_index].written = false;
+    }
+
     // check for configuration errors
-    if (config.vi.mode >= VI_MODE_NUM) {
-        msg_error("Invalid VI mode: %d", config.vi.mode);
+    if (video->config.vi.mode >= VI_MODE_NUM) {
+        msg_error("Invalid VI mode: %d", video->config.vi.mode);
     }
 
     // parse and check some common registers
-    vi_reg_ptr = config.gfx.vi_reg;
+    vi->reg_ptr = video->config.gfx.vi_reg;
 
-    v_start = (*vi_reg_ptr[VI_V_START] >> 16) & 0x3ff;
-    h_start = (*vi_reg_ptr[VI_H_START] >> 16) & 0x3ff;
+    vi->v_start = (*vi->reg_ptr[VI_V_START] >> 16) & 0x3ff;
+    vi->h_start = (*vi->reg_ptr[VI_H_START] >> 16) & 0x3ff;
 
-    int32_t v_end = *vi_reg_ptr[VI_V_START] & 0x3ff;
-    int32_t h_end = *vi_reg_ptr[VI_H_START] & 0x3ff;
+    int32_t v_end = *vi->reg_ptr[VI_V_START] & 0x3ff;
+    int32_t h_end = *vi->reg_ptr[VI_H_START] & 0x3ff;
 
-    hres =  h_end - h_start;
-    vres = (v_end - v_start) >> 1; // vertical is measured in half-lines
+    vi->hres =  h_end - vi->h_start;
+    vi->vres = (v_end - vi->v_start) >> 1; // vertical is measured in half-lines
 
-    x_add = *vi_reg_ptr[VI_X_SCALE] & 0xfff;
-    x_start = (*vi_reg_ptr[VI_X_SCALE] >> 16) & 0xfff;
+    vi->x_add = *vi->reg_ptr[VI_X_SCALE] & 0xfff;
+    vi->x_start = (*vi->reg_ptr[VI_X_SCALE] >> 16) & 0xfff;
 
-    y_add = *vi_reg_ptr[VI_Y_SCALE] & 0xfff;
-    y_start = (*vi_reg_ptr[VI_Y_SCALE] >> 16) & 0xfff;
+    vi->y_add = *vi->reg_ptr[VI_Y_SCALE] & 0xfff;
+    vi->y_start = (*vi->reg_ptr[VI_Y_SCALE] >> 16) & 0xfff;
 
-    v_sync = *vi_reg_ptr[VI_V_SYNC] & 0x3ff;
-    v_current_line = *vi_reg_ptr[VI_V_CURRENT_LINE] & 1;
+    vi->v_sync = *vi->reg_ptr[VI_V_SYNC] & 0x3ff;
+    vi->v_current_line = *vi->reg_ptr[VI_V_CURRENT_LINE] & 1;
 
-    vi_width_low = *vi_reg_ptr[VI_WIDTH] & 0xfff;
-    frame_buffer = *vi_reg_ptr[VI_ORIGIN] & 0xffffff;
+    vi->width_low = *vi->reg_ptr[VI_WIDTH] & 0xfff;
+    vi->frame_buffer = *vi->reg_ptr[VI_ORIGIN] & 0xffffff;
 
     // cancel if the frame buffer contains no valid address
-    if (!frame_buffer) {
-        vdac_sync(true);
+    if (!vi->frame_buffer) {
+        vi_output_sync(false);
         return;
     }
 
     // split up VI_CONTROL bits
-    uint32_t vi_control = *vi_reg_ptr[VI_STATUS];
-    ctrl.type = vi_control & 3;
-    ctrl.gamma_dither_enable = (vi_control >> 2) & 1;
-    ctrl.gamma_enable = (vi_control >> 3) & 1;
-    ctrl.divot_enable = (vi_control >> 4) & config.vi.vi_blur;
-    ctrl.vbus_clock_enable = (vi_control >> 5) & 1;
-    ctrl.serrate = (vi_control >> 6) & 1;
-    ctrl.test_mode = (vi_control >> 7) & 1;
-    ctrl.aa_mode = (vi_control >> 8) & 3;
-    ctrl.reserved = (vi_control >> 9) & 1;
-    ctrl.kill_we = (vi_control >> 10) & 1;
-    ctrl.pixel_advance = (vi_control >> 12) & 0xf;
-    ctrl.dither_filter_enable = (vi_control >> 16) & config.vi.vi_dedither;
+    uint32_t vi_control = *vi->reg_ptr[VI_STATUS];
+    vi->ctrl.type = vi_control & 3;
+    vi->ctrl.gamma_dither_enable = (vi_control >> 2) & 1;
+    vi->ctrl.gamma_enable = (vi_control >> 3) & 1;
+    vi->ctrl.divot_enable = (vi_control >> 4) & video->config.vi.vi_blur;
+    vi->ctrl.vbus_clock_enable = (vi_control >> 5) & 1;
+    vi->ctrl.serrate = (vi_control >> 6) & 1;
+    vi->ctrl.test_mode = (vi_control >> 7) & 1;
+    vi->ctrl.aa_mode = (vi_control >> 8) & 3;
+    vi->ctrl.reserved = (vi_control >> 9) & 1;
+    vi->ctrl.kill_we = (vi_control >> 10) & 1;
+    vi->ctrl.pixel_advance = (vi_control >> 12) & 0xf;
+    vi->ctrl.dither_filter_enable = (vi_control >> 16) & video->config.vi.vi_dedither;
 
     // check for unexpected VI type bits set
-    if (ctrl.type & ~3) {
-        msg_error("Unknown framebuffer format %d", ctrl.type);
+    if (vi->ctrl.type & ~3) {
+        msg_error("Unknown framebuffer format %d", vi->ctrl.type);
     }
 
     // warn about AA glitches in certain cases
-    if (ctrl.aa_mode == VI_AA_REPLICATE && ctrl.type == VI_TYPE_RGBA5551 &&
-        h_start < 0x80 && x_add <= 0x200 && !onetimewarnings.nolerp) {
+    if (vi->ctrl.aa_mode == VI_AA_REPLICATE && vi->ctrl.type == VI_TYPE_RGBA5551 &&
+        vi->h_start < 0x80 && vi->x_add <= 0x200 && !video->onetimewarnings.nolerp) {
         msg_warning("vi_update: Disabling VI interpolation in 16-bit color "
-                    "modes causes glitches on hardware if h_start is less than "
+                    "modes causes glitches on hardware if vi->h_start is less than "
                     "128 pixels and x_scale is less or equal to 0x200.");
-        onetimewarnings.nolerp = true;
+        video->onetimewarnings.nolerp = true;
     }
 
     // check for the dangerous vbus_clock_enable flag. it was introduced to
     // configure Ultra 64 prototypes and enabling it on final hardware will
     // enable two output drivers on the same bus at the same time
-    if (ctrl.vbus_clock_enable && !onetimewarnings.vbusclock) {
+    if (vi->ctrl.vbus_clock_enable && !video->onetimewarnings.vbusclock) {
         msg_warning("vi_update: vbus_clock_enable bit set in VI_CONTROL_REG "
                     "register. Never run this code on your N64! It's rumored "
                     "that turning this bit on will result in permanent damage "
                     "to the hardware! Emulation will now continue.");
-        onetimewarnings.vbusclock = true;
+        video->onetimewarnings.vbusclock = true;
     }
 
     // adjust sizes and offsets
-    ispal = v_sync > (V_SYNC_NTSC + 25);
-    h_start -= (ispal ? 128 : 108);
+    vi->ispal = vi->v_sync > (V_SYNC_NTSC + 25);
+    vi->h_start -= (vi->ispal ? 128 : 108);
 
     bool h_start_clamped = false;
 
-    if (h_start < 0) {
-        x_start += (x_add * (-h_start));
-        hres += h_start;
+    if (vi->h_start < 0) {
+        vi->x_start += (vi->x_add * (-vi->h_start));
+        vi->hres += vi->h_start;
 
-        h_start = 0;
+        vi->h_start = 0;
         h_start_clamped = true;
     }
 
-    int32_t vstartoffset = ispal ? 44 : 34;
-    v_start = (v_start - vstartoffset) / 2;
+    int32_t vstartoffset = vi->ispal ? 44 : 34;
+    vi->v_start = (vi->v_start - vstartoffset) / 2;
 
-    if (v_start < 0) {
-        y_start += (y_add * (uint32_t)(-v_start));
-        v_start = 0;
+    if (vi->v_start < 0) {
+        vi->y_start += (vi->y_add * (uint32_t)(-vi->v_start));
+        vi->v_start = 0;
     }
 
     bool hres_clamped = false;
 
-    if ((hres + h_start) > PRESCALE_WIDTH) {
-        hres = PRESCALE_WIDTH - h_start;
+    if ((vi->hres + vi->h_start) > PRESCALE_WIDTH) {
+        vi->hres = PRESCALE_WIDTH - vi->h_start;
         hres_clamped = true;
     }
 
-    if ((vres + v_start) > PRESCALE_HEIGHT) {
-        vres = PRESCALE_HEIGHT - v_start;
-        msg_warning("vres = %d v_start = %d v_video_start = %d", vres, v_start, (*vi_reg_ptr[VI_V_START] >> 16) & 0x3ff);
+    if ((vi->vres + vi->v_start) > PRESCALE_HEIGHT) {
+        vi->vres = PRESCALE_HEIGHT - vi->v_start;
+        msg_warning("vi->vres = %d vi->v_start = %d v_video_start = %d", vi->vres, vi->v_start, (*vi->reg_ptr[VI_V_START] >> 16) & 0x3ff);
     }
 
-    vactivelines = v_sync - vstartoffset;
+    vi->vactivelines = vi->v_sync - vstartoffset;
 
-    if (vactivelines > PRESCALE_HEIGHT) {
+    if (vi->vactivelines > PRESCALE_HEIGHT) {
         msg_error("VI_V_SYNC_REG too big");
     }
 
     bool valid = true;
 
-    if (vactivelines >= 0) {
-        uint32_t lineshifter = !ctrl.serrate;
-        vactivelines >>= lineshifter;
+    if (vi->vactivelines >= 0) {
+        uint32_t lineshifter = !vi->ctrl.serrate;
+        vi->vactivelines >>= lineshifter;
 
-        minhpass = h_start_clamped ? 0 : 8;
-        maxhpass = hres_clamped ? hres : (hres - 7);
+        vi->minhpass = h_start_clamped ? 0 : 8;
+        vi->maxhpass = hres_clamped ? vi->hres : (vi->hres - 7);
 
         // run filter update in parallel if enabled
-        if (config.vi.mode == VI_MODE_NORMAL) {
+        if (video->config.vi.mode == VI_MODE_NORMAL) {
             valid = vi_process_full();
         } else {
             valid = vi_process_fast();
@@ -751,10 +1023,34 @@ void n64video_update_screen(void)
     }
 
     // render frame to screen or blank screen if the frame is invalid
-    vdac_sync(!valid);
+    vi_output_sync(valid);
+}
+
+void* n64video_present_screen(struct n64video* handle)
+{
+    n64video_bind(handle);
+
+    if (!vi->pipelined) {
+        return vi->prescale;
+    }
+
+    // show the newest frame if its filter pass is done already, otherwise the
+    // one before, so the output lags behind by one frame at most
+    uint32_t index = vi->prescale_index;
+    if (vi->busy && !parallel_done()) {
+        index = (index + PRESCALE_BUFFERS - 1) % PRESCALE_BUFFERS;
+    }
+
+    if (vi->output[index].written) {
+        vdac_write(&vi->output[index].fb);
+    }
+    vdac_sync(!vi->output[index].valid);
+
+    return vi->prescale_buffers[index];
 }
 
 static void vi_close(void)
 {
+    vi_sync();
     vdac_close();
 }
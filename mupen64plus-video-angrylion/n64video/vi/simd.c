@@ -0,0 +1,378 @@
+// SSE2 scanline kernels for the filtered VI output. Each kernel handles a
+// whole row and gives the same results as the per-pixel filters in fetch.c,
+// restore.c, divot.c and lerp.c. Pixels that aren't fully covered still go
+// through video_filter16/32, which is too branchy to vectorize.
+
+#include <emmintrin.h>
+
+// cache entries per row, see viaa_array in vi_process_full_parallel
+#define VI_ROW_MAX 0xa10
+
+// extra entries written past the end of a row by the vector loops
+#define VI_ROW_PAD 16
+
+typedef void(*vi_fetch_row_func)(struct rgba*, uint32_t, uint32_t, uint32_t, uint32_t, struct vi_reg_ctrl, uint32_t, uint32_t);
+
+// copies len pixels starting at idx into a linear buffer, reading them like
+// vi_rdram_read_pair16 does
+static void vi_scan_row16(uint16_t* dst, uint8_t* hdst, uint32_t idx, uint32_t len)
+{
+    uint32_t i = 0;
+    uint32_t last = idx + len - 1;
+
+    if (idx <= idxlim16 && last <= idxlim16 && last >= idx) {
+        if (idx & 1) {
+            dst[i++] = vi->rdram16[idx ^ WORD_ADDR_XOR];
+        }
+
+        // the two halfwords of each word are swapped in RDRAM
+        for (; i + 8 <= len; i += 8) {
+            __m128i pix = _mm_loadu_si128((const __m128i*)&vi->rdram16[idx + i]);
+            pix = _mm_shufflelo_epi16(pix, _MM_SHUFFLE(2, 3, 0, 1));
+            pix = _mm_shufflehi_epi16(pix, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128((__m128i*)&dst[i], pix);
+        }
+
+        for (; i < len; i++) {
+            dst[i] = vi->rdram16[(idx + i) ^ WORD_ADDR_XOR];
+        }
+
+        if (hdst) {
+            memcpy(hdst, &vi->rdram_hidden[idx], len);
+        }
+    } else {
+        for (; i < len; i++) {
+            uint8_t hval;
+            vi_rdram_read_pair16(&dst[i], &hval, idx + i);
+            if (hdst) {
+                hdst[i] = hval;
+            }
+        }
+    }
+}
+
+static void vi_scan_row32(uint32_t* dst, uint32_t idx, uint32_t len)
+{
+    uint32_t i;
+    uint32_t last = idx + len - 1;
+
+    if (idx <= idxlim32 && last <= idxlim32 && last >= idx) {
+        memcpy(dst, &vi->rdram32[idx], len * sizeof(uint32_t));
+    } else {
+        for (i = 0; i < len; i++) {
+            dst[i] = vi_rdram_read_idx32(idx + i);
+        }
+    }
+}
+
+// adds the restore filter sign of one neighbour to each channel, see
+// vi_restore_table
+static STRICTINLINE void vi_restore_step(__m128i* sum, __m128i center, __m128i neighbour)
+{
+    *sum = _mm_sub_epi16(*sum, _mm_cmpgt_epi16(neighbour, center));
+    *sum = _mm_add_epi16(*sum, _mm_cmpgt_epi16(center, neighbour));
+}
+
+static STRICTINLINE void vi_restore_step32(__m128i* sum, __m128i center, __m128i neighbour)
+{
+    *sum = _mm_sub_epi32(*sum, _mm_cmpgt_epi32(neighbour, center));
+    *sum = _mm_add_epi32(*sum, _mm_cmpgt_epi32(center, neighbour));
+}
+
+// fills dst[c_begin .. c_end - 1] like vi_fetch_filter16 does for the pixels
+// at pixels + c - 1, writes up to 7 entries past c_end
+static STRICTINLINE void vi_fetch_row16(struct rgba* dst, uint32_t c_begin, uint32_t c_end, uint32_t pixels,
+    uint32_t fboffset, struct vi_reg_ctrl ctrl, uint32_t hres, uint32_t fetchstate, bool aa, bool restore)
+{
+    uint16_t up[VI_ROW_MAX + VI_ROW_PAD + 4];
+    uint16_t mid[VI_ROW_MAX + VI_ROW_PAD + 4];
+    uint16_t down[VI_ROW_MAX + VI_ROW_PAD + 4];
+    uint8_t hmid[VI_ROW_MAX + VI_ROW_PAD + 4];
+
+    uint32_t num = c_end - c_begin;
+    uint32_t len = num + 4 + 8;
+    uint32_t first = (fboffset >> 1) + pixels + c_begin - 1 - 2;
+
+    vi_scan_row16(mid, aa ? hmid : NULL, first, len);
+
+    // rows above and below, the fetch bug reads the current row instead
+    const uint16_t* below = mid;
+    if (restore) {
+        vi_scan_row16(up, NULL, first - hres, len);
+        if (fetchstate != 1) {
+            vi_scan_row16(down, NULL, first + hres, len);
+            below = down;
+        }
+    }
+
+    const __m128i mask5 = _mm_set1_epi16(0x1f);
+    const __m128i mask8 = _mm_set1_epi16(0xff);
+    const __m128i full = _mm_set1_epi16(7);
+
+    uint32_t i;
+    for (i = 0; i < num; i += 8) {
+        uint32_t j = i + 2;
+        __m128i pix = _mm_loadu_si128((const __m128i*)&mid[j]);
+
+        __m128i r = _mm_and_si128(_mm_srli_epi16(pix, 8), _mm_set1_epi16(0xf8));
+        __m128i g = _mm_srli_epi16(_mm_and_si128(pix, _mm_set1_epi16(0x7c0)), 3);
+        __m128i b = _mm_slli_epi16(_mm_and_si128(pix, _mm_set1_epi16(0x3e)), 2);
+
+        __m128i cvg = full;
+        if (aa) {
+            __m128i hval = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&hmid[j]), _mm_setzero_si128());
+            cvg = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(pix, _mm_set1_epi16(1)), 2), hval);
+        }
+
+        // restore only applies to fully covered pixels, the others are
+        // redone in scalar code below
+        if (restore) {
+            const uint16_t* rows[8] = {
+                &up[j - 1], &up[j], &up[j + 1], &below[j - 1],
+                &below[j], &below[j + 1], &mid[j - 1], &mid[j + 1]
+            };
+            __m128i cr = _mm_srli_epi16(r, 3);
+            __m128i cg = _mm_srli_epi16(g, 3);
+            __m128i cb = _mm_srli_epi16(b, 3);
+            __m128i sr = _mm_setzero_si128();
+            __m128i sg = _mm_setzero_si128();
+            __m128i sb = _mm_setzero_si128();
+            int k;
+
+            for (k = 0; k < 8; k++) {
+                __m128i n = _mm_loadu_si128((const __m128i*)rows[k]);
+                vi_restore_step(&sr, cr, _mm_and_si128(_mm_srli_epi16(n, 11), mask5));
+                vi_restore_step(&sg, cg, _mm_and_si128(_mm_srli_epi16(n, 6), mask5));
+                vi_restore_step(&sb, cb, _mm_and_si128(_mm_srli_epi16(n, 1), mask5));
+            }
+
+            r = _mm_and_si128(_mm_add_epi16(r, sr), mask8);
+            g = _mm_and_si128(_mm_add_epi16(g, sg), mask8);
+            b = _mm_and_si128(_mm_add_epi16(b, sb), mask8);
+        }
+
+        __m128i lo = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        __m128i hi = _mm_or_si128(r, _mm_slli_epi16(cvg, 8));
+        _mm_storeu_si128((__m128i*)&dst[c_begin + i], _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128((__m128i*)&dst[c_begin + i + 4], _mm_unpackhi_epi16(lo, hi));
+
+        if (aa) {
+            int covered = _mm_movemask_epi8(_mm_cmpeq_epi16(cvg, full));
+            if (covered != 0xffff) {
+                uint32_t lane;
+                for (lane = 0; lane < 8 && c_begin + i + lane < c_end; lane++) {
+                    if (!(covered & (1 << (lane << 1)))) {
+                        uint32_t c = c_begin + i + lane;
+                        vi_fetch_filter16(&dst[c], fboffset, pixels + c - 1, ctrl, hres, fetchstate);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static STRICTINLINE void vi_fetch_row32(struct rgba* dst, uint32_t c_begin, uint32_t c_end, uint32_t pixels,
+    uint32_t fboffset, struct vi_reg_ctrl ctrl, uint32_t hres, uint32_t fetchstate, bool aa, bool restore)
+{
+    uint32_t up[VI_ROW_MAX + VI_ROW_PAD + 4];
+    uint32_t mid[VI_ROW_MAX + VI_ROW_PAD + 4];
+    uint32_t down[VI_ROW_MAX + VI_ROW_PAD + 4];
+
+    uint32_t num = c_end - c_begin;
+    uint32_t len = num + 4 + 4;
+    uint32_t first = (fboffset >> 2) + pixels + c_begin - 1 - 2;
+
+    vi_scan_row32(mid, first, len);
+
+    const uint32_t* below = mid;
+    if (restore) {
+        vi_scan_row32(up, first - hres, len);
+        if (fetchstate != 1) {
+            vi_scan_row32(down, first + hres, len);
+            below = down;
+        }
+    }
+
+    const __m128i mask5 = _mm_set1_epi32(0x1f);
+    const __m128i mask8 = _mm_set1_epi32(0xff);
+    const __m128i full = _mm_set1_epi32(7);
+
+    uint32_t i;
+    for (i = 0; i < num; i += 4) {
+        uint32_t j = i + 2;
+        __m128i pix = _mm_loadu_si128((const __m128i*)&mid[j]);
+
+        __m128i r = _mm_srli_epi32(pix, 24);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(pix, 16), mask8);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(pix, 8), mask8);
+
+        __m128i cvg = full;
+        if (aa) {
+            cvg = _mm_and_si128(_mm_srli_epi32(pix, 5), full);
+        }
+
+        if (restore) {
+            const uint32_t* rows[8] = {
+                &up[j - 1], &up[j], &up[j + 1], &below[j - 1],
+                &below[j], &below[j + 1], &mid[j - 1], &mid[j + 1]
+            };
+            __m128i cr = _mm_srli_epi32(r, 3);
+            __m128i cg = _mm_srli_epi32(g, 3);
+            __m128i cb = _mm_srli_epi32(b, 3);
+            __m128i sr = _mm_setzero_si128();
+            __m128i sg = _mm_setzero_si128();
+            __m128i sb = _mm_setzero_si128();
+            int k;
+
+            for (k = 0; k < 8; k++) {
+                __m128i n = _mm_loadu_si128((const __m128i*)rows[k]);
+                vi_restore_step32(&sr, cr, _mm_srli_epi32(n, 27));
+                vi_restore_step32(&sg, cg, _mm_and_si128(_mm_srli_epi32(n, 19), mask5));
+                vi_restore_step32(&sb, cb, _mm_and_si128(_mm_srli_epi32(n, 11), mask5));
+            }
+
+            r = _mm_and_si128(_mm_add_epi32(r, sr), mask8);
+            g = _mm_and_si128(_mm_add_epi32(g, sg), mask8);
+            b = _mm_and_si128(_mm_add_epi32(b, sb), mask8);
+        }
+
+        __m128i px = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)),
+                                  _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(cvg, 24)));
+        _mm_storeu_si128((__m128i*)&dst[c_begin + i], px);
+
+        if (aa) {
+            int covered = _mm_movemask_epi8(_mm_cmpeq_epi32(cvg, full));
+            if (covered != 0xffff) {
+                uint32_t lane;
+                for (lane = 0; lane < 4 && c_begin + i + lane < c_end; lane++) {
+                    if (!(covered & (1 << (lane << 2)))) {
+                        uint32_t c = c_begin + i + lane;
+                        vi_fetch_filter32(&dst[c], fboffset, pixels + c - 1, ctrl, hres, fetchstate);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// one specialized kernel per format, AA and dither filter combination
+#define VI_FETCH_ROW(name, base, aa, restore) \
+    static void name(struct rgba* dst, uint32_t c_begin, uint32_t c_end, uint32_t pixels, \
+        uint32_t fboffset, struct vi_reg_ctrl ctrl, uint32_t hres, uint32_t fetchstate) \
+    { \
+        base(dst, c_begin, c_end, pixels, fboffset, ctrl, hres, fetchstate, aa, restore); \
+    }
+
+VI_FETCH_ROW(vi_fetch_row16_plain, vi_fetch_row16, false, false)
+VI_FETCH_ROW(vi_fetch_row16_restore, vi_fetch_row16, false, true)
+VI_FETCH_ROW(vi_fetch_row16_aa, vi_fetch_row16, true, false)
+VI_FETCH_ROW(vi_fetch_row16_aa_restore, vi_fetch_row16, true, true)
+VI_FETCH_ROW(vi_fetch_row32_plain, vi_fetch_row32, false, false)
+VI_FETCH_ROW(vi_fetch_row32_restore, vi_fetch_row32, false, true)
+VI_FETCH_ROW(vi_fetch_row32_aa, vi_fetch_row32, true, false)
+VI_FETCH_ROW(vi_fetch_row32_aa_restore, vi_fetch_row32, true, true)
+
+static vi_fetch_row_func vi_select_fetch_row(struct vi_reg_ctrl ctrl)
+{
+    static const vi_fetch_row_func kernels[2][2][2] = {
+        {
+            {vi_fetch_row16_plain, vi_fetch_row16_restore},
+            {vi_fetch_row16_aa, vi_fetch_row16_aa_restore}
+        },
+        {
+            {vi_fetch_row32_plain, vi_fetch_row32_restore},
+            {vi_fetch_row32_aa, vi_fetch_row32_aa_restore}
+        }
+    };
+
+    return kernels[ctrl.type & 1][ctrl.aa_mode <= VI_AA_RESAMP_EXTRA][ctrl.dither_filter_enable];
+}
+
+// divot_filter on dst[c_begin .. c_end - 1], reads src one entry past both
+// ends and writes up to 3 entries past c_end
+static void vi_divot_row(struct rgba* dst, const struct rgba* src, uint32_t c_begin, uint32_t c_end)
+{
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    const __m128i full = _mm_set1_epi32(0x07000000);
+
+    uint32_t c;
+    for (c = c_begin; c < c_end; c += 4) {
+        __m128i center = _mm_loadu_si128((const __m128i*)&src[c]);
+        __m128i left = _mm_loadu_si128((const __m128i*)&src[c - 1]);
+        __m128i right = _mm_loadu_si128((const __m128i*)&src[c + 1]);
+
+        // unsigned a >= b per channel
+#define VI_GE(a, b) _mm_cmpeq_epi8(_mm_max_epu8((a), (b)), (a))
+        __m128i use_left = _mm_or_si128(
+            _mm_and_si128(VI_GE(left, center), VI_GE(right, left)),
+            _mm_and_si128(VI_GE(left, right), VI_GE(center, left)));
+        __m128i use_right = _mm_or_si128(
+            _mm_and_si128(VI_GE(right, center), VI_GE(left, right)),
+            _mm_and_si128(VI_GE(right, left), VI_GE(center, right)));
+#undef VI_GE
+
+        __m128i res = _mm_or_si128(_mm_and_si128(use_right, right), _mm_andnot_si128(use_right, center));
+        res = _mm_or_si128(_mm_and_si128(use_left, left), _mm_andnot_si128(use_left, res));
+
+        // coverage is never filtered and fully covered spans are left alone
+        __m128i keep = _mm_or_si128(alpha, _mm_cmpeq_epi32(
+            _mm_and_si128(_mm_and_si128(center, _mm_and_si128(left, right)), alpha), full));
+        res = _mm_or_si128(_mm_and_si128(keep, center), _mm_andnot_si128(keep, res));
+
+        _mm_storeu_si128((__m128i*)&dst[c], res);
+    }
+}
+
+// vi_vl_lerp on four channels of two pixels, frac is 0 for the coverage
+static STRICTINLINE __m128i vi_lerp_step(__m128i up, __m128i down, __m128i frac)
+{
+    __m128i diff = _mm_mullo_epi16(_mm_sub_epi16(down, up), frac);
+    diff = _mm_srai_epi16(_mm_add_epi16(diff, _mm_set1_epi16(16)), 5);
+    return _mm_and_si128(_mm_add_epi16(diff, up), _mm_set1_epi16(0xff));
+}
+
+static STRICTINLINE __m128i vi_gather_rgba(const struct rgba* src, const uint16_t* idx, uint32_t offset)
+{
+    uint32_t px[4];
+    int i;
+    for (i = 0; i < 4; i++) {
+        memcpy(&px[i], &src[idx[i] + offset], sizeof(px[i]));
+    }
+    return _mm_loadu_si128((const __m128i*)px);
+}
+
+// bilinear scaling of one output row, cx holds the cache index of the left
+// source pixel for each output pixel
+static void vi_lerp_row(struct rgba* dst, const struct rgba* cur, const struct rgba* next,
+    const uint16_t* cx, const uint16_t* xfrac, uint32_t yfrac, int32_t num, bool lerp)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yf = _mm_set_epi16(0, yfrac, yfrac, yfrac, 0, yfrac, yfrac, yfrac);
+
+    int32_t x;
+    for (x = 0; x < num; x += 4) {
+        const uint16_t* c = &cx[x];
+        __m128i color = vi_gather_rgba(cur, c, 0);
+
+        if (lerp) {
+            __m128i nextcolor = vi_gather_rgba(cur, c, 1);
+            __m128i scancolor = vi_gather_rgba(next, c, 0);
+            __m128i scannextcolor = vi_gather_rgba(next, c, 1);
+            __m128i xf_lo = _mm_set_epi16(0, xfrac[x + 1], xfrac[x + 1], xfrac[x + 1],
+                                          0, xfrac[x], xfrac[x], xfrac[x]);
+            __m128i xf_hi = _mm_set_epi16(0, xfrac[x + 3], xfrac[x + 3], xfrac[x + 3],
+                                          0, xfrac[x + 2], xfrac[x + 2], xfrac[x + 2]);
+
+            __m128i lo = vi_lerp_step(_mm_unpacklo_epi8(color, zero), _mm_unpacklo_epi8(scancolor, zero), yf);
+            __m128i hi = vi_lerp_step(_mm_unpackhi_epi8(color, zero), _mm_unpackhi_epi8(scancolor, zero), yf);
+            __m128i next_lo = vi_lerp_step(_mm_unpacklo_epi8(nextcolor, zero), _mm_unpacklo_epi8(scannextcolor, zero), yf);
+            __m128i next_hi = vi_lerp_step(_mm_unpackhi_epi8(nextcolor, zero), _mm_unpackhi_epi8(scannextcolor, zero), yf);
+
+            lo = vi_lerp_step(lo, next_lo, xf_lo);
+            hi = vi_lerp_step(hi, next_hi, xf_hi);
+            color = _mm_packus_epi16(lo, hi);
+        }
+
+        _mm_storeu_si128((__m128i*)&dst[x], color);
+    }
+}
@@ -84,7 +84,7 @@ static STRICTINLINE void video_filter16(int* endr, int* endg, int* endb, uint32_
 
     for (i = 0; i < 6; i++)
     {
-        rdram_read_pair16(&pix, &hidval, dirs[i]);
+        vi_rdram_read_pair16(&pix, &hidval, dirs[i]);
         if (hidval == 3 && (pix & 1))
         {
             backr[numoffull] = RGBA16_R(pix);
@@ -156,7 +156,7 @@ static STRICTINLINE void video_filter32(int* endr, int* endg, int* endb, uint32_
 
     for (i = 0; i < 6; i++)
     {
-        pix = rdram_read_idx32(dirs[i]);
+        pix = vi_rdram_read_idx32(dirs[i]);
         pixcvg = (pix >> 5) & 7;
         if (pixcvg == 7)
         {
@@ -62,6 +62,9 @@ public:
             throw std::runtime_error("Workers are exiting and no longer accept work");
         }
 
+        // an asynchronous task may still be using the workers
+        sync();
+
         // prepare task for workers and send signal so they start working
         m_task = std::move(task);
         start_work();
@@ -73,6 +76,31 @@ public:
         wait();
     }
 
+    void run_async(std::function<void(std::uint32_t)>&& task) {
+        if (!m_accept_work) {
+            throw std::runtime_error("Workers are exiting and no longer accept work");
+        }
+
+        sync();
+
+        // same as run(), but worker 0 is skipped and the main thread returns
+        // right away, call sync() before touching anything the task uses
+        m_task = std::move(task);
+        m_async = true;
+        start_work();
+    }
+
+    bool done() {
+        return !m_async || m_tasks_done == m_all_tasks_done;
+    }
+
+    void sync() {
+        if (m_async) {
+            wait();
+            m_async = false;
+        }
+    }
+
     std::uint32_t num_workers() {
         return m_num_workers;
     }
@@ -86,6 +114,7 @@ private:
     std::atomic<uint64_t> m_tasks_done;
     std::uint64_t m_all_tasks_done;
     std::atomic<bool> m_accept_work;
+    bool m_async = false;
     const std::uint32_t m_num_workers;
 
     void start_work() {
@@ -166,6 +195,21 @@ uint32_t parallel_num_workers(void)
     return parallel->num_workers();
 }
 
+void parallel_run_async(void task(uint32_t))
+{
+    parallel->run_async(task);
+}
+
+bool parallel_done(void)
+{
+    return parallel->done();
+}
+
+void parallel_sync(void)
+{
+    parallel->sync();
+}
+
 void parallel_close(void)
 {
     parallel.reset();
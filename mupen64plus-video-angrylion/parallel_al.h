@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #define PARALLEL_MAX_WORKERS 64u
 
@@ -14,6 +15,13 @@ void parallel_run(void task(uint32_t));
 
 uint32_t parallel_num_workers(void);
 
+// runs the task on all workers except worker 0 without waiting for it
+void parallel_run_async(void task(uint32_t));
+
+bool parallel_done(void);
+
+void parallel_sync(void);
+
 void parallel_close(void);
 
 #ifdef __cplusplus
@@ -83,14 +83,17 @@ void parallelViWidthChanged(void)
 
 void parallelFBWrite(unsigned int addr, unsigned int size)
 {
+	RDP::frame_buffer_write(addr, size);
 }
 
 void parallelFBRead(unsigned int addr)
 {
+	RDP::frame_buffer_read(addr);
 }
 
 void parallelFBGetFrameBufferInfo(void *pinfo)
 {
+	RDP::get_frame_buffer_info(static_cast<RDP::FrameBufferInfo *>(pinfo));
 }
 
 m64p_error parallelPluginGetVersion(m64p_plugin_type *PluginType, int *PluginVersion, int *APIVersion,
@@ -156,6 +159,11 @@ void parallel_set_synchronous_rdp(bool enable)
 	RDP::synchronous = enable;
 }
 
+void parallel_set_hazard_tracking(bool enable)
+{
+	RDP::hazard_tracking = enable;
+}
+
 void parallel_set_divot_filter(bool enable)
 {
 	RDP::divot_filter = enable;
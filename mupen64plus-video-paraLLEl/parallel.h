@@ -17,6 +17,7 @@ unsigned parallel_frame_width(void);
 unsigned parallel_frame_height(void);
 void parallel_begin_frame(void);
 void parallel_set_synchronous_rdp(bool enable);
+void parallel_set_hazard_tracking(bool enable);
 
 void parallel_set_divot_filter(bool enable);
 void parallel_set_gamma_dither(bool enable);
@@ -4,6 +4,7 @@
 #include "parallel.h"
 #include "z64.h"
 #include <assert.h>
+#include <algorithm>
 
 using namespace Vulkan;
 using namespace std;
@@ -37,6 +38,38 @@ bool native_tex_rect = true;
 bool synchronous = true, divot_filter = true, gamma_dither = true;
 bool vi_aa = true, vi_scale = true, dither_filter = true;
 bool interlacing = true, super_sampled_read_back = false, super_sampled_dither = true;
+bool hazard_tracking = false;
+static unsigned rdram_size;
+
+// An RDRAM range the RDP writes, as rows of a color or depth image.
+struct WriteRange
+{
+	uint32_t addr;
+	uint32_t width;
+	uint32_t height;
+	uint32_t size;
+	uint64_t timeline;
+};
+
+// Images drawn to since the last full sync.
+static WriteRange batch_ranges[FRAME_BUFFER_INFO_COUNT];
+static unsigned num_batch_ranges;
+static bool batch_overflow;
+
+// Images written by full syncs the GPU might not have completed yet.
+// These are handed to the core as frame buffer info, so it tells us
+// when the CPU, an SP DMA or a PI DMA touches them.
+static WriteRange in_flight_ranges[FRAME_BUFFER_INFO_COUNT];
+static unsigned num_in_flight_ranges;
+static uint64_t completed_timeline_value;
+static bool frame_buffer_info_queried;
+static unsigned tracked_syncs, hazard_waits;
+
+// RDP state which decides where draw commands write.
+static uint32_t color_image_addr, color_image_width, color_image_size;
+static uint32_t mask_image_addr;
+static uint32_t scissor_height;
+static bool depth_update;
 
 static const unsigned cmd_len_lut[64] = {
 	1, 1, 1, 1, 1, 1, 1, 1, 4, 6, 12, 14, 12, 14, 20, 22,
@@ -45,6 +78,232 @@ static const unsigned cmd_len_lut[64] = {
 	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,  1,  1,
 };
 
+static bool range_overlaps(const WriteRange &range, uint32_t addr, uint32_t length)
+{
+	uint32_t end = range.addr + range.width * range.height * range.size;
+	return addr < end && addr + length > range.addr;
+}
+
+static void retire_ranges()
+{
+	unsigned count = 0;
+	for (unsigned i = 0; i < num_in_flight_ranges; i++)
+		if (in_flight_ranges[i].timeline > completed_timeline_value)
+			in_flight_ranges[count++] = in_flight_ranges[i];
+	num_in_flight_ranges = count;
+}
+
+static void wait_for_ranges(uint64_t value)
+{
+	if (value > completed_timeline_value)
+	{
+		frontend->wait_for_timeline(value);
+		completed_timeline_value = value;
+	}
+	retire_ranges();
+}
+
+static void add_batch_range(uint32_t addr, uint32_t width, uint32_t height, uint32_t size)
+{
+	if (addr >= rdram_size || width == 0 || height == 0)
+		return;
+
+	// Never hand the core a range past the end of RDRAM
+	uint32_t max_height = (rdram_size - addr) / (width * size);
+	if (max_height == 0)
+		return;
+	if (height > max_height)
+		height = max_height;
+
+	for (unsigned i = 0; i < num_batch_ranges; i++)
+	{
+		WriteRange &range = batch_ranges[i];
+		if (range.addr == addr)
+		{
+			range.width = std::max(range.width, width);
+			range.height = std::max(range.height, height);
+			range.size = std::max(range.size, size);
+			return;
+		}
+	}
+
+	if (num_batch_ranges < FRAME_BUFFER_INFO_COUNT)
+		batch_ranges[num_batch_ranges++] = { addr, width, height, size, 0 };
+	else
+		batch_overflow = true;
+}
+
+static void add_in_flight_range(const WriteRange &batch_range)
+{
+	for (unsigned i = 0; i < num_in_flight_ranges; i++)
+	{
+		WriteRange &range = in_flight_ranges[i];
+		if (range.addr == batch_range.addr)
+		{
+			range.width = std::max(range.width, batch_range.width);
+			range.height = std::max(range.height, batch_range.height);
+			range.size = std::max(range.size, batch_range.size);
+			range.timeline = batch_range.timeline;
+			return;
+		}
+	}
+
+	// Out of frame buffer info slots, so the oldest range has to complete.
+	if (num_in_flight_ranges == FRAME_BUFFER_INFO_COUNT)
+	{
+		uint64_t oldest = in_flight_ranges[0].timeline;
+		for (unsigned i = 1; i < num_in_flight_ranges; i++)
+			oldest = std::min(oldest, in_flight_ranges[i].timeline);
+		wait_for_ranges(oldest);
+	}
+
+	in_flight_ranges[num_in_flight_ranges++] = batch_range;
+}
+
+static void reset_ranges()
+{
+	num_batch_ranges = 0;
+	batch_overflow = false;
+	num_in_flight_ranges = 0;
+	completed_timeline_value = 0;
+	frame_buffer_info_queried = false;
+	tracked_syncs = 0;
+	hazard_waits = 0;
+	color_image_addr = 0;
+	color_image_width = 0;
+	color_image_size = 0;
+	mask_image_addr = 0;
+	scissor_height = 0;
+	depth_update = false;
+}
+
+static void track_command(const uint32_t *words)
+{
+	const uint32_t w1 = words[0];
+	const uint32_t w2 = words[1];
+
+	switch (RDP::Op((w1 >> 24) & 63))
+	{
+		case RDP::Op::SetColorImage:
+		{
+			// 4-bit images are rounded up to a byte per pixel
+			uint32_t size = (w1 >> 19) & 3;
+			color_image_size = size ? (1u << (size - 1)) : 1u;
+			color_image_width = (w1 & 0x3ff) + 1;
+			color_image_addr = w2 & 0xffffff;
+			break;
+		}
+
+		case RDP::Op::SetMaskImage:
+			mask_image_addr = w2 & 0xffffff;
+			break;
+
+		case RDP::Op::SetScissor:
+			// Lower right corner is 10.2 fixed point
+			scissor_height = ((w2 & 0xfff) + 3) >> 2;
+			break;
+
+		case RDP::Op::SetOtherModes:
+		{
+			// Copy and fill cycles never write depth
+			uint32_t cycle_type = (w1 >> 20) & 3;
+			depth_update = cycle_type < 2 && (w2 & (1u << 5)) != 0;
+			break;
+		}
+
+		case RDP::Op::FillTriangle:
+		case RDP::Op::FillZBufferTriangle:
+		case RDP::Op::TextureTriangle:
+		case RDP::Op::TextureZBufferTriangle:
+		case RDP::Op::ShadeTriangle:
+		case RDP::Op::ShadeZBufferTriangle:
+		case RDP::Op::ShadeTextureTriangle:
+		case RDP::Op::ShadeTextureZBufferTriangle:
+		case RDP::Op::TextureRectangle:
+		case RDP::Op::TextureRectangleFlip:
+		case RDP::Op::FillRectangle:
+			add_batch_range(color_image_addr, color_image_width, scissor_height, color_image_size);
+			if (depth_update)
+				add_batch_range(mask_image_addr, color_image_width, scissor_height, 2);
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void sync_full_tracked()
+{
+	uint64_t value = frontend->signal_timeline();
+	tracked_syncs++;
+
+	// The core only reports reads of frame buffer info it asked for.
+	// It never asks with the dynarec, which reads RDRAM directly.
+	if (!frame_buffer_info_queried || batch_overflow)
+	{
+		wait_for_ranges(value);
+	}
+	else
+	{
+		for (unsigned i = 0; i < num_batch_ranges; i++)
+		{
+			batch_ranges[i].timeline = value;
+			add_in_flight_range(batch_ranges[i]);
+		}
+	}
+
+	num_batch_ranges = 0;
+	batch_overflow = false;
+}
+
+void get_frame_buffer_info(FrameBufferInfo *infos)
+{
+	frame_buffer_info_queried = true;
+
+	for (unsigned i = 0; i < FRAME_BUFFER_INFO_COUNT; i++)
+	{
+		if (i < num_in_flight_ranges)
+		{
+			const WriteRange &range = in_flight_ranges[i];
+			infos[i].addr = range.addr;
+			infos[i].size = range.size;
+			infos[i].width = range.width;
+			infos[i].height = range.height;
+		}
+		else
+			infos[i] = {};
+	}
+}
+
+static void wait_for_overlap(uint32_t addr, uint32_t length)
+{
+	if (!frontend)
+		return;
+
+	uint64_t value = 0;
+	for (unsigned i = 0; i < num_in_flight_ranges; i++)
+		if (range_overlaps(in_flight_ranges[i], addr, length))
+			value = std::max(value, in_flight_ranges[i].timeline);
+
+	if (value > completed_timeline_value)
+	{
+		hazard_waits++;
+		wait_for_ranges(value);
+	}
+}
+
+void frame_buffer_read(uint32_t addr)
+{
+	// The core reports the first read of each 4 KiB page
+	wait_for_overlap(addr & ~0xfffu, 0x1000);
+}
+
+void frame_buffer_write(uint32_t addr, uint32_t size)
+{
+	// Keeps the RDP from overwriting the CPU store later on
+	wait_for_overlap(addr, size);
+}
+
 void process_commands()
 {
 	const uint32_t DP_CURRENT = *GET_GFX_INFO(DPC_CURRENT_REG) & 0x00FFFFF8;
@@ -105,13 +364,19 @@ void process_commands()
 		}
 
 		if (command >= 8 && frontend)
+		{
 			frontend->enqueue_command(cmd_length * 2, &cmd_data[2 * cmd_cur]);
+			if (!synchronous && hazard_tracking)
+				track_command(&cmd_data[2 * cmd_cur]);
+		}
 
 		if (RDP::Op(command) == RDP::Op::SyncFull)
 		{
 			// For synchronous RDP:
 			if (synchronous && frontend)
 				frontend->wait_for_timeline(frontend->signal_timeline());
+			else if (hazard_tracking && frontend)
+				sync_full_tracked();
 			*gfx_info.MI_INTR_REG |= DP_INTERRUPT;
 			gfx_info.CheckInterrupts();
 		}
@@ -210,7 +475,7 @@ bool init()
 	else
 		log_cb(RETRO_LOG_WARN, "VK_EXT_external_memory_host is not supported by this device. Application might run slower because of this.\n");
 
-	unsigned rdram_size = 8 * 1024 * 1024;
+	rdram_size = 8 * 1024 * 1024;
 	if (gfx_info.version >= 2 && gfx_info.RDRAM_SIZE)
 		rdram_size = *gfx_info.RDRAM_SIZE;
 
@@ -265,6 +530,7 @@ bool init()
 
 	timeline_value = 0;
 	pending_timeline_value = 0;
+	reset_ranges();
 	width = 0;
 	height = 0;
 	return true;
@@ -272,6 +538,10 @@ bool init()
 
 void deinit()
 {
+	if (tracked_syncs)
+		log_cb(RETRO_LOG_INFO, "paraLLEl-RDP: %u hazard waits over %u full syncs.\n", hazard_waits, tracked_syncs);
+	reset_ranges();
+
 	begin_ts.reset();
 	end_ts.reset();
 	retro_image_handles.clear();
@@ -28,6 +28,22 @@ extern unsigned overscan;
 extern unsigned downscaling_steps;
 extern bool synchronous, divot_filter, gamma_dither, vi_aa, vi_scale, dither_filter, interlacing;
 extern bool native_texture_lod, native_tex_rect, super_sampled_read_back, super_sampled_dither;
+extern bool hazard_tracking;
+
+// Layout of FrameBufferInfo from the frame buffer plugin spec extension.
+struct FrameBufferInfo
+{
+	unsigned addr;
+	unsigned size;
+	unsigned width;
+	unsigned height;
+};
+enum { FRAME_BUFFER_INFO_COUNT = 6 };
+
+// RDRAM hazard tracking for asynchronous RDP.
+void get_frame_buffer_info(FrameBufferInfo *infos);
+void frame_buffer_read(uint32_t addr);
+void frame_buffer_write(uint32_t addr, uint32_t size);
 
 void complete_frame();
 void deinit();